@@ -4023,8 +4023,10 @@ static int init_input_thread(int i)
     if (f->ctx->pb ? !f->ctx->pb->seekable :
         strcmp(f->ctx->iformat->name, "lavfi"))
         f->non_blocking = 1;
-    ret = av_thread_message_queue_alloc(&f->in_thread_queue,
-                                        f->thread_queue_size, sizeof(f->pkt));
+    /* only the input thread sends and only the main thread receives */
+    ret = av_thread_message_queue_alloc2(&f->in_thread_queue,
+                                         f->thread_queue_size, sizeof(f->pkt),
+                                         AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC);
     if (ret < 0)
         return ret;
 
@@ -142,11 +142,21 @@ static int av1_metadata_update_fragment(AVBSFContext *bsf, AVPacket *pkt,
     return 0;
 }
 
+static int av1_metadata_decompose_unit_types(AVBSFContext *bsf,
+                                             CodedBitstreamUnitType *types)
+{
+    // Temporal delimiters and padding are only ever inserted or
+    // removed whole, so the sequence header, which is always
+    // decomposed, is all we need to parse.
+    return 0;
+}
+
 static const CBSBSFType av1_metadata_type = {
-    .codec_id        = AV_CODEC_ID_AV1,
-    .fragment_name   = "temporal unit",
-    .unit_name       = "OBU",
-    .update_fragment = &av1_metadata_update_fragment,
+    .codec_id             = AV_CODEC_ID_AV1,
+    .fragment_name        = "temporal unit",
+    .unit_name            = "OBU",
+    .update_fragment      = &av1_metadata_update_fragment,
+    .decompose_unit_types = &av1_metadata_decompose_unit_types,
 };
 
 static int av1_metadata_init(AVBSFContext *bsf)
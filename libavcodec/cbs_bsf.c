@@ -16,9 +16,50 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/avassert.h"
+
+#include "av1.h"
 #include "bsf.h"
 #include "bsf_internal.h"
 #include "cbs_bsf.h"
+#include "h264.h"
+#include "hevc.h"
+
+// Parameter sets are always decomposed, whatever the filter asks for,
+// so that the input context keeps track of the active ones.
+static const struct {
+    enum AVCodecID codec_id;
+    CodedBitstreamUnitType types[3];
+    int nb_types;
+} cbs_bsf_parameter_set_types[] = {
+    { AV_CODEC_ID_AV1,  { AV1_OBU_SEQUENCE_HEADER },                     1 },
+    { AV_CODEC_ID_H264, { H264_NAL_SPS, H264_NAL_PPS },                  2 },
+    { AV_CODEC_ID_HEVC, { HEVC_NAL_VPS, HEVC_NAL_SPS, HEVC_NAL_PPS },    3 },
+};
+
+static int cbs_bsf_add_parameter_set_types(enum AVCodecID codec_id,
+                                           CodedBitstreamUnitType *types,
+                                           int nb_types)
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(cbs_bsf_parameter_set_types); i++) {
+        if (cbs_bsf_parameter_set_types[i].codec_id != codec_id)
+            continue;
+        for (int j = 0; j < cbs_bsf_parameter_set_types[i].nb_types; j++) {
+            CodedBitstreamUnitType type = cbs_bsf_parameter_set_types[i].types[j];
+            int k;
+
+            for (k = 0; k < nb_types; k++) {
+                if (types[k] == type)
+                    break;
+            }
+            if (k == nb_types) {
+                av_assert0(nb_types < CBS_BSF_MAX_DECOMPOSE_UNIT_TYPES);
+                types[nb_types++] = type;
+            }
+        }
+    }
+    return nb_types;
+}
 
 static int cbs_bsf_update_side_data(AVBSFContext *bsf, AVPacket *pkt)
 {
@@ -123,6 +164,18 @@ int ff_cbs_bsf_generic_init(AVBSFContext *bsf, const CBSBSFType *type)
     if (err < 0)
         return err;
 
+    if (type->decompose_unit_types) {
+        int nb_types = type->decompose_unit_types(bsf, ctx->decompose_unit_types);
+        av_assert0(nb_types >= 0 &&
+                   nb_types <= FF_ARRAY_ELEMS(ctx->decompose_unit_types));
+        nb_types = cbs_bsf_add_parameter_set_types(type->codec_id,
+                                                   ctx->decompose_unit_types,
+                                                   nb_types);
+
+        ctx->input->decompose_unit_types    = ctx->decompose_unit_types;
+        ctx->input->nb_decompose_unit_types = nb_types;
+    }
+
     if (bsf->par_in->extradata) {
         err = ff_cbs_read_extradata(ctx->input, frag, bsf->par_in);
         if (err < 0) {
@@ -45,8 +45,20 @@ typedef struct CBSBSFType {
     // pkt is NULL, then an extradata header fragment is being updated.
     int (*update_fragment)(AVBSFContext *bsf, AVPacket *pkt,
                            CodedBitstreamFragment *frag);
+
+    // Fill types with the unit types which update_fragment() needs to
+    // see decomposed with the current options, and return their number
+    // (at most CBS_BSF_MAX_DECOMPOSE_UNIT_TYPES minus the number of
+    // parameter set types).  Parameter sets are always decomposed in
+    // addition to these.  Units of all other types are passed through
+    // byte-for-byte without being parsed or rewritten.  If NULL, all
+    // units are decomposed.
+    int (*decompose_unit_types)(AVBSFContext *bsf,
+                                CodedBitstreamUnitType *types);
 } CBSBSFType;
 
+#define CBS_BSF_MAX_DECOMPOSE_UNIT_TYPES 32
+
 // Common structure for all generic CBS BSF users.  An instance of this
 // structure must be the first member of the BSF private context (to be
 // pointed to by AVBSFContext.priv_data).
@@ -57,6 +69,8 @@ typedef struct CBSBSFContext {
     CodedBitstreamContext *input;
     CodedBitstreamContext *output;
     CodedBitstreamFragment fragment;
+
+    CodedBitstreamUnitType decompose_unit_types[CBS_BSF_MAX_DECOMPOSE_UNIT_TYPES];
 } CBSBSFContext;
 
 /**
@@ -1282,6 +1282,19 @@ static int cbs_h2645_assemble_fragment(CodedBitstreamContext *ctx,
 
         zero_run = 0;
         for (sp = 0; sp < unit->data_size; sp++) {
+            if (zero_run == 0) {
+                // Nothing before the next zero byte can need escaping,
+                // so copy up to it in one go.
+                const uint8_t *zero = memchr(unit->data + sp, 0,
+                                             unit->data_size - sp);
+                size_t run = zero ? zero - (unit->data + sp)
+                                  : unit->data_size - sp;
+                memcpy(data + dp, unit->data + sp, run);
+                dp += run;
+                sp += run;
+                if (sp >= unit->data_size)
+                    break;
+            }
             if (zero_run < 2) {
                 if (unit->data[sp] == 0)
                     ++zero_run;
@@ -30,60 +30,42 @@
 #include "hevc.h"
 #include "h264.h"
 #include "h2645_parse.h"
+#include "startcode.h"
 
-int ff_h2645_extract_rbsp(const uint8_t *src, int length,
-                          H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
+/**
+ * @param padding number of readable bytes after the NAL unit, i.e. the rest
+ *                of the input buffer and its padding; if it is large enough
+ *                for the bitstream readers, NAL units without emulation
+ *                prevention bytes are not copied.
+ */
+static int extract_rbsp(const uint8_t *src, int length, int64_t padding,
+                        H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
 {
     int i, si, di;
     uint8_t *dst;
 
     nal->skipped_bytes = 0;
-#define STARTCODE_TEST                                                  \
-        if (i + 2 < length && src[i + 1] == 0 && src[i + 2] <= 3) {     \
-            if (src[i + 2] != 3 && src[i + 2] != 0) {                   \
-                /* startcode, so we must be past the end */             \
-                length = i;                                             \
-            }                                                           \
-            break;                                                      \
+
+    /* find the first 00 00 0x with x <= 3 */
+    i = 0;
+    while (i + 2 < length) {
+        i += ff_startcode_find_zero_pair(src + i, length - 2 - i);
+        if (i + 2 >= length)
+            break;
+        if (src[i + 2] <= 3) {
+            if (src[i + 2] != 3 && src[i + 2] != 0) {
+                /* startcode, so we must be past the end */
+                length = i;
+            }
+            break;
         }
-#if HAVE_FAST_UNALIGNED
-#define FIND_FIRST_ZERO                                                 \
-        if (i > 0 && !src[i])                                           \
-            i--;                                                        \
-        while (src[i])                                                  \
-            i++
-#if HAVE_FAST_64BIT
-    for (i = 0; i + 1 < length; i += 9) {
-        if (!((~AV_RN64(src + i) &
-               (AV_RN64(src + i) - 0x0100010001000101ULL)) &
-              0x8000800080008080ULL))
-            continue;
-        FIND_FIRST_ZERO;
-        STARTCODE_TEST;
-        i -= 7;
-    }
-#else
-    for (i = 0; i + 1 < length; i += 5) {
-        if (!((~AV_RN32(src + i) &
-               (AV_RN32(src + i) - 0x01000101U)) &
-              0x80008080U))
-            continue;
-        FIND_FIRST_ZERO;
-        STARTCODE_TEST;
-        i -= 3;
-    }
-#endif /* HAVE_FAST_64BIT */
-#else
-    for (i = 0; i + 1 < length; i += 2) {
-        if (src[i])
-            continue;
-        if (i > 0 && src[i - 1] == 0)
-            i--;
-        STARTCODE_TEST;
+        i++;
     }
-#endif /* HAVE_FAST_UNALIGNED */
+    if (i + 2 >= length)
+        i = length;
 
-    if (i >= length - 1 && small_padding) { // no escaped 0
+    if (i >= length - 1 &&
+        padding >= (small_padding ? AV_INPUT_BUFFER_PADDING_SIZE : MAX_MBPAIR_SIZE)) { // no escaped 0
         nal->data     =
         nal->raw_data = src;
         nal->size     =
@@ -97,6 +79,14 @@ int ff_h2645_extract_rbsp(const uint8_t *src, int length,
     memcpy(dst, src, i);
     si = di = i;
     while (si + 2 < length) {
+        // copy everything up to the next two zero bytes at once
+        int run = ff_startcode_find_zero_pair(src + si, length - 2 - si);
+        if (run > 0) {
+            memcpy(dst + di, src + si, run);
+            si += run;
+            di += run;
+            continue;
+        }
         // remove escapes (very rare 1:2^22)
         if (src[si + 2] > 3) {
             dst[di++] = src[si++];
@@ -145,6 +135,13 @@ nsc:
     return si;
 }
 
+int ff_h2645_extract_rbsp(const uint8_t *src, int length,
+                          H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
+{
+    return extract_rbsp(src, length, AV_INPUT_BUFFER_PADDING_SIZE,
+                        rbsp, nal, small_padding);
+}
+
 static const char *const hevc_nal_type_name[64] = {
     "TRAIL_N", // HEVC_NAL_TRAIL_N
     "TRAIL_R", // HEVC_NAL_TRAIL_R
@@ -328,13 +325,15 @@ static int h264_parse_nal_header(H2645NAL *nal, void *logctx)
 
 static int find_next_start_code(const uint8_t *buf, const uint8_t *next_avc)
 {
-    int i = 0;
+    int i = 0, size;
 
     if (buf + 3 >= next_avc)
         return next_avc - buf;
 
-    while (buf + i + 3 < next_avc) {
-        if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
+    size = next_avc - buf - 3;
+    while (i < size) {
+        i += ff_startcode_find_zero_pair(buf + i, size - i);
+        if (i >= size || buf[i + 2] == 1)
             break;
         i++;
     }
@@ -396,6 +395,7 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
     int consumed, ret = 0;
     int next_avc = is_nalff ? 0 : length;
     int64_t padding = small_padding ? 0 : MAX_MBPAIR_SIZE;
+    int input_padding = FFMAX(pkt->input_padding, AV_INPUT_BUFFER_PADDING_SIZE);
 
     bytestream2_init(&bc, buf, length);
     alloc_rbsp_buffer(&pkt->rbsp, length + padding, use_ref);
@@ -475,7 +475,9 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
         }
         nal = &pkt->nals[pkt->nb_nals];
 
-        consumed = ff_h2645_extract_rbsp(bc.buffer, extract_length, &pkt->rbsp, nal, small_padding);
+        consumed = extract_rbsp(bc.buffer, extract_length,
+                                buf + length - (bc.buffer + extract_length) + input_padding,
+                                &pkt->rbsp, nal, small_padding);
         if (consumed < 0)
             return consumed;
 
@@ -85,6 +85,13 @@ typedef struct H2645Packet {
     int nb_nals;
     int nals_allocated;
     unsigned nal_buffer_size;
+    /**
+     * Number of readable bytes after the end of the input buffer, may be set
+     * by the caller if it is more than AV_INPUT_BUFFER_PADDING_SIZE.
+     * The NAL units are then used in place instead of being copied to
+     * rbsp_buffer more often.
+     */
+    int input_padding;
 } H2645Packet;
 
 /**
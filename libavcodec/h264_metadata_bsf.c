@@ -545,11 +545,31 @@ static int h264_metadata_update_fragment(AVBSFContext *bsf, AVPacket *pkt,
     return 0;
 }
 
+static int h264_metadata_decompose_unit_types(AVBSFContext *bsf,
+                                              CodedBitstreamUnitType *types)
+{
+    H264MetadataContext *ctx = bsf->priv_data;
+    int nb_types = 0;
+
+    // Slice types are needed to choose the AUD primary_pic_type.
+    if (ctx->aud == BSF_ELEMENT_INSERT) {
+        types[nb_types++] = H264_NAL_SLICE;
+        types[nb_types++] = H264_NAL_IDR_SLICE;
+    }
+
+    if (ctx->sei_user_data || ctx->delete_filler ||
+        ctx->display_orientation != BSF_ELEMENT_PASS)
+        types[nb_types++] = H264_NAL_SEI;
+
+    return nb_types;
+}
+
 static const CBSBSFType h264_metadata_type = {
-    .codec_id        = AV_CODEC_ID_H264,
-    .fragment_name   = "access unit",
-    .unit_name       = "NAL unit",
-    .update_fragment = &h264_metadata_update_fragment,
+    .codec_id             = AV_CODEC_ID_H264,
+    .fragment_name        = "access unit",
+    .unit_name            = "NAL unit",
+    .update_fragment      = &h264_metadata_update_fragment,
+    .decompose_unit_types = &h264_metadata_decompose_unit_types,
 };
 
 static int h264_metadata_init(AVBSFContext *bsf)
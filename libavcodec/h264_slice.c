@@ -2094,7 +2094,7 @@ static int h264_slice_init(H264Context *h, H264SliceContext *sl,
     if (!h->setup_finished)
         ff_h264_direct_ref_list_init(h, sl);
 
-    if (h->avctx->skip_loop_filter >= AVDISCARD_ALL ||
+    if (h->avctx->skip_loop_filter >= AVDISCARD_ALL || h->thumbnail ||
         (h->avctx->skip_loop_filter >= AVDISCARD_NONKEY &&
          h->nal_unit_type != H264_NAL_IDR_SLICE) ||
         (h->avctx->skip_loop_filter >= AVDISCARD_NONINTRA &&
@@ -2268,6 +2268,17 @@ int ff_h264_queue_decode_slice(H264Context *h, const H2645NAL *nal)
             h->avctx->skip_frame >= AVDISCARD_ALL) {
             return 0;
         }
+
+        // in thumbnail mode the first slice decides for the whole picture,
+        // so that mixed slice types never leave it partly decoded
+        if (h->thumbnail) {
+            if (sl->first_mb_addr == 0)
+                h->thumbnail_skip = sl->slice_type_nos != AV_PICTURE_TYPE_I ||
+                                    (h->nal_unit_type != H264_NAL_IDR_SLICE &&
+                                     h->sei.recovery_point.recovery_frame_cnt < 0);
+            if (h->thumbnail_skip)
+                return 0;
+        }
     }
 
     if (!first_slice) {
@@ -613,7 +613,7 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size)
         H2645NAL *nal = &h->pkt.nals[i];
         int max_slice_ctx, err;
 
-        if (avctx->skip_frame >= AVDISCARD_NONREF &&
+        if ((avctx->skip_frame >= AVDISCARD_NONREF || h->thumbnail) &&
             nal->ref_idc == 0 && nal->type != H264_NAL_SEI)
             continue;
 
@@ -1011,7 +1011,10 @@ static int h264_decode_frame(AVCodecContext *avctx, void *data,
                                             avctx->err_recognition, avctx);
     }
 
+    /* the rest of the packet buffer can serve as padding of the last NAL */
+    h->pkt.input_padding = avpkt->buf ? avpkt->buf->data + avpkt->buf->size - (buf + buf_size) : 0;
     buf_index = decode_nal_units(h, buf, buf_size);
+    h->pkt.input_padding = 0;
     if (buf_index < 0)
         return AVERROR_INVALIDDATA;
 
@@ -1021,7 +1024,7 @@ static int h264_decode_frame(AVCodecContext *avctx, void *data,
     }
 
     if (!(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS) && (!h->cur_pic_ptr || !h->has_slice)) {
-        if (avctx->skip_frame >= AVDISCARD_NONREF ||
+        if (avctx->skip_frame >= AVDISCARD_NONREF || h->thumbnail ||
             buf_size >= 4 && !memcmp("Q264", buf, 4))
             return buf_size;
         av_log(avctx, AV_LOG_ERROR, "no frame!\n");
@@ -1056,6 +1059,7 @@ static const AVOption h264_options[] = {
     { "nal_length_size", "nal_length_size", OFFSET(nal_length_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 4, VDX },
     { "enable_er", "Enable error resilience on damaged frames (unsafe)", OFFSET(enable_er), AV_OPT_TYPE_BOOL, { .i64 = -1 }, -1, 1, VD },
     { "x264_build", "Assume this x264 version if no x264 version found in any SEI", OFFSET(x264_build), AV_OPT_TYPE_INT, {.i64 = -1}, -1, INT_MAX, VD },
+    { "thumbnail", "Decode only intra key frames and skip the loop filter", OFFSET(thumbnail), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, VD },
     { NULL },
 };
 
@@ -543,6 +543,8 @@ typedef struct H264Context {
     int height_from_caller;
 
     int enable_er;
+    int thumbnail;      ///< decode only IDR/recovery point I pictures, without deblocking
+    int thumbnail_skip; ///< the current picture is skipped in thumbnail mode
 
     H264SEIContext sei;
 
@@ -396,11 +396,30 @@ static int h265_metadata_update_fragment(AVBSFContext *bsf, AVPacket *pkt,
     return 0;
 }
 
+static int h265_metadata_decompose_unit_types(AVBSFContext *bsf,
+                                              CodedBitstreamUnitType *types)
+{
+    H265MetadataContext *ctx = bsf->priv_data;
+    int nb_types = 0;
+
+    // Slice types and layer/temporal IDs are needed to fill the AUD.
+    if (ctx->aud == BSF_ELEMENT_INSERT) {
+        int type;
+        for (type = HEVC_NAL_TRAIL_N; type <= HEVC_NAL_RASL_R; type++)
+            types[nb_types++] = type;
+        for (type = HEVC_NAL_BLA_W_LP; type <= HEVC_NAL_CRA_NUT; type++)
+            types[nb_types++] = type;
+    }
+
+    return nb_types;
+}
+
 static const CBSBSFType h265_metadata_type = {
-    .codec_id        = AV_CODEC_ID_HEVC,
-    .fragment_name   = "access unit",
-    .unit_name       = "NAL unit",
-    .update_fragment = &h265_metadata_update_fragment,
+    .codec_id             = AV_CODEC_ID_HEVC,
+    .fragment_name        = "access unit",
+    .unit_name            = "NAL unit",
+    .update_fragment      = &h265_metadata_update_fragment,
+    .decompose_unit_types = &h265_metadata_decompose_unit_types,
 };
 
 static int h265_metadata_init(AVBSFContext *bsf)
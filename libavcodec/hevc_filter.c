@@ -841,7 +841,7 @@ void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
 {
     int x_end = x >= s->ps.sps->width  - ctb_size;
     int skip = 0;
-    if (s->avctx->skip_loop_filter >= AVDISCARD_ALL ||
+    if (s->avctx->skip_loop_filter >= AVDISCARD_ALL || s->thumbnail ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONKEY && !IS_IDR(s)) ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONINTRA &&
          s->sh.slice_type != HEVC_SLICE_I) ||
@@ -893,6 +893,11 @@ static int hls_slice_header(HEVCContext *s)
         } else {
             sh->slice_loop_filter_across_slices_enabled_flag = s->ps.pps->seq_loop_filter_across_slices_enabled_flag;
         }
+
+        /* Thumbnail mode never runs the in-loop filters, so do not bother
+         * computing boundary strengths for them either. */
+        if (s->thumbnail && !s->avctx->hwaccel)
+            sh->disable_deblocking_filter_flag = 1;
     } else if (!s->slice_initialized) {
         av_log(s->avctx, AV_LOG_ERROR, "Independent slice segment missing.\n");
         return AVERROR_INVALIDDATA;
@@ -3275,6 +3280,7 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 {
     int i, ret = 0;
     int eos_at_start = 1;
+    int thumbnail_skip = 0;
 
     s->ref = NULL;
     s->last_eos = s->eos;
@@ -3334,13 +3340,30 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
         }
     }
 
+    /* In thumbnail mode, the first VCL NAL unit decides for the whole
+     * picture; mismatching NAL unit types in the rest of it are then
+     * rejected as in normal decoding instead of being partly dropped. */
+    if (s->thumbnail) {
+        for (i = 0; i < s->pkt.nb_nals; i++) {
+            const H2645NAL *nal = &s->pkt.nals[i];
+
+            if (nal->type <= HEVC_NAL_RSV_VCL31 && !nal->nuh_layer_id) {
+                thumbnail_skip = nal->type < HEVC_NAL_BLA_W_LP ||
+                                 nal->type > HEVC_NAL_RSV_IRAP_VCL23;
+                break;
+            }
+        }
+    }
+
     /* decode the NAL units */
     for (i = 0; i < s->pkt.nb_nals; i++) {
         H2645NAL *nal = &s->pkt.nals[i];
 
         if (s->avctx->skip_frame >= AVDISCARD_ALL ||
             (s->avctx->skip_frame >= AVDISCARD_NONREF
-            && ff_hevc_nal_is_nonref(nal->type)) || nal->nuh_layer_id > 0)
+            && ff_hevc_nal_is_nonref(nal->type)) ||
+            (thumbnail_skip && nal->type <= HEVC_NAL_RSV_VCL31) ||
+            nal->nuh_layer_id > 0)
             continue;
 
         ret = decode_nal_unit(s, nal);
@@ -3847,6 +3870,8 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "thumbnail", "Decode only IRAP pictures and skip the in-loop filters", OFFSET(thumbnail),
+        AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { NULL },
 };
 
@@ -25,6 +25,7 @@
  * @author Michael Niedermayer <michaelni@gmx.at>
  */
 
+#include "libavutil/common.h"
 #include "startcode.h"
 #include "config.h"
 
@@ -55,3 +56,16 @@ int ff_startcode_find_candidate_c(const uint8_t *buf, int size)
             break;
     return i;
 }
+
+int ff_startcode_find_zero_pair(const uint8_t *buf, int size)
+{
+    int i = 0;
+
+    while (i < size) {
+        i += ff_startcode_find_candidate_c(buf + i, size - i);
+        if (i >= size || !buf[i + 1])
+            break;
+        i++;
+    }
+    return FFMIN(i, size);
+}
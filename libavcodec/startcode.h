@@ -33,4 +33,16 @@ const uint8_t *avpriv_find_start_code(const uint8_t *p,
 
 int ff_startcode_find_candidate_c(const uint8_t *buf, int size);
 
+/**
+ * Find the first two consecutive zero bytes, which start every H.264/HEVC
+ * start code and emulation prevention sequence.
+ *
+ * @param size number of positions to test; buf[size] is compared too and
+ *             AV_INPUT_BUFFER_PADDING_SIZE bytes after buf + size must be
+ *             readable
+ * @return the smallest i < size with buf[i] == buf[i + 1] == 0, or size if
+ *         there is none
+ */
+int ff_startcode_find_zero_pair(const uint8_t *buf, int size);
+
 #endif /* AVCODEC_STARTCODE_H */
@@ -0,0 +1,287 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/log.h"
+#include "libavutil/opt.h"
+
+#include "libavcodec/bsf.h"
+#include "libavcodec/cbs.h"
+#include "libavcodec/cbs_h264.h"
+#include "libavcodec/h264.h"
+#include "libavcodec/packet.h"
+
+/*
+ * Access units of a stream with two SPS/PPS pairs giving different slice
+ * header layouts, used alternately, and an SPS which is replaced by one
+ * with the same id. The slices can only be read back correctly if every
+ * parameter set is parsed, whichever units the filter options need.
+ */
+
+typedef struct TestSPS {
+    int id;
+    int log2_max_frame_num_minus4;
+    int frame_mbs_only;
+    int poc_type;
+} TestSPS;
+
+typedef struct TestSlice {
+    int pps_id;
+    int idr;
+    int slice_type;
+    int frame_num;
+    int poc_lsb;
+} TestSlice;
+
+typedef struct TestAU {
+    TestSPS sps[2];
+    int nb_sps;
+    int nb_pps;         /* PPS 0 uses SPS 0, PPS 1 uses SPS 1 */
+    TestSlice slice;
+} TestAU;
+
+static const TestAU test_aus[] = {
+    { { { 0, 0, 1, 2 }, { 1, 8, 0, 0 } }, 2, 2, { 1, 1, 7, 0, 0 } },
+    { { { 0 } },                          0, 0, { 1, 0, 5, 1, 2 } },
+    { { { 0 } },                          0, 0, { 0, 1, 7, 0, 0 } },
+    { { { 0 } },                          0, 0, { 0, 0, 5, 1, 0 } },
+    { { { 1, 2, 1, 0 } },                 1, 2, { 1, 1, 2, 0, 0 } },
+    { { { 0 } },                          0, 0, { 1, 0, 0, 3, 4 } },
+};
+
+static const uint8_t slice_data[] = { 0xa5, 0x5a, 0xc3, 0x3c, 0x80 };
+
+static void fill_sps(H264RawSPS *sps, const TestSPS *t)
+{
+    memset(sps, 0, sizeof(*sps));
+    sps->nal_unit_header.nal_ref_idc   = 3;
+    sps->nal_unit_header.nal_unit_type = H264_NAL_SPS;
+
+    sps->profile_idc          = 77;
+    sps->level_idc            = 30;
+    sps->seq_parameter_set_id = t->id;
+    sps->chroma_format_idc    = 1;
+
+    sps->log2_max_frame_num_minus4        = t->log2_max_frame_num_minus4;
+    sps->pic_order_cnt_type               = t->poc_type;
+    sps->log2_max_pic_order_cnt_lsb_minus4 = 4;
+
+    sps->max_num_ref_frames             = 1;
+    sps->pic_width_in_mbs_minus1        = 1;
+    sps->pic_height_in_map_units_minus1 = 1;
+    sps->frame_mbs_only_flag            = t->frame_mbs_only;
+    sps->direct_8x8_inference_flag      = 1;
+
+    /* values inferred for an absent VUI */
+    sps->vui.video_format             = 5;
+    sps->vui.colour_primaries         = 2;
+    sps->vui.transfer_characteristics = 2;
+    sps->vui.matrix_coefficients      = 2;
+    sps->vui.low_delay_hrd_flag       = 1;
+    sps->vui.motion_vectors_over_pic_boundaries_flag = 1;
+    sps->vui.max_bytes_per_pic_denom  = 2;
+    sps->vui.max_bits_per_mb_denom    = 1;
+    sps->vui.log2_max_mv_length_horizontal = 15;
+    sps->vui.log2_max_mv_length_vertical   = 15;
+    sps->vui.max_num_reorder_frames   = H264_MAX_DPB_FRAMES;
+    sps->vui.max_dec_frame_buffering  = H264_MAX_DPB_FRAMES;
+}
+
+static void fill_pps(H264RawPPS *pps, int id)
+{
+    memset(pps, 0, sizeof(*pps));
+    pps->nal_unit_header.nal_ref_idc   = 3;
+    pps->nal_unit_header.nal_unit_type = H264_NAL_PPS;
+
+    pps->pic_parameter_set_id = id;
+    pps->seq_parameter_set_id = id;
+    pps->deblocking_filter_control_present_flag = 1;
+}
+
+static void fill_slice(H264RawSlice *slice, const TestSlice *t)
+{
+    H264RawSliceHeader *sh = &slice->header;
+
+    memset(slice, 0, sizeof(*slice));
+    sh->nal_unit_header.nal_ref_idc   = 2;
+    sh->nal_unit_header.nal_unit_type = t->idr ? H264_NAL_IDR_SLICE
+                                               : H264_NAL_SLICE;
+
+    sh->slice_type           = t->slice_type;
+    sh->pic_parameter_set_id = t->pps_id;
+    sh->frame_num            = t->frame_num;
+    sh->idr_pic_id           = t->idr ? t->frame_num : 0;
+    sh->pic_order_cnt_lsb    = t->poc_lsb;
+    sh->disable_deblocking_filter_idc = 1;
+
+    slice->data      = (uint8_t *)slice_data;
+    slice->data_size = sizeof(slice_data);
+}
+
+static int write_au(CodedBitstreamContext *cbc, CodedBitstreamFragment *frag,
+                    const TestAU *au, AVPacket *pkt)
+{
+    H264RawSPS sps[2];
+    H264RawPPS pps[2];
+    H264RawSlice slice;
+    int i, err;
+
+    for (i = 0; i < au->nb_sps; i++) {
+        fill_sps(&sps[i], &au->sps[i]);
+        err = ff_cbs_insert_unit_content(frag, -1, H264_NAL_SPS,
+                                         &sps[i], NULL);
+        if (err < 0)
+            return err;
+    }
+    for (i = 0; i < au->nb_pps; i++) {
+        fill_pps(&pps[i], i);
+        err = ff_cbs_insert_unit_content(frag, -1, H264_NAL_PPS,
+                                         &pps[i], NULL);
+        if (err < 0)
+            return err;
+    }
+    fill_slice(&slice, &au->slice);
+    err = ff_cbs_insert_unit_content(frag, -1, slice.header.nal_unit_header.nal_unit_type,
+                                     &slice, NULL);
+    if (err < 0)
+        return err;
+
+    err = ff_cbs_write_packet(cbc, pkt, frag);
+    ff_cbs_fragment_reset(frag);
+    return err;
+}
+
+/* Read an output packet back and compare it with the access unit. */
+static int check_au(CodedBitstreamContext *cbc, CodedBitstreamFragment *frag,
+                    const TestAU *au, const AVPacket *pkt, int aud)
+{
+    const TestSlice *t = &au->slice;
+    const H264RawSliceHeader *sh;
+    int nb_units = aud + au->nb_sps + au->nb_pps + 1;
+    int err;
+
+    err = ff_cbs_read_packet(cbc, frag, pkt);
+    if (err < 0)
+        return err;
+    if (frag->nb_units != nb_units) {
+        fprintf(stderr, "%d units instead of %d\n", frag->nb_units, nb_units);
+        return AVERROR_BUG;
+    }
+    if (aud) {
+        const H264RawAUD *raw_aud = frag->units[0].content;
+        int primary_pic_type = t->slice_type % 5 == 2 ? 0 : 1;
+
+        if (frag->units[0].type != H264_NAL_AUD ||
+            raw_aud->primary_pic_type != primary_pic_type) {
+            fprintf(stderr, "missing or wrong AUD\n");
+            return AVERROR_BUG;
+        }
+    }
+
+    sh = &((const H264RawSlice *)frag->units[nb_units - 1].content)->header;
+    if (sh->pic_parameter_set_id != t->pps_id || sh->slice_type != t->slice_type ||
+        sh->frame_num != t->frame_num || sh->pic_order_cnt_lsb != t->poc_lsb ||
+        sh->disable_deblocking_filter_idc != 1) {
+        fprintf(stderr, "slice header mismatch\n");
+        return AVERROR_BUG;
+    }
+    ff_cbs_fragment_reset(frag);
+    return 0;
+}
+
+static int test(const char *options, int aud)
+{
+    CodedBitstreamContext *writer = NULL, *reader = NULL;
+    CodedBitstreamFragment frag = { 0 };
+    const AVBitStreamFilter *filter;
+    AVBSFContext *bsf = NULL;
+    AVPacket *in = NULL, *out = NULL;
+    int i = 0, err;
+
+    err = ff_cbs_init(&writer, AV_CODEC_ID_H264, NULL);
+    if (err < 0)
+        goto end;
+    err = ff_cbs_init(&reader, AV_CODEC_ID_H264, NULL);
+    if (err < 0)
+        goto end;
+
+    filter = av_bsf_get_by_name("h264_metadata");
+    err = av_bsf_alloc(filter, &bsf);
+    if (err < 0)
+        goto end;
+    bsf->par_in->codec_id = AV_CODEC_ID_H264;
+    err = av_opt_set_from_string(bsf->priv_data, options, NULL, "=", ":");
+    if (err < 0)
+        goto end;
+    err = av_bsf_init(bsf);
+    if (err < 0)
+        goto end;
+
+    in  = av_packet_alloc();
+    out = av_packet_alloc();
+    if (!in || !out) {
+        err = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(test_aus); i++) {
+        err = write_au(writer, &frag, &test_aus[i], in);
+        if (err < 0)
+            goto end;
+        err = av_bsf_send_packet(bsf, in);
+        if (err < 0)
+            goto end;
+        err = av_bsf_receive_packet(bsf, out);
+        if (err < 0)
+            goto end;
+        err = check_au(reader, &frag, &test_aus[i], out, aud);
+        ff_cbs_fragment_reset(&frag);
+        av_packet_unref(out);
+        if (err < 0)
+            goto end;
+    }
+
+end:
+    if (err < 0)
+        fprintf(stderr, "h264_metadata=%s, access unit %d: %s\n",
+                options, i, av_err2str(err));
+    ff_cbs_fragment_free(&frag);
+    ff_cbs_close(&writer);
+    ff_cbs_close(&reader);
+    av_bsf_free(&bsf);
+    av_packet_free(&in);
+    av_packet_free(&out);
+    return err;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    av_log_set_level(AV_LOG_QUIET);
+
+    /* only the parameter sets are read */
+    ret |= test("", 0);
+    ret |= test("delete_filler=1", 0);
+    /* the slices are read too */
+    ret |= test("aud=insert", 1);
+
+    return !!ret;
+}
@@ -0,0 +1,298 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/log.h"
+#include "libavutil/opt.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/h264.h"
+#include "libavcodec/put_bits.h"
+#include "libavcodec/put_golomb.h"
+
+/*
+ * A 32x32 CAVLC stream with two slices of two macroblocks per picture.
+ * Intra slices are coded with I_PCM macroblocks of a single value, inter
+ * slices with P_Skip macroblocks. In thumbnail mode only the IDR pictures
+ * and the recovery point picture starting with an intra slice must be
+ * output, each of them completely decoded.
+ */
+
+#define MB_COUNT   4
+#define BUF_SIZE   4096
+
+enum { SKIP = 0, PCM = 1 };
+
+typedef struct TestPicture {
+    int idr;
+    int recovery_point;
+    int frame_num;
+    int slices[2];      /* PCM value of each slice, or SKIP */
+} TestPicture;
+
+static const TestPicture test_pictures[] = {
+    { 1, 0, 0, { 0x40, 0x40 } },
+    { 0, 0, 1, { SKIP, SKIP } },
+    { 0, 1, 2, { 0x60, SKIP } },   /* decoded, the bottom copied from 0 */
+    { 0, 1, 3, { SKIP, 0x80 } },   /* dropped as a whole */
+    { 0, 0, 4, { 0x70, 0x70 } },   /* intra, but not a key picture */
+    { 1, 0, 0, { 0xa0, 0xa0 } },
+};
+
+/* expected luma of the top and bottom macroblock rows of the output */
+static const int expected[][2] = {
+    { 0x40, 0x40 },
+    { 0x60, 0x40 },
+    { 0xa0, 0xa0 },
+};
+
+static uint8_t *write_nal(uint8_t *dst, int ref_idc, int type,
+                          PutBitContext *pb)
+{
+    const uint8_t *rbsp = pb->buf;
+    int size, zeros = 0;
+
+    /* rbsp_trailing_bits() */
+    put_bits(pb, 1, 1);
+    flush_put_bits(pb);
+    size = put_bytes_output(pb);
+
+    memcpy(dst, "\0\0\0\1", 4);
+    dst += 4;
+    *dst++ = ref_idc << 5 | type;
+    for (int i = 0; i < size; i++) {
+        if (zeros == 2 && rbsp[i] <= 3) {
+            *dst++ = 3;
+            zeros  = 0;
+        }
+        zeros  = rbsp[i] ? 0 : zeros + 1;
+        *dst++ = rbsp[i];
+    }
+    return dst;
+}
+
+static uint8_t *write_parameter_sets(uint8_t *dst)
+{
+    uint8_t rbsp[64];
+    PutBitContext pb;
+
+    init_put_bits(&pb, rbsp, sizeof(rbsp));
+    put_bits(&pb, 8, 66);           /* profile_idc */
+    put_bits(&pb, 8, 0);            /* constraint_set flags */
+    put_bits(&pb, 8, 30);           /* level_idc */
+    set_ue_golomb(&pb, 0);          /* seq_parameter_set_id */
+    set_ue_golomb(&pb, 0);          /* log2_max_frame_num_minus4 */
+    set_ue_golomb(&pb, 2);          /* pic_order_cnt_type */
+    set_ue_golomb(&pb, 1);          /* max_num_ref_frames */
+    put_bits(&pb, 1, 0);            /* gaps_in_frame_num_value_allowed_flag */
+    set_ue_golomb(&pb, 1);          /* pic_width_in_mbs_minus1 */
+    set_ue_golomb(&pb, 1);          /* pic_height_in_map_units_minus1 */
+    put_bits(&pb, 1, 1);            /* frame_mbs_only_flag */
+    put_bits(&pb, 1, 1);            /* direct_8x8_inference_flag */
+    put_bits(&pb, 1, 0);            /* frame_cropping_flag */
+    put_bits(&pb, 1, 0);            /* vui_parameters_present_flag */
+    dst = write_nal(dst, 3, H264_NAL_SPS, &pb);
+
+    init_put_bits(&pb, rbsp, sizeof(rbsp));
+    set_ue_golomb(&pb, 0);          /* pic_parameter_set_id */
+    set_ue_golomb(&pb, 0);          /* seq_parameter_set_id */
+    put_bits(&pb, 1, 0);            /* entropy_coding_mode_flag */
+    put_bits(&pb, 1, 0);            /* bottom_field_pic_order_in_frame_present_flag */
+    set_ue_golomb(&pb, 0);          /* num_slice_groups_minus1 */
+    set_ue_golomb(&pb, 0);          /* num_ref_idx_l0_default_active_minus1 */
+    set_ue_golomb(&pb, 0);          /* num_ref_idx_l1_default_active_minus1 */
+    put_bits(&pb, 1, 0);            /* weighted_pred_flag */
+    put_bits(&pb, 2, 0);            /* weighted_bipred_idc */
+    set_se_golomb(&pb, 0);          /* pic_init_qp_minus26 */
+    set_se_golomb(&pb, 0);          /* pic_init_qs_minus26 */
+    set_se_golomb(&pb, 0);          /* chroma_qp_index_offset */
+    put_bits(&pb, 1, 1);            /* deblocking_filter_control_present_flag */
+    put_bits(&pb, 1, 0);            /* constrained_intra_pred_flag */
+    put_bits(&pb, 1, 0);            /* redundant_pic_cnt_present_flag */
+    return write_nal(dst, 3, H264_NAL_PPS, &pb);
+}
+
+static uint8_t *write_recovery_point(uint8_t *dst)
+{
+    uint8_t rbsp[8];
+    PutBitContext pb;
+
+    init_put_bits(&pb, rbsp, sizeof(rbsp));
+    put_bits(&pb, 8, 6);            /* payloadType: recovery point */
+    put_bits(&pb, 8, 1);            /* payloadSize */
+    set_ue_golomb(&pb, 0);          /* recovery_frame_cnt */
+    put_bits(&pb, 1, 1);            /* exact_match_flag */
+    put_bits(&pb, 1, 0);            /* broken_link_flag */
+    put_bits(&pb, 2, 0);            /* changing_slice_group_idc */
+    put_bits(&pb, 3, 4);            /* payload alignment */
+    return write_nal(dst, 0, H264_NAL_SEI, &pb);
+}
+
+static uint8_t *write_slice(uint8_t *dst, const TestPicture *pic, int idx)
+{
+    uint8_t rbsp[1024];
+    PutBitContext pb;
+    int value = pic->slices[idx];
+
+    init_put_bits(&pb, rbsp, sizeof(rbsp));
+    set_ue_golomb(&pb, idx * MB_COUNT / 2);     /* first_mb_in_slice */
+    set_ue_golomb(&pb, value == SKIP ? 0 : 2);  /* slice_type: P or I */
+    set_ue_golomb(&pb, 0);                      /* pic_parameter_set_id */
+    put_bits(&pb, 4, pic->frame_num);
+    if (pic->idr)
+        set_ue_golomb(&pb, pic->frame_num);     /* idr_pic_id */
+    if (value == SKIP) {
+        put_bits(&pb, 1, 0);        /* num_ref_idx_active_override_flag */
+        put_bits(&pb, 1, 0);        /* ref_pic_list_modification_flag_l0 */
+    }
+    if (pic->idr)
+        put_bits(&pb, 2, 0);        /* no_output_of_prior_pics, long_term_reference */
+    else
+        put_bits(&pb, 1, 0);        /* adaptive_ref_pic_marking_mode_flag */
+    set_se_golomb(&pb, 0);          /* slice_qp_delta */
+    set_ue_golomb(&pb, 1);          /* disable_deblocking_filter_idc */
+
+    if (value == SKIP) {
+        set_ue_golomb(&pb, MB_COUNT / 2);       /* mb_skip_run */
+    } else {
+        for (int mb = 0; mb < MB_COUNT / 2; mb++) {
+            set_ue_golomb(&pb, 25); /* mb_type: I_PCM */
+            align_put_bits(&pb);
+            for (int i = 0; i < 256; i++)
+                put_bits(&pb, 8, value);
+            for (int i = 0; i < 2 * 64; i++)
+                put_bits(&pb, 8, 0x80);
+        }
+    }
+    return write_nal(dst, 3, pic->idr ? H264_NAL_IDR_SLICE : H264_NAL_SLICE,
+                     &pb);
+}
+
+static int check_frame(const AVFrame *frame, int n)
+{
+    if (n >= FF_ARRAY_ELEMS(expected)) {
+        fprintf(stderr, "unexpected frame %d\n", n);
+        return AVERROR_BUG;
+    }
+    for (int y = 0; y < frame->height; y++) {
+        const uint8_t *line = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; x++) {
+            if (line[x] != expected[n][y >= 16]) {
+                fprintf(stderr, "frame %d: luma %d,%d is 0x%02x instead of 0x%02x\n",
+                        n, x, y, line[x], expected[n][y >= 16]);
+                return AVERROR_BUG;
+            }
+        }
+    }
+    for (int plane = 1; plane < 3; plane++) {
+        for (int y = 0; y < frame->height / 2; y++) {
+            const uint8_t *line = frame->data[plane] + y * frame->linesize[plane];
+            for (int x = 0; x < frame->width / 2; x++) {
+                if (line[x] != 0x80) {
+                    fprintf(stderr, "frame %d: chroma %d,%d is 0x%02x\n",
+                            n, x, y, line[x]);
+                    return AVERROR_BUG;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static int receive_frames(AVCodecContext *avctx, AVFrame *frame, int *nb_frames)
+{
+    int ret;
+
+    while ((ret = avcodec_receive_frame(avctx, frame)) >= 0) {
+        ret = check_frame(frame, (*nb_frames)++);
+        av_frame_unref(frame);
+        if (ret < 0)
+            return ret;
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+int main(void)
+{
+    static uint8_t buf[BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
+    const AVCodec *codec;
+    AVCodecContext *avctx = NULL;
+    AVPacket *pkt = NULL;
+    AVFrame *frame = NULL;
+    int nb_frames = 0, ret;
+
+    av_log_set_level(AV_LOG_QUIET);
+
+    codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    avctx = avcodec_alloc_context3(codec);
+    pkt   = av_packet_alloc();
+    frame = av_frame_alloc();
+    if (!codec || !avctx || !pkt || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    av_opt_set_int(avctx->priv_data, "thumbnail", 1, 0);
+    ret = avcodec_open2(avctx, codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(test_pictures); i++) {
+        const TestPicture *pic = &test_pictures[i];
+        uint8_t *end = buf;
+
+        if (pic->idr)
+            end = write_parameter_sets(end);
+        if (pic->recovery_point)
+            end = write_recovery_point(end);
+        end = write_slice(end, pic, 0);
+        end = write_slice(end, pic, 1);
+        memset(end, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+        pkt->data = buf;
+        pkt->size = end - buf;
+        ret = avcodec_send_packet(avctx, pkt);
+        if (ret < 0)
+            goto end;
+        ret = receive_frames(avctx, frame, &nb_frames);
+        if (ret < 0)
+            goto end;
+    }
+    ret = avcodec_send_packet(avctx, NULL);
+    if (ret < 0)
+        goto end;
+    ret = receive_frames(avctx, frame, &nb_frames);
+    if (ret < 0)
+        goto end;
+
+    if (nb_frames != FF_ARRAY_ELEMS(expected)) {
+        fprintf(stderr, "%d frames instead of %d\n",
+                nb_frames, (int)FF_ARRAY_ELEMS(expected));
+        ret = AVERROR_BUG;
+    }
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "%s\n", av_err2str(ret));
+    avcodec_free_context(&avctx);
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    return !!ret;
+}
@@ -0,0 +1,175 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/defs.h"
+#include "libavcodec/h2645_parse.h"
+#include "libavcodec/startcode.h"
+
+#define BUF_SIZE 1024
+
+static uint8_t buf[BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
+
+/* mostly nonzero bytes with some single zeros and nb_pairs zero pairs;
+ * a zero pair is followed by 3 (escape) or 1 (start code) with escape_prob
+ * and start_prob out of 16 */
+static void randomize_buffer(AVLFG *lfg, int nb_pairs)
+{
+    int i;
+
+    for (i = 0; i < BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE; i++) {
+        uint8_t r = av_lfg_get(lfg);
+        buf[i] = r & 0x1f ? r : 0;
+    }
+    for (i = 0; i < nb_pairs; i++) {
+        int pos = av_lfg_get(lfg) % (BUF_SIZE - 2);
+        int r   = av_lfg_get(lfg) % 16;
+        buf[pos] = buf[pos + 1] = 0;
+        if (r < 8)
+            buf[pos + 2] = 3;
+        else if (r == 8)
+            buf[pos + 2] = 1;
+    }
+}
+
+static int find_zero_pair_ref(const uint8_t *p, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        if (!p[i] && !p[i + 1])
+            break;
+    return i;
+}
+
+static int test_zero_pair(AVLFG *lfg)
+{
+    int ret = 0;
+
+    for (int nb_pairs = 0; nb_pairs < 4; nb_pairs++) {
+        for (int size = 0; size < BUF_SIZE - 32; size += 1 + size / 8) {
+            int offset = av_lfg_get(lfg) % 32;
+            int ref, out;
+
+            randomize_buffer(lfg, nb_pairs);
+            ref = find_zero_pair_ref(buf + offset, size);
+            out = ff_startcode_find_zero_pair(buf + offset, size);
+            if (ref != out) {
+                printf("find_zero_pair(%d, %d): got %d, expected %d\n",
+                       offset, size, out, ref);
+                ret = 1;
+            }
+        }
+    }
+    /* a zero pair starting at the last position or right after it */
+    for (int size = 1; size < 100; size++) {
+        for (int last = size - 1; last <= size; last++) {
+            int out;
+
+            randomize_buffer(lfg, 0);
+            buf[last] = buf[last + 1] = 0;
+            out = ff_startcode_find_zero_pair(buf, size);
+            if (out != find_zero_pair_ref(buf, size)) {
+                printf("find_zero_pair(0, %d) with a pair at %d: got %d\n",
+                       size, last, out);
+                ret = 1;
+            }
+        }
+    }
+    return ret;
+}
+
+/* removes the emulation prevention bytes and stops at 00 00 01 or 00 00 02,
+ * returning the number of input bytes used; 00 00 00 is kept as is */
+static int extract_rbsp_ref(const uint8_t *src, int length,
+                            uint8_t *dst, int *dst_size)
+{
+    int si = 0, di = 0;
+
+    while (si + 2 < length) {
+        if (!src[si] && !src[si + 1] && src[si + 2] && src[si + 2] <= 3) {
+            if (src[si + 2] != 3)
+                break;
+            dst[di++] = 0;
+            dst[di++] = 0;
+            si += 3;
+            continue;
+        }
+        dst[di++] = src[si++];
+    }
+    if (si + 2 >= length) {
+        while (si < length)
+            dst[di++] = src[si++];
+    }
+    *dst_size = di;
+    return si;
+}
+
+static int test_extract_rbsp(AVLFG *lfg)
+{
+    uint8_t ref[BUF_SIZE];
+    H2645RBSP rbsp = { 0 };
+    int ret = 0;
+
+    rbsp.rbsp_buffer = av_mallocz(BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!rbsp.rbsp_buffer)
+        return 1;
+    rbsp.rbsp_buffer_alloc_size = BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE;
+
+    for (int nb_pairs = 0; nb_pairs < 8; nb_pairs++) {
+        for (int length = 1; length < BUF_SIZE; length += 1 + length / 4) {
+            for (int small_padding = 0; small_padding < 2; small_padding++) {
+                H2645NAL nal = { 0 };
+                int ref_size, ref_consumed, consumed;
+
+                randomize_buffer(lfg, nb_pairs);
+                rbsp.rbsp_buffer_size = 0;
+                ref_consumed = extract_rbsp_ref(buf, length, ref, &ref_size);
+                consumed = ff_h2645_extract_rbsp(buf, length, &rbsp, &nal,
+                                                 small_padding);
+                if (consumed != ref_consumed || nal.raw_size != ref_consumed ||
+                    nal.size != ref_size || memcmp(nal.data, ref, ref_size)) {
+                    printf("extract_rbsp(%d, %d pairs): consumed %d/%d, "
+                           "size %d/%d\n", length, nb_pairs, consumed,
+                           ref_consumed, nal.size, ref_size);
+                    ret = 1;
+                }
+            }
+        }
+    }
+    av_free(rbsp.rbsp_buffer);
+    return ret;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int ret;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    ret  = test_zero_pair(&lfg);
+    ret |= test_extract_rbsp(&lfg);
+    return ret;
+}
@@ -22,7 +22,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/eval.h"
 #include "libavutil/avassert.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
@@ -66,13 +66,20 @@ typedef struct OverlapIndex {
 typedef struct FIREqualizerContext {
     const AVClass *class;
 
-    RDFTContext   *analysis_rdft;
-    RDFTContext   *analysis_irdft;
-    RDFTContext   *rdft;
-    RDFTContext   *irdft;
-    FFTContext    *fft_ctx;
-    RDFTContext   *cepstrum_rdft;
-    RDFTContext   *cepstrum_irdft;
+    AVTXContext   *analysis_rdft;
+    AVTXContext   *analysis_irdft;
+    AVTXContext   *rdft;
+    AVTXContext   *irdft;
+    AVTXContext   *fft_ctx;
+    AVTXContext   *cepstrum_rdft;
+    AVTXContext   *cepstrum_irdft;
+    av_tx_fn      analysis_rdft_fn;
+    av_tx_fn      analysis_irdft_fn;
+    av_tx_fn      rdft_fn;
+    av_tx_fn      irdft_fn;
+    av_tx_fn      fft_fn;
+    av_tx_fn      cepstrum_rdft_fn;
+    av_tx_fn      cepstrum_irdft_fn;
     int           analysis_rdft_len;
     int           rdft_len;
     int           cepstrum_len;
@@ -83,6 +90,7 @@ typedef struct FIREqualizerContext {
     float         *kernel_buf;
     float         *cepstrum_buf;
     float         *conv_buf;
+    AVComplexFloat *tx_buf;
     OverlapIndex  *conv_idx;
     int           fir_len;
     int           nsamples_max;
@@ -150,17 +158,13 @@ AVFILTER_DEFINE_CLASS(firequalizer);
 
 static void common_uninit(FIREqualizerContext *s)
 {
-    av_rdft_end(s->analysis_rdft);
-    av_rdft_end(s->analysis_irdft);
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    av_fft_end(s->fft_ctx);
-    av_rdft_end(s->cepstrum_rdft);
-    av_rdft_end(s->cepstrum_irdft);
-    s->analysis_rdft = s->analysis_irdft = s->rdft = s->irdft = NULL;
-    s->fft_ctx = NULL;
-    s->cepstrum_rdft = NULL;
-    s->cepstrum_irdft = NULL;
+    av_tx_uninit(&s->analysis_rdft);
+    av_tx_uninit(&s->analysis_irdft);
+    av_tx_uninit(&s->rdft);
+    av_tx_uninit(&s->irdft);
+    av_tx_uninit(&s->fft_ctx);
+    av_tx_uninit(&s->cepstrum_rdft);
+    av_tx_uninit(&s->cepstrum_irdft);
 
     av_freep(&s->analysis_buf);
     av_freep(&s->dump_buf);
@@ -168,6 +172,7 @@ static void common_uninit(FIREqualizerContext *s)
     av_freep(&s->kernel_buf);
     av_freep(&s->cepstrum_buf);
     av_freep(&s->conv_buf);
+    av_freep(&s->tx_buf);
     av_freep(&s->conv_idx);
 }
 
@@ -180,28 +185,46 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->gain_entry_cmd);
 }
 
+/* In-place real DFTs with the packed layout the kernels are built in:
+ * buf[0] is the DC bin, buf[1] the Nyquist bin and the other bins follow as
+ * complex values. */
+static void rdft_calc(FIREqualizerContext *s, AVTXContext *tx, av_tx_fn tx_fn, float *buf, int len)
+{
+    tx_fn(tx, s->tx_buf, buf, sizeof(float));
+    buf[0] = s->tx_buf[0].re;
+    buf[1] = s->tx_buf[len/2].re;
+    memcpy(buf + 2, s->tx_buf + 1, (len - 2) * sizeof(*buf));
+}
+
+static void irdft_calc(FIREqualizerContext *s, AVTXContext *tx, av_tx_fn tx_fn, float *buf, int len)
+{
+    s->tx_buf[0]     = (AVComplexFloat){ buf[0], 0 };
+    s->tx_buf[len/2] = (AVComplexFloat){ buf[1], 0 };
+    memcpy(s->tx_buf + 1, buf + 2, (len - 2) * sizeof(*buf));
+    tx_fn(tx, buf, s->tx_buf, sizeof(AVComplexFloat));
+}
+
 static void fast_convolute(FIREqualizerContext *av_restrict s, const float *av_restrict kernel_buf, float *av_restrict conv_buf,
                            OverlapIndex *av_restrict idx, float *av_restrict data, int nsamples)
 {
     if (nsamples <= s->nsamples_max) {
         float *buf = conv_buf + idx->buf_idx * s->rdft_len;
         float *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *tx_buf = s->tx_buf;
         int center = s->fir_len/2;
         int k;
 
         memset(buf, 0, center * sizeof(*data));
         memcpy(buf + center, data, nsamples * sizeof(*data));
         memset(buf + center + nsamples, 0, (s->rdft_len - nsamples - center) * sizeof(*data));
-        av_rdft_calc(s->rdft, buf);
+        s->rdft_fn(s->rdft, tx_buf, buf, sizeof(float));
 
-        buf[0] *= kernel_buf[0];
-        buf[1] *= kernel_buf[s->rdft_len/2];
-        for (k = 1; k < s->rdft_len/2; k++) {
-            buf[2*k] *= kernel_buf[k];
-            buf[2*k+1] *= kernel_buf[k];
+        for (k = 0; k <= s->rdft_len/2; k++) {
+            tx_buf[k].re *= kernel_buf[k];
+            tx_buf[k].im *= kernel_buf[k];
         }
 
-        av_rdft_calc(s->irdft, buf);
+        s->irdft_fn(s->irdft, buf, tx_buf, sizeof(AVComplexFloat));
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++)
             buf[k] += obuf[k];
         memcpy(data, buf, nsamples * sizeof(*data));
@@ -225,23 +248,24 @@ static void fast_convolute_nonlinear(FIREqualizerContext *av_restrict s, const f
     if (nsamples <= s->nsamples_max) {
         float *buf = conv_buf + idx->buf_idx * s->rdft_len;
         float *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *tx_buf = s->tx_buf;
         int k;
 
         memcpy(buf, data, nsamples * sizeof(*data));
         memset(buf + nsamples, 0, (s->rdft_len - nsamples) * sizeof(*data));
-        av_rdft_calc(s->rdft, buf);
+        s->rdft_fn(s->rdft, tx_buf, buf, sizeof(float));
 
-        buf[0] *= kernel_buf[0];
-        buf[1] *= kernel_buf[1];
-        for (k = 2; k < s->rdft_len; k += 2) {
+        tx_buf[0].re *= kernel_buf[0];
+        tx_buf[s->rdft_len/2].re *= kernel_buf[1];
+        for (k = 1; k < s->rdft_len/2; k++) {
             float re, im;
-            re = buf[k] * kernel_buf[k] - buf[k+1] * kernel_buf[k+1];
-            im = buf[k] * kernel_buf[k+1] + buf[k+1] * kernel_buf[k];
-            buf[k] = re;
-            buf[k+1] = im;
+            re = tx_buf[k].re * kernel_buf[2*k] - tx_buf[k].im * kernel_buf[2*k+1];
+            im = tx_buf[k].re * kernel_buf[2*k+1] + tx_buf[k].im * kernel_buf[2*k];
+            tx_buf[k].re = re;
+            tx_buf[k].im = im;
         }
 
-        av_rdft_calc(s->irdft, buf);
+        s->irdft_fn(s->irdft, buf, tx_buf, sizeof(AVComplexFloat));
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++)
             buf[k] += obuf[k];
         memcpy(data, buf, nsamples * sizeof(*data));
@@ -258,12 +282,13 @@ static void fast_convolute_nonlinear(FIREqualizerContext *av_restrict s, const f
     }
 }
 
-static void fast_convolute2(FIREqualizerContext *av_restrict s, const float *av_restrict kernel_buf, FFTComplex *av_restrict conv_buf,
+static void fast_convolute2(FIREqualizerContext *av_restrict s, const float *av_restrict kernel_buf, AVComplexFloat *av_restrict conv_buf,
                             OverlapIndex *av_restrict idx, float *av_restrict data0, float *av_restrict data1, int nsamples)
 {
     if (nsamples <= s->nsamples_max) {
-        FFTComplex *buf = conv_buf + idx->buf_idx * s->rdft_len;
-        FFTComplex *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *buf = conv_buf + idx->buf_idx * s->rdft_len;
+        AVComplexFloat *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *tx_buf = s->tx_buf;
         int center = s->fir_len/2;
         int k;
         float tmp;
@@ -274,29 +299,27 @@ static void fast_convolute2(FIREqualizerContext *av_restrict s, const float *av_
             buf[center+k].im = data1[k];
         }
         memset(buf + center + nsamples, 0, (s->rdft_len - nsamples - center) * sizeof(*buf));
-        av_fft_permute(s->fft_ctx, buf);
-        av_fft_calc(s->fft_ctx, buf);
+        s->fft_fn(s->fft_ctx, tx_buf, buf, sizeof(float));
 
         /* swap re <-> im, do backward fft using forward fft_ctx */
         /* normalize with 0.5f */
-        tmp = buf[0].re;
-        buf[0].re = 0.5f * kernel_buf[0] * buf[0].im;
-        buf[0].im = 0.5f * kernel_buf[0] * tmp;
+        tmp = tx_buf[0].re;
+        tx_buf[0].re = 0.5f * kernel_buf[0] * tx_buf[0].im;
+        tx_buf[0].im = 0.5f * kernel_buf[0] * tmp;
         for (k = 1; k < s->rdft_len/2; k++) {
             int m = s->rdft_len - k;
-            tmp = buf[k].re;
-            buf[k].re = 0.5f * kernel_buf[k] * buf[k].im;
-            buf[k].im = 0.5f * kernel_buf[k] * tmp;
-            tmp = buf[m].re;
-            buf[m].re = 0.5f * kernel_buf[k] * buf[m].im;
-            buf[m].im = 0.5f * kernel_buf[k] * tmp;
+            tmp = tx_buf[k].re;
+            tx_buf[k].re = 0.5f * kernel_buf[k] * tx_buf[k].im;
+            tx_buf[k].im = 0.5f * kernel_buf[k] * tmp;
+            tmp = tx_buf[m].re;
+            tx_buf[m].re = 0.5f * kernel_buf[k] * tx_buf[m].im;
+            tx_buf[m].im = 0.5f * kernel_buf[k] * tmp;
         }
-        tmp = buf[k].re;
-        buf[k].re = 0.5f * kernel_buf[k] * buf[k].im;
-        buf[k].im = 0.5f * kernel_buf[k] * tmp;
+        tmp = tx_buf[k].re;
+        tx_buf[k].re = 0.5f * kernel_buf[k] * tx_buf[k].im;
+        tx_buf[k].im = 0.5f * kernel_buf[k] * tmp;
 
-        av_fft_permute(s->fft_ctx, buf);
-        av_fft_calc(s->fft_ctx, buf);
+        s->fft_fn(s->fft_ctx, buf, tx_buf, sizeof(float));
 
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++) {
             buf[k].re += obuf[k].re;
@@ -360,7 +383,7 @@ static void dump_fir(AVFilterContext *ctx, FILE *fp, int ch)
             fprintf(fp, "%15.10f %15.10f\n", (double)x / rate, (double) s->analysis_buf[x]);
     }
 
-    av_rdft_calc(s->analysis_rdft, s->analysis_buf);
+    rdft_calc(s, s->analysis_rdft, s->analysis_rdft_fn, s->analysis_buf, s->analysis_rdft_len);
 
     fprintf(fp, "\n\n# freq[%d] (frequency desired_gain actual_gain)\n", ch);
 
@@ -532,7 +555,7 @@ static void generate_min_phase_kernel(FIREqualizerContext *s, float *rdft_buf)
     memcpy(s->cepstrum_buf, rdft_buf, rdft_len/2 * sizeof(*rdft_buf));
     memcpy(s->cepstrum_buf + cepstrum_len - rdft_len/2, rdft_buf + rdft_len/2, rdft_len/2  * sizeof(*rdft_buf));
 
-    av_rdft_calc(s->cepstrum_rdft, s->cepstrum_buf);
+    rdft_calc(s, s->cepstrum_rdft, s->cepstrum_rdft_fn, s->cepstrum_buf, cepstrum_len);
 
     s->cepstrum_buf[0] = log(FFMAX(s->cepstrum_buf[0], minval));
     s->cepstrum_buf[1] = log(FFMAX(s->cepstrum_buf[1], minval));
@@ -542,13 +565,13 @@ static void generate_min_phase_kernel(FIREqualizerContext *s, float *rdft_buf)
         s->cepstrum_buf[k+1] = 0;
     }
 
-    av_rdft_calc(s->cepstrum_irdft, s->cepstrum_buf);
+    irdft_calc(s, s->cepstrum_irdft, s->cepstrum_irdft_fn, s->cepstrum_buf, cepstrum_len);
 
     memset(s->cepstrum_buf + cepstrum_len/2 + 1, 0, (cepstrum_len/2 - 1) * sizeof(*s->cepstrum_buf));
     for (k = 1; k < cepstrum_len/2; k++)
         s->cepstrum_buf[k] *= 2;
 
-    av_rdft_calc(s->cepstrum_rdft, s->cepstrum_buf);
+    rdft_calc(s, s->cepstrum_rdft, s->cepstrum_rdft_fn, s->cepstrum_buf, cepstrum_len);
 
     s->cepstrum_buf[0] = exp(s->cepstrum_buf[0] * norm) * norm;
     s->cepstrum_buf[1] = exp(s->cepstrum_buf[1] * norm) * norm;
@@ -559,7 +582,7 @@ static void generate_min_phase_kernel(FIREqualizerContext *s, float *rdft_buf)
         s->cepstrum_buf[k+1] = mag * sin(ph);
     }
 
-    av_rdft_calc(s->cepstrum_irdft, s->cepstrum_buf);
+    irdft_calc(s, s->cepstrum_irdft, s->cepstrum_irdft_fn, s->cepstrum_buf, cepstrum_len);
     memset(rdft_buf, 0, s->rdft_len * sizeof(*rdft_buf));
     memcpy(rdft_buf, s->cepstrum_buf, s->fir_len * sizeof(*rdft_buf));
 
@@ -639,7 +662,7 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         if (s->dump_buf)
             memcpy(s->dump_buf, s->analysis_buf, s->analysis_rdft_len * sizeof(*s->analysis_buf));
 
-        av_rdft_calc(s->analysis_irdft, s->analysis_buf);
+        irdft_calc(s, s->analysis_irdft, s->analysis_irdft_fn, s->analysis_buf, s->analysis_rdft_len);
         center = s->fir_len / 2;
 
         for (k = 0; k <= center; k++) {
@@ -689,7 +712,7 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         memcpy(rdft_buf + s->rdft_len/2, s->analysis_buf + s->analysis_rdft_len - s->rdft_len/2, s->rdft_len/2 * sizeof(*s->analysis_buf));
         if (s->min_phase)
             generate_min_phase_kernel(s, rdft_buf);
-        av_rdft_calc(s->rdft, rdft_buf);
+        rdft_calc(s, s->rdft, s->rdft_fn, rdft_buf, s->rdft_len);
 
         for (k = 0; k < s->rdft_len; k++) {
             if (isnan(rdft_buf[k]) || isinf(rdft_buf[k])) {
@@ -729,7 +752,8 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     FIREqualizerContext *s = ctx->priv;
-    int rdft_bits;
+    float scale = 1.f, iscale = 0.5f;
+    int rdft_bits, ret;
 
     common_uninit(s);
 
@@ -751,11 +775,13 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->rdft = av_rdft_init(rdft_bits, DFT_R2C)) || !(s->irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
-        return AVERROR(ENOMEM);
+    if ((ret = av_tx_init(&s->rdft, &s->rdft_fn, AV_TX_FLOAT_RDFT, 0, 1 << rdft_bits, &scale, 0)) < 0 ||
+        (ret = av_tx_init(&s->irdft, &s->irdft_fn, AV_TX_FLOAT_RDFT, 1, 1 << rdft_bits, &iscale, 0)) < 0)
+        return ret;
 
-    if (s->fft2 && !s->multi && inlink->channels > 1 && !(s->fft_ctx = av_fft_init(rdft_bits, 0)))
-        return AVERROR(ENOMEM);
+    if (s->fft2 && !s->multi && inlink->channels > 1 &&
+        (ret = av_tx_init(&s->fft_ctx, &s->fft_fn, AV_TX_FLOAT_FFT, 0, 1 << rdft_bits, &scale, 0)) < 0)
+        return ret;
 
     if (s->min_phase) {
         int cepstrum_bits = rdft_bits + 2;
@@ -765,10 +791,9 @@ static int config_input(AVFilterLink *inlink)
         }
 
         cepstrum_bits = FFMIN(RDFT_BITS_MAX, cepstrum_bits + 1);
-        s->cepstrum_rdft = av_rdft_init(cepstrum_bits, DFT_R2C);
-        s->cepstrum_irdft = av_rdft_init(cepstrum_bits, IDFT_C2R);
-        if (!s->cepstrum_rdft || !s->cepstrum_irdft)
-            return AVERROR(ENOMEM);
+        if ((ret = av_tx_init(&s->cepstrum_rdft, &s->cepstrum_rdft_fn, AV_TX_FLOAT_RDFT, 0, 1 << cepstrum_bits, &scale, 0)) < 0 ||
+            (ret = av_tx_init(&s->cepstrum_irdft, &s->cepstrum_irdft_fn, AV_TX_FLOAT_RDFT, 1, 1 << cepstrum_bits, &iscale, 0)) < 0)
+            return ret;
 
         s->cepstrum_len = 1 << cepstrum_bits;
         s->cepstrum_buf = av_malloc_array(s->cepstrum_len, sizeof(*s->cepstrum_buf));
@@ -787,11 +812,11 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->analysis_irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
-        return AVERROR(ENOMEM);
+    if ((ret = av_tx_init(&s->analysis_irdft, &s->analysis_irdft_fn, AV_TX_FLOAT_RDFT, 1, 1 << rdft_bits, &iscale, 0)) < 0)
+        return ret;
 
     if (s->dumpfile) {
-        s->analysis_rdft = av_rdft_init(rdft_bits, DFT_R2C);
+        av_tx_init(&s->analysis_rdft, &s->analysis_rdft_fn, AV_TX_FLOAT_RDFT, 0, 1 << rdft_bits, &scale, 0);
         s->dump_buf = av_malloc_array(s->analysis_rdft_len, sizeof(*s->dump_buf));
     }
 
@@ -800,7 +825,9 @@ static int config_input(AVFilterLink *inlink)
     s->kernel_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_buf));
     s->conv_buf   = av_calloc(2 * s->rdft_len * inlink->channels, sizeof(*s->conv_buf));
     s->conv_idx   = av_calloc(inlink->channels, sizeof(*s->conv_idx));
-    if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->conv_idx)
+    s->tx_buf     = av_malloc_array(FFMAX3(s->rdft_len, s->analysis_rdft_len/2 + 1, s->cepstrum_len/2 + 1),
+                                    sizeof(*s->tx_buf));
+    if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->conv_idx || !s->tx_buf)
         return AVERROR(ENOMEM);
 
     av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, rdft_len = %d, fir_len = %d, nsamples_max = %d.\n",
@@ -820,7 +847,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 
     if (!s->min_phase) {
         for (ch = 0; ch + 1 < inlink->channels && s->fft_ctx; ch += 2) {
-            fast_convolute2(s, s->kernel_buf, (FFTComplex *)(s->conv_buf + 2 * ch * s->rdft_len),
+            fast_convolute2(s, s->kernel_buf, (AVComplexFloat *)(s->conv_buf + 2 * ch * s->rdft_len),
                             s->conv_idx + ch, (float *) frame->extended_data[ch],
                             (float *) frame->extended_data[ch+1], frame->nb_samples);
         }
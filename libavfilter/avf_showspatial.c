@@ -21,12 +21,12 @@
 #include <float.h>
 #include <math.h>
 
-#include "libavcodec/avfft.h"
 #include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/tx.h"
 #include "audio.h"
 #include "video.h"
 #include "avfilter.h"
@@ -38,10 +38,11 @@ typedef struct ShowSpatialContext {
     const AVClass *class;
     int w, h;
     AVRational frame_rate;
-    FFTContext *fft[2];           ///< Fast Fourier Transform context
-    FFTContext *ifft[2];          ///< Inverse Fast Fourier Transform context
+    AVTXContext *fft[2];          ///< Fast Fourier Transform context
+    av_tx_fn tx_fn;
     int fft_bits;                 ///< number of bits (FFT window size = 1<<fft_bits)
-    FFTComplex *fft_data[2];      ///< bins holder for each (displayed) channels
+    AVComplexFloat *fft_in[2];    ///< input FFT coeffs
+    AVComplexFloat *fft_data[2];  ///< bins holder for each (displayed) channels
     float *window_func_lut;       ///< Window function LUT
     int win_func;
     int win_size;
@@ -73,11 +74,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     int i;
 
     for (i = 0; i < 2; i++)
-        av_fft_end(s->fft[i]);
-    for (i = 0; i < 2; i++)
-        av_fft_end(s->ifft[i]);
-    for (i = 0; i < 2; i++)
+        av_tx_uninit(&s->fft[i]);
+    for (i = 0; i < 2; i++) {
+        av_freep(&s->fft_in[i]);
         av_freep(&s->fft_data[i]);
+    }
     av_freep(&s->window_func_lut);
     av_audio_fifo_free(s->fifo);
 }
@@ -118,12 +119,11 @@ static int run_channel_fft(AVFilterContext *ctx, void *arg, int jobnr, int nb_jo
     const float *p = (float *)fin->extended_data[ch];
 
     for (int n = 0; n < fin->nb_samples; n++) {
-        s->fft_data[ch][n].re = p[n] * window_func_lut[n];
-        s->fft_data[ch][n].im = 0;
+        s->fft_in[ch][n].re = p[n] * window_func_lut[n];
+        s->fft_in[ch][n].im = 0;
     }
 
-    av_fft_permute(s->fft[ch], s->fft_data[ch]);
-    av_fft_calc(s->fft[ch], s->fft_data[ch]);
+    s->tx_fn(s->fft[ch], s->fft_data[ch], s->fft_in[ch], sizeof(float));
 
     return 0;
 }
@@ -133,8 +133,8 @@ static int config_output(AVFilterLink *outlink)
     AVFilterContext *ctx = outlink->src;
     AVFilterLink *inlink = ctx->inputs[0];
     ShowSpatialContext *s = ctx->priv;
-    int i, fft_bits;
-    float overlap;
+    int i, fft_bits, ret;
+    float overlap, scale = 1.f;
 
     outlink->w = s->w;
     outlink->h = s->h;
@@ -152,21 +152,23 @@ static int config_output(AVFilterLink *outlink)
          * Note: we use free and malloc instead of a realloc-like function to
          * make sure the buffer is aligned in memory for the FFT functions. */
         for (i = 0; i < 2; i++) {
-            av_fft_end(s->fft[i]);
+            av_tx_uninit(&s->fft[i]);
+            av_freep(&s->fft_in[i]);
             av_freep(&s->fft_data[i]);
         }
         for (i = 0; i < 2; i++) {
-            s->fft[i] = av_fft_init(fft_bits, 0);
-            if (!s->fft[i]) {
+            ret = av_tx_init(&s->fft[i], &s->tx_fn, AV_TX_FLOAT_FFT, 0, s->buf_size, &scale, 0);
+            if (ret < 0) {
                 av_log(ctx, AV_LOG_ERROR, "Unable to create FFT context. "
                        "The window size might be too high.\n");
-                return AVERROR(EINVAL);
+                return ret;
             }
         }
 
         for (i = 0; i < 2; i++) {
+            s->fft_in[i] = av_calloc(s->buf_size, sizeof(**s->fft_in));
             s->fft_data[i] = av_calloc(s->buf_size, sizeof(**s->fft_data));
-            if (!s->fft_data[i])
+            if (!s->fft_in[i] || !s->fft_data[i])
                 return AVERROR(ENOMEM);
         }
 
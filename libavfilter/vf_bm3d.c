@@ -35,7 +35,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "formats.h"
@@ -69,16 +69,18 @@ typedef struct PosPairCode {
 } PosPairCode;
 
 typedef struct SliceContext {
-    DCTContext *gdctf, *gdcti;
-    DCTContext *dctf, *dcti;
-    FFTSample *bufferh;
-    FFTSample *bufferv;
-    FFTSample *bufferz;
-    FFTSample *buffer;
-    FFTSample *rbufferh;
-    FFTSample *rbufferv;
-    FFTSample *rbufferz;
-    FFTSample *rbuffer;
+    AVTXContext *gdctf, *gdcti;
+    AVTXContext *dctf, *dcti;
+    av_tx_fn gdctf_fn, gdcti_fn;
+    av_tx_fn dctf_fn, dcti_fn;
+    float *bufferh;
+    float *bufferv;
+    float *bufferz;
+    float *buffer;
+    float *rbufferh;
+    float *rbufferv;
+    float *rbufferz;
+    float *rbuffer;
     float *num, *den;
     PosPairCode match_blocks[256];
     int nb_match_blocks;
@@ -408,14 +410,14 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
 
         for (i = 0; i < block_size; i++) {
             s->get_block_row(src, src_linesize, y + i, x, block_size, bufferh + block_size * i);
-            av_dct_calc(sc->dctf, bufferh + block_size * i);
+            sc->dctf_fn(sc->dctf, bufferh + block_size * i, bufferh + block_size * i, sizeof(float));
         }
 
         for (i = 0; i < block_size; i++) {
             for (j = 0; j < block_size; j++) {
                 bufferv[i * block_size + j] = bufferh[j * block_size + i];
             }
-            av_dct_calc(sc->dctf, bufferv + i * block_size);
+            sc->dctf_fn(sc->dctf, bufferv + i * block_size, bufferv + i * block_size, sizeof(float));
         }
 
         for (i = 0; i < block_size; i++) {
@@ -429,7 +431,7 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
             for (k = 0; k < nb_match_blocks; k++)
                 bufferz[k] = buffer[buffer_linesize * k + i * block_size + j];
             if (group_size > 1)
-                av_dct_calc(sc->gdctf, bufferz);
+                sc->gdctf_fn(sc->gdctf, bufferz, bufferz, sizeof(float));
             bufferz += pgroup_size;
         }
     }
@@ -460,7 +462,7 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
     for (i = 0; i < block_size; i++) {
         for (j = 0; j < block_size; j++) {
             if (group_size > 1)
-                av_dct_calc(sc->gdcti, bufferz);
+                sc->gdcti_fn(sc->gdcti, bufferz, bufferz, sizeof(float));
             for (k = 0; k < nb_match_blocks; k++) {
                 buffer[buffer_linesize * k + i * block_size + j] = bufferz[k];
             }
@@ -483,14 +485,14 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
         }
 
         for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferv + block_size * i);
+            sc->dcti_fn(sc->dcti, bufferv + block_size * i, bufferv + block_size * i, sizeof(float));
             for (j = 0; j < block_size; j++) {
                 bufferh[j * block_size + i] = bufferv[i * block_size + j];
             }
         }
 
         for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferh + block_size * i);
+            sc->dcti_fn(sc->dcti, bufferh + block_size * i, bufferh + block_size * i, sizeof(float));
             for (j = 0; j < block_size; j++) {
                 num[j] += bufferh[i * block_size + j] * num_weight;
                 den[j] += den_weight;
@@ -532,8 +534,8 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
         for (i = 0; i < block_size; i++) {
             s->get_block_row(src, src_linesize, y + i, x, block_size, bufferh + block_size * i);
             s->get_block_row(ref, ref_linesize, y + i, x, block_size, rbufferh + block_size * i);
-            av_dct_calc(sc->dctf, bufferh + block_size * i);
-            av_dct_calc(sc->dctf, rbufferh + block_size * i);
+            sc->dctf_fn(sc->dctf, bufferh + block_size * i, bufferh + block_size * i, sizeof(float));
+            sc->dctf_fn(sc->dctf, rbufferh + block_size * i, rbufferh + block_size * i, sizeof(float));
         }
 
         for (i = 0; i < block_size; i++) {
@@ -541,8 +543,8 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
                 bufferv[i * block_size + j] = bufferh[j * block_size + i];
                 rbufferv[i * block_size + j] = rbufferh[j * block_size + i];
             }
-            av_dct_calc(sc->dctf, bufferv + i * block_size);
-            av_dct_calc(sc->dctf, rbufferv + i * block_size);
+            sc->dctf_fn(sc->dctf, bufferv + i * block_size, bufferv + i * block_size, sizeof(float));
+            sc->dctf_fn(sc->dctf, rbufferv + i * block_size, rbufferv + i * block_size, sizeof(float));
         }
 
         for (i = 0; i < block_size; i++) {
@@ -560,8 +562,8 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
                 rbufferz[k] = rbuffer[buffer_linesize * k + i * block_size + j];
             }
             if (group_size > 1) {
-                av_dct_calc(sc->gdctf, bufferz);
-                av_dct_calc(sc->gdctf, rbufferz);
+                sc->gdctf_fn(sc->gdctf, bufferz, bufferz, sizeof(float));
+                sc->gdctf_fn(sc->gdctf, rbufferz, rbufferz, sizeof(float));
             }
             bufferz += pgroup_size;
             rbufferz += pgroup_size;
@@ -592,7 +594,7 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
     for (i = 0; i < block_size; i++) {
         for (j = 0; j < block_size; j++) {
             if (group_size > 1)
-                av_dct_calc(sc->gdcti, bufferz);
+                sc->gdcti_fn(sc->gdcti, bufferz, bufferz, sizeof(float));
             for (k = 0; k < nb_match_blocks; k++) {
                 buffer[buffer_linesize * k + i * block_size + j] = bufferz[k];
             }
@@ -615,14 +617,14 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
         }
 
         for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferv + block_size * i);
+            sc->dcti_fn(sc->dcti, bufferv + block_size * i, bufferv + block_size * i, sizeof(float));
             for (j = 0; j < block_size; j++) {
                 bufferh[j * block_size + i] = bufferv[i * block_size + j];
             }
         }
 
         for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferh + block_size * i);
+            sc->dcti_fn(sc->dcti, bufferh + block_size * i, bufferh + block_size * i, sizeof(float));
             for (j = 0; j < block_size; j++) {
                 num[j] += bufferh[i * block_size + j] * num_weight;
                 den[j] += den_weight;
@@ -708,8 +710,8 @@ static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
                           (((height + block_step - 1) / block_step) * (jobnr + 1) / nb_jobs) * block_step;
     int i, j;
 
-    memset(sc->num, 0, width * height * sizeof(FFTSample));
-    memset(sc->den, 0, width * height * sizeof(FFTSample));
+    memset(sc->num, 0, width * height * sizeof(float));
+    memset(sc->den, 0, width * height * sizeof(float));
 
     for (j = slice_start; j < slice_end; j += block_step) {
         if (j > block_pos_bottom) {
@@ -773,7 +775,8 @@ static int config_input(AVFilterLink *inlink)
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     AVFilterContext *ctx = inlink->dst;
     BM3DContext *s = ctx->priv;
-    int i, group_bits;
+    float scale = 1.f, iscale;
+    int i, group_bits, ret;
 
     s->nb_threads = FFMIN(ff_filter_get_nb_threads(ctx), MAX_NB_THREADS);
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
@@ -791,21 +794,31 @@ static int config_input(AVFilterLink *inlink)
     for (i = 0; i < s->nb_threads; i++) {
         SliceContext *sc = &s->slices[i];
 
-        sc->num = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(FFTSample));
-        sc->den = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(FFTSample));
+        sc->num = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(float));
+        sc->den = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(float));
         if (!sc->num || !sc->den)
             return AVERROR(ENOMEM);
 
-        sc->dctf = av_dct_init(av_log2(s->block_size), DCT_II);
-        sc->dcti = av_dct_init(av_log2(s->block_size), DCT_III);
-        if (!sc->dctf || !sc->dcti)
-            return AVERROR(ENOMEM);
+        ret = av_tx_init(&sc->dctf, &sc->dctf_fn, AV_TX_FLOAT_DCT, 0,
+                         s->block_size, &scale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
+        iscale = 2.f / s->block_size;
+        ret = av_tx_init(&sc->dcti, &sc->dcti_fn, AV_TX_FLOAT_DCT, 1,
+                         s->block_size, &iscale, AV_TX_INPLACE);
+        if (ret < 0)
+            return ret;
 
         if (s->group_bits > 1) {
-            sc->gdctf = av_dct_init(s->group_bits, DCT_II);
-            sc->gdcti = av_dct_init(s->group_bits, DCT_III);
-            if (!sc->gdctf || !sc->gdcti)
-                return AVERROR(ENOMEM);
+            ret = av_tx_init(&sc->gdctf, &sc->gdctf_fn, AV_TX_FLOAT_DCT, 0,
+                             s->pgroup_size, &scale, AV_TX_INPLACE);
+            if (ret < 0)
+                return ret;
+            iscale = 2.f / s->pgroup_size;
+            ret = av_tx_init(&sc->gdcti, &sc->gdcti_fn, AV_TX_FLOAT_DCT, 1,
+                             s->pgroup_size, &iscale, AV_TX_INPLACE);
+            if (ret < 0)
+                return ret;
         }
 
         sc->buffer = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->buffer));
@@ -1015,10 +1028,10 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&sc->num);
         av_freep(&sc->den);
 
-        av_dct_end(sc->gdctf);
-        av_dct_end(sc->gdcti);
-        av_dct_end(sc->dctf);
-        av_dct_end(sc->dcti);
+        av_tx_uninit(&sc->gdctf);
+        av_tx_uninit(&sc->gdcti);
+        av_tx_uninit(&sc->dctf);
+        av_tx_uninit(&sc->dcti);
 
         av_freep(&sc->buffer);
         av_freep(&sc->bufferh);
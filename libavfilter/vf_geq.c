@@ -61,6 +61,9 @@ typedef struct GEQContext {
 
     double *pixel_sums[NB_PLANES];
     int needs_sum[NB_PLANES];
+
+    double *xs;                 ///< X values of a row, for av_expr_eval_array()
+    double *rows;               ///< results for a row, for each thread
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -349,6 +352,15 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->vsub = desc->log2_chroma_h;
     geq->bps = desc->comp[0].depth;
     geq->planes = desc->nb_components;
+
+    av_freep(&geq->xs);
+    av_freep(&geq->rows);
+    geq->xs   = av_malloc_array(inlink->w, sizeof(*geq->xs));
+    geq->rows = av_malloc_array(inlink->w, MAX_NB_THREADS * sizeof(*geq->rows));
+    if (!geq->xs || !geq->rows)
+        return AVERROR(ENOMEM);
+    for (int x = 0; x < inlink->w; x++)
+        geq->xs[x] = x;
     return 0;
 }
 
@@ -369,9 +381,12 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    const double *const arrays[VAR_VARS_NB] = { [VAR_X] = geq->xs };
+    double *row = geq->rows + jobnr * ctx->inputs[0]->w;
+    int x, y, ret;
 
     double values[VAR_VARS_NB];
+    values[VAR_X] = 0;
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
     values[VAR_N] = geq->values[VAR_N];
@@ -384,20 +399,22 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
 
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
+            ret = av_expr_eval_array(geq->e[plane][jobnr], row, width, values, arrays, geq);
+            if (ret < 0)
+                return ret;
+            for (x = 0; x < width; x++)
+                ptr[x] = row[x];
             ptr += linesize;
         }
     } else {
         uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
+            ret = av_expr_eval_array(geq->e[plane][jobnr], row, width, values, arrays, geq);
+            if (ret < 0)
+                return ret;
+            for (x = 0; x < width; x++)
+                ptr16[x] = row[x];
             ptr16 += linesize/2;
         }
     }
@@ -465,6 +482,8 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
             av_expr_free(geq->e[i][j]);
     for (i = 0; i < NB_PLANES; i++)
         av_freep(&geq->pixel_sums);
+    av_freep(&geq->xs);
+    av_freep(&geq->rows);
 }
 
 static const AVFilterPad geq_inputs[] = {
@@ -1807,6 +1807,17 @@ typedef struct AVFormatContext {
      * @return 0 on success, a negative AVERROR code on failure
      */
     int (*io_close2)(struct AVFormatContext *s, AVIOContext *pb);
+
+    /**
+     * URL of a seek index written by avformat_index_save() to load in
+     * avformat_open_input(), or for demuxers without a header once the
+     * streams are known, at the end of avformat_find_stream_info() or on
+     * the first seek. It is ignored, with a warning, if it does not match
+     * the size and modification time of the input.
+     * - encoding: unused
+     * - decoding: set by user
+     */
+    char *seek_index_url;
 } AVFormatContext;
 
 /**
@@ -2654,6 +2665,46 @@ const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx);
 const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
                                                             int64_t wanted_timestamp,
                                                             int flags);
+
+/**
+ * Build the index of all keyframes of the input by reading it in one pass.
+ *
+ * Afterwards, seeking only uses the index, so it does not need to probe
+ * timestamps in the input, and the input is seeked back to its start.
+ * This is meant for formats without an index of their own, the index can
+ * be saved with avformat_index_save() to be reused later.
+ *
+ * @param s media file handle, the input must be seekable
+ * @return >= 0 on success, a negative AVERROR on failure
+ */
+int avformat_index_build(AVFormatContext *s);
+
+/**
+ * Write the index of all the streams of s, along with the size and, for
+ * local files, the modification time of the input.
+ *
+ * @param s  media file handle
+ * @param pb context to write the index to, e.g. a sidecar file opened with
+ *           avio_open() or a custom AVIOContext
+ * @return >= 0 on success, a negative AVERROR on failure
+ */
+int avformat_index_save(AVFormatContext *s, AVIOContext *pb);
+
+/**
+ * Add the entries of an index written by avformat_index_save() to the
+ * streams of s, and make seeking only use the index.
+ *
+ * The index is rejected if the size or modification time of the input
+ * differ from the ones it was built from. Streams that do not match the
+ * streams the index was built from are skipped, and seeking then does not
+ * rely on the index alone. For demuxers that create their streams while
+ * reading packets, this should be called after avformat_find_stream_info().
+ *
+ * @param s  media file handle, after avformat_open_input()
+ * @param pb context to read the index from
+ * @return >= 0 on success, a negative AVERROR on failure
+ */
+int avformat_index_load(AVFormatContext *s, AVIOContext *pb);
 /**
  * Add an index entry into a sorted list. Update the entry if the list
  * already contains it.
@@ -0,0 +1,458 @@
+/*
+ * Compact stream index
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/avassert.h"
+#include "libavutil/mem.h"
+
+#include "compactindex.h"
+#include "internal.h"
+
+/*
+ * Each entry is coded as 4 varints, relative to the previous entry of the
+ * same block (the first one relative to 0):
+ *  - timestamp, as the difference between this and the previous timestamp
+ *    delta, which is 0 for a constant frame rate
+ *  - position delta
+ *  - size << 2 | flags
+ *  - min_distance
+ * Signed values are zigzag coded.
+ */
+#define MAX_CODED_ENTRY_SIZE (10 + 10 + 5 + 5)
+
+struct FFCompactIndexBlock {
+    uint8_t *data;
+    unsigned int size;              ///< bytes of coded entries in data
+    unsigned int allocated_size;
+    int first_index;                ///< index of the first entry in the whole index
+    int nb_entries;
+    int64_t first_ts;
+    /* state after the last entry, used for appending */
+    uint64_t last_ts, last_ts_delta, last_pos;
+};
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = v | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, uint64_t *v)
+{
+    uint64_t x = 0;
+    int shift = 0;
+
+    do {
+        x |= (uint64_t)(*p & 0x7F) << shift;
+        shift += 7;
+    } while (*p++ & 0x80);
+    *v = x;
+    return p;
+}
+
+static uint64_t zigzag(uint64_t v)
+{
+    return (v << 1) ^ -(v >> 63);
+}
+
+static uint64_t unzigzag(uint64_t v)
+{
+    return (v >> 1) ^ -(v & 1);
+}
+
+static int resize_block(FFCompactIndex *ci, FFCompactIndexBlock *b,
+                        unsigned int size)
+{
+    uint8_t *data = av_realloc(b->data, size);
+
+    if (!data)
+        return AVERROR(ENOMEM);
+    ci->data_size    += size;
+    ci->data_size    -= b->allocated_size;
+    b->data           = data;
+    b->allocated_size = size;
+    return 0;
+}
+
+/* Code e after the last entry of b to p and update the state of b. */
+static uint8_t *code_entry(FFCompactIndexBlock *b, uint8_t *p,
+                           const AVIndexEntry *e)
+{
+    uint64_t ts_delta;
+
+    if (!b->nb_entries) {
+        b->first_ts      = e->timestamp;
+        b->last_ts       = 0;
+        b->last_ts_delta = 0;
+        b->last_pos      = 0;
+    }
+    ts_delta = (uint64_t)e->timestamp - b->last_ts;
+
+    p = put_varint(p, zigzag(ts_delta - b->last_ts_delta));
+    p = put_varint(p, zigzag((uint64_t)e->pos - b->last_pos));
+    p = put_varint(p, (uint64_t)(e->size & 0x3FFFFFFF) << 2 | (e->flags & 3));
+    p = put_varint(p, zigzag((uint64_t)(int64_t)e->min_distance));
+
+    b->last_ts       = e->timestamp;
+    b->last_ts_delta = b->nb_entries ? ts_delta : 0;
+    b->last_pos      = e->pos;
+    b->nb_entries++;
+
+    return p;
+}
+
+static int block_append(FFCompactIndex *ci, FFCompactIndexBlock *b,
+                        const AVIndexEntry *e)
+{
+    int ret;
+
+    if (b->allocated_size - b->size < MAX_CODED_ENTRY_SIZE &&
+        (ret = resize_block(ci, b, FFMAX(2 * b->allocated_size,
+                                         b->size + MAX_CODED_ENTRY_SIZE))) < 0)
+        return ret;
+    b->size = code_entry(b, b->data + b->size, e) - b->data;
+
+    /* full blocks are only ever recoded, so drop the spare space */
+    if (b->nb_entries == FF_COMPACT_INDEX_BLOCK_SIZE)
+        resize_block(ci, b, b->size);
+
+    return 0;
+}
+
+static void block_decode(const FFCompactIndexBlock *b, AVIndexEntry *entries)
+{
+    const uint8_t *p = b->data;
+    uint64_t ts = 0, ts_delta = 0, pos = 0, v;
+
+    for (int i = 0; i < b->nb_entries; i++) {
+        AVIndexEntry *const e = &entries[i];
+        uint64_t delta;
+
+        p = get_varint(p, &v);
+        delta = unzigzag(v) + ts_delta;
+        ts += delta;
+        ts_delta = i ? delta : 0;
+        p = get_varint(p, &v);
+        pos += unzigzag(v);
+        e->timestamp = ts;
+        e->pos       = pos;
+        p = get_varint(p, &v);
+        e->size  = v >> 2;
+        e->flags = v & 3;
+        p = get_varint(p, &v);
+        e->min_distance = (int64_t)unzigzag(v);
+    }
+    av_assert1(p == b->data + b->size);
+}
+
+/* Replace the entries of b, which is left untouched on failure. */
+static int block_encode(FFCompactIndex *ci, FFCompactIndexBlock *b,
+                        const AVIndexEntry *entries, int nb_entries)
+{
+    uint8_t buf[FF_COMPACT_INDEX_BLOCK_SIZE * MAX_CODED_ENTRY_SIZE], *p = buf;
+    FFCompactIndexBlock tmp = *b;
+    int ret;
+
+    av_assert1(nb_entries <= FF_COMPACT_INDEX_BLOCK_SIZE);
+
+    tmp.nb_entries = 0;
+    for (int i = 0; i < nb_entries; i++)
+        p = code_entry(&tmp, p, &entries[i]);
+    tmp.size = p - buf;
+
+    if (tmp.size != b->allocated_size &&
+        (ret = resize_block(ci, b, tmp.size)) < 0)
+        return ret;
+    memcpy(b->data, buf, tmp.size);
+    tmp.data           = b->data;
+    tmp.allocated_size = b->allocated_size;
+    *b = tmp;
+
+    return 0;
+}
+
+static void load_block(FFCompactIndex *ci, int block)
+{
+    if (ci->cache_block != block) {
+        block_decode(&ci->blocks[block], ci->cache);
+        ci->cache_block = block;
+    }
+}
+
+static FFCompactIndexBlock *insert_block(FFCompactIndex *ci, int block)
+{
+    FFCompactIndexBlock *blocks;
+
+    if ((unsigned)ci->nb_blocks + 1 >= UINT_MAX / sizeof(*blocks))
+        return NULL;
+    blocks = av_fast_realloc(ci->blocks, &ci->blocks_allocated_size,
+                             (ci->nb_blocks + 1) * sizeof(*blocks));
+    if (!blocks)
+        return NULL;
+    ci->blocks = blocks;
+
+    memmove(blocks + block + 1, blocks + block,
+            (ci->nb_blocks - block) * sizeof(*blocks));
+    memset(&blocks[block], 0, sizeof(*blocks));
+    ci->nb_blocks++;
+    if (ci->cache_block >= block)
+        ci->cache_block++;
+
+    return &blocks[block];
+}
+
+static void remove_block(FFCompactIndex *ci, int block)
+{
+    FFCompactIndexBlock *const b = &ci->blocks[block];
+
+    ci->data_size -= b->allocated_size;
+    av_free(b->data);
+    memmove(b, b + 1, (ci->nb_blocks - block - 1) * sizeof(*b));
+    ci->nb_blocks--;
+    ci->cache_block = -1;
+}
+
+/* the block containing the entry idx */
+static int find_block(const FFCompactIndex *ci, int idx)
+{
+    int a = 0, b = ci->nb_blocks - 1;
+
+    while (a < b) {
+        int m = (a + b + 1) >> 1;
+        if (ci->blocks[m].first_index <= idx)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return a;
+}
+
+/* the last block starting at or before timestamp, -1 if none */
+static int find_block_timestamp(const FFCompactIndex *ci, int64_t timestamp)
+{
+    int a = -1, b = ci->nb_blocks - 1;
+
+    while (a < b) {
+        int m = (a + b + 1) >> 1;
+        if (ci->blocks[m].first_ts <= timestamp)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return a;
+}
+
+FFCompactIndex *ff_compact_index_alloc(void)
+{
+    FFCompactIndex *ci = av_mallocz(sizeof(*ci));
+
+    if (ci)
+        ci->cache_block = -1;
+    return ci;
+}
+
+void ff_compact_index_free(FFCompactIndex **pci)
+{
+    FFCompactIndex *ci = *pci;
+
+    if (!ci)
+        return;
+    for (int i = 0; i < ci->nb_blocks; i++)
+        av_free(ci->blocks[i].data);
+    av_free(ci->blocks);
+    av_freep(pci);
+}
+
+const AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx)
+{
+    int block;
+
+    if (idx < 0 || idx >= ci->nb_entries)
+        return NULL;
+
+    if (ci->cache_block >= 0) {
+        const FFCompactIndexBlock *b = &ci->blocks[ci->cache_block];
+        if (idx >= b->first_index && idx < b->first_index + b->nb_entries)
+            return &ci->cache[idx - b->first_index];
+    }
+
+    block = find_block(ci, idx);
+    load_block(ci, block);
+    return &ci->cache[idx - ci->blocks[block].first_index];
+}
+
+int ff_compact_index_search(FFCompactIndex *ci, int64_t wanted_timestamp,
+                            int flags)
+{
+    const int nb_entries = ci->nb_entries;
+    int block, a, b, m;
+
+    block = find_block_timestamp(ci, wanted_timestamp);
+    if (block < 0) {
+        a = -1;
+        b = 0;
+    } else {
+        const FFCompactIndexBlock *blk = &ci->blocks[block];
+        int i = 0;
+
+        load_block(ci, block);
+        while (i + 1 < blk->nb_entries &&
+               ci->cache[i + 1].timestamp <= wanted_timestamp)
+            i++;
+        a = blk->first_index + i;
+        b = ci->cache[i].timestamp == wanted_timestamp ? a : a + 1;
+    }
+    m = (flags & AVSEEK_FLAG_BACKWARD) ? a : b;
+
+    if (!(flags & AVSEEK_FLAG_ANY))
+        while (m >= 0 && m < nb_entries &&
+               !(ff_compact_index_get(ci, m)->flags & AVINDEX_KEYFRAME))
+            m += (flags & AVSEEK_FLAG_BACKWARD) ? -1 : 1;
+
+    if (m == nb_entries)
+        return -1;
+    return m;
+}
+
+int ff_compact_index_add(FFCompactIndex *ci, int64_t pos, int64_t timestamp,
+                         int size, int distance, int flags)
+{
+    FFCompactIndexBlock *blk;
+    AVIndexEntry e;
+    int index, block, local, n, ret;
+
+    if ((unsigned)ci->nb_entries + 1 >= INT_MAX)
+        return -1;
+
+    if (timestamp == AV_NOPTS_VALUE)
+        return AVERROR(EINVAL);
+
+    if (size < 0 || size > 0x3FFFFFFF)
+        return AVERROR(EINVAL);
+
+    if (is_relative(timestamp)) //FIXME this maintains previous behavior but we should shift by the correct offset once known
+        timestamp -= RELATIVE_TS_BASE;
+
+    e.pos          = pos;
+    e.timestamp    = timestamp;
+    e.flags        = flags;
+    e.size         = size;
+    e.min_distance = distance;
+
+    blk = ci->nb_blocks ? &ci->blocks[ci->nb_blocks - 1] : NULL;
+    if (!blk || (int64_t)blk->last_ts < timestamp) {
+        if (!blk || blk->nb_entries >= FF_COMPACT_INDEX_BLOCK_SIZE) {
+            if (!(blk = insert_block(ci, ci->nb_blocks)))
+                return AVERROR(ENOMEM);
+            blk->first_index = ci->nb_entries;
+        }
+        if ((ret = block_append(ci, blk, &e)) < 0)
+            return ret;
+        if (ci->cache_block == ci->nb_blocks - 1)
+            ci->cache[blk->nb_entries - 1] = e;
+        return ci->nb_entries++;
+    }
+
+    index = ff_compact_index_search(ci, timestamp, AVSEEK_FLAG_ANY);
+    av_assert0(index >= 0);
+    ff_compact_index_get(ci, index);
+    block = ci->cache_block;
+    blk   = &ci->blocks[block];
+    local = index - blk->first_index;
+    n     = blk->nb_entries;
+
+    if (ci->cache[local].timestamp == timestamp) {
+        if (ci->cache[local].pos == pos && distance < ci->cache[local].min_distance)
+            // do not reduce the distance
+            e.min_distance = ci->cache[local].min_distance;
+        ci->cache[local] = e;
+        if ((ret = block_encode(ci, blk, ci->cache, n)) < 0)
+            goto fail;
+        return index;
+    }
+
+    memmove(ci->cache + local + 1, ci->cache + local,
+            (n - local) * sizeof(*ci->cache));
+    ci->cache[local] = e;
+    n++;
+
+    if (n > FF_COMPACT_INDEX_BLOCK_SIZE) {
+        /* split the block in two */
+        int half = n >> 1;
+
+        if (!insert_block(ci, block + 1)) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        ci->blocks[block + 1].first_index = ci->blocks[block].first_index + half;
+        if ((ret = block_encode(ci, &ci->blocks[block + 1],
+                                ci->cache + half, n - half)) < 0 ||
+            (ret = block_encode(ci, &ci->blocks[block], ci->cache, half)) < 0) {
+            remove_block(ci, block + 1);
+            goto fail;
+        }
+        ci->cache_block = -1;
+        block++;
+    } else if ((ret = block_encode(ci, blk, ci->cache, n)) < 0) {
+        goto fail;
+    }
+
+    for (int i = block + 1; i < ci->nb_blocks; i++)
+        ci->blocks[i].first_index++;
+    ci->nb_entries++;
+
+    return index;
+fail:
+    /* the blocks are unchanged, but not the cache */
+    ci->cache_block = -1;
+    return ret;
+}
+
+int ff_compact_index_decimate(FFCompactIndex **pci)
+{
+    FFCompactIndex *ci = *pci, *reduced = ff_compact_index_alloc();
+    int ret;
+
+    if (!reduced)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < ci->nb_entries; i += 2) {
+        const AVIndexEntry *e = ff_compact_index_get(ci, i);
+        if ((ret = ff_compact_index_add(reduced, e->pos, e->timestamp, e->size,
+                                        e->min_distance, e->flags)) < 0) {
+            ff_compact_index_free(&reduced);
+            return ret;
+        }
+    }
+
+    ff_compact_index_free(pci);
+    *pci = reduced;
+    return 0;
+}
+
+size_t ff_compact_index_memory_size(const FFCompactIndex *ci)
+{
+    return sizeof(*ci) + ci->blocks_allocated_size + ci->data_size;
+}
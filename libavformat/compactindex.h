@@ -0,0 +1,102 @@
+/*
+ * Compact stream index
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_COMPACTINDEX_H
+#define AVFORMAT_COMPACTINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avformat.h"
+
+/**
+ * Maximum number of entries in one block of a compact index.
+ */
+#define FF_COMPACT_INDEX_BLOCK_SIZE 128
+
+typedef struct FFCompactIndexBlock FFCompactIndexBlock;
+
+/**
+ * Stream index stored as blocks of delta coded entries.
+ *
+ * It holds the same entries, in the same order, as the AVIndexEntry array
+ * built by ff_add_index_entry(), in about a quarter of the memory. Lookups
+ * by timestamp or by index are O(log n), appending is O(1) and inserting in
+ * the middle only recodes one block.
+ */
+typedef struct FFCompactIndex {
+    FFCompactIndexBlock *blocks;
+    int nb_blocks;
+    unsigned int blocks_allocated_size;
+
+    int nb_entries;
+    size_t data_size;       ///< bytes allocated for the coded entries
+
+    /**
+     * Decoded entries of one block, the entries returned by
+     * ff_compact_index_get() point in there. One more than a block so that
+     * an insertion can be done before splitting it.
+     */
+    AVIndexEntry cache[FF_COMPACT_INDEX_BLOCK_SIZE + 1];
+    int cache_block;        ///< block in cache, -1 if none
+} FFCompactIndex;
+
+FFCompactIndex *ff_compact_index_alloc(void);
+
+void ff_compact_index_free(FFCompactIndex **pci);
+
+/**
+ * Add an entry, same semantics as ff_add_index_entry().
+ *
+ * @return the index of the entry or a negative value on error
+ */
+int ff_compact_index_add(FFCompactIndex *ci, int64_t pos, int64_t timestamp,
+                         int size, int distance, int flags);
+
+/**
+ * Get an entry.
+ *
+ * The returned pointer is only valid until the next call to any function
+ * taking ci.
+ *
+ * @return the entry or NULL if idx is out of range
+ */
+const AVIndexEntry *ff_compact_index_get(FFCompactIndex *ci, int idx);
+
+/**
+ * Same as ff_index_search_timestamp() on the entries of ci.
+ */
+int ff_compact_index_search(FFCompactIndex *ci, int64_t wanted_timestamp,
+                            int flags);
+
+/**
+ * Drop every other entry, as ff_reduce_index() does for the entry arrays.
+ *
+ * @return 0 on success, a negative AVERROR on failure, in which case the
+ *         index is left untouched
+ */
+int ff_compact_index_decimate(FFCompactIndex **pci);
+
+/**
+ * @return the amount of memory used by ci, in bytes
+ */
+size_t ff_compact_index_memory_size(const FFCompactIndex *ci);
+
+#endif /* AVFORMAT_COMPACTINDEX_H */
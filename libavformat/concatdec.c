@@ -24,6 +24,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/thread.h"
 #include "libavutil/timestamp.h"
 #include "libavcodec/bsf.h"
 #include "avformat.h"
@@ -36,11 +37,39 @@ typedef enum ConcatMatchMode {
     MATCH_EXACT_ID,
 } ConcatMatchMode;
 
+typedef enum ConcatPrefetchState {
+    PREFETCH_NONE,
+    PREFETCH_BUSY,  ///< being opened by a prefetch thread
+    PREFETCH_READY,
+} ConcatPrefetchState;
+
+/* maximum number of files opened in parallel */
+#define MAX_PREFETCH_THREADS 8
+
 typedef struct ConcatStream {
     AVBSFContext *bsf;
     int out_stream_index;
 } ConcatStream;
 
+typedef struct ConcatCachedStream {
+    AVCodecParameters *header; ///< parameters set by the demuxer header
+    AVCodecParameters *probed; ///< parameters after avformat_find_stream_info()
+    AVRational r_frame_rate;
+    AVRational avg_frame_rate;
+    AVPacketSideData *side_data; ///< side data exported by avformat_find_stream_info()
+    int nb_side_data;
+} ConcatCachedStream;
+
+/**
+ * Stream information of the last probed file, reused for the following
+ * files whose header has exactly the same codec parameters.
+ */
+typedef struct ConcatProbeCache {
+    const AVInputFormat *iformat;
+    ConcatCachedStream *streams;
+    int nb_streams;
+} ConcatProbeCache;
+
 typedef struct {
     char *url;
     int64_t start_time;
@@ -55,6 +84,9 @@ typedef struct {
     AVDictionary *metadata;
     AVDictionary *options;
     int nb_streams;
+    ConcatPrefetchState prefetch_state;
+    AVFormatContext *prefetched;
+    int prefetch_ret;
 } ConcatFile;
 
 typedef struct {
@@ -69,6 +101,22 @@ typedef struct {
     ConcatMatchMode stream_match_mode;
     unsigned auto_convert;
     int segment_time_metadata;
+    int prefetch;
+    int probe_cache;
+
+    ConcatProbeCache cache;
+
+#if HAVE_THREADS
+    pthread_t *prefetch_threads;
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+#endif
+    int prefetch_thread_started;
+    int nb_prefetch_threads;
+    int prefetch_exit;
+    /* files which the prefetch threads open in advance */
+    unsigned prefetch_start;
+    unsigned prefetch_end;
 } ConcatContext;
 
 static int concat_probe(const AVProbeData *probe)
@@ -329,42 +377,426 @@ static int64_t get_best_effort_duration(ConcatFile *file, AVFormatContext *avf)
     return AV_NOPTS_VALUE;
 }
 
-static int open_file(AVFormatContext *avf, unsigned fileno)
+/* The cache is shared with the prefetch threads. */
+static void lock_cache(ConcatContext *cat)
+{
+#if HAVE_THREADS
+    if (cat->prefetch_thread_started)
+        pthread_mutex_lock(&cat->prefetch_lock);
+#endif
+}
+
+static void unlock_cache(ConcatContext *cat)
+{
+#if HAVE_THREADS
+    if (cat->prefetch_thread_started)
+        pthread_mutex_unlock(&cat->prefetch_lock);
+#endif
+}
+
+static void probe_cache_free(ConcatProbeCache *cache)
+{
+    for (int i = 0; i < cache->nb_streams; i++) {
+        avcodec_parameters_free(&cache->streams[i].header);
+        avcodec_parameters_free(&cache->streams[i].probed);
+        for (int j = 0; j < cache->streams[i].nb_side_data; j++)
+            av_freep(&cache->streams[i].side_data[j].data);
+        av_freep(&cache->streams[i].side_data);
+    }
+    av_freep(&cache->streams);
+    cache->nb_streams = 0;
+    cache->iformat    = NULL;
+}
+
+/* The probed parameters are only reused if the header set every field alike. */
+static int same_header_params(const AVCodecParameters *a, const AVCodecParameters *b)
+{
+    return a->codec_type            == b->codec_type            &&
+           a->codec_id              == b->codec_id              &&
+           a->codec_tag             == b->codec_tag             &&
+           a->format                == b->format                &&
+           a->bit_rate              == b->bit_rate              &&
+           a->bits_per_coded_sample == b->bits_per_coded_sample &&
+           a->bits_per_raw_sample   == b->bits_per_raw_sample   &&
+           a->profile               == b->profile               &&
+           a->level                 == b->level                 &&
+           a->width                 == b->width                 &&
+           a->height                == b->height                &&
+           !av_cmp_q(a->sample_aspect_ratio, b->sample_aspect_ratio) &&
+           a->field_order           == b->field_order           &&
+           a->color_range           == b->color_range           &&
+           a->color_primaries       == b->color_primaries       &&
+           a->color_trc             == b->color_trc             &&
+           a->color_space           == b->color_space           &&
+           a->chroma_location       == b->chroma_location       &&
+           a->video_delay           == b->video_delay           &&
+           a->channel_layout        == b->channel_layout        &&
+           a->channels              == b->channels              &&
+           a->sample_rate           == b->sample_rate           &&
+           a->block_align           == b->block_align           &&
+           a->frame_size            == b->frame_size            &&
+           a->initial_padding       == b->initial_padding       &&
+           a->trailing_padding      == b->trailing_padding      &&
+           a->seek_preroll          == b->seek_preroll          &&
+           a->extradata_size        == b->extradata_size        &&
+           (!a->extradata_size || !memcmp(a->extradata, b->extradata, a->extradata_size));
+}
+
+/* Fill the timings which avformat_find_stream_info() would have computed. */
+static void fill_timings(AVFormatContext *ctx)
+{
+    int64_t start = INT64_MAX, end = INT64_MIN;
+
+    for (int i = 0; i < ctx->nb_streams; i++) {
+        AVStream *st = ctx->streams[i];
+        int64_t st_start;
+
+        if (st->start_time == AV_NOPTS_VALUE)
+            continue;
+        st_start = av_rescale_q(st->start_time, st->time_base, AV_TIME_BASE_Q);
+        start = FFMIN(start, st_start);
+        if (st->duration != AV_NOPTS_VALUE)
+            end = FFMAX(end, st_start + av_rescale_q(st->duration, st->time_base, AV_TIME_BASE_Q));
+    }
+    if (start == INT64_MAX)
+        return;
+    if (ctx->start_time == AV_NOPTS_VALUE)
+        ctx->start_time = start;
+    if (ctx->duration == AV_NOPTS_VALUE && end != INT64_MIN)
+        ctx->duration = end - start;
+}
+
+/**
+ * Apply the cached stream information to ctx if its header matches.
+ *
+ * @return 1 if the cache was used, 0 if ctx must be probed
+ */
+static int probe_cache_apply(ConcatProbeCache *cache, AVFormatContext *ctx)
+{
+    int i, ret;
+
+    if (cache->iformat != ctx->iformat || cache->nb_streams != ctx->nb_streams)
+        return 0;
+    for (i = 0; i < ctx->nb_streams; i++)
+        if (!same_header_params(cache->streams[i].header, ctx->streams[i]->codecpar))
+            return 0;
+
+    for (i = 0; i < ctx->nb_streams; i++) {
+        AVStream *st = ctx->streams[i];
+
+        if ((ret = avcodec_parameters_copy(st->codecpar, cache->streams[i].probed)) < 0)
+            return ret;
+        st->r_frame_rate   = cache->streams[i].r_frame_rate;
+        st->avg_frame_rate = cache->streams[i].avg_frame_rate;
+        ffstream(st)->need_context_update = 1;
+
+        for (int j = 0; j < cache->streams[i].nb_side_data; j++) {
+            const AVPacketSideData *sd = &cache->streams[i].side_data[j];
+            uint8_t *data;
+
+            if (av_stream_get_side_data(st, sd->type, NULL))
+                continue;
+            if (!(data = av_stream_new_side_data(st, sd->type, sd->size)))
+                return AVERROR(ENOMEM);
+            memcpy(data, sd->data, sd->size);
+        }
+    }
+    fill_timings(ctx);
+    return 1;
+}
+
+static int copy_side_data(ConcatCachedStream *cs, const AVStream *st)
+{
+    if (!st->nb_side_data)
+        return 0;
+    if (!(cs->side_data = av_calloc(st->nb_side_data, sizeof(*cs->side_data))))
+        return AVERROR(ENOMEM);
+    for (; cs->nb_side_data < st->nb_side_data; cs->nb_side_data++) {
+        const AVPacketSideData *sd = &st->side_data[cs->nb_side_data];
+        AVPacketSideData *dst = &cs->side_data[cs->nb_side_data];
+
+        if (!(dst->data = av_memdup(sd->data, sd->size)))
+            return AVERROR(ENOMEM);
+        dst->type = sd->type;
+        dst->size = sd->size;
+    }
+    return 0;
+}
+
+static int probe_streams(AVFormatContext *avf, AVFormatContext *ctx, const char *url)
 {
     ConcatContext *cat = avf->priv_data;
-    ConcatFile *file = &cat->files[fileno];
-    AVDictionary *options = NULL;
-    int ret;
+    ConcatProbeCache new_cache = { 0 };
+    int i, ret;
 
-    if (cat->avf)
-        avformat_close_input(&cat->avf);
+    /* streams of such files are only known after reading packets */
+    if (!cat->probe_cache || (ctx->ctx_flags & AVFMTCTX_NOHEADER) || !ctx->nb_streams)
+        return avformat_find_stream_info(ctx, NULL);
+
+    lock_cache(cat);
+    ret = probe_cache_apply(&cat->cache, ctx);
+    unlock_cache(cat);
+    if (ret) {
+        if (ret > 0)
+            av_log(avf, AV_LOG_VERBOSE, "Reusing stream information for '%s'\n", url);
+        return FFMIN(ret, 0);
+    }
 
-    cat->avf = avformat_alloc_context();
-    if (!cat->avf)
+    new_cache.iformat = ctx->iformat;
+    if (!(new_cache.streams = av_calloc(ctx->nb_streams, sizeof(*new_cache.streams))))
         return AVERROR(ENOMEM);
+    new_cache.nb_streams = ctx->nb_streams;
+    for (i = 0; i < ctx->nb_streams; i++) {
+        ConcatCachedStream *cs = &new_cache.streams[i];
+        if (!(cs->header = avcodec_parameters_alloc()) ||
+            !(cs->probed = avcodec_parameters_alloc()))
+            FAIL(AVERROR(ENOMEM));
+        if ((ret = avcodec_parameters_copy(cs->header, ctx->streams[i]->codecpar)) < 0)
+            FAIL(ret);
+    }
 
-    cat->avf->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
-    cat->avf->interrupt_callback = avf->interrupt_callback;
+    if ((ret = avformat_find_stream_info(ctx, NULL)) < 0)
+        FAIL(ret);
+    if (ctx->nb_streams != new_cache.nb_streams)
+        FAIL(0);
+    for (i = 0; i < ctx->nb_streams; i++) {
+        ConcatCachedStream *cs = &new_cache.streams[i];
+        if ((ret = avcodec_parameters_copy(cs->probed, ctx->streams[i]->codecpar)) < 0)
+            FAIL(ret);
+        cs->r_frame_rate   = ctx->streams[i]->r_frame_rate;
+        cs->avg_frame_rate = ctx->streams[i]->avg_frame_rate;
+        if ((ret = copy_side_data(cs, ctx->streams[i])) < 0)
+            FAIL(ret);
+    }
 
-    if ((ret = ff_copy_whiteblacklists(cat->avf, avf)) < 0)
-        return ret;
+    lock_cache(cat);
+    FFSWAP(ConcatProbeCache, cat->cache, new_cache);
+    unlock_cache(cat);
+    ret = 0;
 
-    ret = av_dict_copy(&options, file->options, 0);
-    if (ret < 0)
-        return ret;
+fail:
+    probe_cache_free(&new_cache);
+    return ret;
+}
+
+/* Open and probe a file; this is also called from the prefetch threads. */
+static int open_input(AVFormatContext *avf, ConcatFile *file, AVFormatContext **rctx)
+{
+    AVFormatContext *ctx;
+    AVDictionary *options = NULL;
+    int ret;
+
+    ctx = avformat_alloc_context();
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->flags |= avf->flags & ~AVFMT_FLAG_CUSTOM_IO;
+    ctx->interrupt_callback = avf->interrupt_callback;
 
-    if ((ret = avformat_open_input(&cat->avf, file->url, NULL, &options)) < 0 ||
-        (ret = avformat_find_stream_info(cat->avf, NULL)) < 0) {
+    if ((ret = ff_copy_whiteblacklists(ctx, avf)) < 0 ||
+        (ret = av_dict_copy(&options, file->options, 0)) < 0)
+        goto fail;
+
+    if ((ret = avformat_open_input(&ctx, file->url, NULL, &options)) < 0 ||
+        (ret = probe_streams(avf, ctx, file->url)) < 0) {
         av_log(avf, AV_LOG_ERROR, "Impossible to open '%s'\n", file->url);
-        av_dict_free(&options);
-        avformat_close_input(&cat->avf);
-        return ret;
+        goto fail;
     }
     if (options) {
         av_log(avf, AV_LOG_WARNING, "Unused options for '%s'.\n", file->url);
         /* TODO log unused options once we have a proper string API */
         av_dict_free(&options);
     }
+    if (file->inpoint != AV_NOPTS_VALUE) {
+       if ((ret = avformat_seek_file(ctx, -1, INT64_MIN, file->inpoint, file->inpoint, 0)) < 0)
+           goto fail;
+    }
+    *rctx = ctx;
+    return 0;
+
+fail:
+    av_dict_free(&options);
+    avformat_close_input(&ctx);
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *prefetch_thread(void *arg)
+{
+    AVFormatContext *avf = arg;
+    ConcatContext *cat = avf->priv_data;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    while (!cat->prefetch_exit) {
+        ConcatFile *file = NULL;
+        AVFormatContext *ctx = NULL;
+        unsigned i;
+        int ret;
+
+        for (i = cat->prefetch_start; i < cat->prefetch_end; i++) {
+            if (cat->files[i].prefetch_state == PREFETCH_NONE) {
+                file = &cat->files[i];
+                break;
+            }
+        }
+        if (!file) {
+            pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_lock);
+            continue;
+        }
+        file->prefetch_state = PREFETCH_BUSY;
+        pthread_mutex_unlock(&cat->prefetch_lock);
+
+        ret = open_input(avf, file, &ctx);
+
+        pthread_mutex_lock(&cat->prefetch_lock);
+        i = file - cat->files;
+        if (i < cat->prefetch_start || i >= cat->prefetch_end) {
+            /* not needed anymore after a seek */
+            file->prefetch_state = PREFETCH_NONE;
+            avformat_close_input(&ctx);
+        } else {
+            file->prefetched     = ctx;
+            file->prefetch_ret   = ret;
+            file->prefetch_state = PREFETCH_READY;
+        }
+        pthread_cond_broadcast(&cat->prefetch_cond);
+    }
+    pthread_mutex_unlock(&cat->prefetch_lock);
+    return NULL;
+}
+
+static void stop_prefetch(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+    unsigned i;
+
+    if (!cat->prefetch_thread_started)
+        return;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    cat->prefetch_exit = 1;
+    pthread_cond_broadcast(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_lock);
+    for (i = 0; i < cat->nb_prefetch_threads; i++)
+        pthread_join(cat->prefetch_threads[i], NULL);
+    av_freep(&cat->prefetch_threads);
+    cat->nb_prefetch_threads = 0;
+
+    for (i = cat->prefetch_start; i < cat->prefetch_end; i++)
+        avformat_close_input(&cat->files[i].prefetched);
+    pthread_cond_destroy(&cat->prefetch_cond);
+    pthread_mutex_destroy(&cat->prefetch_lock);
+    cat->prefetch_thread_started = 0;
+}
+
+static int start_prefetch(AVFormatContext *avf)
+{
+    ConcatContext *cat = avf->priv_data;
+    int nb_threads = FFMIN3(cat->prefetch, cat->nb_files - 1, MAX_PREFETCH_THREADS);
+    int ret;
+
+    if (!(cat->prefetch_threads = av_calloc(nb_threads, sizeof(*cat->prefetch_threads))))
+        return AVERROR(ENOMEM);
+    if ((ret = pthread_mutex_init(&cat->prefetch_lock, NULL))) {
+        av_freep(&cat->prefetch_threads);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&cat->prefetch_cond, NULL))) {
+        pthread_mutex_destroy(&cat->prefetch_lock);
+        av_freep(&cat->prefetch_threads);
+        return AVERROR(ret);
+    }
+    /* set first, the threads rely on it for locking the cache */
+    cat->prefetch_thread_started = 1;
+    for (; cat->nb_prefetch_threads < nb_threads; cat->nb_prefetch_threads++) {
+        ret = pthread_create(&cat->prefetch_threads[cat->nb_prefetch_threads],
+                             NULL, prefetch_thread, avf);
+        if (ret) {
+            av_log(avf, AV_LOG_ERROR, "Failed to start prefetch thread: %s\n",
+                   av_err2str(AVERROR(ret)));
+            stop_prefetch(avf);
+            return AVERROR(ret);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Take file fileno from the prefetch threads, if it was opened in advance,
+ * and move the prefetch window after it.
+ *
+ * @return 1 if *rctx was set, 0 if the file must be opened by the caller
+ */
+static int get_prefetched(AVFormatContext *avf, unsigned fileno, AVFormatContext **rctx)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    unsigned i, start, end;
+    int ret = 0;
+
+    if (!cat->prefetch_thread_started)
+        return 0;
+
+    pthread_mutex_lock(&cat->prefetch_lock);
+    while (file->prefetch_state == PREFETCH_BUSY)
+        pthread_cond_wait(&cat->prefetch_cond, &cat->prefetch_lock);
+    if (file->prefetch_state == PREFETCH_READY) {
+        /* a failed open is retried by the caller, the error may be transient */
+        if (file->prefetch_ret < 0)
+            av_log(avf, AV_LOG_WARNING, "Opening '%s' in advance failed, retrying\n",
+                   file->url);
+        ret = file->prefetch_ret >= 0;
+        *rctx = file->prefetched;
+        file->prefetched     = NULL;
+        file->prefetch_state = PREFETCH_NONE;
+    }
+
+    start = fileno + 1;
+    end   = start + FFMIN(cat->prefetch, cat->nb_files - start);
+    for (i = cat->prefetch_start; i < cat->prefetch_end; i++) {
+        if ((i < start || i >= end) && cat->files[i].prefetch_state == PREFETCH_READY) {
+            avformat_close_input(&cat->files[i].prefetched);
+            cat->files[i].prefetch_state = PREFETCH_NONE;
+        }
+    }
+    cat->prefetch_start = start;
+    cat->prefetch_end   = end;
+    pthread_cond_broadcast(&cat->prefetch_cond);
+    pthread_mutex_unlock(&cat->prefetch_lock);
+    return ret;
+}
+#else
+static int start_prefetch(AVFormatContext *avf)
+{
+    av_log(avf, AV_LOG_WARNING, "Prefetching requires threads, files are opened on demand\n");
+    return 0;
+}
+
+static void stop_prefetch(AVFormatContext *avf)
+{
+}
+
+static int get_prefetched(AVFormatContext *avf, unsigned fileno, AVFormatContext **rctx)
+{
+    return 0;
+}
+#endif /* HAVE_THREADS */
+
+static int open_file(AVFormatContext *avf, unsigned fileno)
+{
+    ConcatContext *cat = avf->priv_data;
+    ConcatFile *file = &cat->files[fileno];
+    int ret;
+
+    if (cat->avf)
+        avformat_close_input(&cat->avf);
+
+    ret = get_prefetched(avf, fileno, &cat->avf);
+    if (!ret)
+        ret = open_input(avf, file, &cat->avf);
+    if (ret < 0)
+        return ret;
+
     cat->cur_file = file;
     file->start_time = !fileno ? 0 :
                        cat->files[fileno - 1].start_time +
@@ -381,10 +813,6 @@ static int open_file(AVFormatContext *avf, unsigned fileno)
 
     if ((ret = match_streams(avf)) < 0)
         return ret;
-    if (file->inpoint != AV_NOPTS_VALUE) {
-       if ((ret = avformat_seek_file(cat->avf, -1, INT64_MIN, file->inpoint, file->inpoint, 0)) < 0)
-           return ret;
-    }
     return 0;
 }
 
@@ -393,6 +821,7 @@ static int concat_read_close(AVFormatContext *avf)
     ConcatContext *cat = avf->priv_data;
     unsigned i, j;
 
+    stop_prefetch(avf);
     for (i = 0; i < cat->nb_files; i++) {
         av_freep(&cat->files[i].url);
         for (j = 0; j < cat->files[i].nb_streams; j++) {
@@ -406,6 +835,7 @@ static int concat_read_close(AVFormatContext *avf)
     if (cat->avf)
         avformat_close_input(&cat->avf);
     av_freep(&cat->files);
+    probe_cache_free(&cat->cache);
     return 0;
 }
 
@@ -678,6 +1108,9 @@ static int concat_read_header(AVFormatContext *avf)
 
     cat->stream_match_mode = avf->nb_streams ? MATCH_EXACT_ID :
                                                MATCH_ONE_TO_ONE;
+    if (cat->prefetch && cat->nb_files > 1 &&
+        (ret = start_prefetch(avf)) < 0)
+        return ret;
     if ((ret = open_file(avf, 0)) < 0)
         return ret;
 
@@ -931,6 +1364,10 @@ static const AVOption options[] = {
       OFFSET(auto_convert), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, DEC },
     { "segment_time_metadata", "output file segment start time and duration as packet metadata",
       OFFSET(segment_time_metadata), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
+    { "prefetch", "number of following files to open in advance",
+      OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, DEC },
+    { "probe_cache", "reuse the stream information of files with identical codec parameters",
+      OFFSET(probe_cache), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, DEC },
     { NULL }
 };
 
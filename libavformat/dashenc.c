@@ -48,6 +48,7 @@
 #include "internal.h"
 #include "isom.h"
 #include "os_support.h"
+#include "uploadqueue.h"
 #include "url.h"
 #include "vpcc.h"
 #include "dash.h"
@@ -197,6 +198,10 @@ typedef struct DASHContext {
     AVRational min_playback_rate;
     AVRational max_playback_rate;
     int64_t update_period;
+    int async_uploads;
+    int upload_retries;
+    UploadQueue *upload_queue;
+    UploadQueueStats upload_stats;
 } DASHContext;
 
 static struct codec_string {
@@ -226,7 +231,10 @@ static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
     DASHContext *c = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
-    if (!*pb || !http_base_proto || !c->http_persistent) {
+    if (c->upload_queue) {
+        err = ff_upload_queue_open(c->upload_queue, pb, filename, options,
+                                   av_match_ext(filename, "mpd,m3u8") ? FF_UPLOAD_MANIFEST : 0);
+    } else if (!*pb || !http_base_proto || !c->http_persistent) {
         err = s->io_open(s, pb, filename, AVIO_FLAG_WRITE, options);
 #if CONFIG_HTTP_PROTOCOL
     } else {
@@ -240,14 +248,18 @@ static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
     return err;
 }
 
-static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename) {
+static int dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename) {
     DASHContext *c = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
+    int ret = 0;
 
     if (!*pb)
-        return;
+        return 0;
 
-    if (!http_base_proto || !c->http_persistent) {
+    if (c->upload_queue) {
+        ret = ff_upload_queue_close(c->upload_queue, pb);
+        ff_upload_queue_get_stats(c->upload_queue, &c->upload_stats);
+    } else if (!http_base_proto || !c->http_persistent) {
         ff_format_io_close(s, pb);
 #if CONFIG_HTTP_PROTOCOL
     } else {
@@ -257,6 +269,16 @@ static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filenam
         ffurl_shutdown(http_url_context, AVIO_FLAG_WRITE);
 #endif
     }
+    return ret;
+}
+
+/* Release *pb without completing the upload, used on error paths. */
+static void dashenc_io_free(AVFormatContext *s, AVIOContext **pb)
+{
+    DASHContext *c = s->priv_data;
+
+    if (!c->upload_queue || !ff_upload_queue_discard(c->upload_queue, pb))
+        ff_format_io_close(s, pb);
 }
 
 static const char *get_format_str(SegmentType segment_type) {
@@ -575,7 +597,9 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     if (final)
         ff_hls_write_end_list(c->m3u8_out);
 
-    dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
+    if (dashenc_io_close(s, &c->m3u8_out, temp_filename_hls) < 0)
+        av_log(os->ctx, AV_LOG_WARNING, "Failed to queue the upload of %s\n",
+               temp_filename_hls);
 
     if (use_rename)
         ff_rename(temp_filename_hls, filename_hls, os->ctx);
@@ -594,9 +618,9 @@ static int flush_init_segment(AVFormatContext *s, OutputStream *os)
     if (!c->single_file) {
         char filename[1024];
         snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-        dashenc_io_close(s, &os->out, filename);
+        ret = dashenc_io_close(s, &os->out, filename);
     }
-    return 0;
+    return ret;
 }
 
 static void dash_free(AVFormatContext *s)
@@ -613,8 +637,10 @@ static void dash_free(AVFormatContext *s)
         c->nb_as = 0;
     }
 
-    if (!c->streams)
+    if (!c->streams) {
+        ff_upload_queue_free(&c->upload_queue);
         return;
+    }
     for (i = 0; i < s->nb_streams; i++) {
         OutputStream *os = &c->streams[i];
         if (os->ctx && os->ctx->pb) {
@@ -623,7 +649,7 @@ static void dash_free(AVFormatContext *s)
             else
                 avio_close(os->ctx->pb);
         }
-        ff_format_io_close(s, &os->out);
+        dashenc_io_free(s, &os->out);
         avformat_free_context(os->ctx);
         avcodec_free_context(&os->parser_avctx);
         av_parser_close(os->parser);
@@ -636,8 +662,9 @@ static void dash_free(AVFormatContext *s)
     }
     av_freep(&c->streams);
 
-    ff_format_io_close(s, &c->mpd_out);
-    ff_format_io_close(s, &c->m3u8_out);
+    dashenc_io_free(s, &c->mpd_out);
+    dashenc_io_free(s, &c->m3u8_out);
+    ff_upload_queue_free(&c->upload_queue);
 }
 
 static void output_segment_list(OutputStream *os, AVIOContext *out, AVFormatContext *s,
@@ -1238,7 +1265,8 @@ static int write_manifest(AVFormatContext *s, int final)
 
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    dashenc_io_close(s, &c->mpd_out, temp_filename);
+    if ((ret = dashenc_io_close(s, &c->mpd_out, temp_filename)) < 0)
+        return ret;
 
     if (use_rename) {
         if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
@@ -1354,7 +1382,8 @@ static int write_manifest(AVFormatContext *s, int final)
             }
         }
 
-        dashenc_io_close(s, &c->m3u8_out, temp_filename);
+        if ((ret = dashenc_io_close(s, &c->m3u8_out, temp_filename)) < 0)
+            return ret;
         if (use_rename)
             if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
                 return ret;
@@ -1459,6 +1488,23 @@ static int dash_init(AVFormatContext *s)
         c->min_playback_rate = c->max_playback_rate = (AVRational) {1, 1};
     }
 
+    if (c->async_uploads) {
+        const char *proto = avio_find_protocol_name(s->url);
+
+        /* streaming and single files are written progressively, local files are renamed */
+        if (c->streaming || c->single_file || (proto && !strcmp(proto, "file"))) {
+            av_log(s, AV_LOG_WARNING, "async_uploads is only supported for network output "
+                   "without streaming or single_file, uploading synchronously\n");
+        } else {
+            ret = ff_upload_queue_alloc(&c->upload_queue, s, c->async_uploads,
+                                        c->upload_retries, c->http_persistent);
+            if (ret == AVERROR(ENOSYS))
+                av_log(s, AV_LOG_WARNING, "async_uploads requires threads, uploading synchronously\n");
+            else if (ret < 0)
+                return ret;
+        }
+    }
+
     av_strlcpy(c->dirname, s->url, sizeof(c->dirname));
     ptr = strrchr(c->dirname, '/');
     if (ptr) {
@@ -1584,7 +1630,7 @@ static int dash_init(AVFormatContext *s)
         if (!c->single_file) {
             if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
                 return ret;
-            ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, &opts);
+            ret = dashenc_io_open(s, &os->out, filename, &opts);
         } else {
             ctx->url = av_strdup(filename);
             ret = avio_open2(&ctx->pb, filename, AVIO_FLAG_WRITE, NULL, &opts);
@@ -1855,6 +1901,14 @@ static void dashenc_delete_file(AVFormatContext *s, char *filename) {
         AVDictionary *http_opts = NULL;
 
         set_http_options(&http_opts, c);
+        if (c->upload_queue) {
+            /* ordered after the manifest that stopped referencing filename,
+             * the hls playlists are queued before it */
+            if (ff_upload_queue_delete(c->upload_queue, filename, &http_opts, s->url) < 0)
+                av_log(s, AV_LOG_ERROR, "failed to delete %s\n", filename);
+            av_dict_free(&http_opts);
+            return;
+        }
         av_dict_set(&http_opts, "method", "DELETE", 0);
 
         if (dashenc_io_open(s, &out, filename, &http_opts) < 0) {
@@ -1965,7 +2019,9 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (c->single_file) {
             find_index_range(s, os->full_path, os->pos, &index_length);
         } else {
-            dashenc_io_close(s, &os->out, os->temp_path);
+            ret = dashenc_io_close(s, &os->out, os->temp_path);
+            if (ret < 0)
+                break;
 
             if (use_rename) {
                 ret = ff_rename(os->temp_path, os->full_path, os->ctx);
@@ -2331,6 +2387,18 @@ static int dash_write_trailer(AVFormatContext *s)
         }
     }
 
+    if (c->upload_queue) {
+        int ret = ff_upload_queue_flush(c->upload_queue);
+        ff_upload_queue_get_stats(c->upload_queue, &c->upload_stats);
+        av_log(s, AV_LOG_VERBOSE, "%"PRId64" uploads, %"PRId64" bytes, %"PRId64" failed, "
+               "average upload time %"PRId64" ms, maximum queue depth %"PRId64"\n",
+               c->upload_stats.uploads, c->upload_stats.bytes, c->upload_stats.failures,
+               c->upload_stats.uploads ? c->upload_stats.upload_time / c->upload_stats.uploads / 1000 : 0,
+               c->upload_stats.max_depth);
+        if (ret < 0 && !c->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2403,6 +2471,15 @@ static const AVOption options[] = {
     { "min_playback_rate", "Set desired minimum playback rate", OFFSET(min_playback_rate), AV_OPT_TYPE_RATIONAL, { .dbl = 1.0 }, 0.5, 1.5, E },
     { "max_playback_rate", "Set desired maximum playback rate", OFFSET(max_playback_rate), AV_OPT_TYPE_RATIONAL, { .dbl = 1.0 }, 0.5, 1.5, E },
     { "update_period", "Set the mpd update interval", OFFSET(update_period), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, E},
+    { "async_uploads", "Maximum number of segments uploaded in the background, 0 to upload synchronously", OFFSET(async_uploads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, E },
+    { "upload_retries", "Number of times a failed background upload is retried", OFFSET(upload_retries), AV_OPT_TYPE_INT, { .i64 = 3 }, 0, INT_MAX, E },
+    { "uploads_completed", "Number of completed background uploads", OFFSET(upload_stats.uploads), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_bytes", "Size of the completed background uploads", OFFSET(upload_stats.bytes), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_time", "Time spent in background uploads, in microseconds", OFFSET(upload_stats.upload_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_time_max", "Longest background upload, in microseconds", OFFSET(upload_stats.max_upload_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_failures", "Number of background uploads that failed after all retries", OFFSET(upload_stats.failures), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_queue_depth", "Number of uploads currently queued or in flight", OFFSET(upload_stats.depth), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "upload_queue_max_depth", "Highest number of uploads queued or in flight", OFFSET(upload_stats.max_depth), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
@@ -328,6 +328,16 @@ int avformat_open_input(AVFormatContext **ps, const char *filename,
     if (s->pb && !si->data_offset)
         si->data_offset = avio_tell(s->pb);
 
+    /* the index is matched against the streams, so without a header it is
+     * loaded once they are known, in avformat_find_stream_info() or on the
+     * first seek */
+    if (s->seek_index_url) {
+        if (s->ctx_flags & AVFMTCTX_NOHEADER)
+            si->seek_index_pending = 1;
+        else
+            ff_load_seek_index(s);
+    }
+
     si->raw_packet_buffer_size = 0;
 
     update_stream_avctx(s);
@@ -2927,6 +2937,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         sti->avctx_inited = 0;
     }
 
+    if (si->seek_index_pending)
+        ff_load_seek_index(ic);
+
 find_stream_info_err:
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
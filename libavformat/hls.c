@@ -34,6 +34,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "avformat.h"
 #include "internal.h"
@@ -78,10 +79,59 @@ struct segment {
     uint8_t iv[16];
     /* associated Media Initialization Section, treated as a segment */
     struct segment *init_section;
+    /* Partial Segments (EXT-X-PART) of the segment, if still listed */
+    int n_parts;
+    struct segment **parts;
+    /* the part starts with an independent frame (INDEPENDENT=YES) */
+    int independent;
 };
 
 struct rendition;
 
+enum PrefetchState {
+    PREFETCH_IDLE,
+    PREFETCH_QUEUED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE,
+};
+
+/*
+ * A prefetch worker downloads whole segments into memory on its own thread,
+ * keeping its connection open between segments when http_persistent is set.
+ * The fields from state on are protected by the prefetch_lock of the
+ * playlist.
+ */
+struct segment_prefetch {
+    struct playlist *pls;
+    /* opens the segments with an interrupt callback checking abort */
+    AVFormatContext *io_ctx;
+    AVIOContext *pb;
+    AVDictionary *avio_opts;
+    uint8_t *chunk;
+#if HAVE_THREADS
+    pthread_t thread;
+    int thread_created;
+#endif
+
+    enum PrefetchState state;
+    int abort;
+    int64_t seq_no;
+    char *url;
+    int64_t url_offset;
+    int64_t size;
+
+    uint8_t *buf;
+    unsigned int buf_size;
+    unsigned int data_len;
+    unsigned int read_offset;
+    int ret;
+
+    int64_t queue_time;
+    int64_t start_time;
+    int64_t first_byte_time;
+    int64_t end_time;
+};
+
 enum PlaylistType {
     PLS_TYPE_UNSPECIFIED,
     PLS_TYPE_EVENT,
@@ -126,6 +176,18 @@ struct playlist {
     int64_t cur_seg_offset;
     int64_t last_load_time;
 
+    /* Low-Latency HLS: Partial Segments of the segment following the last
+     * complete one, the next one announced by EXT-X-PRELOAD-HINT, and the
+     * index of the part of cur_seq_no to read next (0 reads whole segments) */
+    int64_t part_target;
+    int64_t part_hold_back;
+    int can_block_reload;
+    int n_parts;
+    struct segment **parts;
+    struct segment *preload_hint;
+    int cur_part;
+    int reading_part;
+
     /* Currently active Media Initialization Section */
     struct segment *cur_init_section;
     uint8_t *init_sec_buf;
@@ -165,6 +227,17 @@ struct playlist {
      * playlist, if any. */
     int n_init_sections;
     struct segment **init_sections;
+
+    /* Segment prefetch workers, and the one currently read from, if any. */
+    int n_prefetch;
+    struct segment_prefetch *prefetch;
+    struct segment_prefetch *prefetch_cur;
+#if HAVE_THREADS
+    pthread_mutex_t prefetch_lock;
+    pthread_cond_t prefetch_cond;
+    int prefetch_init;
+    int prefetch_quit;
+#endif
 };
 
 /*
@@ -218,6 +291,11 @@ typedef struct HLSContext {
     int http_persistent;
     int http_multiple;
     int http_seekable;
+    int prefetch_segments;
+    int low_latency;
+    int64_t segments_downloaded;
+    int64_t bytes_downloaded;
+    int64_t download_time;
     AVIOContext *playlist_pb;
     HLSCryptoContext  crypto_ctx;
 } HLSContext;
@@ -226,6 +304,8 @@ static void free_segment_dynarray(struct segment **segments, int n_segments)
 {
     int i;
     for (i = 0; i < n_segments; i++) {
+        free_segment_dynarray(segments[i]->parts, segments[i]->n_parts);
+        av_freep(&segments[i]->parts);
         av_freep(&segments[i]->key);
         av_freep(&segments[i]->url);
         av_freep(&segments[i]);
@@ -239,6 +319,15 @@ static void free_segment_list(struct playlist *pls)
     pls->n_segments = 0;
 }
 
+static void free_part_list(struct playlist *pls)
+{
+    free_segment_dynarray(pls->parts, pls->n_parts);
+    av_freep(&pls->parts);
+    pls->n_parts = 0;
+    if (pls->preload_hint)
+        free_segment_dynarray(&pls->preload_hint, 1);
+}
+
 static void free_init_section_list(struct playlist *pls)
 {
     int i;
@@ -250,15 +339,19 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void prefetch_uninit(struct playlist *pls);
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
         free_segment_list(pls);
+        free_part_list(pls);
         free_init_section_list(pls);
         av_freep(&pls->main_streams);
         av_freep(&pls->renditions);
+        prefetch_uninit(pls);
         av_freep(&pls->id3_buf);
         av_dict_free(&pls->id3_initial);
         ff_id3v2_free_extra_meta(&pls->id3_deferred_extra);
@@ -460,6 +553,107 @@ static void handle_init_section_args(struct init_section_info *info, const char
     }
 }
 
+struct part_info {
+    char uri[MAX_URL_SIZE];
+    char duration[32];
+    char byterange[32];
+    char type[16];
+    char byterange_start[32];
+    char byterange_length[32];
+    char independent[4];
+};
+
+/* Partial segment from an EXT-X-PART or EXT-X-PRELOAD-HINT tag. A byte range
+ * without offset continues the previous part of the same resource. */
+static struct segment *new_part(struct part_info *info, const char *url_base,
+                                const struct segment *prev,
+                                struct segment *init_section)
+{
+    struct segment *part;
+    char tmp_str[MAX_URL_SIZE], *ptr;
+
+    ff_make_absolute_url(tmp_str, sizeof(tmp_str), url_base, info->uri);
+    if (!tmp_str[0])
+        return NULL;
+
+    part = av_mallocz(sizeof(*part));
+    if (!part)
+        return NULL;
+    part->url = av_strdup(tmp_str);
+    if (!part->url) {
+        av_free(part);
+        return NULL;
+    }
+
+    part->duration     = atof(info->duration) * AV_TIME_BASE;
+    part->key_type     = KEY_NONE;
+    part->init_section = init_section;
+    part->size         = -1;
+    part->independent  = !strcmp(info->independent, "YES");
+    if (info->byterange[0]) {
+        part->size = strtoll(info->byterange, NULL, 10);
+        ptr = strchr(info->byterange, '@');
+        if (ptr)
+            part->url_offset = strtoll(ptr+1, NULL, 10);
+        else if (prev && prev->size >= 0 && !strcmp(prev->url, part->url))
+            part->url_offset = prev->url_offset + prev->size;
+    } else if (info->byterange_start[0] || info->byterange_length[0]) {
+        part->url_offset = strtoll(info->byterange_start, NULL, 10);
+        if (info->byterange_length[0])
+            part->size = strtoll(info->byterange_length, NULL, 10);
+    }
+
+    return part;
+}
+
+static void handle_part_args(struct part_info *info, const char *key,
+                             int key_len, char **dest, int *dest_len)
+{
+    if (!strncmp(key, "URI=", key_len)) {
+        *dest     =        info->uri;
+        *dest_len = sizeof(info->uri);
+    } else if (!strncmp(key, "DURATION=", key_len)) {
+        *dest     =        info->duration;
+        *dest_len = sizeof(info->duration);
+    } else if (!strncmp(key, "BYTERANGE=", key_len)) {
+        *dest     =        info->byterange;
+        *dest_len = sizeof(info->byterange);
+    } else if (!strncmp(key, "TYPE=", key_len)) {
+        *dest     =        info->type;
+        *dest_len = sizeof(info->type);
+    } else if (!strncmp(key, "BYTERANGE-START=", key_len)) {
+        *dest     =        info->byterange_start;
+        *dest_len = sizeof(info->byterange_start);
+    } else if (!strncmp(key, "BYTERANGE-LENGTH=", key_len)) {
+        *dest     =        info->byterange_length;
+        *dest_len = sizeof(info->byterange_length);
+    } else if (!strncmp(key, "INDEPENDENT=", key_len)) {
+        *dest     =        info->independent;
+        *dest_len = sizeof(info->independent);
+    }
+}
+
+struct server_control_info {
+    char can_block_reload[4];
+    char part_target[32];
+    char part_hold_back[32];
+};
+
+static void handle_server_control_args(struct server_control_info *info, const char *key,
+                                       int key_len, char **dest, int *dest_len)
+{
+    if (!strncmp(key, "CAN-BLOCK-RELOAD=", key_len)) {
+        *dest     =        info->can_block_reload;
+        *dest_len = sizeof(info->can_block_reload);
+    } else if (!strncmp(key, "PART-TARGET=", key_len)) {
+        *dest     =        info->part_target;
+        *dest_len = sizeof(info->part_target);
+    } else if (!strncmp(key, "PART-HOLD-BACK=", key_len)) {
+        *dest     =        info->part_hold_back;
+        *dest_len = sizeof(info->part_hold_back);
+    }
+}
+
 struct rendition_info {
     char type[16];
     char uri[MAX_URL_SIZE];
@@ -628,8 +822,11 @@ static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
 #endif
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+/* Open url through the io_open callback of io_ctx, which is s unless the
+ * url is read by a prefetch worker. */
+static int open_url_io(AVFormatContext *s, AVFormatContext *io_ctx,
+                       AVIOContext **pb, const char *url, AVDictionary **opts,
+                       AVDictionary *opts2, int *is_http_out)
 {
     HLSContext *c = s->priv_data;
     AVDictionary *tmp = NULL;
@@ -680,7 +877,7 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     av_dict_copy(&tmp, opts2, 0);
 
     if (is_http && c->http_persistent && *pb) {
-        ret = open_url_keepalive(c->ctx, pb, url, &tmp);
+        ret = open_url_keepalive(io_ctx, pb, url, &tmp);
         if (ret == AVERROR_EXIT) {
             av_dict_free(&tmp);
             return ret;
@@ -691,10 +888,10 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
                     url, av_err2str(ret));
             av_dict_copy(&tmp, *opts, 0);
             av_dict_copy(&tmp, opts2, 0);
-            ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+            ret = io_ctx->io_open(io_ctx, pb, url, AVIO_FLAG_READ, &tmp);
         }
     } else {
-        ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+        ret = io_ctx->io_open(io_ctx, pb, url, AVIO_FLAG_READ, &tmp);
     }
     if (ret >= 0) {
         // update cookies on http response with setcookies.
@@ -715,6 +912,12 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     return ret;
 }
 
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+{
+    return open_url_io(s, s, pb, url, opts, opts2, is_http_out);
+}
+
 static int parse_playlist(HLSContext *c, const char *url,
                           struct playlist *pls, AVIOContext *in)
 {
@@ -737,6 +940,8 @@ static int parse_playlist(HLSContext *c, const char *url,
     struct segment **prev_segments = NULL;
     int prev_n_segments = 0;
     int64_t prev_start_seq_no = -1;
+    struct segment **parts = NULL;
+    int n_parts = 0;
 
     if (is_http && !in && c->http_persistent && c->playlist_pb) {
         in = c->playlist_pb;
@@ -785,9 +990,13 @@ static int parse_playlist(HLSContext *c, const char *url,
         prev_n_segments = pls->n_segments;
         pls->segments = NULL;
         pls->n_segments = 0;
+        free_part_list(pls);
 
         pls->finished = 0;
         pls->type = PLS_TYPE_UNSPECIFIED;
+        pls->part_target = 0;
+        pls->part_hold_back = 0;
+        pls->can_block_reload = 0;
     }
     while (!avio_feof(in)) {
         ff_get_chomp_line(in, line, sizeof(line));
@@ -879,6 +1088,46 @@ static int parse_playlist(HLSContext *c, const char *url,
                 cur_init_section->key = NULL;
             }
 
+        } else if (c->low_latency && (av_strstart(line, "#EXT-X-PART-INF:", &ptr) ||
+                                      av_strstart(line, "#EXT-X-SERVER-CONTROL:", &ptr))) {
+            struct server_control_info info = {{0}};
+            ret = ensure_playlist(c, &pls, url);
+            if (ret < 0)
+                goto fail;
+            ff_parse_key_value(ptr, (ff_parse_key_val_cb) handle_server_control_args,
+                               &info);
+            if (info.part_target[0])
+                pls->part_target = atof(info.part_target) * AV_TIME_BASE;
+            if (info.part_hold_back[0])
+                pls->part_hold_back = atof(info.part_hold_back) * AV_TIME_BASE;
+            if (!strcmp(info.can_block_reload, "YES"))
+                pls->can_block_reload = 1;
+        } else if (c->low_latency && (av_strstart(line, "#EXT-X-PART:", &ptr) ||
+                                      av_strstart(line, "#EXT-X-PRELOAD-HINT:", &ptr))) {
+            struct part_info info = {{0}};
+            int is_hint = av_strstart(line, "#EXT-X-PRELOAD-HINT:", NULL);
+            struct segment *part;
+            ret = ensure_playlist(c, &pls, url);
+            if (ret < 0)
+                goto fail;
+            ff_parse_key_value(ptr, (ff_parse_key_val_cb) handle_part_args,
+                               &info);
+            /* parts of encrypted segments are not read, the whole segments are */
+            if (!info.uri[0] || key_type != KEY_NONE ||
+                (is_hint && (strcmp(info.type, "PART") || pls->preload_hint)))
+                continue;
+            part = new_part(&info, url, n_parts ? parts[n_parts - 1] : NULL,
+                            cur_init_section);
+            if (!part) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+            if (is_hint) {
+                part->duration = pls->part_target;
+                pls->preload_hint = part;
+            } else {
+                dynarray_add(&parts, &n_parts, part);
+            }
         } else if (av_strstart(line, "#EXT-X-ENDLIST", &ptr)) {
             if (pls)
                 pls->finished = 1;
@@ -959,6 +1208,10 @@ static int parse_playlist(HLSContext *c, const char *url,
                 }
                 seg->duration = duration;
                 seg->key_type = key_type;
+                seg->parts    = parts;
+                seg->n_parts  = n_parts;
+                parts   = NULL;
+                n_parts = 0;
                 dynarray_add(&pls->segments, &pls->n_segments, seg);
                 is_segment = 0;
 
@@ -995,10 +1248,17 @@ static int parse_playlist(HLSContext *c, const char *url,
         free_segment_dynarray(prev_segments, prev_n_segments);
         av_freep(&prev_segments);
     }
-    if (pls)
+    if (pls) {
+        pls->parts   = parts;
+        pls->n_parts = n_parts;
+        parts   = NULL;
+        n_parts = 0;
         pls->last_load_time = av_gettime_relative();
+    }
 
 fail:
+    free_segment_dynarray(parts, n_parts);
+    av_free(parts);
     av_free(new_url);
     if (close_in)
         ff_format_io_close(c->ctx, &in);
@@ -1026,6 +1286,40 @@ static struct segment *next_segment(struct playlist *pls)
     return pls->segments[n];
 }
 
+/* Partial segment to read next, if the current segment is read part by part:
+ * either a segment whose first parts were read at the live edge before it was
+ * complete, or the segment still being produced. */
+static struct segment *current_part(struct playlist *pls)
+{
+    struct segment *seg = current_segment(pls);
+
+    if (seg)
+        return pls->cur_part && pls->cur_part < seg->n_parts ?
+               seg->parts[pls->cur_part] : NULL;
+    if (pls->cur_seq_no != pls->start_seq_no + pls->n_segments)
+        return NULL;
+    if (pls->cur_part < pls->n_parts)
+        return pls->parts[pls->cur_part];
+    /* a server that supports blocking reloads also holds requests for the
+     * hinted part until it is available */
+    if (pls->cur_part == pls->n_parts && pls->can_block_reload)
+        return pls->preload_hint;
+    return NULL;
+}
+
+/* Playlist URL asking the server to hold the response until the playlist
+ * contains the segment or part following the last listed one. */
+static char *blocking_reload_url(struct playlist *pls)
+{
+    int64_t msn = pls->start_seq_no + pls->n_segments;
+    const char *sep = strchr(pls->url, '?') ? "&" : "?";
+
+    if (pls->part_target > 0)
+        return av_asprintf("%s%s_HLS_msn=%"PRId64"&_HLS_part=%d",
+                           pls->url, sep, msn, pls->n_parts);
+    return av_asprintf("%s%s_HLS_msn=%"PRId64, pls->url, sep, msn);
+}
+
 static int read_from_url(struct playlist *pls, struct segment *seg,
                          uint8_t *buf, int buf_size)
 {
@@ -1326,6 +1620,414 @@ cleanup:
     return ret;
 }
 
+#if HAVE_THREADS
+#define PREFETCH_CHUNK_SIZE 65536
+
+/* Download the segment of w into w->buf, called without the lock held. */
+static int prefetch_download(struct segment_prefetch *w)
+{
+    struct playlist *pls = w->pls;
+    HLSContext *c = pls->parent->priv_data;
+    AVDictionary *opts = NULL;
+    int64_t remaining = w->size;
+    int is_http = 0, ret;
+
+    if (c->http_persistent)
+        av_dict_set(&opts, "multiple_requests", "1", 0);
+    if (w->size >= 0) {
+        av_dict_set_int(&opts, "offset", w->url_offset, 0);
+        av_dict_set_int(&opts, "end_offset", w->url_offset + w->size, 0);
+    }
+
+    /* only kept http connections can be reused */
+    if (w->pb && !av_strstart(w->url, "http", NULL))
+        ff_format_io_close(w->io_ctx, &w->pb);
+
+    ret = open_url_io(pls->parent, w->io_ctx, &w->pb, w->url, &w->avio_opts,
+                      opts, &is_http);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+    if (!is_http && w->url_offset) {
+        int64_t seekret = avio_seek(w->pb, w->url_offset, SEEK_SET);
+        if (seekret < 0) {
+            ret = seekret;
+            goto end;
+        }
+    }
+
+    while (remaining) {
+        int size = remaining > 0 ? FFMIN(remaining, PREFETCH_CHUNK_SIZE) : PREFETCH_CHUNK_SIZE;
+        uint8_t *buf;
+
+        size = avio_read(w->pb, w->chunk, size);
+        if (size <= 0) {
+            ret = size == AVERROR_EOF ? 0 : size;
+            break;
+        }
+        if (remaining > 0)
+            remaining -= size;
+
+        pthread_mutex_lock(&pls->prefetch_lock);
+        if (w->abort) {
+            ret = AVERROR_EXIT;
+        } else if (w->data_len > UINT_MAX - size ||
+                   !(buf = av_fast_realloc(w->buf, &w->buf_size, w->data_len + size))) {
+            ret = AVERROR(ENOMEM);
+        } else {
+            w->buf = buf;
+            memcpy(w->buf + w->data_len, w->chunk, size);
+            if (!w->data_len)
+                w->first_byte_time = av_gettime_relative();
+            w->data_len += size;
+            pthread_cond_broadcast(&pls->prefetch_cond);
+        }
+        pthread_mutex_unlock(&pls->prefetch_lock);
+        if (ret < 0)
+            break;
+    }
+
+end:
+    if (ret < 0 || !is_http || !c->http_persistent)
+        ff_format_io_close(w->io_ctx, &w->pb);
+    return ret;
+}
+
+/* Interrupts the download of a worker as soon as it is aborted, instead of
+ * when its current read returns. */
+static int prefetch_interrupt(void *opaque)
+{
+    struct segment_prefetch *w = opaque;
+    struct playlist *pls = w->pls;
+    int abort;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    abort = w->abort;
+    pthread_mutex_unlock(&pls->prefetch_lock);
+    return abort || ff_check_interrupt(&pls->parent->interrupt_callback);
+}
+
+static int prefetch_alloc_io_ctx(struct segment_prefetch *w)
+{
+    AVFormatContext *s = w->pls->parent;
+    AVFormatContext *io_ctx = avformat_alloc_context();
+
+    if (!io_ctx)
+        return AVERROR(ENOMEM);
+    w->io_ctx = io_ctx;
+    io_ctx->io_open   = s->io_open;
+    io_ctx->io_close  = s->io_close;
+    io_ctx->io_close2 = s->io_close2;
+    io_ctx->opaque    = s->opaque;
+    io_ctx->interrupt_callback.callback = prefetch_interrupt;
+    io_ctx->interrupt_callback.opaque   = w;
+    if (!(io_ctx->url = av_strdup(s->url)))
+        return AVERROR(ENOMEM);
+    if (s->protocol_whitelist &&
+        !(io_ctx->protocol_whitelist = av_strdup(s->protocol_whitelist)))
+        return AVERROR(ENOMEM);
+    if (s->protocol_blacklist &&
+        !(io_ctx->protocol_blacklist = av_strdup(s->protocol_blacklist)))
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    struct segment_prefetch *w = arg;
+    struct playlist *pls = w->pls;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    for (;;) {
+        int ret;
+
+        while (!pls->prefetch_quit && w->state != PREFETCH_QUEUED)
+            pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+        if (pls->prefetch_quit)
+            break;
+
+        w->state      = PREFETCH_RUNNING;
+        w->start_time = av_gettime_relative();
+        pthread_mutex_unlock(&pls->prefetch_lock);
+
+        ret = prefetch_download(w);
+
+        pthread_mutex_lock(&pls->prefetch_lock);
+        w->ret      = ret;
+        w->end_time = av_gettime_relative();
+        w->state    = PREFETCH_DONE;
+        pthread_cond_broadcast(&pls->prefetch_cond);
+    }
+    pthread_mutex_unlock(&pls->prefetch_lock);
+
+    ff_format_io_close(w->io_ctx, &w->pb);
+    return NULL;
+}
+
+static int prefetch_init(HLSContext *c, struct playlist *pls)
+{
+    int ret;
+
+    if (pthread_mutex_init(&pls->prefetch_lock, NULL))
+        return AVERROR(ENOMEM);
+    if (pthread_cond_init(&pls->prefetch_cond, NULL)) {
+        pthread_mutex_destroy(&pls->prefetch_lock);
+        return AVERROR(ENOMEM);
+    }
+    pls->prefetch_init = 1;
+    pls->prefetch = av_calloc(c->prefetch_segments, sizeof(*pls->prefetch));
+    if (!pls->prefetch) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    pls->n_prefetch = c->prefetch_segments;
+
+    for (int i = 0; i < pls->n_prefetch; i++) {
+        struct segment_prefetch *w = &pls->prefetch[i];
+
+        w->pls   = pls;
+        w->chunk = av_malloc(PREFETCH_CHUNK_SIZE);
+        if (!w->chunk || av_dict_copy(&w->avio_opts, c->avio_opts, 0) < 0) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = prefetch_alloc_io_ctx(w)) < 0)
+            goto fail;
+        if ((ret = pthread_create(&w->thread, NULL, prefetch_worker, w))) {
+            ret = AVERROR(ret);
+            goto fail;
+        }
+        w->thread_created = 1;
+    }
+    return 0;
+
+fail:
+    prefetch_uninit(pls);
+    return ret;
+}
+
+static void prefetch_uninit(struct playlist *pls)
+{
+    if (!pls->prefetch_init)
+        return;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    pls->prefetch_quit = 1;
+    for (int i = 0; i < pls->n_prefetch; i++)
+        pls->prefetch[i].abort = 1;
+    pthread_cond_broadcast(&pls->prefetch_cond);
+    pthread_mutex_unlock(&pls->prefetch_lock);
+
+    for (int i = 0; i < pls->n_prefetch; i++) {
+        struct segment_prefetch *w = &pls->prefetch[i];
+        if (w->thread_created)
+            pthread_join(w->thread, NULL);
+        av_freep(&w->chunk);
+        av_freep(&w->url);
+        av_freep(&w->buf);
+        av_dict_free(&w->avio_opts);
+        avformat_free_context(w->io_ctx);
+    }
+    av_freep(&pls->prefetch);
+    pls->n_prefetch   = 0;
+    pls->prefetch_cur = NULL;
+    pthread_cond_destroy(&pls->prefetch_cond);
+    pthread_mutex_destroy(&pls->prefetch_lock);
+    pls->prefetch_init = 0;
+}
+
+/* Queue the segments following the current one on idle workers, called
+ * with the lock held. Encrypted segments are left to read_data(), as their
+ * key is part of the playlist state. */
+static void prefetch_schedule(struct playlist *pls)
+{
+    int64_t end = FFMIN(pls->cur_seq_no + pls->n_prefetch,
+                        pls->start_seq_no + pls->n_segments);
+
+    for (int64_t seq_no = FFMAX(pls->cur_seq_no, pls->start_seq_no); seq_no < end; seq_no++) {
+        struct segment *seg = pls->segments[seq_no - pls->start_seq_no];
+        struct segment_prefetch *w = NULL;
+        char *url;
+        int i;
+
+        if (seg->key_type != KEY_NONE)
+            continue;
+        for (i = 0; i < pls->n_prefetch; i++)
+            if (pls->prefetch[i].state != PREFETCH_IDLE &&
+                pls->prefetch[i].seq_no == seq_no)
+                break;
+        if (i < pls->n_prefetch)
+            continue;
+
+        /* idle workers, or finished ones with a segment that was skipped */
+        for (i = 0; i < pls->n_prefetch && !w; i++) {
+            struct segment_prefetch *p = &pls->prefetch[i];
+            if (p->state == PREFETCH_IDLE ||
+                (p->state == PREFETCH_DONE && p->seq_no < pls->cur_seq_no &&
+                 p != pls->prefetch_cur))
+                w = p;
+        }
+        if (!w || !(url = av_strdup(seg->url)))
+            break;
+
+        av_free(w->url);
+        w->url         = url;
+        w->seq_no      = seq_no;
+        w->url_offset  = seg->url_offset;
+        w->size        = seg->size;
+        w->data_len    = 0;
+        w->read_offset = 0;
+        w->ret         = 0;
+        w->abort       = 0;
+        w->queue_time  = av_gettime_relative();
+        w->state       = PREFETCH_QUEUED;
+    }
+    pthread_cond_broadcast(&pls->prefetch_cond);
+}
+
+/**
+ * Start reading the current segment from a prefetch worker.
+ *
+ * @return 1 if the segment is read from a worker, 0 if it is not prefetched
+ *         and has to be opened by the caller, a negative AVERROR if its
+ *         download failed
+ */
+static int prefetch_open(HLSContext *c, struct playlist *pls)
+{
+    struct segment_prefetch *w = NULL;
+    int ret;
+
+    if (!c->prefetch_segments)
+        return 0;
+    if (!pls->prefetch_init && (ret = prefetch_init(c, pls)) < 0) {
+        av_log(pls->parent, AV_LOG_WARNING,
+               "Failed to start segment prefetching: %s\n", av_err2str(ret));
+        c->prefetch_segments = 0;
+        return 0;
+    }
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    prefetch_schedule(pls);
+    for (int i = 0; i < pls->n_prefetch; i++)
+        if (pls->prefetch[i].state != PREFETCH_IDLE &&
+            pls->prefetch[i].seq_no == pls->cur_seq_no)
+            w = &pls->prefetch[i];
+    if (!w) {
+        pthread_mutex_unlock(&pls->prefetch_lock);
+        return 0;
+    }
+
+    while (w->state != PREFETCH_DONE && !w->data_len)
+        pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+    if (!w->data_len && w->ret < 0) {
+        ret = w->ret;
+        w->state = PREFETCH_IDLE;
+        pthread_mutex_unlock(&pls->prefetch_lock);
+        return ret;
+    }
+    pls->prefetch_cur = w;
+    pthread_mutex_unlock(&pls->prefetch_lock);
+
+    return 1;
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    struct segment_prefetch *w = pls->prefetch_cur;
+    int size;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    while (w->read_offset == w->data_len && w->state != PREFETCH_DONE)
+        pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+    size = FFMIN(w->data_len - w->read_offset, buf_size);
+    memcpy(buf, w->buf + w->read_offset, size);
+    w->read_offset += size;
+    pthread_mutex_unlock(&pls->prefetch_lock);
+
+    return size ? size : AVERROR_EOF;
+}
+
+/* Give back the worker of the segment that was read entirely. */
+static void prefetch_release(HLSContext *c, struct playlist *pls)
+{
+    struct segment_prefetch *w = pls->prefetch_cur;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    if (w->ret < 0) {
+        av_log(pls->parent, AV_LOG_WARNING,
+               "Failed to download segment %"PRId64" of playlist %d: %s\n",
+               w->seq_no, pls->index, av_err2str(w->ret));
+    } else {
+        av_log(pls->parent, AV_LOG_VERBOSE,
+               "Segment %"PRId64" of playlist %d: %u bytes, queued for %.3fs, "
+               "first byte after %.3fs, downloaded in %.3fs\n",
+               w->seq_no, pls->index, w->data_len,
+               (w->start_time - w->queue_time) / 1000000.0,
+               w->data_len ? (w->first_byte_time - w->start_time) / 1000000.0 : 0,
+               (w->end_time - w->start_time) / 1000000.0);
+        c->segments_downloaded++;
+        c->bytes_downloaded += w->data_len;
+        c->download_time    += w->end_time - w->start_time;
+    }
+    w->state = PREFETCH_IDLE;
+    pls->prefetch_cur = NULL;
+    pthread_mutex_unlock(&pls->prefetch_lock);
+}
+
+/* Drop all the prefetched segments, e.g. on seeks. */
+static void prefetch_reset(struct playlist *pls)
+{
+    int running;
+
+    if (!pls->prefetch_init)
+        return;
+
+    pthread_mutex_lock(&pls->prefetch_lock);
+    do {
+        running = 0;
+        for (int i = 0; i < pls->n_prefetch; i++) {
+            struct segment_prefetch *w = &pls->prefetch[i];
+            if (w->state == PREFETCH_RUNNING) {
+                w->abort = 1;
+                running  = 1;
+            } else {
+                w->state = PREFETCH_IDLE;
+            }
+        }
+        if (running)
+            pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_lock);
+    } while (running);
+    pls->prefetch_cur = NULL;
+    pthread_mutex_unlock(&pls->prefetch_lock);
+}
+#else
+static void prefetch_uninit(struct playlist *pls)
+{
+}
+
+static int prefetch_open(HLSContext *c, struct playlist *pls)
+{
+    if (c->prefetch_segments) {
+        av_log(pls->parent, AV_LOG_WARNING, "Segment prefetching requires threads\n");
+        c->prefetch_segments = 0;
+    }
+    return 0;
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    return AVERROR_BUG;
+}
+
+static void prefetch_release(HLSContext *c, struct playlist *pls)
+{
+}
+
+static void prefetch_reset(struct playlist *pls)
+{
+}
+#endif /* HAVE_THREADS */
+
 static int update_init_section(struct playlist *pls, struct segment *seg)
 {
     static const int max_init_section_size = 1024*1024;
@@ -1337,6 +2039,15 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
     if (seg->init_section == pls->cur_init_section)
         return 0;
 
+    /* playlist reloads create new sections for the same resource */
+    if (seg->init_section && pls->cur_init_section &&
+        !strcmp(seg->init_section->url, pls->cur_init_section->url) &&
+        seg->init_section->url_offset == pls->cur_init_section->url_offset &&
+        seg->init_section->size       == pls->cur_init_section->size) {
+        pls->cur_init_section = seg->init_section;
+        return 0;
+    }
+
     pls->cur_init_section = NULL;
 
     if (!seg->init_section)
@@ -1385,6 +2096,8 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
 
 static int64_t default_reload_interval(struct playlist *pls)
 {
+    if (pls->part_target > 0)
+        return pls->part_target;
     return pls->n_segments > 0 ?
                           pls->segments[pls->n_segments - 1]->duration :
                           pls->target_duration;
@@ -1443,13 +2156,15 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     int ret;
     int just_opened = 0;
     int reload_count = 0;
-    struct segment *seg;
+    int block_reload = 0;
+    struct segment *seg, *part;
 
 restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if (!v->prefetch_cur &&
+        (!v->input || (c->http_persistent && v->input_read_done))) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1472,7 +2187,12 @@ reload:
             return AVERROR_EOF;
         if (!v->finished &&
             av_gettime_relative() - v->last_load_time >= reload_interval) {
-            if ((ret = parse_playlist(c, v->url, v, NULL)) < 0) {
+            char *url = NULL;
+            if (block_reload && !(url = blocking_reload_url(v)))
+                return AVERROR(ENOMEM);
+            ret = parse_playlist(c, url ? url : v->url, v, NULL);
+            av_free(url);
+            if (ret < 0) {
                 if (ret != AVERROR_EXIT)
                     av_log(v->parent, AV_LOG_WARNING, "Failed to reload playlist %d\n",
                            v->index);
@@ -1480,14 +2200,16 @@ reload:
             }
             /* If we need to reload the playlist again below (if
              * there's still no more segments), switch to a reload
-             * interval of half the target duration. */
-            reload_interval = v->target_duration / 2;
+             * interval of half the target duration, or of half the
+             * part target duration for low-latency playlists. */
+            reload_interval = (v->part_target > 0 ? v->part_target : v->target_duration) / 2;
         }
         if (v->cur_seq_no < v->start_seq_no) {
             av_log(v->parent, AV_LOG_WARNING,
                    "skipping %"PRId64" segments ahead, expired from playlists\n",
                    v->start_seq_no - v->cur_seq_no);
             v->cur_seq_no = v->start_seq_no;
+            v->cur_part   = 0;
         }
         if (v->cur_seq_no > v->last_seq_no) {
             v->last_seq_no = v->cur_seq_no;
@@ -1500,9 +2222,27 @@ reload:
         } else {
             av_log(v->parent, AV_LOG_WARNING, "maybe the m3u8 list sequence have been wraped.\n");
         }
-        if (v->cur_seq_no >= v->start_seq_no + v->n_segments) {
+        seg = current_segment(v);
+        if (seg && v->cur_part && v->cur_part >= seg->n_parts) {
+            /* the segment was completed while reading it part by part */
+            if (!seg->n_parts)
+                av_log(v->parent, AV_LOG_WARNING,
+                       "Partial segments of segment %"PRId64" of playlist %d expired, "
+                       "skipping the rest of it\n", v->cur_seq_no, v->index);
+            v->cur_seq_no++;
+            v->cur_part = 0;
+            goto reload;
+        }
+        part = current_part(v);
+        if (!part && v->cur_seq_no >= v->start_seq_no + v->n_segments) {
             if (v->finished)
                 return AVERROR_EOF;
+            if (v->can_block_reload && !block_reload) {
+                /* the server holds the reload until there is more to read */
+                block_reload    = 1;
+                reload_interval = 0;
+                goto reload;
+            }
             while (av_gettime_relative() - v->last_load_time < reload_interval) {
                 if (ff_check_interrupt(c->interrupt_callback))
                     return AVERROR_EXIT;
@@ -1513,14 +2253,18 @@ reload:
         }
 
         v->input_read_done = 0;
-        seg = current_segment(v);
+        v->reading_part = !!part;
+        if (part)
+            seg = part;
 
         /* load/update Media Initialization Section, if any */
         ret = update_init_section(v, seg);
         if (ret)
             return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
+        if (!v->reading_part && (ret = prefetch_open(c, v))) {
+            ret = FFMIN(ret, 0);
+        } else if (!v->reading_part && c->http_multiple == 1 && v->input_next_requested) {
             FFSWAP(AVIOContext *, v->input, v->input_next);
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
@@ -1531,6 +2275,17 @@ reload:
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback))
                 return AVERROR_EXIT;
+            if (part && part == v->preload_hint) {
+                /* wait for the hinted part to be listed instead */
+                free_segment_dynarray(&v->preload_hint, 1);
+                goto reload;
+            }
+            if (v->reading_part) {
+                av_log(v->parent, AV_LOG_WARNING, "Failed to open part %d of segment %"PRId64" of playlist %d\n",
+                       v->cur_part, v->cur_seq_no, v->index);
+                v->cur_part++;
+                goto reload;
+            }
             av_log(v->parent, AV_LOG_WARNING, "Failed to open segment %"PRId64" of playlist %d\n",
                    v->cur_seq_no,
                    v->index);
@@ -1540,7 +2295,7 @@ reload:
         just_opened = 1;
     }
 
-    if (c->http_multiple == -1) {
+    if (c->http_multiple == -1 && v->input) {
         uint8_t *http_version_opt = NULL;
         int r = av_opt_get(v->input, "http_version", AV_OPT_SEARCH_CHILDREN, &http_version_opt);
         if (r >= 0) {
@@ -1550,7 +2305,7 @@ reload:
     }
 
     seg = next_segment(v);
-    if (c->http_multiple == 1 && !v->input_next_requested &&
+    if (c->http_multiple == 1 && !v->input_next_requested && !c->prefetch_segments &&
         seg && seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         ret = open_input(c, v, seg, &v->input_next);
         if (ret < 0) {
@@ -1572,8 +2327,11 @@ reload:
         return copy_size;
     }
 
-    seg = current_segment(v);
-    ret = read_from_url(v, seg, buf, buf_size);
+    seg = v->reading_part ? current_part(v) : current_segment(v);
+    if (v->prefetch_cur)
+        ret = prefetch_read(v, buf, buf_size);
+    else
+        ret = read_from_url(v, seg, buf, buf_size);
     if (ret > 0) {
         if (just_opened && v->is_id3_timestamped != 0) {
             /* Intercept ID3 tags here, elementary audio streams are required
@@ -1583,13 +2341,20 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->prefetch_cur) {
+        prefetch_release(c, v);
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
         ff_format_io_close(v->parent, &v->input);
     }
-    v->cur_seq_no++;
+    if (v->reading_part) {
+        v->cur_part++;
+        v->m3u8_hold_counters = 0;
+    } else {
+        v->cur_seq_no++;
+    }
 
     c->cur_seq_no = v->cur_seq_no;
 
@@ -1682,10 +2447,56 @@ static int find_timestamp_in_playlist(HLSContext *c, struct playlist *pls,
     return 0;
 }
 
+/* Start a low-latency playlist PART-HOLD-BACK (or three part target
+ * durations) behind the end of the last listed part, on an independent part
+ * or a segment boundary. Returns 0 if the playlist lists no parts. */
+static int select_cur_part(struct playlist *pls, int64_t *seq_no, int *part)
+{
+    int64_t hold_back = pls->part_hold_back > 0 ? pls->part_hold_back :
+                                                  3 * pls->part_target;
+    int64_t pos = 0;
+    int i, j, found = 0;
+
+    if (pls->part_target <= 0 || (!pls->n_parts &&
+        (!pls->n_segments || !pls->segments[pls->n_segments - 1]->n_parts)))
+        return 0;
+
+    for (j = pls->n_parts - 1; j >= 0; j--) {
+        pos += pls->parts[j]->duration;
+        *seq_no = pls->start_seq_no + pls->n_segments;
+        *part   = j;
+        if (pos >= hold_back && (!j || pls->parts[j]->independent))
+            return 1;
+    }
+    for (i = pls->n_segments - 1; i >= 0 && !found; i--) {
+        struct segment *seg = pls->segments[i];
+
+        *seq_no = pls->start_seq_no + i;
+        *part   = 0;
+        if (!seg->n_parts) {
+            pos  += seg->duration;
+            found = pos >= hold_back;
+            continue;
+        }
+        for (j = seg->n_parts - 1; j >= 0; j--) {
+            pos  += seg->parts[j]->duration;
+            *part = j;
+            if (pos >= hold_back && (!j || seg->parts[j]->independent)) {
+                found = 1;
+                break;
+            }
+        }
+    }
+
+    return 1;
+}
+
 static int64_t select_cur_seq_no(HLSContext *c, struct playlist *pls)
 {
     int64_t seq_no;
 
+    pls->cur_part = 0;
+
     if (!pls->finished && !c->first_packet &&
         av_gettime_relative() - pls->last_load_time >= default_reload_interval(pls))
         /* reload the playlist since it was suspended */
@@ -1709,6 +2520,9 @@ static int64_t select_cur_seq_no(HLSContext *c, struct playlist *pls)
              * require us to download a segment to inspect its timestamps. */
             return c->cur_seq_no;
 
+        if (select_cur_part(pls, &seq_no, &pls->cur_part))
+            return seq_no;
+
         /* If this is a live stream, start live_start_index segments from the
          * start or end */
         if (c->live_start_index < 0)
@@ -2011,6 +2825,7 @@ static int hls_read_header(AVFormatContext *s)
             ff_format_io_close(pls->parent, &pls->input_next);
             pls->input_next = NULL;
             pls->input_next_requested = 0;
+            prefetch_reset(pls);
             pls->cur_seg_offset = 0;
             pls->cur_init_section = NULL;
             /* Reset EOF flag */
@@ -2163,6 +2978,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             pls->input_read_done = 0;
             ff_format_io_close(pls->parent, &pls->input_next);
             pls->input_next_requested = 0;
+            prefetch_reset(pls);
             pls->needed = 0;
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving playlist %d\n", i);
@@ -2409,6 +3225,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
 
     /* set segment now so we do not need to search again below */
     seek_pls->cur_seq_no = seq_no;
+    seek_pls->cur_part   = 0;
     seek_pls->seek_stream_index = stream_subdemuxer_index;
 
     for (i = 0; i < c->n_playlists; i++) {
@@ -2419,6 +3236,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
         pls->input_next_requested = 0;
+        prefetch_reset(pls);
         av_packet_unref(pls->pkt);
         pb->eof_reached = 0;
         /* Clear any buffered data */
@@ -2434,6 +3252,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         if (pls != seek_pls) {
             /* set closest segment seq_no for playlists not handled above */
             find_timestamp_in_playlist(c, pls, seek_timestamp, &pls->cur_seq_no, NULL);
+            pls->cur_part = 0;
             /* seek the playlist to the given position without taking
              * keyframes into account since this playlist does not have the
              * specified stream where we should look for the keyframes */
@@ -2482,6 +3301,19 @@ static const AVOption hls_options[] = {
         OFFSET(http_seekable), AV_OPT_TYPE_BOOL, { .i64 = -1}, -1, 1, FLAGS},
     {"seg_format_options", "Set options for segment demuxer",
         OFFSET(seg_format_opts), AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, FLAGS},
+    {"prefetch_segments", "Number of segments to download ahead of time per playlist, on separate threads",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 16, FLAGS},
+    {"low_latency", "Read partial segments and use blocking reloads of Low-Latency HLS playlists",
+        OFFSET(low_latency), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, FLAGS},
+    {"segments_downloaded", "Number of prefetched segments",
+        OFFSET(segments_downloaded), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX,
+        FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
+    {"bytes_downloaded", "Size of the prefetched segments",
+        OFFSET(bytes_downloaded), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX,
+        FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
+    {"download_time", "Time spent downloading the prefetched segments, in microseconds",
+        OFFSET(download_time), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX,
+        FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
     {NULL}
 };
 
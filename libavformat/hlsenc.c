@@ -54,6 +54,7 @@
 #include "hlsplaylist.h"
 #include "internal.h"
 #include "os_support.h"
+#include "uploadqueue.h"
 
 typedef enum {
     HLS_START_SEQUENCE_AS_START_NUMBER = 0,
@@ -74,6 +75,12 @@ typedef enum {
 #define BUFSIZE (16 * 1024)
 #define POSTFIX_PATTERN "_%d"
 
+typedef struct HLSPart {
+    char *filename;
+    double duration; /* in seconds */
+    int independent;
+} HLSPart;
+
 typedef struct HLSSegment {
     char filename[MAX_URL_SIZE];
     char sub_filename[MAX_URL_SIZE];
@@ -88,6 +95,9 @@ typedef struct HLSSegment {
     char key_uri[LINE_BUFFER_SIZE + 1];
     char iv_string[KEYSIZE*2 + 1];
 
+    HLSPart *parts;  /* partial segments of a low-latency playlist */
+    int nb_parts;
+
     struct HLSSegment *next;
     double discont_program_date_time;
 } HLSSegment;
@@ -154,6 +164,12 @@ typedef struct VariantStream {
     HLSSegment *last_segment;
     HLSSegment *old_segments;
 
+    HLSPart *parts;          // partial segments of the segment being written
+    int nb_parts;
+    int64_t part_offset;     // end of the last partial segment in the dynamic buffer
+    int64_t part_start_pts;
+    int part_independent;
+
     char *basename_tmp;
     char *basename;
     char *vtt_basename;
@@ -199,6 +215,8 @@ typedef struct HLSContext {
 
     int64_t time;          // Set by a private option.
     int64_t init_time;     // Set by a private option.
+    int64_t part_time;     // Set by a private option.
+    int block_reload;      // Set by a private option.
     int max_nb_segments;   // Set by a private option.
     int hls_delete_threshold; // Set by a private option.
     uint32_t flags;        // enum HLSFlags
@@ -256,6 +274,11 @@ typedef struct HLSContext {
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
+
+    int async_uploads;     // Set by a private option.
+    int upload_retries;    // Set by a private option.
+    UploadQueue *upload_queue;
+    UploadQueueStats upload_stats; /* exported as read-only options */
 } HLSContext;
 
 static int strftime_expand(const char *fmt, char **dest)
@@ -287,7 +310,10 @@ static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *file
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
-    if (!*pb || !http_base_proto || !hls->http_persistent) {
+    if (hls->upload_queue) {
+        err = ff_upload_queue_open(hls->upload_queue, pb, filename, options,
+                                   av_match_ext(filename, "m3u8") ? FF_UPLOAD_MANIFEST : 0);
+    } else if (!*pb || !http_base_proto || !hls->http_persistent) {
         err = s->io_open(s, pb, filename, AVIO_FLAG_WRITE, options);
 #if CONFIG_HTTP_PROTOCOL
     } else {
@@ -309,7 +335,10 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     int ret = 0;
     if (!*pb)
         return ret;
-    if (!http_base_proto || !hls->http_persistent || hls->key_info_file || hls->encrypt) {
+    if (hls->upload_queue) {
+        ret = ff_upload_queue_close(hls->upload_queue, pb);
+        ff_upload_queue_get_stats(hls->upload_queue, &hls->upload_stats);
+    } else if (!http_base_proto || !hls->http_persistent || hls->key_info_file || hls->encrypt) {
         ff_format_io_close(s, pb);
 #if CONFIG_HTTP_PROTOCOL
     } else {
@@ -323,6 +352,15 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     return ret;
 }
 
+/* Release *pb without completing the upload, used on error paths. */
+static void hlsenc_io_free(AVFormatContext *s, AVIOContext **pb)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (!hls->upload_queue || !ff_upload_queue_discard(hls->upload_queue, pb))
+        ff_format_io_close(s, pb);
+}
+
 static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSContext *c)
 {
     int http_base_proto = ff_is_http_proto(s->url);
@@ -565,13 +603,20 @@ static void reflush_dynbuf(VariantStream *vs, int *range_length)
 #endif
 
 static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
-                           const char *path, const char *proto)
+                           const char *path, const char *proto,
+                           const char *playlist)
 {
     if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
         AVDictionary *opt = NULL;
         AVIOContext  *out = NULL;
         int ret;
         set_http_options(avf, &opt, hls);
+        if (hls->upload_queue) {
+            /* ordered after the playlist that stopped referencing path */
+            ret = ff_upload_queue_delete(hls->upload_queue, path, &opt, playlist);
+            av_dict_free(&opt);
+            return ret;
+        }
         av_dict_set(&opt, "method", "DELETE", 0);
         ret = avf->io_open(avf, &out, path, AVIO_FLAG_WRITE, &opt);
         av_dict_free(&opt);
@@ -585,13 +630,50 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
     return 0;
 }
 
+static void hls_free_parts(HLSPart **parts, int *nb_parts)
+{
+    int i;
+
+    for (i = 0; i < *nb_parts; i++)
+        av_freep(&(*parts)[i].filename);
+    av_freep(parts);
+    *nb_parts = 0;
+}
+
+/* Partial segments are named after the segment they belong to,
+ * e.g. file3.part0.m4s for the first part of file3.m4s. */
+static int get_part_filename(HLSContext *hls, VariantStream *vs, int part_idx,
+                             char **filename)
+{
+    const char *url = vs->avf->url;
+    size_t len = strlen(url), ext_pos;
+
+    if ((hls->flags & HLS_TEMP_FILE) && len > 4 &&
+        !strcmp(url + len - 4, ".tmp"))
+        len -= 4;
+
+    for (ext_pos = len; ext_pos > 0; ext_pos--) {
+        if (url[ext_pos - 1] == '/' || url[ext_pos - 1] == SEPARATOR) {
+            ext_pos = 0;
+            break;
+        }
+        if (url[ext_pos - 1] == '.')
+            break;
+    }
+    ext_pos = ext_pos ? ext_pos - 1 : len;
+
+    *filename = av_asprintf("%.*s.part%d%.*s", (int)ext_pos, url, part_idx,
+                            (int)(len - ext_pos), url + ext_pos);
+    return *filename ? 0 : AVERROR(ENOMEM);
+}
+
 static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
                                    VariantStream *vs)
 {
 
     HLSSegment *segment, *previous_segment = NULL;
     float playlist_duration = 0.0f;
-    int ret = 0;
+    int ret = 0, i;
     int segment_cnt = 0;
     AVBPrint path;
     const char *dirname = NULL;
@@ -662,9 +744,24 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
         }
 
         proto = avio_find_protocol_name(s->url);
-        if (ret = hls_delete_file(hls, vs->avf, path.str, proto))
+        if (ret = hls_delete_file(hls, vs->avf, path.str, proto, vs->m3u8_name))
             goto fail;
 
+        for (i = 0; i < segment->nb_parts; i++) {
+            av_bprint_clear(&path);
+            if (!hls->use_localtime_mkdir)
+                av_bprintf(&path, "%s%c", dirname, SEPARATOR);
+            av_bprintf(&path, "%s", segment->parts[i].filename);
+
+            if (!av_bprint_is_complete(&path)) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+
+            if (ret = hls_delete_file(hls, vs->avf, path.str, proto, vs->m3u8_name))
+                goto fail;
+        }
+
         if ((segment->sub_filename[0] != '\0')) {
             vtt_dirname_r = av_strdup(vs->vtt_avf->url);
             vtt_dirname = av_dirname(vtt_dirname_r);
@@ -679,12 +776,13 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
                 goto fail;
             }
 
-            if (ret = hls_delete_file(hls, vs->vtt_avf, path.str, proto))
+            if (ret = hls_delete_file(hls, vs->vtt_avf, path.str, proto, vs->vtt_m3u8_name))
                 goto fail;
         }
         av_bprint_clear(&path);
         previous_segment = segment;
         segment = previous_segment->next;
+        hls_free_parts(&previous_segment->parts, &previous_segment->nb_parts);
         av_freep(&previous_segment);
     }
 
@@ -1156,6 +1254,11 @@ static int hls_append_segment(struct AVFormatContext *s, HLSContext *hls,
         av_strlcpy(en->iv_string, vs->iv_string, sizeof(en->iv_string));
     }
 
+    en->parts    = vs->parts;
+    en->nb_parts = vs->nb_parts;
+    vs->parts    = NULL;
+    vs->nb_parts = 0;
+
     if (!vs->segments)
         vs->segments = en;
     else
@@ -1178,8 +1281,10 @@ static int hls_append_segment(struct AVFormatContext *s, HLSContext *hls,
             vs->old_segments = en;
             if ((ret = hls_delete_old_segments(s, hls, vs)) < 0)
                 return ret;
-        } else
+        } else {
+            hls_free_parts(&en->parts, &en->nb_parts);
             av_freep(&en);
+        }
     } else
         vs->nb_entries++;
 
@@ -1309,6 +1414,7 @@ static void hls_free_segments(HLSSegment *p)
     while (p) {
         en = p;
         p = p->next;
+        hls_free_parts(&en->parts, &en->nb_parts);
         av_freep(&en);
     }
 }
@@ -1549,6 +1655,9 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     double prog_date_time = vs->initial_prog_date_time;
     double *prog_date_time_p = (hls->flags & HLS_PROGRAM_DATE_TIME) ? &prog_date_time : NULL;
     int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    int low_latency = hls->part_time > 0;
+    double remaining_duration = 0;
+    int i;
 
     hls->version = 3;
     if (byterange_mode) {
@@ -1582,6 +1691,13 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     for (en = vs->segments; en; en = en->next) {
         if (target_duration <= en->duration)
             target_duration = lrint(en->duration);
+        remaining_duration += en->duration;
+    }
+    if (low_latency) {
+        if (!target_duration)
+            target_duration = ceil(hls->time / (double)HLS_MICROSECOND_UNIT);
+        for (i = 0; i < vs->nb_parts; i++)
+            remaining_duration += vs->parts[i].duration;
     }
 
     vs->discontinuity_set = 0;
@@ -1595,6 +1711,9 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     if (vs->has_video && (hls->flags & HLS_INDEPENDENT_SEGMENTS)) {
         avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
     }
+    if (low_latency)
+        ff_hls_write_low_latency_info(vs->out, hls->part_time / (double)HLS_MICROSECOND_UNIT,
+                                      hls->block_reload);
     for (en = vs->segments; en; en = en->next) {
         if ((hls->encrypt || hls->key_info_file) && (!key_uri || strcmp(en->key_uri, key_uri) ||
                                     av_strcasecmp(en->iv_string, iv_string))) {
@@ -1611,6 +1730,14 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
                                    hls->flags & HLS_SINGLE_FILE, vs->init_range_length, 0);
         }
 
+        /* Partial segments are only listed for the last three target durations */
+        if (low_latency && remaining_duration <= 3 * target_duration) {
+            for (i = 0; i < en->nb_parts; i++)
+                ff_hls_write_part(vs->out, en->parts[i].duration, hls->baseurl,
+                                  en->parts[i].filename, en->parts[i].independent);
+        }
+        remaining_duration -= en->duration;
+
         ret = ff_hls_write_file_entry(byterange_mode ? hls->m3u8_out : vs->out, en->discont, byterange_mode,
                                       en->duration, hls->flags & HLS_ROUND_DURATIONS,
                                       en->size, en->pos, hls->baseurl,
@@ -1624,6 +1751,22 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
         }
     }
 
+    /* right after a segment boundary only the first part of the new segment
+     * is hinted */
+    if (low_latency && (vs->nb_parts || !last)) {
+        char *hint = NULL;
+
+        if (!vs->segments)
+            ff_hls_write_init_file(vs->out, vs->fmp4_init_filename, 0, vs->init_range_length, 0);
+        for (i = 0; i < vs->nb_parts; i++)
+            ff_hls_write_part(vs->out, vs->parts[i].duration, hls->baseurl,
+                              vs->parts[i].filename, vs->parts[i].independent);
+        if (!last && get_part_filename(hls, vs, vs->nb_parts, &hint) >= 0)
+            ff_hls_write_preload_hint(vs->out, hls->baseurl,
+                                      hls->use_localtime_mkdir ? hint : av_basename(hint));
+        av_free(hint);
+    }
+
     if (last && (hls->flags & HLS_OMIT_ENDLIST)==0)
         ff_hls_write_end_list(byterange_mode ? hls->m3u8_out : vs->out);
 
@@ -2396,6 +2539,95 @@ static int64_t append_single_file(AVFormatContext *s, VariantStream *vs)
 
     return ret;
 }
+
+/* Write the fMP4 initialization section flushed into the dynamic buffer */
+static int write_init_segment(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    int range_length, ret;
+
+    range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
+    oc->pb = NULL;
+    if (range_length <= 0)
+        return AVERROR(EINVAL);
+    avio_write(vs->out, vs->init_buffer, range_length);
+    if (!hls->resend_init_file)
+        av_freep(&vs->init_buffer);
+    vs->init_range_length = range_length;
+    if ((ret = avio_open_dyn_buf(&oc->pb)) < 0)
+        return ret;
+    vs->start_pos = range_length;
+    vs->part_offset = 0;
+    if (!byterange_mode) {
+        hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
+    }
+    return 0;
+}
+
+/* Write everything muxed since the last partial segment into a new part file */
+static int hls_write_part(AVFormatContext *s, VariantStream *vs, double duration)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    AVDictionary *options = NULL;
+    HLSPart *parts;
+    char *filename = NULL;
+    uint8_t *buf;
+    int size, ret;
+
+    av_write_frame(oc, NULL); /* Flush any buffered data */
+    if (!vs->init_range_length) {
+        if ((ret = write_init_segment(s, vs)) < 0)
+            return ret;
+        /* with delay_moov the first flush only emits the moov */
+        av_write_frame(oc, NULL);
+    }
+
+    size = avio_get_dyn_buf(oc->pb, &buf);
+    if (size <= vs->part_offset)
+        return 0;
+
+    if ((ret = get_part_filename(hls, vs, vs->nb_parts, &filename)) < 0)
+        return ret;
+
+    set_http_options(s, &options, hls);
+    ret = hlsenc_io_open(s, &vs->out, filename, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+               "Failed to open file '%s'\n", filename);
+        av_free(filename);
+        return hls->ignore_io_errors ? 0 : ret;
+    }
+    avio_write(vs->out, buf + vs->part_offset, size - vs->part_offset);
+    ret = hlsenc_io_close(s, &vs->out, filename);
+    if (ret < 0)
+        av_log(s, AV_LOG_WARNING, "upload partial segment '%s' failed\n", filename);
+
+    parts = av_realloc_array(vs->parts, vs->nb_parts + 1, sizeof(*vs->parts));
+    if (!parts) {
+        av_free(filename);
+        return AVERROR(ENOMEM);
+    }
+    vs->parts = parts;
+    if (!hls->use_localtime_mkdir) {
+        char *basename = av_strdup(av_basename(filename));
+        av_free(filename);
+        if (!basename)
+            return AVERROR(ENOMEM);
+        filename = basename;
+    }
+    parts[vs->nb_parts].filename    = filename;
+    parts[vs->nb_parts].duration    = duration;
+    parts[vs->nb_parts].independent = vs->part_independent;
+    vs->nb_parts++;
+
+    vs->part_offset = size;
+    return 0;
+}
+
 static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 {
     HLSContext *hls = s->priv_data;
@@ -2486,31 +2718,32 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         }
     }
 
+    if (hls->part_time > 0 && is_ref_pkt && vs->part_start_pts == AV_NOPTS_VALUE) {
+        vs->part_start_pts   = pkt->pts;
+        vs->part_independent = !vs->has_video || (pkt->flags & AV_PKT_FLAG_KEY);
+    }
+
     can_split = can_split && (pkt->pts - vs->end_pts > 0);
     if (vs->packets_written && can_split && av_compare_ts(pkt->pts - vs->start_pts, st->time_base,
                                                           end_pts, AV_TIME_BASE_Q) >= 0) {
         int64_t new_start_pos;
         int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
 
+        if (hls->part_time > 0) {
+            /* the tail of the segment becomes its last partial segment */
+            ret = hls_write_part(s, vs, (pkt->pts - vs->part_start_pts) * av_q2d(st->time_base));
+            if (ret < 0)
+                return ret;
+        }
         av_write_frame(oc, NULL); /* Flush any buffered data */
         new_start_pos = avio_tell(oc->pb);
         vs->size = new_start_pos - vs->start_pos;
         avio_flush(oc->pb);
         if (hls->segment_type == SEGMENT_TYPE_FMP4) {
             if (!vs->init_range_length) {
-                range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
-                if (range_length <= 0)
-                    return AVERROR(EINVAL);
-                avio_write(vs->out, vs->init_buffer, range_length);
-                if (!hls->resend_init_file)
-                    av_freep(&vs->init_buffer);
-                vs->init_range_length = range_length;
-                avio_open_dyn_buf(&oc->pb);
+                if ((ret = write_init_segment(s, vs)) < 0)
+                    return ret;
                 vs->packets_written = 0;
-                vs->start_pos = range_length;
-                if (!byterange_mode) {
-                    hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
-                }
             }
         }
         if (!byterange_mode) {
@@ -2577,7 +2810,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 if (ret < 0) {
                     av_log(s, AV_LOG_WARNING, "upload segment failed,"
                            " will retry with a new http session.\n");
-                    ff_format_io_close(s, &vs->out);
+                    hlsenc_io_free(s, &vs->out);
                     ret = hlsenc_io_open(s, &vs->out, filename, &options);
                     reflush_dynbuf(vs, &range_length);
                     ret = hlsenc_io_close(s, &vs->out, filename);
@@ -2608,10 +2841,11 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         }
 
         // if we're building a VOD playlist, skip writing the manifest multiple times, and just wait until the end
-        if (hls->pl_type != PLAYLIST_TYPE_VOD) {
+        // low-latency playlists are written once the next segment is started, to hint at its first part
+        if (hls->pl_type != PLAYLIST_TYPE_VOD && !hls->part_time) {
             if ((ret = hls_window(s, 0, vs)) < 0) {
                 av_log(s, AV_LOG_WARNING, "upload playlist failed, will retry with a new http session.\n");
-                ff_format_io_close(s, &vs->out);
+                hlsenc_io_free(s, &vs->out);
                 if ((ret = hls_window(s, 0, vs)) < 0) {
                     av_freep(&old_filename);
                     return ret;
@@ -2653,6 +2887,25 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             return ret;
         }
+        if (hls->part_time > 0 && (ret = hls_window(s, 0, vs)) < 0)
+            return ret;
+
+        vs->part_offset      = 0;
+        vs->part_start_pts   = pkt->pts;
+        vs->part_independent = !vs->has_video || (pkt->flags & AV_PKT_FLAG_KEY);
+    }
+
+    if (hls->part_time > 0 && is_ref_pkt && oc == vs->avf && vs->packets_written &&
+        pkt->pts > vs->part_start_pts &&
+        av_compare_ts(pkt->pts + pkt->duration - vs->part_start_pts, st->time_base,
+                      hls->part_time, AV_TIME_BASE_Q) > 0) {
+        ret = hls_write_part(s, vs, (pkt->pts - vs->part_start_pts) * av_q2d(st->time_base));
+        if (ret < 0)
+            return ret;
+        vs->part_start_pts   = pkt->pts;
+        vs->part_independent = !vs->has_video || (pkt->flags & AV_PKT_FLAG_KEY);
+        if ((ret = hls_window(s, 0, vs)) < 0)
+            return ret;
     }
 
     vs->packets_written++;
@@ -2692,12 +2945,14 @@ static void hls_deinit(AVFormatContext *s)
             av_freep(&vs->init_buffer);
         hls_free_segments(vs->segments);
         hls_free_segments(vs->old_segments);
+        hls_free_parts(&vs->parts, &vs->nb_parts);
         av_freep(&vs->m3u8_name);
         av_freep(&vs->streams);
     }
 
-    ff_format_io_close(s, &hls->m3u8_out);
-    ff_format_io_close(s, &hls->sub_m3u8_out);
+    hlsenc_io_free(s, &hls->m3u8_out);
+    hlsenc_io_free(s, &hls->sub_m3u8_out);
+    ff_upload_queue_free(&hls->upload_queue);
     av_freep(&hls->key_basename);
     av_freep(&hls->var_streams);
     av_freep(&hls->cc_streams);
@@ -2755,9 +3010,19 @@ static int hls_write_trailer(struct AVFormatContext *s)
                 vs->packets_written = 0;
                 vs->start_pos = range_length;
                 byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
-                if (!byterange_mode) {
-                    ff_format_io_close(s, &vs->out);
+                if (!byterange_mode)
                     hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
+            }
+            if (hls->part_time > 0 && vs->part_start_pts != AV_NOPTS_VALUE) {
+                double part_duration = vs->duration + vs->dpp;
+                int j;
+                for (j = 0; j < vs->nb_parts; j++)
+                    part_duration -= vs->parts[j].duration;
+                ret = hls_write_part(s, vs, FFMAX(part_duration, 0));
+                if (ret < 0) {
+                    av_freep(&old_filename);
+                    av_freep(&filename);
+                    return ret;
                 }
             }
         }
@@ -2779,7 +3044,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
         ret = hlsenc_io_close(s, &vs->out, filename);
         if (ret < 0) {
             av_log(s, AV_LOG_WARNING, "upload segment failed, will retry with a new http session.\n");
-            ff_format_io_close(s, &vs->out);
+            hlsenc_io_free(s, &vs->out);
             ret = hlsenc_io_open(s, &vs->out, filename, &options);
             if (ret < 0) {
                 av_log(s, AV_LOG_ERROR, "Failed to open file '%s'\n", oc->url);
@@ -2826,12 +3091,13 @@ failed:
             if (vtt_oc->pb)
                 av_write_trailer(vtt_oc);
             vs->size = avio_tell(vs->vtt_avf->pb) - vs->start_pos;
+            hlsenc_io_close(s, &vtt_oc->pb, vtt_oc->url);
             ff_format_io_close(s, &vtt_oc->pb);
         }
         ret = hls_window(s, 1, vs);
         if (ret < 0) {
             av_log(s, AV_LOG_WARNING, "upload playlist failed, will retry with a new http session.\n");
-            ff_format_io_close(s, &vs->out);
+            hlsenc_io_free(s, &vs->out);
             hls_window(s, 1, vs);
         }
         ffio_free_dyn_buf(&oc->pb);
@@ -2839,6 +3105,18 @@ failed:
         av_free(old_filename);
     }
 
+    if (hls->upload_queue) {
+        ret = ff_upload_queue_flush(hls->upload_queue);
+        ff_upload_queue_get_stats(hls->upload_queue, &hls->upload_stats);
+        av_log(s, AV_LOG_VERBOSE, "%"PRId64" uploads, %"PRId64" bytes, %"PRId64" failed, "
+               "average upload time %"PRId64" ms, maximum queue depth %"PRId64"\n",
+               hls->upload_stats.uploads, hls->upload_stats.bytes, hls->upload_stats.failures,
+               hls->upload_stats.uploads ? hls->upload_stats.upload_time / hls->upload_stats.uploads / 1000 : 0,
+               hls->upload_stats.max_depth);
+        if (ret < 0 && !hls->ignore_io_errors)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -2878,6 +3156,26 @@ static int hls_init(AVFormatContext *s)
         av_log(hls, AV_LOG_WARNING, "No HTTP method set, hls muxer defaulting to method PUT.\n");
     }
 
+    if (hls->async_uploads) {
+        const char *proto = avio_find_protocol_name(s->url);
+        const char *seg_proto = hls->segment_filename ?
+                                avio_find_protocol_name(hls->segment_filename) : proto;
+
+        /* local files rely on renames, single files are written progressively */
+        if ((proto && !strcmp(proto, "file")) || (seg_proto && !strcmp(seg_proto, "file")) ||
+            (hls->flags & HLS_SINGLE_FILE)) {
+            av_log(s, AV_LOG_WARNING, "async_uploads is only supported for network output "
+                   "without single_file, uploading synchronously\n");
+        } else {
+            ret = ff_upload_queue_alloc(&hls->upload_queue, s, hls->async_uploads,
+                                        hls->upload_retries, hls->http_persistent);
+            if (ret == AVERROR(ENOSYS))
+                av_log(s, AV_LOG_WARNING, "async_uploads requires threads, uploading synchronously\n");
+            else if (ret < 0)
+                return ret;
+        }
+    }
+
     ret = validate_name(hls->nb_varstreams, s->url);
     if (ret < 0)
         return ret;
@@ -2939,6 +3237,23 @@ static int hls_init(AVFormatContext *s)
                "enabled together. Disabling 'independent_segments' flag\n");
     }
 
+    if (hls->part_time > 0) {
+        if (hls->segment_type != SEGMENT_TYPE_FMP4 || (hls->flags & HLS_SINGLE_FILE) ||
+            hls->max_seg_size > 0 || hls->encrypt || hls->key_info_file ||
+            hls->pl_type == PLAYLIST_TYPE_VOD) {
+            hls->part_time = 0;
+            av_log(s, AV_LOG_WARNING,
+                   "'hls_part_time' requires fmp4 segments written to separate files "
+                   "without encryption in a live or event playlist. "
+                   "Disabling partial segments\n");
+        } else if (hls->part_time > hls->time) {
+            hls->part_time = hls->time;
+            av_log(s, AV_LOG_WARNING,
+                   "'hls_part_time' is longer than 'hls_time', using %f seconds\n",
+                   hls->part_time / (double)HLS_MICROSECOND_UNIT);
+        }
+    }
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         vs = &hls->var_streams[i];
 
@@ -2949,6 +3264,7 @@ static int hls_init(AVFormatContext *s)
         vs->sequence  = hls->start_sequence;
         vs->start_pts = AV_NOPTS_VALUE;
         vs->end_pts   = AV_NOPTS_VALUE;
+        vs->part_start_pts = AV_NOPTS_VALUE;
         vs->current_segment_final_filename_fmt[0] = '\0';
         vs->initial_prog_date_time = initial_program_date_time;
 
@@ -3099,6 +3415,8 @@ static int hls_init(AVFormatContext *s)
 static const AVOption options[] = {
     {"start_number",  "set first number in the sequence",        OFFSET(start_sequence),AV_OPT_TYPE_INT64,  {.i64 = 0},     0, INT64_MAX, E},
     {"hls_time",      "set segment length",                      OFFSET(time),          AV_OPT_TYPE_DURATION, {.i64 = 2000000}, 0, INT64_MAX, E},
+    {"hls_part_time", "set partial segment length for low-latency HLS", OFFSET(part_time), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, E},
+    {"hls_block_reload", "advertise blocking playlist reload support of the server", OFFSET(block_reload), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E},
     {"hls_init_time", "set segment length at init list",         OFFSET(init_time),     AV_OPT_TYPE_DURATION, {.i64 = 0},       0, INT64_MAX, E},
     {"hls_list_size", "set maximum number of playlist entries",  OFFSET(max_nb_segments),    AV_OPT_TYPE_INT,    {.i64 = 5},     0, INT_MAX, E},
     {"hls_delete_threshold", "set number of unreferenced segments to keep before deleting",  OFFSET(hls_delete_threshold),    AV_OPT_TYPE_INT,    {.i64 = 1},     1, INT_MAX, E},
@@ -3158,6 +3476,15 @@ static const AVOption options[] = {
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
+    {"async_uploads", "maximum number of segments uploaded in the background, 0 to upload synchronously", OFFSET(async_uploads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, E },
+    {"upload_retries", "number of times a failed background upload is retried", OFFSET(upload_retries), AV_OPT_TYPE_INT, { .i64 = 3 }, 0, INT_MAX, E },
+    {"uploads_completed", "number of completed background uploads", OFFSET(upload_stats.uploads), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_bytes", "size of the completed background uploads", OFFSET(upload_stats.bytes), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_time", "time spent in background uploads, in microseconds", OFFSET(upload_stats.upload_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_time_max", "longest background upload, in microseconds", OFFSET(upload_stats.max_upload_time), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_failures", "number of background uploads that failed after all retries", OFFSET(upload_stats.failures), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_queue_depth", "number of uploads currently queued or in flight", OFFSET(upload_stats.depth), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    {"upload_queue_max_depth", "highest number of uploads queued or in flight", OFFSET(upload_stats.max_depth), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
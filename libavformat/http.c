@@ -88,6 +88,9 @@ typedef struct HTTPContext {
     int chunked_post;
     /* A flag which indicates if the end of chunked encoding has been sent. */
     int end_chunked_post;
+    /* Error from the reply to a write, if it was read when shutting down. */
+    int write_reply_status;
+    int write_reply_read;
     /* A flag which indicates we have finished to read POST reply. */
     int end_header;
     /* A flag which indicates if we use persistent connections. */
@@ -440,6 +443,17 @@ fail:
         return ret;
     return ff_http_averror(s->http_code, AVERROR(EIO));
 }
+/* Map the status line of the reply to a write to an error code. */
+static int http_write_reply_status(char *buf, int len)
+{
+    int code;
+
+    buf[len] = '\0';
+    if (sscanf(buf, "HTTP/%*d.%*d %d", &code) == 1 && code >= 400)
+        return ff_http_averror(code, AVERROR(EIO));
+    return 0;
+}
+
 int ff_http_get_shutdown_status(URLContext *h)
 {
     int ret = 0;
@@ -448,9 +462,16 @@ int ff_http_get_shutdown_status(URLContext *h)
     /* flush the receive buffer when it is write only mode */
     char buf[1024];
     int read_ret;
-    read_ret = ffurl_read(s->hd, buf, sizeof(buf));
+
+    if (s->write_reply_read) {
+        s->write_reply_read = 0;
+        return s->write_reply_status;
+    }
+    read_ret = ffurl_read(s->hd, buf, sizeof(buf) - 1);
     if (read_ret < 0) {
         ret = read_ret;
+    } else {
+        ret = http_write_reply_status(buf, read_ret);
     }
 
     return ret;
@@ -497,6 +518,7 @@ int ff_http_do_new_request2(URLContext *h, const char *uri, AVDictionary **opts)
         return AVERROR_EOF;
 
     s->end_chunked_post = 0;
+    s->write_reply_read = 0;
     s->chunkend      = 0;
     s->off           = 0;
     s->icy_data_read = 0;
@@ -1865,11 +1887,14 @@ static int http_shutdown(URLContext *h, int flags)
             char buf[1024];
             int read_ret;
             s->hd->flags |= AVIO_FLAG_NONBLOCK;
-            read_ret = ffurl_read(s->hd, buf, sizeof(buf));
+            read_ret = ffurl_read(s->hd, buf, sizeof(buf) - 1);
             s->hd->flags &= ~AVIO_FLAG_NONBLOCK;
             if (read_ret < 0 && read_ret != AVERROR(EAGAIN)) {
                 av_log(h, AV_LOG_ERROR, "URL read error: %s\n", av_err2str(read_ret));
                 ret = read_ret;
+            } else if (read_ret > 0) {
+                s->write_reply_status = http_write_reply_status(buf, read_ret);
+                s->write_reply_read   = 1;
             }
         }
         s->end_chunked_post = 1;
@@ -47,6 +47,13 @@
  * by the caller upon read_header() failure.
  */
 #define FF_FMT_INIT_CLEANUP                             (1 << 0)
+/**
+ * The generic index of the streams of an AVInputFormat with this flag set
+ * is stored as an FFCompactIndex. Such demuxers must only access the index
+ * through av_add_index_entry(), av_index_search_timestamp() and
+ * avformat_index_get_entry*(), never through FFStream.index_entries.
+ */
+#define FF_FMT_COMPACT_INDEX                            (1 << 1)
 
 typedef struct AVCodecTag {
     enum AVCodecID id;
@@ -183,6 +190,19 @@ typedef struct FFFormatContext {
      * Set if chapter ids are strictly monotonic.
      */
     int chapter_ids_monotonic;
+
+    /**
+     * Set if the index is complete, because it was built by
+     * avformat_index_build() or loaded by avformat_index_load(), so seeking
+     * can use it directly instead of probing timestamps.
+     */
+    int index_complete;
+
+    /**
+     * Set if AVFormatContext.seek_index_url still has to be loaded, because
+     * the demuxer creates its streams while reading packets.
+     */
+    int seek_index_pending;
 } FFFormatContext;
 
 static av_always_inline FFFormatContext *ffformatcontext(AVFormatContext *s)
@@ -277,6 +297,11 @@ typedef struct FFStream {
                                     support seeking natively. */
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
+    /**
+     * Used instead of index_entries if the format has FF_FMT_COMPACT_INDEX
+     * set, nb_index_entries is kept in sync with it.
+     */
+    struct FFCompactIndex *compact_index;
 
     int64_t interleaver_chunk_size;
     int64_t interleaver_chunk_duration;
@@ -671,6 +696,12 @@ enum AVCodecID ff_guess_image2_codec(const char *filename);
 
 const AVCodec *ff_find_decoder(AVFormatContext *s, const AVStream *st,
                                enum AVCodecID codec_id);
+/**
+ * Load the seek index of AVFormatContext.seek_index_url.
+ * Failures are only logged, as seeking then works as without an index.
+ */
+void ff_load_seek_index(AVFormatContext *s);
+
 /**
  * Perform a binary search using av_index_search_timestamp() and
  * AVInputFormat.read_timestamp().
@@ -1023,4 +1054,22 @@ void avpriv_register_devices(const AVOutputFormat * const o[], const AVInputForm
  */
 int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size);
 
+/**
+ * Replace the output file by its first head_size bytes, followed by buf and
+ * by the data of the output from data_start to its end. The result is
+ * written to a temporary file next to the output, which is then renamed over
+ * it; the data is copied with copy_file_range(), so file systems supporting
+ * reflinks share it instead of copying it. The output must be a local file
+ * and everything written to s->pb must be final, as s->pb keeps pointing to
+ * the replaced file.
+ *
+ * @param copied set to the number of bytes copied from data_start
+ * @return 0 on success, a negative AVERROR otherwise, in which case the
+ *         output is unchanged; AVERROR(ENOSYS) if the output is not a local
+ *         file or copy_file_range() is not available
+ */
+int ff_format_splice_data(AVFormatContext *s, int head_size,
+                          const uint8_t *buf, int buf_size,
+                          int64_t data_start, int64_t *copied);
+
 #endif /* AVFORMAT_INTERNAL_H */
@@ -3913,6 +3913,7 @@ static int matroska_read_seek(AVFormatContext *s, int stream_index,
     MatroskaTrack *tracks = NULL;
     AVStream *st = s->streams[stream_index];
     FFStream *const sti = ffstream(st);
+    int64_t pos, ts;
     int i, index;
 
     /* Parse the CUES now since we need the index data to seek. */
@@ -3923,11 +3924,12 @@ static int matroska_read_seek(AVFormatContext *s, int stream_index,
 
     if (!sti->nb_index_entries)
         goto err;
-    timestamp = FFMAX(timestamp, sti->index_entries[0].timestamp);
+    timestamp = FFMAX(timestamp, avformat_index_get_entry(st, 0)->timestamp);
 
     if ((index = av_index_search_timestamp(st, timestamp, flags)) < 0 ||
          index == sti->nb_index_entries - 1) {
-        matroska_reset_status(matroska, 0, sti->index_entries[sti->nb_index_entries - 1].pos);
+        matroska_reset_status(matroska, 0,
+                              avformat_index_get_entry(st, sti->nb_index_entries - 1)->pos);
         while ((index = av_index_search_timestamp(st, timestamp, flags)) < 0 ||
                index == sti->nb_index_entries - 1) {
             matroska_clear_queue(matroska);
@@ -3949,18 +3951,21 @@ static int matroska_read_seek(AVFormatContext *s, int stream_index,
         tracks[i].end_timecode         = 0;
     }
 
+    pos = avformat_index_get_entry(st, index)->pos;
+    ts  = avformat_index_get_entry(st, index)->timestamp;
+
     /* We seek to a level 1 element, so set the appropriate status. */
-    matroska_reset_status(matroska, 0, sti->index_entries[index].pos);
+    matroska_reset_status(matroska, 0, pos);
     if (flags & AVSEEK_FLAG_ANY) {
         sti->skip_to_keyframe = 0;
         matroska->skip_to_timecode = timestamp;
     } else {
         sti->skip_to_keyframe = 1;
-        matroska->skip_to_timecode = sti->index_entries[index].timestamp;
+        matroska->skip_to_timecode = ts;
     }
     matroska->skip_to_keyframe = 1;
     matroska->done             = 0;
-    avpriv_update_cur_dts(s, st, sti->index_entries[index].timestamp);
+    avpriv_update_cur_dts(s, st, ts);
     return 0;
 err:
     // slightly hackish but allows proper fallback to
@@ -4004,25 +4009,27 @@ typedef struct {
  */
 static CueDesc get_cue_desc(AVFormatContext *s, int64_t ts, int64_t cues_start) {
     MatroskaDemuxContext *matroska = s->priv_data;
-    FFStream *const sti = ffstream(s->streams[0]);
-    AVIndexEntry *const index_entries = sti->index_entries;
-    int nb_index_entries = sti->nb_index_entries;
+    AVStream *const st = s->streams[0];
+    int nb_index_entries = ffstream(st)->nb_index_entries;
+    const AVIndexEntry *entry;
     CueDesc cue_desc;
     int i;
 
     if (ts >= matroska->duration * matroska->time_scale) return (CueDesc) {-1, -1, -1, -1};
     for (i = 1; i < nb_index_entries; i++) {
-        if (index_entries[i - 1].timestamp * matroska->time_scale <= ts &&
-            index_entries[i].timestamp * matroska->time_scale > ts) {
+        if (avformat_index_get_entry(st, i - 1)->timestamp * matroska->time_scale <= ts &&
+            avformat_index_get_entry(st, i)->timestamp * matroska->time_scale > ts) {
             break;
         }
     }
     --i;
-    cue_desc.start_time_ns = index_entries[i].timestamp * matroska->time_scale;
-    cue_desc.start_offset = index_entries[i].pos - matroska->segment_start;
+    entry = avformat_index_get_entry(st, i);
+    cue_desc.start_time_ns = entry->timestamp * matroska->time_scale;
+    cue_desc.start_offset = entry->pos - matroska->segment_start;
     if (i != nb_index_entries - 1) {
-        cue_desc.end_time_ns = index_entries[i + 1].timestamp * matroska->time_scale;
-        cue_desc.end_offset = index_entries[i + 1].pos - matroska->segment_start;
+        entry = avformat_index_get_entry(st, i + 1);
+        cue_desc.end_time_ns = entry->timestamp * matroska->time_scale;
+        cue_desc.end_offset = entry->pos - matroska->segment_start;
     } else {
         cue_desc.end_time_ns = matroska->duration * matroska->time_scale;
         // FIXME: this needs special handling for files where Cues appear
@@ -4049,7 +4056,7 @@ static int webm_clusters_start_with_keyframe(AVFormatContext *s)
     index = av_index_search_timestamp(st, 0, 0);
     if (index < 0)
         return 0;
-    cluster_pos = sti->index_entries[index].pos;
+    cluster_pos = avformat_index_get_entry(st, index)->pos;
     before_pos = avio_tell(s->pb);
     while (1) {
         uint64_t cluster_id, cluster_length;
@@ -4175,7 +4182,7 @@ static int64_t webm_dash_manifest_compute_bandwidth(AVFormatContext *s, int64_t
 
     for (int i = 0; i < sti->nb_index_entries; i++) {
         int64_t prebuffer_ns = 1000000000;
-        int64_t time_ns = sti->index_entries[i].timestamp * matroska->time_scale;
+        int64_t time_ns = avformat_index_get_entry(st, i)->timestamp * matroska->time_scale;
         double nano_seconds_per_second = 1000000000.0;
         int64_t prebuffered_ns = time_ns + prebuffer_ns;
         double prebuffer_bytes = 0.0;
@@ -4325,7 +4332,7 @@ static int webm_dash_manifest_cues(AVFormatContext *s, int64_t init_range)
     // for checking subsegment alignment in the muxer.
     av_bprint_init(&bprint, 0, AV_BPRINT_SIZE_UNLIMITED);
     for (int i = 0; i < sti->nb_index_entries; i++)
-        av_bprintf(&bprint, "%" PRId64",", sti->index_entries[i].timestamp);
+        av_bprintf(&bprint, "%" PRId64",", avformat_index_get_entry(st, i)->timestamp);
     if (!av_bprint_is_complete(&bprint)) {
         av_bprint_finalize(&bprint, NULL);
         return AVERROR(ENOMEM);
@@ -4418,7 +4425,7 @@ const AVInputFormat ff_webm_dash_manifest_demuxer = {
     .long_name      = NULL_IF_CONFIG_SMALL("WebM DASH Manifest"),
     .priv_class     = &webm_dash_class,
     .priv_data_size = sizeof(MatroskaDemuxContext),
-    .flags_internal = FF_FMT_INIT_CLEANUP,
+    .flags_internal = FF_FMT_INIT_CLEANUP | FF_FMT_COMPACT_INDEX,
     .read_header    = webm_dash_manifest_read_header,
     .read_packet    = webm_dash_manifest_read_packet,
     .read_close     = matroska_read_close,
@@ -4430,7 +4437,7 @@ const AVInputFormat ff_matroska_demuxer = {
     .long_name      = NULL_IF_CONFIG_SMALL("Matroska / WebM"),
     .extensions     = "mkv,mk3d,mka,mks,webm",
     .priv_data_size = sizeof(MatroskaDemuxContext),
-    .flags_internal = FF_FMT_INIT_CLEANUP,
+    .flags_internal = FF_FMT_INIT_CLEANUP | FF_FMT_COMPACT_INDEX,
     .read_probe     = matroska_probe,
     .read_header    = matroska_read_header,
     .read_packet    = matroska_read_packet,
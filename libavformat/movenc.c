@@ -112,6 +112,11 @@ static const AVOption options[] = {
     { "pts", NULL, 0, AV_OPT_TYPE_CONST, {.i64 = MOV_PRFT_SRC_PTS}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "prft"},
     { "empty_hdlr_name", "write zero-length name string in hdlr atoms within mdia and minf atoms", offsetof(MOVMuxContext, empty_hdlr_name), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
     { "movie_timescale", "set movie timescale", offsetof(MOVMuxContext, movie_timescale), AV_OPT_TYPE_INT, {.i64 = MOV_TIMESCALE}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
+    { "faststart_mode", "how the faststart flag moves the moov atom to the beginning of the file", offsetof(MOVMuxContext, faststart_mode), AV_OPT_TYPE_INT, {.i64 = MOV_FASTSTART_SHIFT}, 0, MOV_FASTSTART_NB-1, AV_OPT_FLAG_ENCODING_PARAM, "faststart_mode"},
+    { "shift", "rewrite the media data in a second pass", 0, AV_OPT_TYPE_CONST, {.i64 = MOV_FASTSTART_SHIFT}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "faststart_mode"},
+    { "reserve", "reserve space for an estimated moov size, only shift the media data if it is too small", 0, AV_OPT_TYPE_CONST, {.i64 = MOV_FASTSTART_RESERVE}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "faststart_mode"},
+    { "splice", "write the moov atom to a new file and append the media data with copy_file_range()", 0, AV_OPT_TYPE_CONST, {.i64 = MOV_FASTSTART_SPLICE}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "faststart_mode"},
+    { "faststart_moved", "number of bytes of media data moved by faststart", offsetof(MOVMuxContext, faststart_moved), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, AV_OPT_FLAG_ENCODING_PARAM | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
     { NULL },
 };
 
@@ -123,6 +128,7 @@ static const AVClass mov_isobmff_muxer_class = {
 };
 
 static int get_moov_size(AVFormatContext *s);
+static int64_t estimate_moov_size(AVFormatContext *s);
 static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt);
 
 static int utf8len(const uint8_t *b)
@@ -6605,7 +6611,38 @@ static int mov_init(AVFormatContext *s)
     }
 
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        int reserved_moov_size = mov->reserved_moov_size;
+
         mov->reserved_moov_size = -1;
+        if (mov->flags & FF_MOV_FLAG_FRAGMENT) {
+            mov->faststart_mode = MOV_FASTSTART_SHIFT;
+        } else if (mov->faststart_mode == MOV_FASTSTART_RESERVE) {
+            int64_t estimate = reserved_moov_size;
+
+            if (!estimate)
+                estimate = estimate_moov_size(s);
+            if (estimate <= 0) {
+                av_log(s, AV_LOG_WARNING, "Stream durations unknown, cannot estimate "
+                       "the moov size; falling back to shifting the media data\n");
+                mov->faststart_mode = MOV_FASTSTART_SHIFT;
+            } else if (!reserved_moov_size && estimate > MOV_RESERVE_MAX) {
+                av_log(s, AV_LOG_WARNING, "Estimated moov size of %"PRId64" bytes is "
+                       "larger than %d bytes; falling back to shifting the media data\n",
+                       estimate, MOV_RESERVE_MAX);
+                mov->faststart_mode = MOV_FASTSTART_SHIFT;
+            } else {
+                av_log(s, AV_LOG_VERBOSE, "Reserving %"PRId64" bytes for the moov atom\n",
+                       estimate);
+                mov->reserved_moov_size = estimate;
+            }
+        } else if (mov->faststart_mode == MOV_FASTSTART_SPLICE) {
+            const char *proto = avio_find_protocol_name(s->url);
+            if (!HAVE_COPY_FILE_RANGE || !proto || strcmp(proto, "file")) {
+                av_log(s, AV_LOG_WARNING, "Splicing needs copy_file_range() and a local "
+                       "output file; falling back to shifting the media data\n");
+                mov->faststart_mode = MOV_FASTSTART_SHIFT;
+            }
+        }
     }
 
     if (mov->use_editlist < 0) {
@@ -7004,8 +7041,20 @@ static int mov_write_header(AVFormatContext *s)
             !mov->max_fragment_duration && !mov->max_fragment_size)
             mov->flags |= FF_MOV_FLAG_FRAG_KEYFRAME;
     } else {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size < 0) {
             mov->reserved_header_pos = avio_tell(pb);
+            if (mov->faststart_mode == MOV_FASTSTART_SPLICE) {
+                /* Align the media data, so that it stays aligned to file
+                 * system blocks once spliced after the moov atom, which
+                 * allows sharing the blocks instead of copying them. */
+                int64_t size = FFALIGN(mov->reserved_header_pos + 8, MOV_SPLICE_ALIGN) -
+                               mov->reserved_header_pos;
+                avio_wb32(pb, size);
+                ffio_wfourcc(pb, "free");
+                ffio_fill(pb, 0, size - 8);
+            }
+        }
+        mov->faststart_data_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
 
@@ -7138,6 +7187,182 @@ static int compute_sidx_size(AVFormatContext *s)
     return sidx_size;
 }
 
+/*
+ * Estimate the moov size from the stream durations and rates, following how
+ * the sample tables are written: one stsz entry per sample, run-length coded
+ * stts and ctts, stss entries for the keyframes only, and one chunk (co64 and
+ * stsc entry) per sample when the tracks are interleaved or per MiB of data
+ * otherwise. Returns 0 if the duration of an audio or video stream is unknown.
+ */
+static int64_t estimate_moov_size(AVFormatContext *s)
+{
+    double size = 16384;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        const AVCodecDescriptor *desc = avcodec_descriptor_get(par->codec_id);
+        double duration, samples, keyframes = 0, chunks, table;
+        int cfr = 1;
+
+        if (st->duration > 0 && st->time_base.num && st->time_base.den)
+            duration = st->duration * av_q2d(st->time_base);
+        else if (s->duration > 0)
+            duration = s->duration / (double)AV_TIME_BASE;
+        else if (par->codec_type == AVMEDIA_TYPE_VIDEO ||
+                 par->codec_type == AVMEDIA_TYPE_AUDIO)
+            return 0;
+        else
+            duration = 0;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            cfr = st->avg_frame_rate.num && st->avg_frame_rate.den;
+            samples = duration * (cfr ? av_q2d(st->avg_frame_rate) : 60);
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO && par->sample_rate > 0) {
+            samples = duration * par->sample_rate /
+                      (par->frame_size > 0 ? par->frame_size : 1024);
+        } else {
+            cfr     = 0;
+            samples = duration;
+        }
+
+        /* The key frames of a track are only known once it is written and
+         * stss is left out when every sample is one, so a track which can
+         * have non-key samples needs room for up to samples - 1 entries. */
+        if ((par->codec_type == AVMEDIA_TYPE_VIDEO ||
+             par->codec_id == AV_CODEC_ID_TRUEHD ||
+             par->codec_id == AV_CODEC_ID_MPEGH_3D_AUDIO) &&
+            (!desc || !(desc->props & AV_CODEC_PROP_INTRA_ONLY)))
+            keyframes = FFMAX(samples - 1, 0);
+
+        table = 4 * samples;                                    // stsz
+        table += 8 * (cfr ? 16 : samples);                      // stts
+        table += 4 * keyframes;                                 // stss
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO && par->video_delay > 0)
+            table += 8 * samples;                               // ctts
+        if (s->nb_streams > 1 || par->bit_rate <= 0)
+            chunks = samples;
+        else
+            chunks = duration * par->bit_rate / 8 / (1 << 20) + 1;
+        table += (8 + 12) * chunks;                             // co64, stsc
+
+        size += 4096 + table;
+        if (size > INT_MAX)
+            return INT_MAX;
+    }
+    size += size / 8;
+
+    return FFMIN(size, INT_MAX);
+}
+
+/*
+ * Write the moov atom in the space reserved for it. If it does not fit, only
+ * the media data is shifted, by the missing amount rounded up, and the rest
+ * of the reserved space is filled with a free atom.
+ */
+static int mov_write_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t data_pos = mov->reserved_header_pos + mov->reserved_moov_size;
+    int64_t shift = 0, size;
+    int moov_size, ret;
+
+    for (;;) {
+        moov_size = get_moov_size(s);
+        if (moov_size < 0)
+            return moov_size;
+        size = mov->reserved_moov_size + shift;
+        if (moov_size == size || moov_size <= size - 8)
+            break;
+        size = FFALIGN(moov_size + 8 - mov->reserved_moov_size, MOV_RESERVE_GROW);
+        for (int i = 0; i < mov->nb_streams; i++)
+            mov->tracks[i].data_offset += size - shift;
+        shift = size;
+    }
+
+    if (shift) {
+        if (shift > INT_MAX)
+            return AVERROR(EINVAL);
+        av_log(s, AV_LOG_WARNING, "reserved moov size too small by %d bytes, "
+               "shifting the media data by %"PRId64" bytes\n",
+               moov_size - mov->reserved_moov_size, shift);
+        avio_seek(pb, moov_pos, SEEK_SET);
+        if ((ret = ff_format_shift_data(s, data_pos, shift)) < 0)
+            return ret;
+        mov->faststart_moved = moov_pos - data_pos;
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    if ((ret = mov_write_moov_tag(pb, mov, s)) < 0)
+        return ret;
+    size = data_pos + shift - avio_tell(pb);
+    if (size) {
+        avio_wb32(pb, size);
+        ffio_wfourcc(pb, "free");
+        ffio_fill(pb, 0, size - 8);
+    }
+    avio_seek(pb, moov_pos + shift, SEEK_SET);
+    av_log(s, AV_LOG_INFO, "moov atom written in the reserved space, "
+           "%"PRId64" bytes of media data moved\n", mov->faststart_moved);
+
+    return 0;
+}
+
+/*
+ * Write a new file made of the identification atoms, the moov atom and a
+ * free atom keeping the media data aligned, followed by the media data
+ * appended with copy_file_range(), and rename it over the output.
+ */
+static int mov_splice_moov(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *buf;
+    uint8_t *moov_buf;
+    int64_t shift = 0, data_pos, copied;
+    int moov_size, buf_size, ret;
+
+    for (;;) {
+        moov_size = get_moov_size(s);
+        if (moov_size < 0) {
+            ret = moov_size;
+            goto fail;
+        }
+        data_pos = FFALIGN(mov->reserved_header_pos + moov_size + 8, MOV_SPLICE_ALIGN);
+        if (data_pos - mov->faststart_data_pos == shift)
+            break;
+        for (int i = 0; i < mov->nb_streams; i++)
+            mov->tracks[i].data_offset += data_pos - mov->faststart_data_pos - shift;
+        shift = data_pos - mov->faststart_data_pos;
+    }
+
+    if ((ret = avio_open_dyn_buf(&buf)) < 0)
+        goto fail;
+    if ((ret = mov_write_moov_tag(buf, mov, s)) < 0) {
+        ffio_free_dyn_buf(&buf);
+        goto fail;
+    }
+    avio_wb32(buf, data_pos - mov->reserved_header_pos - moov_size);
+    ffio_wfourcc(buf, "free");
+    ffio_fill(buf, 0, data_pos - mov->reserved_header_pos - moov_size - 8);
+    buf_size = avio_close_dyn_buf(buf, &moov_buf);
+
+    ret = ff_format_splice_data(s, mov->reserved_header_pos, moov_buf, buf_size,
+                                mov->faststart_data_pos, &copied);
+    av_free(moov_buf);
+    if (ret < 0)
+        goto fail;
+
+    mov->faststart_moved = copied;
+    av_log(s, AV_LOG_INFO, "moov atom spliced in front of the media data, "
+           "%"PRId64" bytes passed to copy_file_range()\n", copied);
+    return 0;
+fail:
+    for (int i = 0; i < mov->nb_streams; i++)
+        mov->tracks[i].data_offset -= shift;
+    return ret;
+}
+
 static int shift_data(AVFormatContext *s)
 {
     int moov_size;
@@ -7224,11 +7449,24 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size > 0) {
+            if ((res = mov_write_reserved_moov(s, moov_pos)) < 0)
+                return res;
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+            if (mov->faststart_mode == MOV_FASTSTART_SPLICE) {
+                res = mov_splice_moov(s);
+                if (res >= 0)
+                    return 0;
+                av_log(s, AV_LOG_WARNING, "Splicing the moov atom failed (%s), "
+                       "falling back to shifting the media data\n", av_err2str(res));
+            }
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
+            mov->faststart_moved = moov_pos - mov->reserved_header_pos;
             res = shift_data(s);
             if (res < 0)
                 return res;
+            av_log(s, AV_LOG_VERBOSE, "%"PRId64" bytes of media data moved\n",
+                   mov->faststart_moved);
             avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
@@ -31,6 +31,9 @@
 #define MOV_FRAG_INFO_ALLOC_INCREMENT 64
 #define MOV_INDEX_CLUSTER_SIZE 1024
 #define MOV_TIMESCALE 1000
+#define MOV_SPLICE_ALIGN  4096   ///< alignment of the media data for splice faststart
+#define MOV_RESERVE_GROW  65536  ///< granularity of the shift if the reserved moov is too small
+#define MOV_RESERVE_MAX   (64 << 20) ///< largest estimated moov size reserved by reserve faststart
 
 #define RTP_MAX_PACKET_SIZE 1450
 
@@ -182,6 +185,13 @@ typedef enum {
     MOV_PRFT_NB
 } MOVPrftBox;
 
+typedef enum {
+    MOV_FASTSTART_SHIFT = 0,
+    MOV_FASTSTART_RESERVE,
+    MOV_FASTSTART_SPLICE,
+    MOV_FASTSTART_NB
+} MOVFaststartMode;
+
 typedef struct MOVMuxContext {
     const AVClass *av_class;
     int     mode;
@@ -213,6 +223,9 @@ typedef struct MOVMuxContext {
 
     int reserved_moov_size; ///< 0 for disabled, -1 for automatic, size otherwise
     int64_t reserved_header_pos;
+    MOVFaststartMode faststart_mode;
+    int64_t faststart_data_pos;  ///< start of the media data moved by faststart
+    int64_t faststart_moved;     ///< bytes of media data moved by faststart
 
     char *major_brand;
 
@@ -394,6 +394,10 @@ static int discard_pid(MpegTSContext *ts, unsigned int pid)
         for (j = 0; j < p->nb_pids; j++) {
             if (p->pids[j] != pid)
                 continue;
+            /* the PMT tells which other PIDs belong to the program, so
+             * read it at least once even if the program is discarded */
+            if (j == 0 && !p->pmt_found)
+                return 0;
             // is program with id p->id set to be discarded?
             for (k = 0; k < ts->stream->nb_programs; k++) {
                 if (ts->stream->programs[k]->id == p->id) {
@@ -583,16 +587,21 @@ static int analyze(const uint8_t *buf, int size, int packet_size,
     memset(stat, 0, packet_size * sizeof(*stat));
 
     for (i = 0; i < size - 3; i++) {
-        if (buf[i] == 0x47) {
-            int pid = AV_RB16(buf+1) & 0x1FFF;
-            int asc = buf[i + 3] & 0x30;
-            if (!probe || pid == 0x1FFF || asc) {
-                int x = i % packet_size;
-                stat[x]++;
-                stat_all++;
-                if (stat[x] > best_score) {
-                    best_score = stat[x];
-                }
+        const uint8_t *sync = memchr(buf + i, 0x47, size - 3 - i);
+        int pid, asc;
+
+        if (!sync)
+            break;
+        i = sync - buf;
+
+        pid = AV_RB16(buf+1) & 0x1FFF;
+        asc = buf[i + 3] & 0x30;
+        if (!probe || pid == 0x1FFF || asc) {
+            int x = i % packet_size;
+            stat[x]++;
+            stat_all++;
+            if (stat[x] > best_score) {
+                best_score = stat[x];
             }
         }
     }
@@ -2902,9 +2911,26 @@ static int mpegts_resync(AVFormatContext *s, int seekback, const uint8_t *curren
     avio_seek(pb, -back, SEEK_CUR);
 
     for (i = 0; i < ts->resync_size; i++) {
-        c = avio_r8(pb);
-        if (avio_feof(pb))
-            return AVERROR_EOF;
+        int avail = FFMIN(pb->buf_end - pb->buf_ptr, ts->resync_size - i);
+
+        if (avail > 0) {
+            /* scan whatever is already buffered with memchr() instead of
+             * going through avio_r8() for every byte */
+            const uint8_t *sync = memchr(pb->buf_ptr, 0x47, avail);
+            if (!sync) {
+                avio_skip(pb, avail);
+                i += avail - 1;
+                continue;
+            }
+            avail = sync - pb->buf_ptr;
+            avio_skip(pb, avail);
+            i += avail;
+            c = avio_r8(pb);
+        } else {
+            c = avio_r8(pb);
+            if (avio_feof(pb))
+                return AVERROR_EOF;
+        }
         if (c == 0x47) {
             int new_packet_size, ret;
             avio_seek(pb, -1, SEEK_CUR);
@@ -3425,6 +3451,7 @@ const AVInputFormat ff_mpegts_demuxer = {
     .name           = "mpegts",
     .long_name      = NULL_IF_CONFIG_SMALL("MPEG-TS (MPEG-2 Transport Stream)"),
     .priv_data_size = sizeof(MpegTSContext),
+    .flags_internal = FF_FMT_COMPACT_INDEX,
     .read_probe     = mpegts_probe,
     .read_header    = mpegts_read_header,
     .read_packet    = mpegts_read_packet,
@@ -3438,6 +3465,7 @@ const AVInputFormat ff_mpegtsraw_demuxer = {
     .name           = "mpegtsraw",
     .long_name      = NULL_IF_CONFIG_SMALL("raw MPEG-TS (MPEG-2 Transport Stream)"),
     .priv_data_size = sizeof(MpegTSContext),
+    .flags_internal = FF_FMT_COMPACT_INDEX,
     .read_header    = mpegts_read_header,
     .read_packet    = mpegts_raw_read_packet,
     .read_close     = mpegts_read_close,
@@ -23,11 +23,39 @@
 /* needed by inet_aton() */
 #define _DEFAULT_SOURCE
 #define _SVID_SOURCE
+/* needed by copy_file_range() */
+#define _GNU_SOURCE
 
 #include "config.h"
 #include "avformat.h"
 #include "os_support.h"
 
+#if HAVE_COPY_FILE_RANGE
+#include <errno.h>
+#include <unistd.h>
+
+int64_t ff_copy_file_range(int fd_in, int64_t off_in,
+                           int fd_out, int64_t off_out, int64_t len)
+{
+    loff_t in = off_in, out = off_out;
+    int64_t copied = 0;
+
+    while (copied < len) {
+        ssize_t ret = copy_file_range(fd_in, &in, fd_out, &out,
+                                      FFMIN(len - copied, 1 << 30), 0);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return copied ? copied : AVERROR(errno);
+        }
+        if (!ret)
+            break;
+        copied += ret;
+    }
+    return copied;
+}
+#endif /* HAVE_COPY_FILE_RANGE */
+
 #if CONFIG_NETWORK
 #include <fcntl.h>
 #if !HAVE_POLL_H
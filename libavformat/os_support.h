@@ -29,6 +29,7 @@
 
 #include "config.h"
 
+#include <stdint.h>
 #include <sys/stat.h>
 
 #ifdef _WIN32
@@ -76,6 +77,20 @@ static inline int is_dos_path(const char *path)
     return 0;
 }
 
+#if HAVE_COPY_FILE_RANGE
+/**
+ * Copy len bytes from fd_in at off_in to fd_out at off_out with
+ * copy_file_range(), letting the kernel share the extents instead of copying
+ * the data on file systems supporting it.
+ *
+ * @return the number of bytes copied, which is less than len if the end of
+ *         fd_in was reached or an error occurred after some data was copied,
+ *         or a negative AVERROR if nothing could be copied
+ */
+int64_t ff_copy_file_range(int fd_in, int64_t off_in,
+                           int fd_out, int64_t off_out, int64_t len);
+#endif
+
 #if defined(_WIN32)
 #ifndef S_IRUSR
 #define S_IRUSR S_IREAD
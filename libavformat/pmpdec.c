@@ -187,6 +187,7 @@ const AVInputFormat ff_pmp_demuxer = {
     .name           = "pmp",
     .long_name      = NULL_IF_CONFIG_SMALL("Playstation Portable PMP"),
     .priv_data_size = sizeof(PMPContext),
+    .flags_internal = FF_FMT_COMPACT_INDEX,
     .read_probe     = pmp_probe,
     .read_header    = pmp_header,
     .read_packet    = pmp_packet,
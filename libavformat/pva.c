@@ -232,6 +232,7 @@ const AVInputFormat ff_pva_demuxer = {
     .name           = "pva",
     .long_name      = NULL_IF_CONFIG_SMALL("TechnoTrend PVA"),
     .priv_data_size = sizeof(PVAContext),
+    .flags_internal = FF_FMT_COMPACT_INDEX,
     .read_probe     = pva_probe,
     .read_header    = pva_read_header,
     .read_packet    = pva_read_packet,
@@ -22,12 +22,15 @@
 #include <stdint.h>
 
 #include "libavutil/avassert.h"
+#include "libavutil/avstring.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/timestamp.h"
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "compactindex.h"
 #include "internal.h"
+#include "os_support.h"
 
 void avpriv_update_cur_dts(AVFormatContext *s, AVStream *ref_st, int64_t timestamp)
 {
@@ -48,6 +51,13 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
     FFStream *const sti = ffstream(st);
     unsigned int max_entries = s->max_index_size / sizeof(AVIndexEntry);
 
+    if (sti->compact_index) {
+        if (ff_compact_index_memory_size(sti->compact_index) >= s->max_index_size &&
+            ff_compact_index_decimate(&sti->compact_index) >= 0)
+            sti->nb_index_entries = sti->compact_index->nb_entries;
+        return;
+    }
+
     if ((unsigned) sti->nb_index_entries >= max_entries) {
         int i;
         for (i = 0; 2 * i < sti->nb_index_entries; i++)
@@ -119,6 +129,12 @@ int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
 {
     FFStream *const sti = ffstream(st);
     timestamp = ff_wrap_timestamp(st, timestamp);
+    if (sti->compact_index) {
+        int ret = ff_compact_index_add(sti->compact_index, pos, timestamp,
+                                       size, distance, flags);
+        sti->nb_index_entries = sti->compact_index->nb_entries;
+        return ret;
+    }
     return ff_add_index_entry(&sti->index_entries, &sti->nb_index_entries,
                               &sti->index_entries_allocated_size, pos,
                               timestamp, size, distance, flags);
@@ -198,12 +214,12 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
                 continue;
 
             for (int i1 = 0, i2 = 0; i1 < sti1->nb_index_entries; i1++) {
-                const AVIndexEntry *const e1 = &sti1->index_entries[i1];
+                const AVIndexEntry *const e1 = avformat_index_get_entry(st1, i1);
                 int64_t e1_pts = av_rescale_q(e1->timestamp, st1->time_base, AV_TIME_BASE_Q);
 
                 skip = FFMAX(skip, e1->size);
                 for (; i2 < sti2->nb_index_entries; i2++) {
-                    const AVIndexEntry *const e2 = &sti2->index_entries[i2];
+                    const AVIndexEntry *const e2 = avformat_index_get_entry(st2, i2);
                     int64_t e2_pts = av_rescale_q(e2->timestamp, st2->time_base, AV_TIME_BASE_Q);
                     if (e2_pts < e1_pts || e2_pts - (uint64_t)e1_pts < time_tolerance)
                         continue;
@@ -237,6 +253,8 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
 int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
 {
     const FFStream *const sti = ffstream(st);
+    if (sti->compact_index)
+        return ff_compact_index_search(sti->compact_index, wanted_timestamp, flags);
     return ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
                                      wanted_timestamp, flags);
 }
@@ -251,6 +269,8 @@ const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx)
     const FFStream *const sti = ffstream(st);
     if (idx < 0 || idx >= sti->nb_index_entries)
         return NULL;
+    if (sti->compact_index)
+        return ff_compact_index_get(sti->compact_index, idx);
 
     return &sti->index_entries[idx];
 }
@@ -259,15 +279,12 @@ const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
                                                             int64_t wanted_timestamp,
                                                             int flags)
 {
-    const FFStream *const sti = ffstream(st);
-    int idx = ff_index_search_timestamp(sti->index_entries,
-                                        sti->nb_index_entries,
-                                        wanted_timestamp, flags);
+    int idx = av_index_search_timestamp(st, wanted_timestamp, flags);
 
     if (idx < 0)
         return NULL;
 
-    return &sti->index_entries[idx];
+    return avformat_index_get_entry(st, idx);
 }
 
 static int64_t read_timestamp(AVFormatContext *s, int stream_index, int64_t *ppos, int64_t pos_limit,
@@ -301,7 +318,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
 
     st  = s->streams[stream_index];
     sti = ffstream(st);
-    if (sti->index_entries) {
+    if (sti->nb_index_entries) {
         const AVIndexEntry *e;
 
         /* FIXME: Whole function must be checked for non-keyframe entries in
@@ -309,7 +326,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
         index = av_index_search_timestamp(st, target_ts,
                                           flags | AVSEEK_FLAG_BACKWARD);
         index = FFMAX(index, 0);
-        e     = &sti->index_entries[index];
+        e     = avformat_index_get_entry(st, index);
 
         if (e->timestamp <= target_ts || e->pos == e->min_distance) {
             pos_min = e->pos;
@@ -324,7 +341,7 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
                                           flags & ~AVSEEK_FLAG_BACKWARD);
         av_assert0(index < sti->nb_index_entries);
         if (index >= 0) {
-            e = &sti->index_entries[index];
+            e = avformat_index_get_entry(st, index);
             av_assert1(e->timestamp >= target_ts);
             pos_max   = e->pos;
             ts_max    = e->timestamp;
@@ -528,7 +545,7 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     index = av_index_search_timestamp(st, timestamp, flags);
 
     if (index < 0 && sti->nb_index_entries &&
-        timestamp < sti->index_entries[0].timestamp)
+        timestamp < avformat_index_get_entry(st, 0)->timestamp)
         return -1;
 
     if (index < 0 || index == sti->nb_index_entries - 1) {
@@ -536,8 +553,8 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
         int nonkey = 0;
 
         if (sti->nb_index_entries) {
-            av_assert0(sti->index_entries);
-            ie = &sti->index_entries[sti->nb_index_entries - 1];
+            ie = avformat_index_get_entry(st, sti->nb_index_entries - 1);
+            av_assert0(ie);
             if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
                 return ret;
             s->io_repositioned = 1;
@@ -577,7 +594,30 @@ static int seek_frame_generic(AVFormatContext *s, int stream_index,
     if (s->iformat->read_seek)
         if (s->iformat->read_seek(s, stream_index, timestamp, flags) >= 0)
             return 0;
-    ie = &sti->index_entries[index];
+    ie = avformat_index_get_entry(st, index);
+    if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
+        return ret;
+    s->io_repositioned = 1;
+    avpriv_update_cur_dts(s, st, ie->timestamp);
+
+    return 0;
+}
+
+/* Seek to an entry of a complete index, without reading anything. */
+static int seek_frame_index(AVFormatContext *s, int stream_index,
+                            int64_t timestamp, int flags)
+{
+    AVStream *const st = s->streams[stream_index];
+    const AVIndexEntry *ie;
+    int64_t ret;
+    int index;
+
+    index = av_index_search_timestamp(st, timestamp, flags);
+    if (index < 0)
+        return -1;
+
+    ff_read_frame_flush(s);
+    ie = avformat_index_get_entry(st, index);
     if ((ret = avio_seek(s->pb, ie->pos, SEEK_SET)) < 0)
         return ret;
     s->io_repositioned = 1;
@@ -610,6 +650,12 @@ static int seek_frame_internal(AVFormatContext *s, int stream_index,
                                AV_TIME_BASE * (int64_t) st->time_base.num);
     }
 
+    if (ffformatcontext(s)->seek_index_pending)
+        ff_load_seek_index(s);
+    if (ffformatcontext(s)->index_complete &&
+        seek_frame_index(s, stream_index, timestamp, flags) >= 0)
+        return 0;
+
     /* first, we try the format specific seek */
     if (s->iformat->read_seek) {
         ff_read_frame_flush(s);
@@ -751,3 +797,199 @@ int avformat_flush(AVFormatContext *s)
     ff_read_frame_flush(s);
     return 0;
 }
+
+#define SEEK_INDEX_TAG     MKBETAG('F', 'F', 'S', 'I')
+#define SEEK_INDEX_VERSION 1
+
+int avformat_index_build(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    unsigned int max_index_size = s->max_index_size;
+    int64_t start;
+    AVPacket *pkt;
+    int ret;
+
+    if (!s->pb || !(s->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return AVERROR(ENOSYS);
+    if (!(pkt = av_packet_alloc()))
+        return AVERROR(ENOMEM);
+
+    /* the whole index is wanted, the generic index must not reduce it */
+    s->max_index_size = UINT_MAX;
+    while ((ret = av_read_frame(s, pkt)) >= 0 || ret == AVERROR(EAGAIN)) {
+        if (ret >= 0 && pkt->flags & AV_PKT_FLAG_KEY &&
+            pkt->pos >= 0 && pkt->dts != AV_NOPTS_VALUE)
+            av_add_index_entry(s->streams[pkt->stream_index], pkt->pos,
+                               pkt->dts, pkt->size, 0, AVINDEX_KEYFRAME);
+        av_packet_unref(pkt);
+    }
+    s->max_index_size = max_index_size;
+    av_packet_free(&pkt);
+    if (ret != AVERROR_EOF)
+        return ret;
+
+    si->index_complete = 1;
+    start = s->start_time != AV_NOPTS_VALUE ? s->start_time : 0;
+    if (av_seek_frame(s, -1, start, AVSEEK_FLAG_BACKWARD) < 0) {
+        ff_read_frame_flush(s);
+        if ((ret = avio_seek(s->pb, si->data_offset, SEEK_SET)) < 0)
+            return ret;
+        s->io_repositioned = 1;
+    }
+
+    return 0;
+}
+
+/* Modification time of local input files, so that a stale index is noticed
+ * even if the file size did not change. */
+static int64_t input_mtime(AVFormatContext *s)
+{
+    const char *proto = avio_find_protocol_name(s->url);
+    const char *path  = s->url;
+    struct stat st;
+
+    if (!proto || strcmp(proto, "file"))
+        return AV_NOPTS_VALUE;
+    av_strstart(path, "file:", &path);
+    if (stat(path, &st) < 0)
+        return AV_NOPTS_VALUE;
+    return st.st_mtime;
+}
+
+int avformat_index_save(AVFormatContext *s, AVIOContext *pb)
+{
+    avio_wb32(pb, SEEK_INDEX_TAG);
+    avio_wb32(pb, SEEK_INDEX_VERSION);
+    avio_wb64(pb, s->pb ? avio_size(s->pb) : -1);
+    avio_wb64(pb, input_mtime(s));
+    avio_wb32(pb, s->nb_streams);
+
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        AVStream *const st = s->streams[i];
+        avio_wb32(pb, st->id);
+        avio_wb32(pb, st->time_base.num);
+        avio_wb32(pb, st->time_base.den);
+        avio_wb32(pb, avformat_index_get_entries_count(st));
+    }
+
+    for (unsigned i = 0; i < s->nb_streams; i++) {
+        AVStream *const st = s->streams[i];
+        int nb_entries = avformat_index_get_entries_count(st);
+
+        for (int j = 0; j < nb_entries; j++) {
+            const AVIndexEntry *e = avformat_index_get_entry(st, j);
+            avio_wb64(pb, e->pos);
+            avio_wb64(pb, e->timestamp);
+            avio_wb32(pb, e->size);
+            avio_wb32(pb, e->min_distance);
+            avio_wb32(pb, e->flags);
+        }
+    }
+    avio_flush(pb);
+
+    return pb->error;
+}
+
+int avformat_index_load(AVFormatContext *s, AVIOContext *pb)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    int64_t size, mtime, cur_size, cur_mtime;
+    unsigned int nb_streams, max_entries = 0;
+    int *nb_entries, skipped = 0;
+    int ret = 0;
+
+    if (avio_rb32(pb) != SEEK_INDEX_TAG || avio_rb32(pb) != SEEK_INDEX_VERSION) {
+        av_log(s, AV_LOG_ERROR, "Invalid seek index\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    size       = avio_rb64(pb);
+    mtime      = avio_rb64(pb);
+    cur_size   = s->pb ? avio_size(s->pb) : -1;
+    cur_mtime  = input_mtime(s);
+    if (size != cur_size ||
+        (mtime != AV_NOPTS_VALUE && cur_mtime != AV_NOPTS_VALUE && mtime != cur_mtime)) {
+        av_log(s, AV_LOG_WARNING, "Seek index does not match the input, ignoring it\n");
+        return AVERROR(EINVAL);
+    }
+
+    nb_streams = avio_rb32(pb);
+    if (nb_streams > s->max_streams)
+        return AVERROR_INVALIDDATA;
+    nb_entries = av_calloc(nb_streams, sizeof(*nb_entries));
+    if (!nb_entries)
+        return AVERROR(ENOMEM);
+
+    for (unsigned i = 0; i < nb_streams; i++) {
+        int id            = avio_rb32(pb);
+        AVRational tb     = { avio_rb32(pb), 0 };
+        tb.den            = avio_rb32(pb);
+        nb_entries[i]     = avio_rb32(pb);
+
+        if (nb_entries[i] < 0) {
+            ret = AVERROR_INVALIDDATA;
+            goto end;
+        }
+        /* streams the demuxer does not know (yet) are skipped */
+        if (i >= s->nb_streams || s->streams[i]->id != id ||
+            av_cmp_q(s->streams[i]->time_base, tb)) {
+            av_log(s, AV_LOG_VERBOSE, "Skipping seek index of stream %u\n", i);
+            nb_entries[i] = -nb_entries[i] - 1;
+            skipped = 1;
+        }
+        max_entries = FFMAX(max_entries, nb_entries[i] < 0 ? 0 : nb_entries[i]);
+    }
+
+    /* keep room for the generic index, so that it does not reduce ours */
+    if (max_entries >= s->max_index_size / sizeof(AVIndexEntry) / 2)
+        s->max_index_size = FFMIN(2ULL * (max_entries + 1) * sizeof(AVIndexEntry),
+                                  UINT_MAX);
+
+    for (unsigned i = 0; i < nb_streams && !avio_feof(pb); i++) {
+        int skip = nb_entries[i] < 0;
+        int n    = skip ? -nb_entries[i] - 1 : nb_entries[i];
+
+        if (skip) {
+            avio_skip(pb, n * 28LL);
+            continue;
+        }
+        for (int j = 0; j < n && !avio_feof(pb); j++) {
+            int64_t pos       = avio_rb64(pb);
+            int64_t timestamp = avio_rb64(pb);
+            int entry_size    = avio_rb32(pb);
+            int distance      = avio_rb32(pb);
+            int flags         = avio_rb32(pb);
+            av_add_index_entry(s->streams[i], pos, timestamp, entry_size,
+                               distance, flags);
+        }
+    }
+
+    if (avio_feof(pb)) {
+        av_log(s, AV_LOG_ERROR, "Truncated seek index\n");
+        ret = AVERROR_INVALIDDATA;
+    } else if (skipped || nb_streams != s->nb_streams) {
+        /* the entries still help the usual seeking, but it must not rely
+         * on them alone */
+        av_log(s, AV_LOG_WARNING, "Seek index does not cover all streams\n");
+    } else {
+        si->index_complete = 1;
+    }
+
+end:
+    av_free(nb_entries);
+    return ret;
+}
+
+void ff_load_seek_index(AVFormatContext *s)
+{
+    AVIOContext *pb;
+
+    ffformatcontext(s)->seek_index_pending = 0;
+    if (s->io_open(s, &pb, s->seek_index_url, AVIO_FLAG_READ, NULL) < 0) {
+        av_log(s, AV_LOG_WARNING, "Could not open seek index %s\n",
+               s->seek_index_url);
+        return;
+    }
+    avformat_index_load(s, pb);
+    ff_format_io_close(s, &pb);
+}
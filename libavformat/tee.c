@@ -20,9 +20,13 @@
  */
 
 
+#include <stdatomic.h>
+
 #include "libavutil/avutil.h"
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
 #include "libavcodec/bsf.h"
 #include "internal.h"
 #include "avformat.h"
@@ -36,6 +40,13 @@ typedef enum {
 
 #define DEFAULT_SLAVE_FAILURE_POLICY ON_SLAVE_FAILURE_ABORT
 
+typedef enum {
+    QUEUE_FULL_BLOCK = 0,
+    QUEUE_FULL_DROP  = 1,
+} QueueFullPolicy;
+
+#define DEFAULT_QUEUE_SIZE 60
+
 typedef struct {
     AVFormatContext *avf;
     AVBSFContext **bsfs; ///< bitstream filters per stream
@@ -48,6 +59,33 @@ typedef struct {
      * disabled output streams are set to -1 */
     int *stream_map;
     int header_written;
+
+    AVFormatContext *parent;
+    int use_thread;
+    int queue_size;
+    QueueFullPolicy drop_policy;
+    AVThreadMessageQueue *queue;
+#if HAVE_THREADS
+    pthread_t thread;
+    pthread_mutex_t flush_lock;
+    pthread_cond_t flush_cond;
+#endif
+    int thread_started;
+    int thread_ret;
+    /** flushes requested from and completed by the slave thread */
+    int64_t flushes_queued;
+    int64_t flushes_done;
+    int thread_exited;
+    /** set on output streams which are dropped until the next keyframe */
+    uint8_t *drop_until_key;
+    int overflow;
+
+    /** timestamp of the last packet written by the slave thread */
+    atomic_int_least64_t written_ts;
+    int64_t packets_queued;
+    int64_t packets_dropped;
+    int64_t max_queue_depth;
+    int64_t max_lag;
 } TeeSlave;
 
 typedef struct TeeContext {
@@ -57,6 +95,14 @@ typedef struct TeeContext {
     TeeSlave *slaves;
     int use_fifo;
     AVDictionary *fifo_options;
+    int use_threads;
+    int queue_size;
+    int drop_policy;
+    AVPacket *shared_pkt;
+
+    int64_t packets_dropped;
+    int64_t max_queue_depth;
+    int64_t max_lag;
 } TeeContext;
 
 static const char *const slave_delim     = "|";
@@ -64,11 +110,26 @@ static const char *const slave_bsfs_spec_sep = "/";
 static const char *const slave_select_sep = ",";
 
 #define OFFSET(x) offsetof(TeeContext, x)
+#define STATS AV_OPT_FLAG_ENCODING_PARAM | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY
 static const AVOption options[] = {
         {"use_fifo", "Use fifo pseudo-muxer to separate actual muxers from encoder",
          OFFSET(use_fifo), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
         {"fifo_options", "fifo pseudo-muxer options", OFFSET(fifo_options),
          AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM},
+        {"use_threads", "Write each slave from its own thread",
+         OFFSET(use_threads), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
+        {"queue_size", "Maximum number of packets queued for a threaded slave",
+         OFFSET(queue_size), AV_OPT_TYPE_INT, {.i64 = DEFAULT_QUEUE_SIZE}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
+        {"drop_policy", "What to do when the queue of a threaded slave is full",
+         OFFSET(drop_policy), AV_OPT_TYPE_INT, {.i64 = QUEUE_FULL_BLOCK}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM, "drop_policy"},
+        {"block", "wait for the slave", 0, AV_OPT_TYPE_CONST, {.i64 = QUEUE_FULL_BLOCK}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "drop_policy"},
+        {"drop", "drop packets until the next keyframe", 0, AV_OPT_TYPE_CONST, {.i64 = QUEUE_FULL_DROP}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "drop_policy"},
+        {"packets_dropped", "Number of packets dropped by threaded slaves",
+         OFFSET(packets_dropped), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, STATS},
+        {"max_queue_depth", "Highest number of packets queued for a threaded slave",
+         OFFSET(max_queue_depth), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, STATS},
+        {"max_lag", "Highest lag of a threaded slave behind the input, in microseconds",
+         OFFSET(max_lag), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, STATS},
         {NULL}
 };
 
@@ -115,19 +176,244 @@ static int parse_slave_fifo_options(const char *fifo_options, TeeSlave *tee_slav
     return av_dict_parse_string(&tee_slave->fifo_options, fifo_options, "=", ":", 0);
 }
 
+static int parse_slave_thread_policy(const char *use_thread, TeeSlave *tee_slave)
+{
+    if (av_match_name(use_thread, "true,y,yes,enable,enabled,on,1")) {
+        tee_slave->use_thread = 1;
+    } else if (av_match_name(use_thread, "false,n,no,disable,disabled,off,0")) {
+        tee_slave->use_thread = 0;
+    } else {
+        return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+static int parse_slave_queue_size(const char *queue_size, TeeSlave *tee_slave)
+{
+    char *end;
+    long size = strtol(queue_size, &end, 10);
+
+    if (*end || size < 1 || size > INT_MAX)
+        return AVERROR(EINVAL);
+    tee_slave->queue_size = size;
+    return 0;
+}
+
+static int parse_slave_drop_policy(const char *drop_policy, TeeSlave *tee_slave)
+{
+    if (!av_strcasecmp("block", drop_policy)) {
+        tee_slave->drop_policy = QUEUE_FULL_BLOCK;
+    } else if (!av_strcasecmp("drop", drop_policy)) {
+        tee_slave->drop_policy = QUEUE_FULL_DROP;
+    } else {
+        return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+/**
+ * Filter pkt, which belongs to output stream s2 of the slave, and write it
+ * to the slave. pkt is unreferenced.
+ */
+static int write_slave_packet(TeeSlave *tee_slave, AVPacket *pkt, int s2)
+{
+    AVFormatContext *avf2 = tee_slave->avf;
+    AVBSFContext *bsfs = tee_slave->bsfs[s2];
+    int ret;
+
+    pkt->stream_index = s2;
+    ret = av_bsf_send_packet(bsfs, pkt);
+    if (ret < 0) {
+        av_packet_unref(pkt);
+        av_log(tee_slave->parent, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
+               av_err2str(ret));
+        return ret;
+    }
+
+    while(1) {
+        ret = av_bsf_receive_packet(bsfs, pkt);
+        if (ret == AVERROR(EAGAIN)) {
+            ret = 0;
+            break;
+        } else if (ret < 0) {
+            break;
+        }
+
+        av_packet_rescale_ts(pkt, bsfs->time_base_out,
+                             avf2->streams[s2]->time_base);
+        ret = av_interleaved_write_frame(avf2, pkt);
+        if (ret < 0)
+            break;
+    };
+    return ret;
+}
+
+static int64_t packet_ts(AVFormatContext *avf, const AVPacket *pkt)
+{
+    int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+
+    if (ts == AV_NOPTS_VALUE)
+        return AV_NOPTS_VALUE;
+    return av_rescale_q(ts, avf->streams[pkt->stream_index]->time_base, AV_TIME_BASE_Q);
+}
+
+#if HAVE_THREADS
+static void free_queued_packet(void *msg)
+{
+    av_packet_free(msg);
+}
+
+static void *slave_thread(void *arg)
+{
+    TeeSlave *tee_slave = arg;
+    AVPacket *pkt;
+    int ret;
+
+    for (;;) {
+        ret = av_thread_message_queue_recv(tee_slave->queue, &pkt, 0);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF)
+                ret = 0;
+            break;
+        }
+
+        /* a NULL packet requests a flush */
+        if (!pkt) {
+            ret = av_interleaved_write_frame(tee_slave->avf, NULL);
+            pthread_mutex_lock(&tee_slave->flush_lock);
+            tee_slave->flushes_done++;
+            pthread_cond_signal(&tee_slave->flush_cond);
+            pthread_mutex_unlock(&tee_slave->flush_lock);
+        } else {
+            int64_t ts = packet_ts(tee_slave->parent, pkt);
+            ret = write_slave_packet(tee_slave, pkt, tee_slave->stream_map[pkt->stream_index]);
+            av_packet_free(&pkt);
+            if (ts != AV_NOPTS_VALUE)
+                atomic_store(&tee_slave->written_ts, ts);
+        }
+        if (ret < 0)
+            break;
+    }
+
+    pthread_mutex_lock(&tee_slave->flush_lock);
+    tee_slave->thread_ret    = ret;
+    tee_slave->thread_exited = 1;
+    pthread_cond_signal(&tee_slave->flush_cond);
+    pthread_mutex_unlock(&tee_slave->flush_lock);
+    /* make the next send fail, so that the failure is handled */
+    if (ret < 0)
+        av_thread_message_queue_set_err_send(tee_slave->queue, ret);
+    return NULL;
+}
+
+static int start_slave_thread(AVFormatContext *avf, TeeSlave *tee_slave)
+{
+    int ret;
+
+    tee_slave->drop_until_key = av_calloc(tee_slave->avf->nb_streams,
+                                          sizeof(*tee_slave->drop_until_key));
+    if (!tee_slave->drop_until_key)
+        return AVERROR(ENOMEM);
+
+    ret = av_thread_message_queue_alloc2(&tee_slave->queue, tee_slave->queue_size,
+                                         sizeof(AVPacket *),
+                                         AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC);
+    if (ret < 0)
+        return ret;
+    av_thread_message_queue_set_free_func(tee_slave->queue, free_queued_packet);
+    atomic_init(&tee_slave->written_ts, AV_NOPTS_VALUE);
+
+    if ((ret = pthread_mutex_init(&tee_slave->flush_lock, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&tee_slave->flush_cond, NULL))) {
+        pthread_mutex_destroy(&tee_slave->flush_lock);
+        return AVERROR(ret);
+    }
+    ret = pthread_create(&tee_slave->thread, NULL, slave_thread, tee_slave);
+    if (ret) {
+        av_log(avf, AV_LOG_ERROR, "Failed to start slave thread: %s\n",
+               av_err2str(AVERROR(ret)));
+        pthread_cond_destroy(&tee_slave->flush_cond);
+        pthread_mutex_destroy(&tee_slave->flush_lock);
+        return AVERROR(ret);
+    }
+    tee_slave->thread_started = 1;
+    return 0;
+}
+
+/* Let the thread write the queued packets and wait for it. */
+static int stop_slave_thread(TeeSlave *tee_slave)
+{
+    if (!tee_slave->thread_started)
+        return 0;
+
+    av_thread_message_queue_set_err_recv(tee_slave->queue, AVERROR_EOF);
+    pthread_join(tee_slave->thread, NULL);
+    pthread_cond_destroy(&tee_slave->flush_cond);
+    pthread_mutex_destroy(&tee_slave->flush_lock);
+    tee_slave->thread_started = 0;
+    return tee_slave->thread_ret;
+}
+
+/* Wait until the slave thread has written all the flushes queued for it. */
+static int wait_slave_flush(TeeSlave *tee_slave)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&tee_slave->flush_lock);
+    while (tee_slave->flushes_done < tee_slave->flushes_queued &&
+           !tee_slave->thread_exited)
+        pthread_cond_wait(&tee_slave->flush_cond, &tee_slave->flush_lock);
+    if (tee_slave->flushes_done < tee_slave->flushes_queued)
+        ret = tee_slave->thread_ret < 0 ? tee_slave->thread_ret : AVERROR_EXIT;
+    pthread_mutex_unlock(&tee_slave->flush_lock);
+    return ret;
+}
+#else
+static int start_slave_thread(AVFormatContext *avf, TeeSlave *tee_slave)
+{
+    av_log(avf, AV_LOG_WARNING, "Threaded slaves require threads, writing from the muxing thread\n");
+    tee_slave->use_thread = 0;
+    return 0;
+}
+
+static int stop_slave_thread(TeeSlave *tee_slave)
+{
+    return 0;
+}
+
+static int wait_slave_flush(TeeSlave *tee_slave)
+{
+    return 0;
+}
+#endif /* HAVE_THREADS */
+
 static int close_slave(TeeSlave *tee_slave)
 {
     AVFormatContext *avf;
     unsigned i;
-    int ret = 0;
+    int ret = 0, thread_ret;
 
     av_dict_free(&tee_slave->fifo_options);
     avf = tee_slave->avf;
     if (!avf)
         return 0;
 
+    thread_ret = stop_slave_thread(tee_slave);
+    av_thread_message_queue_free(&tee_slave->queue);
+    av_freep(&tee_slave->drop_until_key);
+    if (tee_slave->use_thread) {
+        av_log(tee_slave->parent, tee_slave->packets_dropped ? AV_LOG_WARNING : AV_LOG_VERBOSE,
+               "Slave '%s': %"PRId64" packets queued, %"PRId64" dropped, "
+               "maximum queue depth %"PRId64", maximum lag %"PRId64" ms\n",
+               avf->url, tee_slave->packets_queued, tee_slave->packets_dropped,
+               tee_slave->max_queue_depth, tee_slave->max_lag / 1000);
+    }
+
     if (tee_slave->header_written)
         ret = av_write_trailer(avf);
+    if (thread_ret < 0)
+        ret = thread_ret;
 
     if (tee_slave->bsfs) {
         for (i = 0; i < avf->nb_streams; ++i)
@@ -161,6 +447,7 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
     char *filename;
     char *format = NULL, *select = NULL, *on_fail = NULL;
     char *use_fifo = NULL, *fifo_options_str = NULL;
+    char *use_thread = NULL, *queue_size = NULL, *drop_policy = NULL;
     AVFormatContext *avf2 = NULL;
     AVStream *st, *st2;
     int stream_count;
@@ -185,6 +472,16 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
 
     STEAL_OPTION("f", format);
     STEAL_OPTION("select", select);
+    PROCESS_OPTION("use_thread", use_thread,
+                   parse_slave_thread_policy(use_thread, tee_slave),
+                   av_log(avf, AV_LOG_ERROR, "Invalid use_thread option value\n"););
+    PROCESS_OPTION("queue_size", queue_size,
+                   parse_slave_queue_size(queue_size, tee_slave),
+                   av_log(avf, AV_LOG_ERROR, "Invalid queue_size option value\n"););
+    PROCESS_OPTION("drop_policy", drop_policy,
+                   parse_slave_drop_policy(drop_policy, tee_slave),
+                   av_log(avf, AV_LOG_ERROR, "Invalid drop_policy option value, "
+                          "valid options are 'block' and 'drop'\n"););
     PROCESS_OPTION("onfail", on_fail,
                    parse_slave_failure_policy_option(on_fail, tee_slave),
                    av_log(avf, AV_LOG_ERROR, "Invalid onfail option value, "
@@ -398,6 +695,14 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
         goto end;
     }
 
+    if (tee_slave->use_thread && tee_slave->use_fifo) {
+        av_log(avf, AV_LOG_WARNING, "Slave '%s': the fifo muxer already writes "
+               "from its own thread, use_thread is ignored\n", slave);
+        tee_slave->use_thread = 0;
+    }
+    if (tee_slave->use_thread)
+        ret = start_slave_thread(avf, tee_slave);
+
 end:
     av_free(format);
     av_free(select);
@@ -472,7 +777,8 @@ static int tee_write_header(AVFormatContext *avf)
             filename++;
     }
 
-    if (!FF_ALLOCZ_TYPED_ARRAY(tee->slaves, nb_slaves)) {
+    if (!FF_ALLOCZ_TYPED_ARRAY(tee->slaves, nb_slaves) ||
+        !(tee->shared_pkt = av_packet_alloc())) {
         ret = AVERROR(ENOMEM);
         goto fail;
     }
@@ -480,7 +786,11 @@ static int tee_write_header(AVFormatContext *avf)
 
     for (i = 0; i < nb_slaves; i++) {
 
-        tee->slaves[i].use_fifo = tee->use_fifo;
+        tee->slaves[i].parent      = avf;
+        tee->slaves[i].use_fifo    = tee->use_fifo;
+        tee->slaves[i].use_thread  = tee->use_threads;
+        tee->slaves[i].queue_size  = tee->queue_size;
+        tee->slaves[i].drop_policy = tee->drop_policy;
         ret = av_dict_copy(&tee->slaves[i].fifo_options, tee->fifo_options, 0);
         if (ret < 0)
             goto fail;
@@ -532,71 +842,138 @@ static int tee_write_trailer(AVFormatContext *avf)
     return ret_all;
 }
 
+static void tee_deinit(AVFormatContext *avf)
+{
+    TeeContext *tee = avf->priv_data;
+
+    /* slaves are left open if the trailer is not written */
+    if (tee->slaves)
+        close_slaves(avf);
+    av_packet_free(&tee->shared_pkt);
+}
+
+/* Queue pkt for the thread of a slave, pkt is consumed. */
+static int queue_slave_packet(AVFormatContext *avf, TeeSlave *tee_slave,
+                              AVPacket *pkt, int s2)
+{
+    TeeContext *tee = avf->priv_data;
+    int64_t ts = AV_NOPTS_VALUE, written_ts;
+    int ret, depth;
+
+    if (pkt) {
+        ts = packet_ts(avf, pkt);
+        /* resume a stream only where it can be decoded again */
+        if (tee_slave->drop_until_key[s2] && !(pkt->flags & AV_PKT_FLAG_KEY)) {
+            av_packet_free(&pkt);
+            tee_slave->packets_dropped++;
+            tee->packets_dropped++;
+            return 0;
+        }
+    }
+
+    /* flushes are never dropped */
+    ret = av_thread_message_queue_send(tee_slave->queue, &pkt,
+                                       pkt && tee_slave->drop_policy == QUEUE_FULL_DROP ?
+                                       AV_THREAD_MESSAGE_NONBLOCK : 0);
+    if (ret == AVERROR(EAGAIN)) {
+        if (!tee_slave->overflow)
+            av_log(avf, AV_LOG_WARNING, "Slave '%s': queue full, dropping packets\n",
+                   tee_slave->avf->url);
+        tee_slave->overflow = 1;
+        av_packet_free(&pkt);
+        tee_slave->drop_until_key[s2] = 1;
+        tee_slave->packets_dropped++;
+        tee->packets_dropped++;
+        return 0;
+    } else if (ret < 0) {
+        av_packet_free(&pkt);
+        return ret;
+    }
+    if (!pkt) {
+        tee_slave->flushes_queued++;
+        return 0;
+    }
+
+    tee_slave->overflow = 0;
+    tee_slave->drop_until_key[s2] = 0;
+    tee_slave->packets_queued++;
+
+    depth = av_thread_message_queue_nb_elems(tee_slave->queue);
+    tee_slave->max_queue_depth = FFMAX(tee_slave->max_queue_depth, depth);
+    tee->max_queue_depth       = FFMAX(tee->max_queue_depth, depth);
+    written_ts = atomic_load(&tee_slave->written_ts);
+    if (ts != AV_NOPTS_VALUE && written_ts != AV_NOPTS_VALUE) {
+        tee_slave->max_lag = FFMAX(tee_slave->max_lag, ts - written_ts);
+        tee->max_lag       = FFMAX(tee->max_lag, ts - written_ts);
+    }
+    return 0;
+}
+
 static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
 {
     TeeContext *tee = avf->priv_data;
     AVFormatContext *avf2;
-    AVBSFContext *bsfs;
     AVPacket *const pkt2 = ffformatcontext(avf)->pkt;
+    AVPacket *src = pkt;
     int ret_all = 0, ret;
     unsigned i, s;
     int s2;
 
+    /* all slaves reference the same data */
+    if (pkt) {
+        if ((ret = av_packet_ref(tee->shared_pkt, pkt)) < 0)
+            return ret;
+        src = tee->shared_pkt;
+    }
+
     for (i = 0; i < tee->nb_slaves; i++) {
-        if (!(avf2 = tee->slaves[i].avf))
+        TeeSlave *tee_slave = &tee->slaves[i];
+
+        if (!(avf2 = tee_slave->avf))
             continue;
 
-        /* Flush slave if pkt is NULL*/
-        if (!pkt) {
+        if (pkt) {
+            s = pkt->stream_index;
+            s2 = tee_slave->stream_map[s];
+            if (s2 < 0)
+                continue;
+        }
+
+        if (tee_slave->thread_started) {
+            AVPacket *queued = NULL;
+            if (pkt && !(queued = av_packet_clone(src))) {
+                if (!ret_all)
+                    ret_all = AVERROR(ENOMEM);
+                continue;
+            }
+            ret = queue_slave_packet(avf, tee_slave, queued, pkt ? s2 : 0);
+        } else if (!pkt) {
+            /* Flush slave if pkt is NULL*/
             ret = av_interleaved_write_frame(avf2, NULL);
-            if (ret < 0) {
-                ret = tee_process_slave_failure(avf, i, ret);
-                if (!ret_all && ret < 0)
+        } else {
+            if ((ret = av_packet_ref(pkt2, src)) < 0) {
+                if (!ret_all)
                     ret_all = ret;
+                continue;
             }
-            continue;
-        }
-
-        s = pkt->stream_index;
-        s2 = tee->slaves[i].stream_map[s];
-        if (s2 < 0)
-            continue;
-
-        if ((ret = av_packet_ref(pkt2, pkt)) < 0) {
-            if (!ret_all)
-                ret_all = ret;
-            continue;
+            ret = write_slave_packet(tee_slave, pkt2, s2);
         }
-        bsfs = tee->slaves[i].bsfs[s2];
-        pkt2->stream_index = s2;
 
-        ret = av_bsf_send_packet(bsfs, pkt2);
         if (ret < 0) {
-            av_packet_unref(pkt2);
-            av_log(avf, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
-                   av_err2str(ret));
             ret = tee_process_slave_failure(avf, i, ret);
             if (!ret_all && ret < 0)
                 ret_all = ret;
         }
+    }
+    av_packet_unref(tee->shared_pkt);
 
-        while(1) {
-            ret = av_bsf_receive_packet(bsfs, pkt2);
-            if (ret == AVERROR(EAGAIN)) {
-                ret = 0;
-                break;
-            } else if (ret < 0) {
-                break;
-            }
-
-            av_packet_rescale_ts(pkt2, bsfs->time_base_out,
-                                 avf2->streams[s2]->time_base);
-            ret = av_interleaved_write_frame(avf2, pkt2);
-            if (ret < 0)
-                break;
-        };
+    /* the slave threads flush in parallel, return once all of them are done */
+    for (i = 0; !pkt && i < tee->nb_slaves; i++) {
+        TeeSlave *tee_slave = &tee->slaves[i];
 
-        if (ret < 0) {
+        if (!tee_slave->avf || !tee_slave->thread_started)
+            continue;
+        if ((ret = wait_slave_flush(tee_slave)) < 0) {
             ret = tee_process_slave_failure(avf, i, ret);
             if (!ret_all && ret < 0)
                 ret_all = ret;
@@ -612,6 +989,7 @@ const AVOutputFormat ff_tee_muxer = {
     .write_header      = tee_write_header,
     .write_trailer     = tee_write_trailer,
     .write_packet      = tee_write_packet,
+    .deinit            = tee_deinit,
     .priv_class        = &tee_muxer_class,
     .flags             = AVFMT_NOFILE | AVFMT_ALLOW_FLUSH | AVFMT_TS_NEGATIVE,
 };
@@ -0,0 +1,131 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavformat/compactindex.h"
+#include "libavformat/internal.h"
+
+/* Builds the same index as an FFCompactIndex and as an AVIndexEntry array,
+ * with mostly increasing timestamps and some out of order and duplicate
+ * ones, and checks that entries and searches always match. */
+
+#define NB_ADDS 20000
+
+static int check_entries(FFCompactIndex *ci, const AVIndexEntry *ref, int nb)
+{
+    if (ci->nb_entries != nb) {
+        printf("%d entries instead of %d\n", ci->nb_entries, nb);
+        return 1;
+    }
+    for (int i = 0; i < nb; i++) {
+        const AVIndexEntry *e = ff_compact_index_get(ci, i);
+        if (!e || memcmp(e, &ref[i], sizeof(*e))) {
+            printf("entry %d differs\n", i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const int search_flags[] = {
+        0, AVSEEK_FLAG_BACKWARD, AVSEEK_FLAG_ANY,
+        AVSEEK_FLAG_ANY | AVSEEK_FLAG_BACKWARD,
+    };
+    FFCompactIndex *ci = ff_compact_index_alloc();
+    AVIndexEntry *ref = NULL;
+    unsigned int ref_size = 0;
+    int nb_ref = 0, err = 0;
+    int64_t ts = -1000, pos = 0;
+    AVLFG lfg;
+
+    if (!ci)
+        return 1;
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int i = 0; i < NB_ADDS && !err; i++) {
+        unsigned r    = av_lfg_get(&lfg) % 100;
+        int size      = av_lfg_get(&lfg) & 0x3FFFFFF;
+        int distance  = av_lfg_get(&lfg) % 50;
+        int flags     = av_lfg_get(&lfg) & AVINDEX_KEYFRAME;
+        int64_t t;
+        int a, b;
+
+        if (r < 85) {
+            t = ts += 1001;
+        } else if (r < 95) {
+            t = av_lfg_get(&lfg) % (ts + 2000) - 1000;
+        } else {
+            t = ts + av_lfg_get(&lfg) % 5000;
+            ts = FFMAX(ts, t);
+        }
+        pos += (int)(av_lfg_get(&lfg) % 100000) - 1000;
+
+        a = ff_add_index_entry(&ref, &nb_ref, &ref_size, pos, t, size,
+                               distance, flags);
+        b = ff_compact_index_add(ci, pos, t, size, distance, flags);
+        if (a != b) {
+            printf("add %d returned %d instead of %d\n", i, b, a);
+            err = 1;
+        }
+
+        if (i % 1000 == 999) {
+            err |= check_entries(ci, ref, nb_ref);
+            for (int k = 0; k < 64; k++) {
+                int64_t wanted = av_lfg_get(&lfg) % (ts + 3000) - 2000;
+                int f = search_flags[k & 3];
+                a = ff_index_search_timestamp(ref, nb_ref, wanted, f);
+                b = ff_compact_index_search(ci, wanted, f);
+                if (a != b) {
+                    printf("search %"PRId64" flags %d returned %d instead of %d\n",
+                           wanted, f, b, a);
+                    err = 1;
+                }
+            }
+        }
+    }
+
+    if (!err) {
+        int i;
+        for (i = 0; 2 * i < nb_ref; i++)
+            ref[i] = ref[2 * i];
+        nb_ref = i;
+        if (ff_compact_index_decimate(&ci) < 0)
+            err = 1;
+        else
+            err = check_entries(ci, ref, nb_ref);
+    }
+
+    if (!err && ff_compact_index_memory_size(ci) >= nb_ref * sizeof(*ref)) {
+        printf("compact index uses %zu bytes for %d entries\n",
+               ff_compact_index_memory_size(ci), nb_ref);
+        err = 1;
+    }
+
+    ff_compact_index_free(&ci);
+    av_free(ref);
+    return err;
+}
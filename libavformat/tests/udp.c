@@ -0,0 +1,128 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/opt.h"
+#include "libavformat/avio.h"
+#include "libavformat/url.h"
+
+#define NB_DATAGRAMS 50
+#define MAX_SIZE     1316
+
+static int datagram_size(int i)
+{
+    return 1 + (i * 97) % MAX_SIZE;
+}
+
+/**
+ * Send NB_DATAGRAMS datagrams of varying size over the loopback interface
+ * and check that all of them arrive in order, cut to read_pkt_size bytes
+ * when they are read in batches.
+ */
+static int test(int read_batch, int read_pkt_size, int write_batch, int fifo_size)
+{
+    URLContext *in = NULL, *out = NULL;
+    uint8_t buf[MAX_SIZE + 1];
+    char url[256];
+    int64_t overruns = 0;
+    int i, j, ret, tries = 0, received = 0;
+
+    snprintf(url, sizeof(url), "udp://127.0.0.1:0?batch_size=%d&pkt_size=%d&fifo_size=%d",
+             read_batch, read_pkt_size, fifo_size);
+    ret = ffurl_open_whitelist(&in, url, AVIO_FLAG_READ, NULL, NULL,
+                               NULL, NULL, NULL);
+    if (ret < 0)
+        goto end;
+    snprintf(url, sizeof(url), "udp://127.0.0.1:%d?batch_size=%d&pkt_size=%d",
+             ff_udp_get_local_port(in), write_batch, MAX_SIZE);
+    ret = ffurl_open_whitelist(&out, url, AVIO_FLAG_WRITE, NULL, NULL,
+                               NULL, NULL, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (i = 0; i < NB_DATAGRAMS; i++) {
+        for (j = 0; j < datagram_size(i); j++)
+            buf[j] = i + j;
+        ret = ffurl_write(out, buf, datagram_size(i));
+        if (ret < 0)
+            goto end;
+    }
+    /* sends the datagrams still queued for a batch */
+    ret = ffurl_closep(&out);
+    if (ret < 0)
+        goto end;
+
+    /* All datagrams are queued on the receiving socket once sent over the
+     * loopback interface, so waiting only covers the reading thread. */
+    while (received < NB_DATAGRAMS) {
+        int expected = datagram_size(received);
+
+        if (read_batch > 1 && fifo_size)
+            expected = FFMIN(expected, read_pkt_size);
+        ret = ffurl_read(in, buf, sizeof(buf));
+        if (ret == AVERROR(EAGAIN) && ++tries < 100)
+            continue;
+        if (ret < 0)
+            goto end;
+        tries = 0;
+        if (ret != expected) {
+            printf("datagram %d: size %d, expected %d\n",
+                   received, ret, expected);
+            ret = AVERROR_BUG;
+            goto end;
+        }
+        for (j = 0; j < ret; j++) {
+            if (buf[j] != (uint8_t)(received + j)) {
+                printf("datagram %d: mismatch at byte %d\n", received, j);
+                ret = AVERROR_BUG;
+                goto end;
+            }
+        }
+        received++;
+    }
+    av_opt_get_int(in->priv_data, "overruns", 0, &overruns);
+    ret = 0;
+
+end:
+    printf("read batch %d, pkt_size %d, write batch %d, fifo %d: "
+           "%d datagrams received, %"PRId64" overruns%s%s\n",
+           read_batch, read_pkt_size, write_batch, fifo_size, received,
+           overruns, ret < 0 ? ", error: " : "", ret < 0 ? av_err2str(ret) : "");
+    ffurl_closep(&out);
+    ffurl_closep(&in);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    ret |= test(1,  MAX_SIZE, 1,  7 * 4096);
+    ret |= test(8,  MAX_SIZE, 1,  7 * 4096);
+    ret |= test(1,  MAX_SIZE, 8,  7 * 4096);
+    ret |= test(16, MAX_SIZE, 16, 7 * 4096);
+    /* the buffers for batches hold pkt_size bytes */
+    ret |= test(8,  500,      8,  7 * 4096);
+    /* batch_size only applies to the circular buffer thread in read mode */
+    ret |= test(8,  500,      7,  0);
+
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/log.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+#include "libavformat/avio.h"
+#include "libavformat/uploadqueue.h"
+
+#define MAX_EVENTS 32
+#define MAX_FILES  8
+
+/* The io callbacks write into memory and log each completed upload or
+ * deletion. Opening a url containing "block" waits until it is released,
+ * "fail" always fails, and "retry" fails twice. */
+typedef struct OpenFile {
+    AVIOContext *pb;
+    char url[64];
+    int delete;
+} OpenFile;
+
+static pthread_mutex_t lock;
+static pthread_cond_t  cond;
+static OpenFile files[MAX_FILES];
+static char events[MAX_EVENTS][128];
+static int nb_events;
+static int released;
+static int retry_attempts, fail_attempts;
+
+static void reset(void)
+{
+    nb_events      = 0;
+    released       = 0;
+    retry_attempts = 0;
+    fail_attempts  = 0;
+}
+
+static int find_event(const char *event)
+{
+    for (int i = 0; i < nb_events; i++)
+        if (!strcmp(events[i], event))
+            return i;
+    return -1;
+}
+
+static void print_events(const char *test)
+{
+    for (int i = 0; i < nb_events; i++)
+        printf("%s: %s\n", test, events[i]);
+}
+
+static int mem_io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                       int flags, AVDictionary **options)
+{
+    AVDictionaryEntry *method = av_dict_get(*options, "method", NULL, 0);
+    int i, ret;
+
+    pthread_mutex_lock(&lock);
+    if (strstr(url, "block")) {
+        while (!released)
+            pthread_cond_wait(&cond, &lock);
+    }
+    if (strstr(url, "fail") || (strstr(url, "retry") && retry_attempts < 2)) {
+        if (strstr(url, "fail"))
+            fail_attempts++;
+        else
+            retry_attempts++;
+        pthread_mutex_unlock(&lock);
+        return AVERROR(EIO);
+    }
+    if (strstr(url, "retry"))
+        retry_attempts++;
+    for (i = 0; i < MAX_FILES && files[i].pb; i++)
+        ;
+    if (i == MAX_FILES || (ret = avio_open_dyn_buf(pb)) < 0) {
+        pthread_mutex_unlock(&lock);
+        return AVERROR(ENOMEM);
+    }
+    files[i].pb     = *pb;
+    files[i].delete = method && !strcmp(method->value, "DELETE");
+    av_strlcpy(files[i].url, url, sizeof(files[i].url));
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+static int mem_io_close2(AVFormatContext *s, AVIOContext *pb)
+{
+    uint8_t *data;
+    int i, size;
+
+    size = avio_close_dyn_buf(pb, &data);
+    pthread_mutex_lock(&lock);
+    for (i = 0; i < MAX_FILES && files[i].pb != pb; i++)
+        ;
+    if (i < MAX_FILES && nb_events < MAX_EVENTS) {
+        if (files[i].delete)
+            snprintf(events[nb_events++], sizeof(*events), "delete %s", files[i].url);
+        else
+            snprintf(events[nb_events++], sizeof(*events), "upload %s \"%.*s\"",
+                     files[i].url, size, data);
+        files[i].pb = NULL;
+    }
+    pthread_mutex_unlock(&lock);
+    av_free(data);
+    return 0;
+}
+
+static void release(void)
+{
+    pthread_mutex_lock(&lock);
+    released = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+static int upload(UploadQueue *q, const char *url, const char *data, int flags)
+{
+    AVIOContext *pb;
+    int ret = ff_upload_queue_open(q, &pb, url, NULL, flags);
+    if (ret < 0)
+        return ret;
+    avio_write(pb, data, strlen(data));
+    return ff_upload_queue_close(q, &pb);
+}
+
+static int open_queue(AVFormatContext **s, UploadQueue **q, int max_segments)
+{
+    int ret;
+
+    *s = avformat_alloc_context();
+    if (!*s)
+        return AVERROR(ENOMEM);
+    (*s)->io_open   = mem_io_open;
+    (*s)->io_close2 = mem_io_close2;
+    reset();
+    if ((ret = ff_upload_queue_alloc(q, *s, max_segments, 2, 0)) < 0)
+        avformat_free_context(*s);
+    return ret;
+}
+
+static void close_queue(AVFormatContext **s, UploadQueue **q)
+{
+    ff_upload_queue_free(q);
+    avformat_free_context(*s);
+    *s = NULL;
+}
+
+/* The playlist only goes out after the segments queued before it, and the
+ * segment it no longer references is only deleted after it. */
+static int test_ordering(void)
+{
+    AVFormatContext *s;
+    UploadQueue *q;
+    int i, ret, manifest;
+
+    if ((ret = open_queue(&s, &q, 4)) < 0)
+        return ret;
+    release();
+    for (i = 1; i <= 3 && ret >= 0; i++) {
+        char url[16];
+        snprintf(url, sizeof(url), "seg%d.ts", i);
+        ret = upload(q, url, "segment", 0);
+    }
+    if (ret >= 0)
+        ret = ff_upload_queue_delete(q, "seg0.ts", NULL, "index.m3u8");
+    if (ret >= 0)
+        ret = upload(q, "index.m3u8", "seg1 seg2 seg3", FF_UPLOAD_MANIFEST);
+    if (ret >= 0)
+        ret = ff_upload_queue_flush(q);
+    close_queue(&s, &q);
+    if (ret < 0)
+        return ret;
+
+    manifest = find_event("upload index.m3u8 \"seg1 seg2 seg3\"");
+    printf("ordering: %d events, playlist after the segments: %s, "
+           "deletion after the playlist: %s\n", nb_events,
+           manifest == 3 ? "yes" : "no",
+           find_event("delete seg0.ts") > manifest ? "yes" : "no");
+    return 0;
+}
+
+/* A playlist replaced before its upload started is not uploaded, and the
+ * deletions waiting for it move behind its replacement. */
+static int test_dedup(void)
+{
+    AVFormatContext *s;
+    UploadQueue *q;
+    UploadQueueStats stats;
+    int ret;
+
+    if ((ret = open_queue(&s, &q, 2)) < 0)
+        return ret;
+    ret = upload(q, "block.ts", "segment", 0);
+    if (ret >= 0)
+        ret = upload(q, "index.m3u8", "v1", FF_UPLOAD_MANIFEST);
+    if (ret >= 0)
+        ret = ff_upload_queue_delete(q, "old.ts", NULL, "index.m3u8");
+    if (ret >= 0)
+        ret = upload(q, "index.m3u8", "v2", FF_UPLOAD_MANIFEST);
+    release();
+    if (ret >= 0)
+        ret = ff_upload_queue_flush(q);
+    ff_upload_queue_get_stats(q, &stats);
+    close_queue(&s, &q);
+    if (ret < 0)
+        return ret;
+
+    print_events("dedup");
+    printf("dedup: %"PRId64" uploads, max depth %"PRId64"\n",
+           stats.uploads, stats.max_depth);
+    return 0;
+}
+
+/* Failed uploads are retried, and the error of the upload that still
+ * failed is returned by the next flush. */
+static int test_retry(void)
+{
+    AVFormatContext *s;
+    UploadQueue *q;
+    UploadQueueStats stats;
+    int ret, flush_ret;
+
+    if ((ret = open_queue(&s, &q, 2)) < 0)
+        return ret;
+    release();
+    ret = upload(q, "retry.ts", "segment", 0);
+    if (ret >= 0)
+        ret = upload(q, "fail.ts", "segment", 0);
+    flush_ret = ff_upload_queue_flush(q);
+    ff_upload_queue_get_stats(q, &stats);
+    close_queue(&s, &q);
+    if (ret < 0)
+        return ret;
+
+    print_events("retry");
+    printf("retry: retry.ts opened %d times, fail.ts opened %d times, "
+           "%"PRId64" uploads, %"PRId64" failures, flush: %s\n",
+           retry_attempts, fail_attempts, stats.uploads, stats.failures,
+           flush_ret == AVERROR(EIO) ? "EIO" : "no error");
+    return 0;
+}
+
+static void *delayed_release(void *arg)
+{
+    av_usleep(100000);
+    release();
+    return NULL;
+}
+
+/* Closing a segment blocks while max_segments segments are in flight. */
+static int test_backpressure(void)
+{
+    AVFormatContext *s;
+    UploadQueue *q;
+    pthread_t thread;
+    int ret, blocked;
+
+    if ((ret = open_queue(&s, &q, 1)) < 0)
+        return ret;
+    ret = upload(q, "block.ts", "segment", 0);
+    if (ret >= 0 && (ret = pthread_create(&thread, NULL, delayed_release, NULL))) {
+        ret = AVERROR(ret);
+    } else if (ret >= 0) {
+        ret = upload(q, "seg1.ts", "segment", 0);
+        pthread_mutex_lock(&lock);
+        blocked = released;
+        pthread_mutex_unlock(&lock);
+        pthread_join(thread, NULL);
+        if (ret >= 0)
+            ret = ff_upload_queue_flush(q);
+        if (ret >= 0)
+            printf("backpressure: second segment queued after the first one "
+                   "was released: %s\n", blocked ? "yes" : "no");
+    }
+    close_queue(&s, &q);
+    return ret;
+}
+
+int main(void)
+{
+    int ret;
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&cond, NULL);
+    if ((ret = test_ordering()) < 0 ||
+        (ret = test_dedup()) < 0 ||
+        (ret = test_retry()) < 0 ||
+        (ret = test_backpressure()) < 0) {
+        printf("error: %s\n", av_err2str(ret));
+        ret = 1;
+    }
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&lock);
+    return ret ? 1 : 0;
+}
@@ -26,6 +26,7 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() with glibc */
 
 #include "avformat.h"
 #include "avio_internal.h"
@@ -79,6 +80,9 @@
 #define UDP_RX_BUF_SIZE 393216
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+#define UDP_MAX_BATCH_SIZE 1024
+
+#define HAVE_UDP_MMSG (HAVE_RECVMMSG || HAVE_SENDMMSG)
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -117,6 +121,21 @@ typedef struct UDPContext {
     char *sources;
     char *block;
     IPSourceFilters filters;
+
+    /* Batched I/O with recvmmsg() / sendmmsg() */
+    int batch_size;
+#if HAVE_UDP_MMSG
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    struct sockaddr_storage *msg_addrs;
+    uint8_t *msg_ctrl;
+    uint8_t *msg_bufs;
+    int msg_buf_size;
+    int nb_queued;      /* datagrams waiting in msg_bufs to be sent */
+    int send_error;     /* error sending a batch, returned by the next udp_write() */
+#endif
+    int64_t overruns;   /* datagrams dropped because the circular buffer was full */
+    int64_t kernel_drops; /* datagrams dropped by the kernel, as reported by SO_RXQ_OVFL */
 } UDPContext;
 
 #define OFFSET(x) offsetof(UDPContext, x)
@@ -141,6 +160,9 @@ static const AVOption options[] = {
     { "timeout",        "set raise error timeout, in microseconds (only in read mode)",OFFSET(timeout),         AV_OPT_TYPE_INT,  {.i64 = 0}, 0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
+    { "batch_size",     "Max number of datagrams per recvmmsg()/sendmmsg() call", OFFSET(batch_size), AV_OPT_TYPE_INT,  { .i64 = 1 },      1, UDP_MAX_BATCH_SIZE, D|E },
+    { "overruns",       "number of datagrams dropped on circular buffer overrun", OFFSET(overruns), AV_OPT_TYPE_INT64, { .i64 = 0 },    0, INT64_MAX, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+    { "kernel_drops",   "number of datagrams dropped by the kernel",       OFFSET(kernel_drops),   AV_OPT_TYPE_INT64,  { .i64 = 0 },      0, INT64_MAX, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL }
 };
 
@@ -480,6 +502,122 @@ static int udp_get_file_handle(URLContext *h)
     return s->udp_fd;
 }
 
+#if HAVE_UDP_MMSG
+#ifdef SO_RXQ_OVFL
+#define UDP_MSG_CTRL_SIZE CMSG_SPACE(sizeof(uint32_t))
+#else
+#define UDP_MSG_CTRL_SIZE 0
+#endif
+
+static void udp_free_mmsg(UDPContext *s)
+{
+    av_freep(&s->msgs);
+    av_freep(&s->iovs);
+    av_freep(&s->msg_addrs);
+    av_freep(&s->msg_ctrl);
+    av_freep(&s->msg_bufs);
+}
+
+/**
+ * Set up batch_size message headers, each pointing to its own buffer of
+ * buf_size bytes which is preceded by headroom bytes.
+ */
+static int udp_alloc_mmsg(UDPContext *s, int buf_size, int headroom)
+{
+    int i;
+
+    s->msgs      = av_calloc(s->batch_size, sizeof(*s->msgs));
+    s->iovs      = av_calloc(s->batch_size, sizeof(*s->iovs));
+    s->msg_addrs = av_calloc(s->batch_size, sizeof(*s->msg_addrs));
+    s->msg_bufs  = av_malloc_array(s->batch_size, buf_size + headroom);
+    if (UDP_MSG_CTRL_SIZE)
+        s->msg_ctrl = av_calloc(s->batch_size, UDP_MSG_CTRL_SIZE);
+    if (!s->msgs || !s->iovs || !s->msg_addrs || !s->msg_bufs ||
+        (UDP_MSG_CTRL_SIZE && !s->msg_ctrl)) {
+        udp_free_mmsg(s);
+        return AVERROR(ENOMEM);
+    }
+    s->msg_buf_size = buf_size;
+
+    for (i = 0; i < s->batch_size; i++) {
+        s->iovs[i].iov_base = s->msg_bufs + i * (buf_size + headroom) + headroom;
+        s->iovs[i].iov_len  = buf_size;
+        s->msgs[i].msg_hdr.msg_iov    = &s->iovs[i];
+        s->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return 0;
+}
+#endif
+
+#if HAVE_RECVMMSG
+static int udp_recv_batch(UDPContext *s)
+{
+    int i;
+
+    for (i = 0; i < s->batch_size; i++) {
+        struct msghdr *hdr = &s->msgs[i].msg_hdr;
+        hdr->msg_name       = &s->msg_addrs[i];
+        hdr->msg_namelen    = sizeof(s->msg_addrs[i]);
+        hdr->msg_control    = s->msg_ctrl ? s->msg_ctrl + i * UDP_MSG_CTRL_SIZE : NULL;
+        hdr->msg_controllen = UDP_MSG_CTRL_SIZE;
+        hdr->msg_flags      = 0;
+    }
+    return recvmmsg(s->udp_fd, s->msgs, s->batch_size, MSG_WAITFORONE, NULL);
+}
+
+static void udp_parse_cmsgs(UDPContext *s, struct msghdr *hdr)
+{
+#ifdef SO_RXQ_OVFL
+    struct cmsghdr *cmsg;
+
+    for (cmsg = CMSG_FIRSTHDR(hdr); cmsg; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops;
+            memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            s->kernel_drops = drops;
+        }
+    }
+#endif
+}
+#endif
+
+#if HAVE_SENDMMSG
+/**
+ * Send the datagrams queued by udp_write(). On a partial send, the unsent
+ * datagrams are moved to the front of the queue.
+ */
+static int udp_send_queued(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+    int sent = 0, ret = 0, i;
+
+    while (sent < s->nb_queued) {
+        if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
+            ret = ff_network_wait_fd(s->udp_fd, 1);
+            if (ret < 0)
+                break;
+        }
+        ret = sendmmsg(s->udp_fd, s->msgs + sent, s->nb_queued - sent, 0);
+        if (ret < 0) {
+            ret = ff_neterrno();
+            if (ret == AVERROR(EINTR) ||
+                (ret == AVERROR(EAGAIN) && !(h->flags & AVIO_FLAG_NONBLOCK)))
+                continue;
+            break;
+        }
+        sent += ret;
+        ret   = 0;
+    }
+
+    for (i = 0; i < s->nb_queued - sent; i++) {
+        memcpy(s->iovs[i].iov_base, s->iovs[sent + i].iov_base, s->iovs[sent + i].iov_len);
+        s->iovs[i].iov_len = s->iovs[sent + i].iov_len;
+    }
+    s->nb_queued -= sent;
+    return ret;
+}
+#endif
+
 #if HAVE_PTHREAD_CANCEL
 static void *circular_buffer_task_rx( void *_URLContext)
 {
@@ -495,15 +633,21 @@ static void *circular_buffer_task_rx( void *_URLContext)
         goto end;
     }
     while(1) {
-        int len;
-        struct sockaddr_storage addr;
+        int len, i, nb_msgs = 1;
+        struct sockaddr_storage addr, *addrp = &addr;
         socklen_t addr_len = sizeof(addr);
+        uint8_t *pkt = s->tmp;
 
         pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
+#if HAVE_RECVMMSG
+        if (s->msgs)
+            len = nb_msgs = udp_recv_batch(s);
+        else
+#endif
         len = recvfrom(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0, (struct sockaddr *)&addr, &addr_len);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
@@ -514,25 +658,39 @@ static void *circular_buffer_task_rx( void *_URLContext)
             }
             continue;
         }
-        if (ff_ip_check_source_lists(&addr, &s->filters))
-            continue;
-        AV_WL32(s->tmp, len);
-
-        if (av_fifo_can_write(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
+        for (i = 0; i < nb_msgs; i++) {
+#if HAVE_RECVMMSG
+            if (s->msgs) {
+                pkt   = (uint8_t *)s->iovs[i].iov_base - 4;
+                len   = s->msgs[i].msg_len;
+                addrp = &s->msg_addrs[i];
+                udp_parse_cmsgs(s, &s->msgs[i].msg_hdr);
+                if (s->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+                    av_log(h, AV_LOG_WARNING, "Part of datagram lost due to "
+                           "insufficient buffer size, increase pkt_size\n");
+            }
+#endif
+            if (ff_ip_check_source_lists(addrp, &s->filters))
                 continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+            AV_WL32(pkt, len);
+
+            if (av_fifo_can_write(s->fifo) < len + 4) {
+                /* No Space left */
+                s->overruns++;
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                            "Surviving due to overrun_nonfatal option\n");
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    s->circular_buffer_error = AVERROR(EIO);
+                    goto end;
+                }
             }
+            av_fifo_write(s->fifo, pkt, len + 4);
         }
-        av_fifo_write(s->fifo, s->tmp, len + 4);
         pthread_cond_signal(&s->cond);
     }
 
@@ -733,6 +891,15 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "burst_bits", p)) {
             s->burst_bits = strtoll(buf, NULL, 10);
         }
+        if (av_find_info_tag(buf, sizeof(buf), "batch_size", p)) {
+            s->batch_size = strtol(buf, NULL, 10);
+            if (s->batch_size < 1 || s->batch_size > UDP_MAX_BATCH_SIZE) {
+                av_log(h, AV_LOG_ERROR, "batch_size(%d) should be in range [1,%d]\n",
+                       s->batch_size, UDP_MAX_BATCH_SIZE);
+                ret = AVERROR(EINVAL);
+                goto fail;
+            }
+        }
         if (av_find_info_tag(buf, sizeof(buf), "localaddr", p)) {
             av_freep(&s->localaddr);
             s->localaddr = av_strdup(buf);
@@ -915,6 +1082,29 @@ static int udp_open(URLContext *h, const char *uri, int flags)
 
     s->udp_fd = udp_fd;
 
+#if HAVE_RECVMMSG && HAVE_PTHREAD_CANCEL
+    if (!is_output && s->circular_buffer_size && s->batch_size > 1) {
+        ret = udp_alloc_mmsg(s, s->pkt_size > 0 ? FFMIN(s->pkt_size, UDP_MAX_PKT_SIZE)
+                                                : UDP_MAX_PKT_SIZE, 4);
+        if (ret < 0)
+            goto fail;
+#ifdef SO_RXQ_OVFL
+        tmp = 1;
+        if (setsockopt(udp_fd, SOL_SOCKET, SO_RXQ_OVFL, &tmp, sizeof(tmp)) < 0)
+            ff_log_net_error(h, AV_LOG_DEBUG, "setsockopt(SO_RXQ_OVFL)");
+#endif
+    }
+#endif
+#if HAVE_SENDMMSG
+    if (is_output && s->batch_size > 1 &&
+        !(HAVE_PTHREAD_CANCEL && s->bitrate && s->circular_buffer_size)) {
+        ret = udp_alloc_mmsg(s, h->max_packet_size > 0 ? h->max_packet_size
+                                                       : UDP_MAX_PKT_SIZE, 0);
+        if (ret < 0)
+            goto fail;
+    }
+#endif
+
 #if HAVE_PTHREAD_CANCEL
     /*
       Create thread in case of:
@@ -967,6 +1157,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
     if (udp_fd >= 0)
         closesocket(udp_fd);
     av_fifo_freep2(&s->fifo);
+#if HAVE_UDP_MMSG
+    udp_free_mmsg(s);
+#endif
     ff_ip_reset_filters(&s->filters);
     return ret;
 }
@@ -1078,6 +1271,43 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
         pthread_mutex_unlock(&s->mutex);
         return size;
     }
+#endif
+#if HAVE_SENDMMSG
+    if (s->msgs && size <= s->msg_buf_size) {
+        struct msghdr *hdr;
+
+        /*
+          Return error if the last batch failed.
+          The datagrams were already accepted, so it is reported here.
+        */
+        if (s->send_error < 0) {
+            ret = s->send_error;
+            s->send_error = 0;
+            return ret;
+        }
+        if (s->nb_queued == s->batch_size) {
+            ret = udp_send_queued(h);
+            if (ret < 0)
+                return ret;
+        }
+        hdr = &s->msgs[s->nb_queued].msg_hdr;
+        hdr->msg_name    = s->is_connected ? NULL : &s->dest_addr;
+        hdr->msg_namelen = s->is_connected ? 0    : s->dest_addr_len;
+        memcpy(s->iovs[s->nb_queued].iov_base, buf, size);
+        s->iovs[s->nb_queued++].iov_len = size;
+
+        if (s->nb_queued == s->batch_size) {
+            ret = udp_send_queued(h);
+            if (ret < 0 && ret != AVERROR(EAGAIN))
+                s->send_error = ret;
+        }
+        return size;
+    } else if (s->nb_queued) {
+        /* keep the datagrams in order */
+        ret = udp_send_queued(h);
+        if (ret < 0)
+            return ret;
+    }
 #endif
     if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
         ret = ff_network_wait_fd(s->udp_fd, 1);
@@ -1109,6 +1339,11 @@ static int udp_close(URLContext *h)
     }
 #endif
 
+#if HAVE_SENDMMSG
+    if (s->nb_queued)
+        udp_send_queued(h);
+#endif
+
     if (s->is_multicast && (h->flags & AVIO_FLAG_READ))
         udp_leave_multicast_group(s->udp_fd, (struct sockaddr *)&s->dest_addr,
                                   (struct sockaddr *)&s->local_addr_storage, h);
@@ -1134,8 +1369,14 @@ static int udp_close(URLContext *h)
         pthread_cond_destroy(&s->cond);
     }
 #endif
+    if (s->overruns || s->kernel_drops)
+        av_log(h, AV_LOG_VERBOSE, "%"PRId64" datagrams dropped on circular buffer overrun, "
+               "%"PRId64" dropped by the kernel\n", s->overruns, s->kernel_drops);
     closesocket(s->udp_fd);
     av_fifo_freep2(&s->fifo);
+#if HAVE_UDP_MMSG
+    udp_free_mmsg(s);
+#endif
     ff_ip_reset_filters(&s->filters);
     return 0;
 }
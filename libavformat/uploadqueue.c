@@ -0,0 +1,603 @@
+/*
+ * Background upload queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <stdatomic.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "avio_internal.h"
+#if CONFIG_HTTP_PROTOCOL
+#include "http.h"
+#endif
+#include "internal.h"
+#include "uploadqueue.h"
+#include "url.h"
+
+#define UPLOAD_DELETE       2
+#define UPLOAD_BARRIER      (FF_UPLOAD_MANIFEST | UPLOAD_DELETE)
+#define RETRY_DELAY         100000
+#define RETRY_DELAY_MAX     5000000
+
+typedef struct UploadJob {
+    struct UploadJob *next;
+    AVIOContext *pb;        ///< buffer being written, until the job is queued
+    char *url;
+    char *manifest;         ///< deletion: manifest to be uploaded first
+    AVDictionary *options;
+    uint8_t *data;
+    int size;
+    int flags;
+} UploadJob;
+
+#if HAVE_THREADS
+typedef struct UploadWorker {
+    UploadQueue *q;
+    pthread_t thread;
+    AVIOContext *conn;      ///< persistent http connection
+} UploadWorker;
+
+struct UploadQueue {
+    AVFormatContext *s;
+    int max_segments;
+    int max_retries;
+    int http_persistent;
+
+    UploadWorker *workers;
+    int nb_workers;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    UploadJob *open_jobs;   ///< opened and not closed yet
+    UploadJob *head;        ///< queued, not started
+    UploadJob **tail;
+    UploadJob *deferred;    ///< deletions waiting for their manifest
+    int in_flight;
+    int nb_segments;        ///< segments queued or in flight
+    int finish;
+    atomic_int abort;
+    int error;
+    UploadQueueStats stats;
+};
+
+static void free_job(UploadJob *job)
+{
+    if (!job)
+        return;
+    if (job->pb)
+        ffio_free_dyn_buf(&job->pb);
+    av_freep(&job->url);
+    av_freep(&job->manifest);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+    av_free(job);
+}
+
+static UploadJob *alloc_job(const char *url, AVDictionary **options, int flags)
+{
+    UploadJob *job = av_mallocz(sizeof(*job));
+
+    if (!job)
+        return NULL;
+    job->flags = flags;
+    job->url   = av_strdup(url);
+    if (!job->url || (options && av_dict_copy(&job->options, *options, 0) < 0)) {
+        free_job(job);
+        return NULL;
+    }
+    return job;
+}
+
+/* Called with the lock held. */
+static void enqueue_job(UploadQueue *q, UploadJob *job)
+{
+    UploadJob *deletes = NULL, **deletes_tail = &deletes;
+
+    if (job->flags & FF_UPLOAD_MANIFEST) {
+        UploadJob **p = &q->head;
+
+        /* publishing an outdated manifest is pointless */
+        while (*p) {
+            UploadJob *old = *p;
+            if ((old->flags & FF_UPLOAD_MANIFEST) && !strcmp(old->url, job->url)) {
+                av_log(q->s, AV_LOG_DEBUG, "Dropping outdated upload of %s\n", old->url);
+                *p = old->next;
+                free_job(old);
+                q->stats.depth--;
+                break;
+            }
+            p = &old->next;
+        }
+        /* deletions queued behind the dropped manifest must still wait
+         * for a manifest that no longer references the deleted files */
+        while (*p) {
+            UploadJob *next = *p;
+            if (next->flags & UPLOAD_DELETE) {
+                *p = next->next;
+                next->next    = NULL;
+                *deletes_tail = next;
+                deletes_tail  = &next->next;
+            } else {
+                p = &next->next;
+            }
+        }
+        q->tail = p;
+        /* and so do the deletions that waited for this manifest */
+        for (p = &q->deferred; *p;) {
+            UploadJob *next = *p;
+            if (!strcmp(next->manifest, job->url)) {
+                *p = next->next;
+                next->next    = NULL;
+                *deletes_tail = next;
+                deletes_tail  = &next->next;
+                q->stats.depth++;
+            } else {
+                p = &next->next;
+            }
+        }
+    } else if (!(job->flags & UPLOAD_DELETE)) {
+        q->nb_segments++;
+    }
+
+    job->next = deletes;
+    *q->tail  = job;
+    q->tail   = deletes ? deletes_tail : &job->next;
+    q->stats.depth++;
+    q->stats.max_depth = FFMAX(q->stats.max_depth, q->stats.depth);
+    pthread_cond_broadcast(&q->cond);
+}
+
+/* Queue the deletions whose manifest will not be uploaded anymore.
+ * Called with the lock held. */
+static void release_deferred(UploadQueue *q)
+{
+    while (q->deferred) {
+        UploadJob *job = q->deferred;
+        q->deferred = job->next;
+        job->next   = NULL;
+        enqueue_job(q, job);
+    }
+}
+
+static int upload_once(UploadWorker *w, UploadJob *job)
+{
+    UploadQueue *q = w->q;
+    AVFormatContext *s = q->s;
+    AVIOContext *pb = NULL;
+    AVDictionary *opts = NULL;
+    int ret, ret2;
+
+    if ((ret = av_dict_copy(&opts, job->options, 0)) < 0)
+        goto end;
+
+    if (job->flags & UPLOAD_DELETE) {
+        av_dict_set(&opts, "method", "DELETE", 0);
+        ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &opts);
+        if (ret >= 0)
+            ff_format_io_close(s, &pb);
+        goto end;
+    }
+
+#if CONFIG_HTTP_PROTOCOL
+    if (q->http_persistent && ff_is_http_proto(job->url)) {
+        URLContext *h;
+
+        if (w->conn) {
+            ret = ff_http_do_new_request2(ffio_geturlcontext(w->conn), job->url, &opts);
+            if (ret < 0)
+                ff_format_io_close(s, &w->conn);
+        }
+        if (!w->conn) {
+            ret = s->io_open(s, &w->conn, job->url, AVIO_FLAG_WRITE, &opts);
+            if (ret < 0)
+                goto end;
+        }
+        h = ffio_geturlcontext(w->conn);
+        avio_write(w->conn, job->data, job->size);
+        avio_flush(w->conn);
+        ret = w->conn->error;
+        if (h) {
+            ffurl_shutdown(h, AVIO_FLAG_WRITE);
+            if (ret >= 0)
+                ret = ff_http_get_shutdown_status(h);
+        }
+        /* custom io callbacks or a broken session, start over next time */
+        if (!h || ret < 0)
+            ff_format_io_close(s, &w->conn);
+        goto end;
+    }
+#endif
+
+    ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &opts);
+    if (ret < 0)
+        goto end;
+    avio_write(pb, job->data, job->size);
+    avio_flush(pb);
+    ret  = pb->error;
+    ret2 = ff_format_io_close(s, &pb);
+    if (ret >= 0)
+        ret = ret2;
+
+end:
+    av_dict_free(&opts);
+    return ret;
+}
+
+static int upload_job(UploadWorker *w, UploadJob *job)
+{
+    UploadQueue *q = w->q;
+    int64_t delay = RETRY_DELAY;
+    int ret, attempt;
+
+    for (attempt = 0;; attempt++) {
+        int64_t wait_end;
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+
+        ret = upload_once(w, job);
+        if (ret >= 0 || ret == AVERROR_EXIT || attempt >= q->max_retries ||
+            atomic_load(&q->abort))
+            return ret;
+
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        av_log(q->s, AV_LOG_WARNING, "Upload of %s failed: %s, retrying in %"PRId64" ms\n",
+               job->url, errbuf, delay / 1000);
+
+        wait_end = av_gettime_relative() + delay;
+        while (av_gettime_relative() < wait_end) {
+            if (atomic_load(&q->abort) || ff_check_interrupt(&q->s->interrupt_callback))
+                return ret;
+            av_usleep(10000);
+        }
+        delay = FFMIN(delay * 2, RETRY_DELAY_MAX);
+    }
+}
+
+static void *upload_worker(void *arg)
+{
+    UploadWorker *w = arg;
+    UploadQueue *q = w->q;
+
+    pthread_mutex_lock(&q->mutex);
+    for (;;) {
+        UploadJob *job;
+        int64_t start, elapsed;
+        int ret;
+
+        /* a barrier only starts once everything queued before it is done */
+        while (!atomic_load(&q->abort) &&
+               !(q->head && (!(q->head->flags & UPLOAD_BARRIER) || !q->in_flight)) &&
+               !(q->finish && !q->head))
+            pthread_cond_wait(&q->cond, &q->mutex);
+        if (atomic_load(&q->abort) || !q->head)
+            break;
+
+        job = q->head;
+        q->head = job->next;
+        if (!q->head)
+            q->tail = &q->head;
+        q->in_flight++;
+        pthread_mutex_unlock(&q->mutex);
+
+        start   = av_gettime_relative();
+        ret     = upload_job(w, job);
+        elapsed = av_gettime_relative() - start;
+
+        pthread_mutex_lock(&q->mutex);
+        q->in_flight--;
+        q->stats.depth--;
+        if (!(job->flags & UPLOAD_BARRIER))
+            q->nb_segments--;
+        if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            av_log(q->s, AV_LOG_ERROR, "Failed to %s %s: %s\n",
+                   job->flags & UPLOAD_DELETE ? "delete" : "upload", job->url, errbuf);
+            q->stats.failures++;
+            if (!q->error)
+                q->error = ret;
+        } else if (job->flags & UPLOAD_DELETE) {
+            av_log(q->s, AV_LOG_VERBOSE, "Deleted %s\n", job->url);
+        } else {
+            q->stats.uploads++;
+            q->stats.bytes += job->size;
+            q->stats.upload_time += elapsed;
+            q->stats.max_upload_time = FFMAX(q->stats.max_upload_time, elapsed);
+            av_log(q->s, AV_LOG_VERBOSE, "Uploaded %s (%d bytes) in %"PRId64" ms, queue depth %"PRId64"\n",
+                   job->url, job->size, elapsed / 1000, q->stats.depth);
+        }
+        free_job(job);
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->mutex);
+
+    ff_format_io_close(q->s, &w->conn);
+    return NULL;
+}
+
+int ff_upload_queue_alloc(UploadQueue **pq, AVFormatContext *s,
+                          int max_segments, int max_retries,
+                          int http_persistent)
+{
+    UploadQueue *q;
+    int i, ret;
+
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->s               = s;
+    q->max_segments    = FFMAX(max_segments, 1);
+    q->max_retries     = max_retries;
+    q->http_persistent = http_persistent;
+    q->tail            = &q->head;
+    atomic_init(&q->abort, 0);
+
+    q->workers = av_calloc(q->max_segments, sizeof(*q->workers));
+    if (!q->workers) {
+        av_free(q);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = pthread_mutex_init(&q->mutex, NULL))) {
+        av_free(q->workers);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&q->cond, NULL))) {
+        pthread_mutex_destroy(&q->mutex);
+        av_free(q->workers);
+        av_free(q);
+        return AVERROR(ret);
+    }
+
+    for (i = 0; i < q->max_segments; i++) {
+        UploadWorker *w = &q->workers[i];
+        w->q = q;
+        if ((ret = pthread_create(&w->thread, NULL, upload_worker, w))) {
+            *pq = q;
+            ff_upload_queue_free(pq);
+            return AVERROR(ret);
+        }
+        q->nb_workers++;
+    }
+
+    *pq = q;
+    return 0;
+}
+
+int ff_upload_queue_open(UploadQueue *q, AVIOContext **pb, const char *url,
+                         AVDictionary **options, int flags)
+{
+    UploadJob *job = alloc_job(url, options, flags & FF_UPLOAD_MANIFEST);
+    int ret;
+
+    if (!job)
+        return AVERROR(ENOMEM);
+    if ((ret = avio_open_dyn_buf(&job->pb)) < 0) {
+        free_job(job);
+        return ret;
+    }
+    *pb = job->pb;
+
+    pthread_mutex_lock(&q->mutex);
+    job->next    = q->open_jobs;
+    q->open_jobs = job;
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+/* Called with the lock held. */
+static UploadJob *take_open_job(UploadQueue *q, AVIOContext *pb)
+{
+    UploadJob **p;
+
+    for (p = &q->open_jobs; *p; p = &(*p)->next) {
+        UploadJob *job = *p;
+        if (job->pb == pb) {
+            *p = job->next;
+            job->next = NULL;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+int ff_upload_queue_close(UploadQueue *q, AVIOContext **pb)
+{
+    UploadJob *job;
+
+    if (!*pb)
+        return 0;
+
+    pthread_mutex_lock(&q->mutex);
+    job = take_open_job(q, *pb);
+    pthread_mutex_unlock(&q->mutex);
+    if (!job)
+        return AVERROR(EINVAL);
+
+    job->size = avio_close_dyn_buf(job->pb, &job->data);
+    job->pb   = NULL;
+    *pb       = NULL;
+    if (!job->data) {
+        free_job(job);
+        return AVERROR(ENOMEM);
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    if (!(job->flags & FF_UPLOAD_MANIFEST)) {
+        if (q->nb_segments >= q->max_segments)
+            av_log(q->s, AV_LOG_DEBUG, "Upload queue full, waiting\n");
+        while (q->nb_segments >= q->max_segments && !atomic_load(&q->abort))
+            pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    enqueue_job(q, job);
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+int ff_upload_queue_discard(UploadQueue *q, AVIOContext **pb)
+{
+    UploadJob *job;
+
+    if (!*pb)
+        return 0;
+
+    pthread_mutex_lock(&q->mutex);
+    job = take_open_job(q, *pb);
+    pthread_mutex_unlock(&q->mutex);
+    if (!job)
+        return 0;
+
+    free_job(job);
+    *pb = NULL;
+    return 1;
+}
+
+int ff_upload_queue_delete(UploadQueue *q, const char *url,
+                           AVDictionary **options, const char *manifest)
+{
+    UploadJob *job = alloc_job(url, options, UPLOAD_DELETE), **p;
+
+    if (!job)
+        return AVERROR(ENOMEM);
+    if (manifest && !(job->manifest = av_strdup(manifest))) {
+        free_job(job);
+        return AVERROR(ENOMEM);
+    }
+
+    pthread_mutex_lock(&q->mutex);
+    if (job->manifest) {
+        for (p = &q->deferred; *p; p = &(*p)->next)
+            ;
+        *p = job;
+    } else {
+        enqueue_job(q, job);
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+int ff_upload_queue_flush(UploadQueue *q)
+{
+    int ret;
+
+    pthread_mutex_lock(&q->mutex);
+    release_deferred(q);
+    while ((q->head || q->in_flight) && !atomic_load(&q->abort))
+        pthread_cond_wait(&q->cond, &q->mutex);
+    ret = q->error;
+    q->error = 0;
+    pthread_mutex_unlock(&q->mutex);
+    return ret;
+}
+
+void ff_upload_queue_get_stats(UploadQueue *q, UploadQueueStats *stats)
+{
+    pthread_mutex_lock(&q->mutex);
+    *stats = q->stats;
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void ff_upload_queue_free(UploadQueue **pq)
+{
+    UploadQueue *q = *pq;
+    int i;
+
+    if (!q)
+        return;
+
+    pthread_mutex_lock(&q->mutex);
+    release_deferred(q);
+    q->finish = 1;
+    /* the workers drain the queue unless the caller was interrupted */
+    if (ff_check_interrupt(&q->s->interrupt_callback))
+        atomic_store(&q->abort, 1);
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+
+    for (i = 0; i < q->nb_workers; i++)
+        pthread_join(q->workers[i].thread, NULL);
+
+    while (q->head) {
+        UploadJob *job = q->head;
+        q->head = job->next;
+        free_job(job);
+    }
+    while (q->open_jobs) {
+        UploadJob *job = q->open_jobs;
+        q->open_jobs = job->next;
+        free_job(job);
+    }
+
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->mutex);
+    av_freep(&q->workers);
+    av_freep(pq);
+}
+
+#else
+
+struct UploadQueue {
+    int dummy;
+};
+
+int ff_upload_queue_alloc(UploadQueue **q, AVFormatContext *s,
+                          int max_segments, int max_retries,
+                          int http_persistent)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_upload_queue_open(UploadQueue *q, AVIOContext **pb, const char *url,
+                         AVDictionary **options, int flags)
+{
+    return AVERROR_BUG;
+}
+
+int ff_upload_queue_close(UploadQueue *q, AVIOContext **pb)
+{
+    return AVERROR_BUG;
+}
+
+int ff_upload_queue_discard(UploadQueue *q, AVIOContext **pb)
+{
+    return 0;
+}
+
+int ff_upload_queue_delete(UploadQueue *q, const char *url,
+                           AVDictionary **options, const char *manifest)
+{
+    return AVERROR_BUG;
+}
+
+int ff_upload_queue_flush(UploadQueue *q)
+{
+    return 0;
+}
+
+void ff_upload_queue_get_stats(UploadQueue *q, UploadQueueStats *stats)
+{
+}
+
+void ff_upload_queue_free(UploadQueue **q)
+{
+}
+#endif /* HAVE_THREADS */
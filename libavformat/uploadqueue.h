@@ -0,0 +1,108 @@
+/*
+ * Background upload queue for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_UPLOADQUEUE_H
+#define AVFORMAT_UPLOADQUEUE_H
+
+#include <stdint.h>
+
+#include "avformat.h"
+#include "avio.h"
+
+/**
+ * The resource is a manifest: it is only uploaded once everything queued
+ * before it has been uploaded, and a newer version of the same manifest
+ * replaces one that has not been started yet.
+ */
+#define FF_UPLOAD_MANIFEST 1
+
+typedef struct UploadQueue UploadQueue;
+
+typedef struct UploadQueueStats {
+    int64_t uploads;         ///< number of completed uploads
+    int64_t bytes;           ///< number of bytes uploaded
+    int64_t upload_time;     ///< total upload time, in microseconds
+    int64_t max_upload_time; ///< longest single upload, in microseconds
+    int64_t failures;        ///< uploads given up after all retries
+    int64_t depth;           ///< uploads currently queued or in flight
+    int64_t max_depth;       ///< highest value of depth so far
+} UploadQueueStats;
+
+/**
+ * Create an upload queue writing through the io_open callback of s.
+ * The io_open and io_close2 callbacks are called from the worker threads,
+ * concurrently with each other and with the caller.
+ *
+ * @param max_segments   maximum number of segment uploads queued or in
+ *                       flight; closing a segment blocks while the limit is
+ *                       reached
+ * @param max_retries    number of times a failed upload is retried, with an
+ *                       exponential backoff between attempts
+ * @param http_persistent keep one persistent http connection per worker
+ * @return 0 on success, AVERROR(ENOSYS) if built without threads
+ */
+int ff_upload_queue_alloc(UploadQueue **q, AVFormatContext *s,
+                          int max_segments, int max_retries,
+                          int http_persistent);
+
+/**
+ * Open a memory buffer that is uploaded to url once it is closed with
+ * ff_upload_queue_close().
+ */
+int ff_upload_queue_open(UploadQueue *q, AVIOContext **pb, const char *url,
+                         AVDictionary **options, int flags);
+
+/**
+ * Queue the data written to *pb for upload and free *pb.
+ */
+int ff_upload_queue_close(UploadQueue *q, AVIOContext **pb);
+
+/**
+ * Free *pb without uploading it if it was opened by ff_upload_queue_open().
+ *
+ * @return 1 if *pb belonged to the queue, 0 otherwise
+ */
+int ff_upload_queue_discard(UploadQueue *q, AVIOContext **pb);
+
+/**
+ * Queue the deletion of url. Deletions are ordered like manifests.
+ *
+ * @param manifest if not NULL, the deletion is only queued behind the next
+ *                 upload of this manifest, which is expected to no longer
+ *                 reference url, or when the queue is flushed
+ */
+int ff_upload_queue_delete(UploadQueue *q, const char *url,
+                           AVDictionary **options, const char *manifest);
+
+/**
+ * Wait until all queued uploads are done.
+ *
+ * @return the first error of an upload that failed since the last call
+ */
+int ff_upload_queue_flush(UploadQueue *q);
+
+void ff_upload_queue_get_stats(UploadQueue *q, UploadQueueStats *stats);
+
+/**
+ * Finish the queued uploads and free the queue.
+ */
+void ff_upload_queue_free(UploadQueue **q);
+
+#endif /* AVFORMAT_UPLOADQUEUE_H */
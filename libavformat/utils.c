@@ -23,6 +23,12 @@
 
 #include "config.h"
 
+#if HAVE_COPY_FILE_RANGE
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/bprint.h"
@@ -42,7 +48,9 @@
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "compactindex.h"
 #include "internal.h"
+#include "os_support.h"
 #if CONFIG_NETWORK
 #include "network.h"
 #endif
@@ -661,6 +669,7 @@ static void free_stream(AVStream **pst)
     av_bsf_free(&sti->bsfc);
     av_freep(&sti->priv_pts);
     av_freep(&sti->index_entries);
+    ff_compact_index_free(&sti->compact_index);
     av_freep(&sti->probe_data.buf);
 
     av_bsf_free(&sti->extract_extradata.bsf);
@@ -812,6 +821,12 @@ AVStream *avformat_new_stream(AVFormatContext *s, const AVCodec *c)
         sti->info->fps_first_dts = AV_NOPTS_VALUE;
         sti->info->fps_last_dts  = AV_NOPTS_VALUE;
 
+        if (s->iformat->flags_internal & FF_FMT_COMPACT_INDEX) {
+            sti->compact_index = ff_compact_index_alloc();
+            if (!sti->compact_index)
+                goto fail;
+        }
+
         /* default pts setting is MPEG-like */
         avpriv_set_pts_info(st, 33, 1, 90000);
         /* we set the current DTS to 0 so that formats without any timestamps
@@ -2091,3 +2106,104 @@ end:
     av_free(buf);
     return ret;
 }
+
+#if HAVE_COPY_FILE_RANGE
+static int write_all(int fd, const uint8_t *buf, int size)
+{
+    while (size > 0) {
+        ssize_t ret = write(fd, buf, size);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        buf  += ret;
+        size -= ret;
+    }
+    return 0;
+}
+#endif
+
+int ff_format_splice_data(AVFormatContext *s, int head_size,
+                          const uint8_t *buf, int buf_size,
+                          int64_t data_start, int64_t *copied)
+{
+#if HAVE_COPY_FILE_RANGE
+    const char *proto = avio_find_protocol_name(s->url);
+    const char *path  = s->url;
+    char *tmp_path = NULL;
+    uint8_t *head = NULL;
+    int fd_in = -1, fd_out = -1, created = 0;
+    int64_t ret;
+    struct stat st;
+
+    if (!proto || strcmp(proto, "file"))
+        return AVERROR(ENOSYS);
+    av_strstart(path, "file:", &path);
+
+    avio_flush(s->pb);
+
+    fd_in = avpriv_open(path, O_RDONLY);
+    if (fd_in < 0 || fstat(fd_in, &st) < 0) {
+        ret = AVERROR(errno);
+        goto end;
+    }
+    if (st.st_size < data_start) {
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+    tmp_path = av_asprintf("%s.tmp", path);
+    head     = av_malloc(head_size);
+    if (!tmp_path || !head) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    fd_out = avpriv_open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, st.st_mode & 0777);
+    if (fd_out < 0) {
+        ret = AVERROR(errno);
+        goto end;
+    }
+    created = 1;
+
+    for (int pos = 0; pos < head_size;) {
+        ssize_t n = pread(fd_in, head + pos, head_size - pos, pos);
+        if (n <= 0) {
+            ret = n < 0 ? AVERROR(errno) : AVERROR_EOF;
+            goto end;
+        }
+        pos += n;
+    }
+    if ((ret = write_all(fd_out, head, head_size)) < 0 ||
+        (ret = write_all(fd_out, buf, buf_size)) < 0)
+        goto end;
+
+    ret = ff_copy_file_range(fd_in, data_start, fd_out,
+                             (int64_t)head_size + buf_size,
+                             st.st_size - data_start);
+    if (ret < 0)
+        goto end;
+    if (ret != st.st_size - data_start) {
+        ret = AVERROR(EIO);
+        goto end;
+    }
+    *copied = ret;
+
+    ret    = close(fd_out) < 0 || rename(tmp_path, path) < 0 ? AVERROR(errno) : 0;
+    fd_out = -1;
+    if (!ret)
+        created = 0;
+
+end:
+    if (fd_in >= 0)
+        close(fd_in);
+    if (fd_out >= 0)
+        close(fd_out);
+    if (created)
+        unlink(tmp_path);
+    av_free(tmp_path);
+    av_free(head);
+    return ret;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
@@ -317,6 +317,7 @@ const AVInputFormat ff_xwma_demuxer = {
     .name           = "xwma",
     .long_name      = NULL_IF_CONFIG_SMALL("Microsoft xWMA"),
     .priv_data_size = sizeof(XWMAContext),
+    .flags_internal = FF_FMT_COMPACT_INDEX,
     .read_probe     = xwma_probe,
     .read_header    = xwma_read_header,
     .read_packet    = xwma_read_packet,
@@ -263,6 +263,10 @@ int av_aes_init(AVAES *a, const uint8_t *key, int key_bits, int decrypt)
             FFSWAP(av_aes_block, a->round_key[i], a->round_key[rounds - i]);
     }
 
+#if ARCH_X86
+    ff_init_aes_x86(a, decrypt);
+#endif
+
     return 0;
 }
 
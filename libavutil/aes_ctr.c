@@ -23,9 +23,11 @@
 #include "aes_ctr.h"
 #include "aes.h"
 #include "aes_internal.h"
+#include "intreadwrite.h"
 #include "random_seed.h"
 
 #define AES_BLOCK_SIZE (16)
+#define AES_CTR_BATCH  (8)
 
 typedef struct AVAESCTR {
     uint8_t counter[AES_BLOCK_SIZE];
@@ -107,6 +109,24 @@ void av_aes_ctr_crypt(struct AVAESCTR *a, uint8_t *dst, const uint8_t *src, int
     const uint8_t* cur_end_pos;
     uint8_t* encrypted_counter_pos;
 
+    /* Encrypt several counter blocks per av_aes_crypt() call while whole
+     * blocks are left, so that implementations can interleave them. */
+    while (a->block_offset == 0 && src_end - src >= AES_BLOCK_SIZE) {
+        uint8_t keystream[AES_CTR_BATCH * AES_BLOCK_SIZE];
+        int i, blocks = FFMIN((src_end - src) / AES_BLOCK_SIZE, AES_CTR_BATCH);
+
+        for (i = 0; i < blocks; i++) {
+            memcpy(keystream + i * AES_BLOCK_SIZE, a->counter, AES_BLOCK_SIZE);
+            av_aes_ctr_increment_be64(a->counter + 8);
+        }
+        av_aes_crypt(&a->aes, keystream, keystream, blocks, NULL, 0);
+
+        for (i = 0; i < blocks * AES_BLOCK_SIZE; i += 8)
+            AV_WN64(dst + i, AV_RN64(src + i) ^ AV_RN64(keystream + i));
+        src += blocks * AES_BLOCK_SIZE;
+        dst += blocks * AES_BLOCK_SIZE;
+    }
+
     while (src < src_end) {
         if (a->block_offset == 0) {
             av_aes_crypt(&a->aes, a->encrypted_counter, a->counter, 1, NULL, 0);
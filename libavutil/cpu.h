@@ -55,6 +55,8 @@
 #define AV_CPU_FLAG_BMI2        0x40000 ///< Bit Manipulation Instruction Set 2
 #define AV_CPU_FLAG_AVX512     0x100000 ///< AVX-512 functions: requires OS support even if YMM/ZMM registers aren't used
 #define AV_CPU_FLAG_SLOW_GATHER  0x2000000 ///< CPU has slow gathers.
+#define AV_CPU_FLAG_CLMUL      0x400000 ///< Carry-less multiplication (PCLMULQDQ)
+#define AV_CPU_FLAG_SHA        0x800000 ///< SHA-1/SHA-256 extensions
 
 #define AV_CPU_FLAG_ALTIVEC      0x0001 ///< standard
 #define AV_CPU_FLAG_VSX          0x0002 ///< ISA 2.06
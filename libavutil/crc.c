@@ -25,6 +25,26 @@
 #include "bswap.h"
 #include "common.h"
 #include "crc.h"
+#if ARCH_X86
+#include "x86/crc.h"
+#endif
+
+#if !CONFIG_HARDCODED_TABLES || ARCH_X86
+static const struct {
+    uint8_t  le;
+    uint8_t  bits;
+    uint32_t poly;
+} crc_params[AV_CRC_MAX] = {
+    [AV_CRC_8_ATM]      = { 0,  8,       0x07 },
+    [AV_CRC_8_EBU]      = { 0,  8,       0x1D },
+    [AV_CRC_16_ANSI]    = { 0, 16,     0x8005 },
+    [AV_CRC_16_CCITT]   = { 0, 16,     0x1021 },
+    [AV_CRC_24_IEEE]    = { 0, 24,   0x864CFB },
+    [AV_CRC_32_IEEE]    = { 0, 32, 0x04C11DB7 },
+    [AV_CRC_32_IEEE_LE] = { 1, 32, 0xEDB88320 },
+    [AV_CRC_16_ANSI_LE] = { 1, 16,     0xA001 },
+};
+#endif
 
 #if CONFIG_HARDCODED_TABLES
 static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
@@ -319,23 +339,38 @@ static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
 #endif
 static AVCRC av_crc_table[AV_CRC_MAX][CRC_TABLE_SIZE];
 
-#define DECLARE_CRC_INIT_TABLE_ONCE(id, le, bits, poly)                                       \
-static AVOnce id ## _once_control = AV_ONCE_INIT;                                             \
-static void id ## _init_table_once(void)                                                      \
-{                                                                                             \
-    av_assert0(av_crc_init(av_crc_table[id], le, bits, poly, sizeof(av_crc_table[id])) >= 0); \
+#define DECLARE_CRC_INIT_TABLE_ONCE(id)                                                \
+static AVOnce id ## _once_control = AV_ONCE_INIT;                                      \
+static void id ## _init_table_once(void)                                               \
+{                                                                                      \
+    av_assert0(av_crc_init(av_crc_table[id], crc_params[id].le, crc_params[id].bits,   \
+                           crc_params[id].poly, sizeof(av_crc_table[id])) >= 0);       \
 }
 
 #define CRC_INIT_TABLE_ONCE(id) ff_thread_once(&id ## _once_control, id ## _init_table_once)
 
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_8_ATM,      0,  8,       0x07)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_8_EBU,      0,  8,       0x1D)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI,    0, 16,     0x8005)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_CCITT,   0, 16,     0x1021)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_24_IEEE,    0, 24,   0x864CFB)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_32_IEEE,    0, 32, 0x04C11DB7)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_32_IEEE_LE, 1, 32, 0xEDB88320)
-DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI_LE, 1, 16,     0xA001)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_8_ATM)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_8_EBU)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_CCITT)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_24_IEEE)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_32_IEEE)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_32_IEEE_LE)
+DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI_LE)
+#endif
+
+#if ARCH_X86
+static CRCX86Context crc_x86[AV_CRC_MAX];
+static AVOnce crc_x86_once_control = AV_ONCE_INIT;
+
+static av_cold void crc_init_x86_once(void)
+{
+    int i;
+
+    for (i = 0; i < AV_CRC_MAX; i++)
+        ff_crc_init_x86(&crc_x86[i], crc_params[i].le, crc_params[i].bits,
+                        crc_params[i].poly);
+}
 #endif
 
 int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
@@ -385,6 +420,9 @@ const AVCRC *av_crc_get_table(AVCRCId crc_id)
     case AV_CRC_16_ANSI_LE: CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI_LE); break;
     default: av_assert0(0);
     }
+#endif
+#if ARCH_X86
+    ff_thread_once(&crc_x86_once_control, crc_init_x86_once);
 #endif
     return av_crc_table[crc_id];
 }
@@ -394,6 +432,21 @@ uint32_t av_crc(const AVCRC *ctx, uint32_t crc,
 {
     const uint8_t *end = buffer + length;
 
+#if ARCH_X86
+    /* Only the built-in tables have their parameters known here. */
+    if (length >= 64 && ctx >= av_crc_table[0] && ctx < av_crc_table[AV_CRC_MAX]) {
+        const CRCX86Context *c = &crc_x86[(ctx - av_crc_table[0]) /
+                                          FF_ARRAY_ELEMS(av_crc_table[0])];
+        if (c->fold) {
+            uint8_t lane[16];
+            size_t len = length & ~15;
+
+            c->fold(c, crc, buffer, len, lane);
+            crc     = av_crc(ctx, 0, lane, sizeof(lane));
+            buffer += len;
+        }
+    }
+#endif
 #if !CONFIG_SMALL
     if (!ctx[256]) {
         while (((intptr_t) buffer & 3) && buffer < end)
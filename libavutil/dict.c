@@ -27,11 +27,109 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/* Dictionaries with at least this many entries get a hash index. */
+#define DICT_INDEX_MIN_COUNT 16
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    /**
+     * Open addressing hash table of 1-based indices into elems, keyed by the
+     * case-insensitive hash of the keys, with linear probing. Only used for
+     * exact key lookups; the order of elems is not affected by it.
+     */
+    unsigned *index;
+    unsigned index_mask;
 };
 
+static uint32_t dict_hash(const char *key)
+{
+    uint32_t h = 2166136261U;
+
+    while (*key)
+        h = (h ^ av_toupper(*key++)) * 16777619U;
+    return h;
+}
+
+static void dict_index_insert(AVDictionary *m, unsigned idx)
+{
+    unsigned slot = dict_hash(m->elems[idx].key) & m->index_mask;
+
+    while (m->index[slot])
+        slot = (slot + 1) & m->index_mask;
+    m->index[slot] = idx + 1;
+}
+
+static void dict_index_build(AVDictionary *m, int count)
+{
+    unsigned size = 2 * DICT_INDEX_MIN_COUNT, i;
+
+    while (size < 2 * count)
+        size *= 2;
+
+    av_freep(&m->index);
+    m->index = av_calloc(size, sizeof(*m->index));
+    if (!m->index)
+        return; /* the linear search is used instead */
+    m->index_mask = size - 1;
+    for (i = 0; i < count; i++)
+        dict_index_insert(m, i);
+}
+
+static unsigned dict_index_find(const AVDictionary *m, unsigned idx)
+{
+    unsigned slot = dict_hash(m->elems[idx].key) & m->index_mask;
+
+    while (m->index[slot] != idx + 1)
+        slot = (slot + 1) & m->index_mask;
+    return slot;
+}
+
+/**
+ * Remove the entry idx from the index and make the last entry, which is
+ * about to be moved to idx, point there.
+ */
+static void dict_index_remove(AVDictionary *m, unsigned idx)
+{
+    unsigned last = m->count - 1;
+    unsigned i = dict_index_find(m, idx), j = i;
+
+    /* backward shift deletion, keeping all probe sequences unbroken */
+    for (;;) {
+        unsigned home;
+
+        j = (j + 1) & m->index_mask;
+        if (!m->index[j])
+            break;
+        home = dict_hash(m->elems[m->index[j] - 1].key) & m->index_mask;
+        if (((j - home) & m->index_mask) >= ((j - i) & m->index_mask)) {
+            m->index[i] = m->index[j];
+            i = j;
+        }
+    }
+    m->index[i] = 0;
+
+    if (idx != last)
+        m->index[dict_index_find(m, last)] = idx + 1;
+}
+
+static int dict_key_match(const char *s, const char *key, int flags)
+{
+    unsigned j;
+
+    if (flags & AV_DICT_MATCH_CASE)
+        for (j = 0; s[j] == key[j] && key[j]; j++)
+            ;
+    else
+        for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
+            ;
+    if (key[j])
+        return 0;
+    if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return 0;
+    return 1;
+}
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
@@ -40,29 +138,32 @@ int av_dict_count(const AVDictionary *m)
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
-    unsigned int i, j;
+    unsigned int i;
 
     if (!m)
         return NULL;
 
+    if (m->index && !prev && !(flags & AV_DICT_IGNORE_SUFFIX)) {
+        unsigned slot = dict_hash(key) & m->index_mask, found = 0;
+
+        /* return the first matching entry, as the linear search would */
+        for (; m->index[slot]; slot = (slot + 1) & m->index_mask) {
+            i = m->index[slot];
+            if ((!found || i < found) &&
+                dict_key_match(m->elems[i - 1].key, key, flags))
+                found = i;
+        }
+        return found ? &m->elems[found - 1] : NULL;
+    }
+
     if (prev)
         i = prev - m->elems + 1;
     else
         i = 0;
 
     for (; i < m->count; i++) {
-        const char *s = m->elems[i].key;
-        if (flags & AV_DICT_MATCH_CASE)
-            for (j = 0; s[j] == key[j] && key[j]; j++)
-                ;
-        else
-            for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
-                ;
-        if (key[j])
-            continue;
-        if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
-            continue;
-        return &m->elems[i];
+        if (dict_key_match(m->elems[i].key, key, flags))
+            return &m->elems[i];
     }
     return NULL;
 }
@@ -100,6 +201,8 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             oldval = tag->value;
         else
             av_free(tag->value);
+        if (m->index)
+            dict_index_remove(m, tag - m->elems);
         av_free(tag->key);
         *tag = m->elems[--m->count];
     } else if (copy_value) {
@@ -124,11 +227,16 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        if (m->index && 2 * m->count <= m->index_mask + 1)
+            dict_index_insert(m, m->count - 1);
+        else if (m->count >= DICT_INDEX_MIN_COUNT)
+            dict_index_build(m, m->count);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
 
@@ -137,6 +245,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 err_out:
     if (m && !m->count) {
         av_freep(&m->elems);
+        av_freep(&m->index);
         av_freep(pm);
     }
     av_free(copy_key);
@@ -210,6 +319,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].value);
         }
         av_freep(&m->elems);
+        av_freep(&m->index);
     }
     av_freep(pm);
 }
@@ -174,8 +174,31 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+    struct ExprProgram *prog;
+    int nb_consts;
+    double *array_values; ///< constants of one element, for av_expr_eval_array() without prog
 };
 
+#define EXPR_BLOCK_SIZE 64
+#define EXPR_MAX_REGS   16
+
+/**
+ * One step of a compiled expression: evaluate the node e for a block of
+ * values, reading its arguments from registers src[] and writing its result
+ * to register dst.
+ */
+typedef struct ExprInsn {
+    const AVExpr *e;
+    int dst;
+    int src[3];
+} ExprInsn;
+
+typedef struct ExprProgram {
+    ExprInsn *insns;
+    int nb_insns;
+    int nb_regs;
+} ExprProgram;
+
 static double etime(double v)
 {
     return av_gettime() * 0.000001;
@@ -340,6 +363,10 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    av_freep(&e->array_values);
+    if (e->prog)
+        av_freep(&e->prog->insns);
+    av_freep(&e->prog);
     av_freep(&e);
 }
 
@@ -682,6 +709,134 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/**
+ * Replace the subexpressions which do not depend on the identifiers, the
+ * functions, the variables or the time with their value.
+ *
+ * @return 1 if e is (now) a constant value, 0 otherwise
+ */
+static int fold_expr(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i, is_const = 1;
+    double d;
+
+    if (!e)
+        return 1;
+    for (i = 0; i < 3; i++)
+        is_const &= fold_expr(e->param[i]);
+
+    switch (e->type) {
+    case e_value:
+        return 1;
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        return 0;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return 0;
+        break;
+    }
+    if (!is_const)
+        return 0;
+
+    d = eval_expr(&p, e);
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+    e->type  = e_value;
+    e->value = d;
+    return 1;
+}
+
+static int count_nodes(const AVExpr *e, int *nb_consts)
+{
+    int i, nb = 1;
+
+    if (e->type == e_const)
+        *nb_consts = FFMAX(*nb_consts, e->const_index + 1);
+    for (i = 0; i < 3 && e->param[i]; i++)
+        nb += count_nodes(e->param[i], nb_consts);
+    return nb;
+}
+
+static int compile_expr(ExprProgram *prog, const AVExpr *e, int dst)
+{
+    ExprInsn *insn;
+    int i, ret;
+
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        /* these depend on the order of evaluation */
+        return AVERROR(ENOSYS);
+    }
+
+    for (i = 0; i < 3 && e->param[i]; i++) {
+        if (dst + i >= EXPR_MAX_REGS)
+            return AVERROR(ENOSYS);
+        if ((ret = compile_expr(prog, e->param[i], dst + i)) < 0)
+            return ret;
+    }
+
+    insn = &prog->insns[prog->nb_insns++];
+    insn->e   = e;
+    insn->dst = dst;
+    for (i = 0; i < 3; i++)
+        insn->src[i] = e->param[i] ? dst + i : dst;
+    prog->nb_regs = FFMAX(prog->nb_regs, dst + 1);
+    return 0;
+}
+
+/**
+ * Lower the expression to a flat list of steps, each of which evaluates one
+ * node for a whole block of values, for use by av_expr_eval_array().
+ * Expressions with side effects are left for eval_expr().
+ */
+static int compile_program(AVExpr *e)
+{
+    ExprProgram *prog;
+    int nb_nodes = count_nodes(e, &e->nb_consts);
+    int ret;
+
+    prog = av_mallocz(sizeof(*prog));
+    if (!prog)
+        return AVERROR(ENOMEM);
+    prog->insns = av_calloc(nb_nodes, sizeof(*prog->insns));
+    if (!prog->insns) {
+        av_free(prog);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = compile_expr(prog, e, 0);
+    if (ret < 0) {
+        av_free(prog->insns);
+        av_free(prog);
+        if (ret != AVERROR(ENOSYS))
+            return ret;
+        /* av_expr_eval_array() falls back to av_expr_eval() per element */
+        e->array_values = av_malloc_array(FFMAX(e->nb_consts, 1),
+                                          sizeof(*e->array_values));
+        return e->array_values ? 0 : AVERROR(ENOMEM);
+    }
+    e->prog = prog;
+    return 0;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -724,6 +879,9 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_expr(e);
+    if ((ret = compile_program(e)) < 0)
+        goto end;
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
@@ -773,6 +931,106 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+static void run_program(const ExprProgram *prog, double (*r)[EXPR_BLOCK_SIZE],
+                        int offset, int n, const double *const_values,
+                        const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+#define LOOP(expr) for (j = 0; j < n; j++) { d[j] = (expr); } break
+    for (i = 0; i < prog->nb_insns; i++) {
+        const ExprInsn *insn = &prog->insns[i];
+        const AVExpr *e = insn->e;
+        const double *x = r[insn->src[0]];
+        const double *y = r[insn->src[1]];
+        const double *z = r[insn->src[2]];
+        double *d = r[insn->dst];
+        double v = e->value;
+
+        switch (e->type) {
+        case e_value: LOOP(v);
+        case e_const:
+            if (const_arrays && const_arrays[e->const_index]) {
+                const double *c = const_arrays[e->const_index] + offset;
+                LOOP(v * c[j]);
+            } else {
+                double c = v * const_values[e->const_index];
+                LOOP(c);
+            }
+        case e_func0:  LOOP(v * e->a.func0(x[j]));
+        case e_func1:  LOOP(v * e->a.func1(opaque, x[j]));
+        case e_func2:  LOOP(v * e->a.func2(opaque, x[j], y[j]));
+        case e_squish: LOOP(1/(1+exp(4*x[j])));
+        case e_gauss:  LOOP(exp(-x[j]*x[j]/2)/sqrt(2*M_PI));
+        case e_isnan:  LOOP(v * !!isnan(x[j]));
+        case e_isinf:  LOOP(v * !!isinf(x[j]));
+        case e_floor:  LOOP(v * floor(x[j]));
+        case e_ceil:   LOOP(v * ceil (x[j]));
+        case e_trunc:  LOOP(v * trunc(x[j]));
+        case e_round:  LOOP(v * round(x[j]));
+        case e_sgn:    LOOP(v * FFDIFFSIGN(x[j], 0));
+        case e_sqrt:   LOOP(v * sqrt (x[j]));
+        case e_not:    LOOP(v * (x[j] == 0));
+        case e_if:     LOOP(v * ( x[j] ? y[j] : e->param[2] ? z[j] : 0));
+        case e_ifnot:  LOOP(v * (!x[j] ? y[j] : e->param[2] ? z[j] : 0));
+        case e_clip:
+            LOOP(isnan(y[j]) || isnan(z[j]) || isnan(x[j]) || y[j] > z[j] ? NAN :
+                 v * av_clipd(x[j], y[j], z[j]));
+        case e_between: LOOP(v * (x[j] >= y[j] && x[j] <= z[j]));
+        case e_lerp:   LOOP(x[j] + (y[j] - x[j]) * z[j]);
+        case e_mod:    LOOP(v * (x[j] - floor(y[j] ? x[j] / y[j] : x[j] * INFINITY) * y[j]));
+        case e_gcd:    LOOP(v * av_gcd(x[j], y[j]));
+        case e_max:    LOOP(v * (x[j] >  y[j] ? x[j] : y[j]));
+        case e_min:    LOOP(v * (x[j] <  y[j] ? x[j] : y[j]));
+        case e_eq:     LOOP(v * (x[j] == y[j] ? 1.0 : 0.0));
+        case e_gt:     LOOP(v * (x[j] >  y[j] ? 1.0 : 0.0));
+        case e_gte:    LOOP(v * (x[j] >= y[j] ? 1.0 : 0.0));
+        case e_lt:     LOOP(v * (x[j] <  y[j] ? 1.0 : 0.0));
+        case e_lte:    LOOP(v * (x[j] <= y[j] ? 1.0 : 0.0));
+        case e_pow:    LOOP(v * pow(x[j], y[j]));
+        case e_mul:    LOOP(v * (x[j] * y[j]));
+        case e_div:    LOOP(v * (y[j] ? (x[j] / y[j]) : x[j] * INFINITY));
+        case e_add:    LOOP(v * (x[j] + y[j]));
+        case e_last:   LOOP(v * y[j]);
+        case e_hypot:  LOOP(v * hypot(x[j], y[j]));
+        case e_atan2:  LOOP(v * atan2(x[j], y[j]));
+        case e_bitand: LOOP(isnan(x[j]) || isnan(y[j]) ? NAN : v * ((long int)x[j] & (long int)y[j]));
+        case e_bitor:  LOOP(isnan(x[j]) || isnan(y[j]) ? NAN : v * ((long int)x[j] | (long int)y[j]));
+        default:       LOOP(NAN);
+        }
+    }
+#undef LOOP
+}
+
+int av_expr_eval_array(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    double *values = e->array_values;
+    int i, j;
+
+    if (e->prog) {
+        double r[EXPR_MAX_REGS][EXPR_BLOCK_SIZE];
+
+        for (i = 0; i < nb; i += EXPR_BLOCK_SIZE) {
+            int n = FFMIN(nb - i, EXPR_BLOCK_SIZE);
+            run_program(e->prog, r, i, n, const_values, const_arrays, opaque);
+            memcpy(res + i, r[0], n * sizeof(*res));
+        }
+        return 0;
+    }
+
+    if (e->nb_consts)
+        memcpy(values, const_values, e->nb_consts * sizeof(*values));
+    for (i = 0; i < nb; i++) {
+        for (j = 0; const_arrays && j < e->nb_consts; j++)
+            if (const_arrays[j])
+                values[j] = const_arrays[j][i];
+        res[i] = av_expr_eval(e, values, opaque);
+    }
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
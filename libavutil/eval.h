@@ -86,6 +86,29 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for several sets of values of the
+ * identifiers, e.g. once for each pixel of a row.
+ *
+ * This is equivalent to calling av_expr_eval() nb times, where the i-th
+ * call uses const_arrays[k][i] as the value of the k-th identifier if
+ * const_arrays[k] is not NULL, and const_values[k] otherwise, but is usually
+ * much faster. The functions from funcs1 and funcs2 may be called in a
+ * different order and more often than with av_expr_eval(), so they should
+ * not have side effects.
+ *
+ * @param res          array of nb elements where the results will be stored
+ * @param nb           number of evaluations
+ * @param const_values an array of values for the identifiers from av_expr_parse() const_names
+ * @param const_arrays an array of per-evaluation values for the identifiers, may be NULL;
+ *                     each non-NULL element must have nb elements
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_expr_eval_array(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
@@ -52,6 +52,7 @@ DECLARE_BLOCK_FUNCTIONS(4)
 DECLARE_BLOCK_FUNCTIONS(8)
 DECLARE_BLOCK_FUNCTIONS(16)
 DECLARE_BLOCK_FUNCTIONS(32)
+DECLARE_BLOCK_FUNCTIONS(64)
 
 static const av_pixelutils_sad_fn sad_c[] = {
     block_sad_2x2_c,
@@ -59,6 +60,7 @@ static const av_pixelutils_sad_fn sad_c[] = {
     block_sad_8x8_c,
     block_sad_16x16_c,
     block_sad_32x32_c,
+    block_sad_64x64_c,
 };
 
 #endif /* CONFIG_PIXELUTILS */
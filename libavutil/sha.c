@@ -29,6 +29,9 @@
 #include "sha.h"
 #include "intreadwrite.h"
 #include "mem.h"
+#if ARCH_X86
+#include "x86/sha.h"
+#endif
 
 /** hash context */
 typedef struct AVSHA {
@@ -307,6 +310,9 @@ av_cold int av_sha_init(AVSHA *ctx, int bits)
     default:
         return AVERROR(EINVAL);
     }
+#if ARCH_X86
+    ff_sha_init_x86(&ctx->transform, bits);
+#endif
     ctx->count = 0;
     return 0;
 }
@@ -23,10 +23,63 @@
 #include <string.h>
 
 #include "libavutil/aes.h"
+#include "libavutil/cpu.h"
 #include "libavutil/lfg.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
 
+/* Check that the optimized code (if any) matches the C code on multiple
+ * blocks, for every key size and mode, in place or not. */
+static int check_simd(AVLFG *prng)
+{
+    struct AVAES *ref = av_aes_alloc(), *opt = av_aes_alloc();
+    uint8_t key[32], src[64 * 16], dst[2][64 * 16], iv[2][16];
+    int i, j, err = 0;
+
+    if (!ref || !opt) {
+        err = 1;
+        goto end;
+    }
+
+    for (i = 0; i < 600; i++) {
+        int bits     = 128 + 64 * (i % 3);
+        int decrypt  = (i / 3) & 1;
+        int cbc      = (i / 6) & 1;
+        int in_place = (i / 12) & 1;
+        int count    = 1 + av_lfg_get(prng) % 64;
+
+        for (j = 0; j < sizeof(key); j++)
+            key[j] = av_lfg_get(prng);
+        for (j = 0; j < sizeof(src); j++)
+            src[j] = av_lfg_get(prng);
+        for (j = 0; j < 16; j++)
+            iv[0][j] = iv[1][j] = av_lfg_get(prng);
+
+        av_force_cpu_flags(0);
+        av_aes_init(ref, key, bits, decrypt);
+        av_force_cpu_flags(-1);
+        av_aes_init(opt, key, bits, decrypt);
+
+        av_aes_crypt(ref, dst[0], src, count, cbc ? iv[0] : NULL, decrypt);
+        if (in_place) {
+            memcpy(dst[1], src, count * 16);
+            av_aes_crypt(opt, dst[1], dst[1], count, cbc ? iv[1] : NULL, decrypt);
+        } else {
+            av_aes_crypt(opt, dst[1], src, count, cbc ? iv[1] : NULL, decrypt);
+        }
+        if (memcmp(dst[0], dst[1], count * 16) || memcmp(iv[0], iv[1], 16)) {
+            av_log(NULL, AV_LOG_ERROR, "mismatch: %d bits, %s, %s, %d blocks\n",
+                   bits, decrypt ? "decrypt" : "encrypt", cbc ? "CBC" : "ECB", count);
+            err = 1;
+        }
+    }
+
+end:
+    av_free(ref);
+    av_free(opt);
+    return err;
+}
+
 int main(int argc, char **argv)
 {
     int i, j;
@@ -71,9 +124,17 @@ int main(int argc, char **argv)
     }
     av_free(b);
 
+    {
+        AVLFG prng;
+
+        av_lfg_init(&prng, 1);
+        err |= check_simd(&prng);
+    }
+
     if (argc > 1 && !strcmp(argv[1], "-t")) {
         struct AVAES *ae, *ad;
         AVLFG prng;
+        static uint8_t buf[4096];
 
         ae = av_aes_alloc();
         ad = av_aes_alloc();
@@ -114,6 +175,17 @@ int main(int argc, char **argv)
                 }
             }
         }
+
+        for (i = 0; i < 10000; i++) {
+            START_TIMER;
+            av_aes_crypt(ae, buf, buf, sizeof(buf) / 16, NULL, 0);
+            STOP_TIMER("aes ecb 4096");
+        }
+        for (i = 0; i < 10000; i++) {
+            START_TIMER;
+            av_aes_crypt(ad, buf, buf, sizeof(buf) / 16, iv[1], 1);
+            STOP_TIMER("aes cbc decrypt 4096");
+        }
         av_free(ae);
         av_free(ad);
     }
@@ -24,12 +24,15 @@ static const DECLARE_ALIGNED(8, uint8_t, plain)[] = {
     0x6d, 0x6f, 0x73, 0x74, 0x20, 0x72, 0x61, 0x6e, 0x64, 0x6f, 0x6d
 };
 static DECLARE_ALIGNED(8, uint8_t, tmp)[11];
+static uint8_t big[2][1000];
+static uint8_t full_iv[16];
 
 int main (void)
 {
     int ret = 1;
     struct AVAESCTR *ae, *ad;
     const uint8_t *iv;
+    int i;
 
     ae = av_aes_ctr_alloc();
     ad = av_aes_ctr_alloc();
@@ -46,6 +49,7 @@ int main (void)
     av_aes_ctr_set_random_iv(ae);
     iv =   av_aes_ctr_get_iv(ae);
     av_aes_ctr_set_full_iv(ad, iv);
+    memcpy(full_iv, iv, sizeof(full_iv));
 
     av_aes_ctr_crypt(ae, tmp, plain, sizeof(tmp));
     av_aes_ctr_crypt(ad, tmp, tmp,   sizeof(tmp));
@@ -55,6 +59,20 @@ int main (void)
         goto ERROR;
     }
 
+    /* whole blocks are encrypted in batches, compare with one byte at a time */
+    for (i = 0; i < sizeof(big[0]); i++)
+        big[0][i] = big[1][i] = i * i;
+    av_aes_ctr_set_full_iv(ae, full_iv);
+    av_aes_ctr_crypt(ae, big[0], big[0], sizeof(big[0]));
+    av_aes_ctr_set_full_iv(ad, full_iv);
+    for (i = 0; i < sizeof(big[1]); i++)
+        av_aes_ctr_crypt(ad, big[1] + i, big[1] + i, 1);
+
+    if (memcmp(big[0], big[1], sizeof(big[0])) != 0) {
+        av_log(NULL, AV_LOG_ERROR, "test failed\n");
+        goto ERROR;
+    }
+
     av_log(NULL, AV_LOG_INFO, "test passed\n");
     ret = 0;
 
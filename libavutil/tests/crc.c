@@ -18,13 +18,46 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "libavutil/crc.h"
+#include "libavutil/lfg.h"
+#include "libavutil/macros.h"
+#include "libavutil/timer.h"
 
-int main(void)
+/* Compare av_crc() on the built-in tables, which may take a SIMD path for
+ * longer buffers, with a table built by av_crc_init(). */
+static int check_crc(AVLFG *prng, AVCRCId id, int le, int bits, uint32_t poly)
 {
-    uint8_t buf[1999];
+    static uint8_t data[4096 + 16];
+    const AVCRC *ctx = av_crc_get_table(id);
+    AVCRC ref[1024];
     int i;
+
+    if (av_crc_init(ref, le, bits, poly, sizeof(ref)) < 0)
+        return 1;
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = av_lfg_get(prng);
+
+    for (i = 0; i < 1000; i++) {
+        int offset = av_lfg_get(prng) % 16;
+        int len    = av_lfg_get(prng) % 4096;
+        uint32_t init = av_lfg_get(prng) & (bits == 32 ? UINT32_MAX : (1U << bits) - 1);
+        uint32_t a = av_crc(ctx, init, data + offset, len);
+        uint32_t b = av_crc(ref, init, data + offset, len);
+
+        if (a != b) {
+            printf("crc %08X mismatch at len %d: %X != %X\n", poly, len, a, b);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t buf[1999];
+    int i, err = 0;
     static const unsigned p[7][3] = {
         { AV_CRC_32_IEEE_LE, 0xEDB88320, 0x3D5CDD04 },
         { AV_CRC_32_IEEE   , 0x04C11DB7, 0xC0F5BAE0 },
@@ -43,5 +76,41 @@ int main(void)
         ctx = av_crc_get_table(p[i][0]);
         printf("crc %08X = %X\n", p[i][1], av_crc(ctx, 0, buf, sizeof(buf)));
     }
-    return 0;
+
+    {
+        static const struct {
+            AVCRCId id;
+            int le, bits;
+            uint32_t poly;
+        } all[] = {
+            { AV_CRC_8_ATM,      0,  8,       0x07 },
+            { AV_CRC_8_EBU,      0,  8,       0x1D },
+            { AV_CRC_16_ANSI,    0, 16,     0x8005 },
+            { AV_CRC_16_CCITT,   0, 16,     0x1021 },
+            { AV_CRC_24_IEEE,    0, 24,   0x864CFB },
+            { AV_CRC_32_IEEE,    0, 32, 0x04C11DB7 },
+            { AV_CRC_32_IEEE_LE, 1, 32, 0xEDB88320 },
+            { AV_CRC_16_ANSI_LE, 1, 16,     0xA001 },
+        };
+        AVLFG prng;
+
+        av_lfg_init(&prng, 1);
+        for (i = 0; i < FF_ARRAY_ELEMS(all); i++)
+            err |= check_crc(&prng, all[i].id, all[i].le, all[i].bits, all[i].poly);
+    }
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        static uint8_t data[1 << 20];
+        volatile uint32_t crc = 0;
+
+        for (i = 0; i < sizeof(data); i++)
+            data[i] = i + i * i;
+        ctx = av_crc_get_table(AV_CRC_32_IEEE_LE);
+        for (i = 0; i < 100; i++) {
+            START_TIMER;
+            crc = av_crc(ctx, crc, data, sizeof(data));
+            STOP_TIMER("crc32 1 MiB");
+        }
+    }
+    return err;
 }
@@ -54,6 +54,8 @@ int main(void)
     AVDictionary *dict = NULL;
     AVDictionaryEntry *e;
     char *buffer = NULL;
+    char key[16];
+    int i;
 
     printf("Testing av_dict_get_string() and av_dict_parse_string()\n");
     av_dict_get_string(dict, &buffer, '=', ',');
@@ -132,5 +134,28 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_get() with many entries\n");
+    for (i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set_int(&dict, key, i, 0);
+    }
+    av_dict_set(&dict, "KEY42", "upper", AV_DICT_MATCH_CASE);
+    av_dict_set(&dict, "key7", NULL, 0);
+    av_dict_set(&dict, "key8", "eight", 0);
+    av_dict_set(&dict, "key9", "nine", AV_DICT_MULTIKEY);
+    av_dict_set(&dict, "Key10", "ten", AV_DICT_APPEND);
+    printf("%d entries\n", av_dict_count(dict));
+    for (i = 0; i < 6; i++) {
+        static const char *const keys[] = { "key42", "KEY42", "key7", "key8", "key9", "key10" };
+        e = av_dict_get(dict, keys[i], NULL, 0);
+        printf("%s: %s", keys[i], e ? e->value : "(null)");
+        e = av_dict_get(dict, keys[i], NULL, AV_DICT_MATCH_CASE);
+        printf(" %s\n", e ? e->value : "(null)");
+    }
+    e = NULL;
+    while ((e = av_dict_get(dict, "key9", e, 0)))
+        printf("%s %s\n", e->key, e->value);
+    av_dict_free(&dict);
+
     return 0;
 }
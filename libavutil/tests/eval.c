@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "libavutil/libm.h"
+#include "libavutil/macros.h"
 #include "libavutil/eval.h"
 
 static const double const_values[] = {
@@ -37,6 +38,38 @@ static const char *const const_names[] = {
     0
 };
 
+#define ARRAY_NB 100
+
+/* compare av_expr_eval_array() with av_expr_eval() for each element */
+static void test_eval_array(const char *s)
+{
+    double e_array[ARRAY_NB], res[ARRAY_NB], values[2] = { M_PI, 0 };
+    const double *arrays[2] = { NULL, e_array };
+    AVExpr *e;
+    int i, mismatches = 0;
+
+    for (i = 0; i < ARRAY_NB; i++)
+        e_array[i] = i * 0.37 - 5;
+
+    if (av_expr_parse(&e, s, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0) {
+        printf("av_expr_parse failed\n");
+        return;
+    }
+    if (av_expr_eval_array(e, res, ARRAY_NB, values, arrays, NULL) < 0)
+        printf("av_expr_eval_array failed\n");
+    for (i = 0; i < ARRAY_NB; i++) {
+        double ref;
+
+        values[1] = e_array[i];
+        ref = av_expr_eval(e, values, NULL);
+        if (isnan(ref) ? !isnan(res[i]) :
+            fabs(res[i] - ref) > 1e-12 * FFMAX(fabs(ref), 1))
+            mismatches++;
+    }
+    printf("av_expr_eval_array '%s': %d mismatches\n", s, mismatches);
+    av_expr_free(e);
+}
+
 int main(int argc, char **argv)
 {
     int i;
@@ -168,6 +201,11 @@ int main(int argc, char **argv)
     if (ret < 0)
         printf("av_expr_parse_and_eval failed\n");
 
+    test_eval_array("PI*E+sin(E)-E/3");
+    test_eval_array("if(gt(E,PI), E-PI, hypot(PI,E))");
+    test_eval_array("clip(E, -1, 1)+floor(E*3)+sqrt(E)");
+    test_eval_array("st(0, E*2); ld(0)+PI");
+
     if (argc > 1 && !strcmp(argv[1], "-t")) {
         for (i = 0; i < 1050; i++) {
             START_TIMER;
@@ -17,11 +17,13 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "libavutil/mem.h"
 #include "libavutil/sha.h"
+#include "libavutil/timer.h"
 
-int main(void)
+int main(int argc, char **argv)
 {
     int i, j, k;
     struct AVSHA *ctx;
@@ -69,6 +71,22 @@ int main(void)
             break;
         }
     }
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        static uint8_t data[1 << 16];
+
+        for (i = 0; i < sizeof(data); i++)
+            data[i] = i + i * i;
+        for (j = 0; j < 3; j++) {
+            av_sha_init(ctx, lengths[j]);
+            for (k = 0; k < 1000; k++) {
+                START_TIMER;
+                av_sha_update(ctx, data, sizeof(data));
+                STOP_TIMER(lengths[j] == 160 ? "sha1 64 KiB" : "sha2 64 KiB");
+            }
+            av_sha_final(ctx, digest);
+        }
+    }
     av_free(ctx);
 
     return 0;
@@ -0,0 +1,236 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
+#include "libavutil/time.h"
+
+typedef struct Msg {
+    unsigned seq;
+    int64_t  time;
+} Msg;
+
+typedef struct Pipe {
+    AVThreadMessageQueue *queue;
+    AVThreadMessageQueue *reply;
+    unsigned nb_msgs;
+    unsigned batch;
+} Pipe;
+
+static void *sender(void *arg)
+{
+    Pipe *p = arg;
+    Msg msgs[64];
+    unsigned seq = 0;
+    int ret = 0;
+
+    while (seq < p->nb_msgs) {
+        unsigned i, n = FFMIN(p->batch ? 1 + seq % p->batch : 1, p->nb_msgs - seq);
+
+        for (i = 0; i < n; i++)
+            msgs[i].seq = seq + i;
+        if (n == 1)
+            ret = av_thread_message_queue_send(p->queue, msgs, 0);
+        else
+            ret = av_thread_message_queue_send_batch(p->queue, msgs, n, 0);
+        if (ret < 0)
+            break;
+        seq += n;
+    }
+    av_thread_message_queue_set_err_recv(p->queue, ret < 0 ? ret : AVERROR_EOF);
+    return NULL;
+}
+
+/* Send nb_msgs messages through a queue of size 16 from another thread and
+ * check that they arrive in order, alternating single and batched calls. */
+static int check_order(unsigned flags, unsigned batch)
+{
+    Pipe p = { .nb_msgs = 100000, .batch = batch };
+    pthread_t thread;
+    Msg msgs[64];
+    unsigned seq = 0;
+    int i, ret;
+
+    if ((ret = av_thread_message_queue_alloc2(&p.queue, 16, sizeof(Msg), flags)) < 0)
+        return ret;
+    if ((ret = pthread_create(&thread, NULL, sender, &p))) {
+        av_thread_message_queue_free(&p.queue);
+        return AVERROR(ret);
+    }
+    while (1) {
+        if (seq & 1) {
+            if ((ret = av_thread_message_queue_recv(p.queue, msgs, 0)) >= 0)
+                ret = 1;
+        } else
+            ret = av_thread_message_queue_recv_batch(p.queue, msgs, FF_ARRAY_ELEMS(msgs), 0);
+        if (ret < 0)
+            break;
+        for (i = 0; i < ret; i++) {
+            if (msgs[i].seq != seq++) {
+                printf("message %u received as %u\n", msgs[i].seq, seq - 1);
+                ret = AVERROR_BUG;
+                break;
+            }
+        }
+        if (ret < 0)
+            break;
+    }
+    av_thread_message_queue_set_err_send(p.queue, AVERROR_EOF);
+    pthread_join(thread, NULL);
+    av_thread_message_queue_free(&p.queue);
+    if (ret != AVERROR_EOF)
+        return ret;
+    if (seq != p.nb_msgs) {
+        printf("received %u messages instead of %u\n", seq, p.nb_msgs);
+        return AVERROR_BUG;
+    }
+    return 0;
+}
+
+/* non-blocking calls on a full/empty queue */
+static int check_nonblock(unsigned flags)
+{
+    AVThreadMessageQueue *queue;
+    Msg msgs[5] = { { 0 } };
+    int ret, err = 0;
+
+    if ((ret = av_thread_message_queue_alloc2(&queue, 4, sizeof(Msg), flags)) < 0)
+        return ret;
+    err |= av_thread_message_queue_recv(queue, msgs, AV_THREAD_MESSAGE_NONBLOCK) != AVERROR(EAGAIN);
+    err |= av_thread_message_queue_send_batch(queue, msgs, 5, AV_THREAD_MESSAGE_NONBLOCK) != 4;
+    err |= av_thread_message_queue_nb_elems(queue) != 4;
+    err |= av_thread_message_queue_send(queue, msgs, AV_THREAD_MESSAGE_NONBLOCK) != AVERROR(EAGAIN);
+    err |= av_thread_message_queue_recv_batch(queue, msgs, 3, 0) != 3;
+    av_thread_message_queue_set_err_recv(queue, AVERROR_EOF);
+    err |= av_thread_message_queue_recv_batch(queue, msgs, 3, 0) != 1;
+    err |= av_thread_message_queue_recv(queue, msgs, 0) != AVERROR_EOF;
+    av_thread_message_queue_set_err_send(queue, AVERROR(EIO));
+    err |= av_thread_message_queue_send(queue, msgs, 0) != AVERROR(EIO);
+    av_thread_message_queue_free(&queue);
+    return err ? AVERROR_BUG : 0;
+}
+
+// LCOV_EXCL_START
+
+static double throughput(unsigned flags, unsigned batch)
+{
+    Pipe p = { .nb_msgs = 2000000, .batch = batch };
+    pthread_t thread;
+    Msg msgs[64];
+    int64_t t;
+    int ret;
+
+    if (av_thread_message_queue_alloc2(&p.queue, 64, sizeof(Msg), flags) < 0)
+        return 0;
+    t = av_gettime_relative();
+    if (pthread_create(&thread, NULL, sender, &p)) {
+        av_thread_message_queue_free(&p.queue);
+        return 0;
+    }
+    do {
+        ret = batch ? av_thread_message_queue_recv_batch(p.queue, msgs, FF_ARRAY_ELEMS(msgs), 0)
+                    : av_thread_message_queue_recv(p.queue, msgs, 0);
+    } while (ret >= 0);
+    pthread_join(thread, NULL);
+    t = av_gettime_relative() - t;
+    av_thread_message_queue_free(&p.queue);
+    return p.nb_msgs / (t / 1000000.0);
+}
+
+static void *echo(void *arg)
+{
+    Pipe *p = arg;
+    Msg msg;
+
+    while (av_thread_message_queue_recv(p->queue, &msg, 0) >= 0)
+        if (av_thread_message_queue_send(p->reply, &msg, 0) < 0)
+            break;
+    return NULL;
+}
+
+/* one way latency, from a ping-pong between two threads */
+static double latency(unsigned flags, int64_t pause)
+{
+    Pipe p = { .nb_msgs = 2000 };
+    pthread_t thread;
+    int64_t total = 0;
+    unsigned i = 0;
+    Msg msg;
+
+    if (av_thread_message_queue_alloc2(&p.queue, 1, sizeof(Msg), flags) < 0 ||
+        av_thread_message_queue_alloc2(&p.reply, 1, sizeof(Msg), flags) < 0)
+        goto end;
+    if (pthread_create(&thread, NULL, echo, &p))
+        goto end;
+    for (i = 0; i < p.nb_msgs; i++) {
+        /* let the other thread go to sleep to measure wake-up latency */
+        if (pause)
+            av_usleep(pause);
+        msg.time = av_gettime_relative();
+        if (av_thread_message_queue_send(p.queue, &msg, 0) < 0 ||
+            av_thread_message_queue_recv(p.reply, &msg, 0) < 0)
+            break;
+        total += av_gettime_relative() - msg.time;
+    }
+    av_thread_message_queue_set_err_recv(p.queue, AVERROR_EOF);
+    pthread_join(thread, NULL);
+end:
+    av_thread_message_queue_free(&p.queue);
+    av_thread_message_queue_free(&p.reply);
+    return i ? total / 2.0 / i : 0;
+}
+
+// LCOV_EXCL_STOP
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        const char *name;
+        unsigned flags;
+    } modes[] = {
+        { "mutex", 0 },
+        { "spsc",  AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC },
+    };
+    int i, ret, err = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(modes); i++) {
+        if ((ret = check_nonblock(modes[i].flags)) < 0 ||
+            (ret = check_order(modes[i].flags, 0)) < 0 ||
+            (ret = check_order(modes[i].flags, 37)) < 0) {
+            printf("%s: %s\n", modes[i].name, av_err2str(ret));
+            err = 1;
+        }
+    }
+
+    if (argc > 1 && !strcmp(argv[1], "-t")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(modes); i++) {
+            printf("%-5s: %5.2f Mmsg/s, %5.2f Mmsg/s batched, "
+                   "latency %.2f us (busy) %.2f us (idle)\n", modes[i].name,
+                   throughput(modes[i].flags,  0) / 1000000,
+                   throughput(modes[i].flags, 64) / 1000000,
+                   latency(modes[i].flags, 0), latency(modes[i].flags, 1000));
+        }
+    }
+
+    return err;
+}
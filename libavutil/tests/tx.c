@@ -0,0 +1,252 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "libavutil/tx.h"
+
+/* Checks the FFT, RDFT and DCT types against direct evaluation of their
+ * definitions, for lengths which take all the different code paths. */
+
+enum SampleType { FLT, DBL, S32 };
+
+static const struct {
+    enum SampleType sample;
+    enum AVTXType fft, rdft, dct;
+    const char *name;
+    double eps;
+} types[] = {
+    { FLT, AV_TX_FLOAT_FFT,  AV_TX_FLOAT_RDFT,  AV_TX_FLOAT_DCT,  "float",  1e-5  },
+    { DBL, AV_TX_DOUBLE_FFT, AV_TX_DOUBLE_RDFT, AV_TX_DOUBLE_DCT, "double", 1e-12 },
+    { S32, AV_TX_INT32_FFT,  AV_TX_INT32_RDFT,  AV_TX_INT32_DCT,  "int32",  1e-5  },
+};
+
+/* power of two, PFA, prime and composite lengths */
+static const int fft_lens[] = { 2, 3, 6, 7, 15, 16, 17, 30, 97, 100, 210, 1000, 1009 };
+static const int dct_lens[] = { 2, 4, 6, 16, 30, 34, 64, 100, 1024, 1026 };
+
+/* int32 transforms use Q31, so the input is scaled down for headroom */
+#define S32_SCALE (2147483648.0 / 4096)
+
+static void store(enum SampleType t, void *dst, const double *src, int n)
+{
+    for (int i = 0; i < n; i++) {
+        switch (t) {
+        case FLT: ((float   *)dst)[i] = src[i];                      break;
+        case DBL: ((double  *)dst)[i] = src[i];                      break;
+        case S32: ((int32_t *)dst)[i] = lrint(src[i] * S32_SCALE); break;
+        }
+    }
+}
+
+static void load(enum SampleType t, double *dst, const void *src, int n)
+{
+    for (int i = 0; i < n; i++) {
+        switch (t) {
+        case FLT: dst[i] = ((const float   *)src)[i];             break;
+        case DBL: dst[i] = ((const double  *)src)[i];             break;
+        case S32: dst[i] = ((const int32_t *)src)[i] / S32_SCALE; break;
+        }
+    }
+}
+
+static int compare(const char *what, const char *name, int inv, int len,
+                   const double *out, const double *ref, int n, double eps)
+{
+    double err = 0, max = 1;
+
+    for (int i = 0; i < n; i++) {
+        err = FFMAX(err, fabs(out[i] - ref[i]));
+        max = FFMAX(max, fabs(ref[i]));
+    }
+    if (err > eps * max * len) {
+        printf("%s %s %s %d: error %g\n", name, inv ? "inverse" : "forward",
+               what, len, err / max);
+        return 1;
+    }
+    return 0;
+}
+
+static int run(enum AVTXType type, enum SampleType sample, int inv, int len,
+               double *out, const double *in, int in_n, int out_n,
+               const void *scale, ptrdiff_t stride)
+{
+    AVTXContext *tx;
+    av_tx_fn fn;
+    void *src, *dst;
+    int ret;
+
+    if ((ret = av_tx_init(&tx, &fn, type, inv, len, scale, 0)) < 0)
+        return ret;
+    src = av_malloc_array(in_n,  sizeof(double));
+    dst = av_malloc_array(out_n, sizeof(double));
+    if (!src || !dst) {
+        ret = AVERROR(ENOMEM);
+    } else {
+        store(sample, src, in, in_n);
+        fn(tx, dst, src, stride);
+        load(sample, out, dst, out_n);
+    }
+    av_free(src);
+    av_free(dst);
+    av_tx_uninit(&tx);
+    return ret;
+}
+
+static int check_fft(int t, int len, int inv, AVLFG *lfg,
+                     double *in, double *ref, double *out)
+{
+    const double sign = inv ? 1 : -1;
+    int ret;
+
+    for (int i = 0; i < 2*len; i++)
+        in[i] = av_lfg_get(lfg) / (double)UINT_MAX - 0.5;
+    for (int k = 0; k < len; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < len; n++) {
+            double phase = sign * 2 * M_PI * ((int64_t)n * k % len) / len;
+            re += in[2*n] * cos(phase) - in[2*n + 1] * sin(phase);
+            im += in[2*n] * sin(phase) + in[2*n + 1] * cos(phase);
+        }
+        ref[2*k] = re;
+        ref[2*k + 1] = im;
+    }
+
+    ret = run(types[t].fft, types[t].sample, inv, len, out, in, 2*len, 2*len,
+              NULL, 2 * (types[t].sample == FLT ? sizeof(float) :
+                         types[t].sample == DBL ? sizeof(double) : sizeof(int32_t)));
+    if (ret < 0)
+        return 1;
+    return compare("fft", types[t].name, inv, len, out, ref, 2*len, types[t].eps);
+}
+
+static int check_rdft(int t, int len, int inv, AVLFG *lfg,
+                      double *in, double *ref, double *out)
+{
+    const float  scale_f = 0.5f;
+    const double scale_d = 0.5;
+    const void *scale = types[t].sample == DBL ? (const void *)&scale_d :
+                                                 (const void *)&scale_f;
+    const ptrdiff_t stride = types[t].sample == FLT ? sizeof(float) :
+                             types[t].sample == DBL ? sizeof(double) : sizeof(int32_t);
+    int ret;
+
+    if (!inv) {
+        for (int i = 0; i < len; i++)
+            in[i] = av_lfg_get(lfg) / (double)UINT_MAX - 0.5;
+        for (int k = 0; k <= len / 2; k++) {
+            double re = 0, im = 0;
+            for (int n = 0; n < len; n++) {
+                double phase = -2 * M_PI * ((int64_t)n * k % len) / len;
+                re += in[n] * cos(phase);
+                im += in[n] * sin(phase);
+            }
+            ref[2*k]     = 0.5 * re;
+            ref[2*k + 1] = 0.5 * im;
+        }
+        ret = run(types[t].rdft, types[t].sample, 0, len, out, in,
+                  len + 2, len + 2, scale, stride);
+        /* the imaginary part of the last bin is not written */
+        out[len + 1] = ref[len + 1];
+    } else {
+        for (int i = 0; i < len + 2; i++)
+            in[i] = av_lfg_get(lfg) / (double)UINT_MAX - 0.5;
+        in[1] = in[len + 1] = 0;
+        for (int n = 0; n < len; n++) {
+            double sum = in[0] + in[len] * (n & 1 ? -1 : 1);
+            for (int k = 1; k < len / 2; k++) {
+                double phase = 2 * M_PI * ((int64_t)n * k % len) / len;
+                sum += 2 * (in[2*k] * cos(phase) - in[2*k + 1] * sin(phase));
+            }
+            ref[n] = 0.5 * sum;
+        }
+        ret = run(types[t].rdft, types[t].sample, 1, len, out, in,
+                  len + 2, len, scale, stride);
+    }
+    if (ret < 0)
+        return 1;
+    return compare("rdft", types[t].name, inv, len, out, ref,
+                   inv ? len : len + 2, types[t].eps);
+}
+
+static int check_dct(int t, int len, int inv, AVLFG *lfg,
+                     double *in, double *ref, double *out)
+{
+    const float  scale_f = 2.0f / len;
+    const double scale_d = 2.0  / len;
+    const void *scale = !inv ? NULL : types[t].sample == DBL ?
+                        (const void *)&scale_d : (const void *)&scale_f;
+    const ptrdiff_t stride = types[t].sample == FLT ? sizeof(float) :
+                             types[t].sample == DBL ? sizeof(double) : sizeof(int32_t);
+    int ret;
+
+    for (int i = 0; i < len; i++)
+        in[i] = av_lfg_get(lfg) / (double)UINT_MAX - 0.5;
+    for (int k = 0; k < len; k++) {
+        double sum = inv ? in[0] / 2 : 0;
+        for (int n = !!inv; n < len; n++) {
+            if (inv)
+                sum += in[n] * cos(M_PI * (k + 0.5) * n / len);
+            else
+                sum += in[n] * cos(M_PI * (n + 0.5) * k / len);
+        }
+        ref[k] = inv ? sum * 2 / len : sum;
+    }
+
+    ret = run(types[t].dct, types[t].sample, inv, len, out, in, len, len,
+              scale, stride);
+    if (ret < 0)
+        return 1;
+    return compare("dct", types[t].name, inv, len, out, ref, len, types[t].eps);
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    double *in, *ref, *out;
+    int err = 0;
+
+    in  = av_malloc_array(2 * 2048, sizeof(*in));
+    ref = av_malloc_array(2 * 2048, sizeof(*ref));
+    out = av_malloc_array(2 * 2048, sizeof(*out));
+    if (!in || !ref || !out)
+        return 1;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int t = 0; t < FF_ARRAY_ELEMS(types); t++) {
+        for (int inv = 0; inv < 2; inv++) {
+            for (int i = 0; i < FF_ARRAY_ELEMS(fft_lens); i++)
+                err |= check_fft(t, fft_lens[i], inv, &lfg, in, ref, out);
+            for (int i = 0; i < FF_ARRAY_ELEMS(dct_lens); i++) {
+                err |= check_rdft(t, dct_lens[i], inv, &lfg, in, ref, out);
+                err |= check_dct(t, dct_lens[i], inv, &lfg, in, ref, out);
+            }
+        }
+    }
+
+    av_free(in);
+    av_free(ref);
+    av_free(out);
+    return err;
+}
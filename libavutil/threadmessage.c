@@ -18,28 +18,51 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
+#include <string.h>
+
+#include "cpu.h"
 #include "fifo.h"
 #include "threadmessage.h"
 #include "thread.h"
 
+/* number of polls before blocking in SPSC mode, adapted at runtime */
+#define SPIN_MIN    16
+#define SPIN_INIT 1024
+#define SPIN_MAX 65536
+
 struct AVThreadMessageQueue {
 #if HAVE_THREADS
     AVFifo *fifo;
     pthread_mutex_t lock;
     pthread_cond_t cond_recv;
     pthread_cond_t cond_send;
-    int err_send;
-    int err_recv;
+    atomic_int err_send;
+    atomic_int err_recv;
     unsigned elsize;
     void (*free_func)(void *msg);
+
+    /* SPSC mode: fifo is NULL and the messages live in a ring of nelem
+     * elements. The positions count modulo 2 * nelem, so that a full ring
+     * can be told from an empty one; each is only written by its side. */
+    uint8_t *ring;
+    unsigned nelem;
+    atomic_uint write_pos;
+    atomic_uint read_pos;
+    atomic_int send_waiting;
+    atomic_int recv_waiting;
+    int spin_send;
+    int spin_recv;
+    int spin_max;
 #else
     int dummy;
 #endif
 };
 
-int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
-                                  unsigned nelem,
-                                  unsigned elsize)
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags)
 {
 #if HAVE_THREADS
     AVThreadMessageQueue *rmq;
@@ -47,6 +70,8 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
 
     if (nelem > INT_MAX / elsize)
         return AVERROR(EINVAL);
+    if ((flags & AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC) && !nelem)
+        return AVERROR(EINVAL);
     if (!(rmq = av_mallocz(sizeof(*rmq))))
         return AVERROR(ENOMEM);
     if ((ret = pthread_mutex_init(&rmq->lock, NULL))) {
@@ -64,7 +89,11 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
         av_free(rmq);
         return AVERROR(ret);
     }
-    if (!(rmq->fifo = av_fifo_alloc2(nelem, elsize, 0))) {
+    if (flags & AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC)
+        rmq->ring = av_malloc_array(nelem, elsize);
+    else
+        rmq->fifo = av_fifo_alloc2(nelem, elsize, 0);
+    if (!rmq->ring && !rmq->fifo) {
         pthread_cond_destroy(&rmq->cond_send);
         pthread_cond_destroy(&rmq->cond_recv);
         pthread_mutex_destroy(&rmq->lock);
@@ -72,6 +101,16 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
         return AVERROR(ENOMEM);
     }
     rmq->elsize = elsize;
+    rmq->nelem  = nelem;
+    atomic_init(&rmq->err_send, 0);
+    atomic_init(&rmq->err_recv, 0);
+    atomic_init(&rmq->write_pos, 0);
+    atomic_init(&rmq->read_pos, 0);
+    atomic_init(&rmq->send_waiting, 0);
+    atomic_init(&rmq->recv_waiting, 0);
+    /* spinning only helps if the other side can run meanwhile */
+    rmq->spin_max  = av_cpu_count() > 1 ? SPIN_MAX : 0;
+    rmq->spin_send = rmq->spin_recv = FFMIN(SPIN_INIT, rmq->spin_max);
     *mq = rmq;
     return 0;
 #else
@@ -80,6 +119,13 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
 #endif /* HAVE_THREADS */
 }
 
+int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
+                                  unsigned nelem,
+                                  unsigned elsize)
+{
+    return av_thread_message_queue_alloc2(mq, nelem, elsize, 0);
+}
+
 void av_thread_message_queue_set_free_func(AVThreadMessageQueue *mq,
                                            void (*free_func)(void *msg))
 {
@@ -94,6 +140,7 @@ void av_thread_message_queue_free(AVThreadMessageQueue **mq)
     if (*mq) {
         av_thread_message_flush(*mq);
         av_fifo_freep2(&(*mq)->fifo);
+        av_freep(&(*mq)->ring);
         pthread_cond_destroy(&(*mq)->cond_send);
         pthread_cond_destroy(&(*mq)->cond_recv);
         pthread_mutex_destroy(&(*mq)->lock);
@@ -102,10 +149,156 @@ void av_thread_message_queue_free(AVThreadMessageQueue **mq)
 #endif
 }
 
+#if HAVE_THREADS
+
+static unsigned spsc_can_read(AVThreadMessageQueue *mq)
+{
+    unsigned w = atomic_load(&mq->write_pos);
+    unsigned r = atomic_load_explicit(&mq->read_pos, memory_order_relaxed);
+    return w >= r ? w - r : w + 2 * mq->nelem - r;
+}
+
+static unsigned spsc_can_write(AVThreadMessageQueue *mq)
+{
+    unsigned w = atomic_load_explicit(&mq->write_pos, memory_order_relaxed);
+    unsigned r = atomic_load(&mq->read_pos);
+    return mq->nelem - (w >= r ? w - r : w + 2 * mq->nelem - r);
+}
+
+/**
+ * @return >0 if the operation can proceed, 0 if it has to wait, or the
+ *         error to return
+ */
+static int spsc_ready(AVThreadMessageQueue *mq, int recv)
+{
+    int err;
+
+    if (recv) {
+        if (spsc_can_read(mq))
+            return 1;
+        /* the sender may have sent a last message before setting the error */
+        err = atomic_load(&mq->err_recv);
+        return err && spsc_can_read(mq) ? 1 : err;
+    }
+    err = atomic_load(&mq->err_send);
+    return err ? err : !!spsc_can_write(mq);
+}
+
+static int spsc_wait(AVThreadMessageQueue *mq, int recv, unsigned flags)
+{
+    atomic_int *waiting  = recv ? &mq->recv_waiting : &mq->send_waiting;
+    pthread_cond_t *cond = recv ? &mq->cond_recv    : &mq->cond_send;
+    int *spin            = recv ? &mq->spin_recv    : &mq->spin_send;
+    int i, ret;
+
+    if ((ret = spsc_ready(mq, recv)))
+        return ret;
+    if (flags & AV_THREAD_MESSAGE_NONBLOCK)
+        return AVERROR(EAGAIN);
+
+    /* Poll for a while first, as the other side is likely to be running.
+     * The budget grows when that pays off and shrinks when it does not. */
+    for (i = 0; i < *spin; i++) {
+        if ((ret = spsc_ready(mq, recv))) {
+            *spin = FFMIN(2 * *spin, mq->spin_max);
+            return ret;
+        }
+    }
+    *spin = FFMAX(*spin / 2, FFMIN(SPIN_MIN, mq->spin_max));
+
+    /* The other side checks the flag after publishing its position, and we
+     * check its position after setting the flag, so one of us sees the
+     * other. The lock makes sure a signal cannot come before the wait. */
+    pthread_mutex_lock(&mq->lock);
+    atomic_store(waiting, 1);
+    while (!(ret = spsc_ready(mq, recv)))
+        pthread_cond_wait(cond, &mq->lock);
+    atomic_store(waiting, 0);
+    pthread_mutex_unlock(&mq->lock);
+    return ret;
+}
+
+static void spsc_wake(AVThreadMessageQueue *mq, int recv)
+{
+    if (atomic_load(recv ? &mq->recv_waiting : &mq->send_waiting)) {
+        pthread_mutex_lock(&mq->lock);
+        pthread_cond_signal(recv ? &mq->cond_recv : &mq->cond_send);
+        pthread_mutex_unlock(&mq->lock);
+    }
+}
+
+/* copy nb elements between msgs and the ring starting at position pos */
+static void spsc_copy(AVThreadMessageQueue *mq, unsigned pos, uint8_t *msgs,
+                      unsigned nb, int to_ring)
+{
+    unsigned idx = pos >= mq->nelem ? pos - mq->nelem : pos;
+
+    while (nb) {
+        unsigned n    = FFMIN(nb, mq->nelem - idx);
+        uint8_t *ring = mq->ring + (size_t)idx * mq->elsize;
+        size_t size   = (size_t)n * mq->elsize;
+
+        if (to_ring)
+            memcpy(ring, msgs, size);
+        else
+            memcpy(msgs, ring, size);
+        msgs += size;
+        nb   -= n;
+        idx   = 0;
+    }
+}
+
+static unsigned spsc_advance(AVThreadMessageQueue *mq, unsigned pos, unsigned n)
+{
+    pos += n;
+    return pos >= 2 * mq->nelem ? pos - 2 * mq->nelem : pos;
+}
+
+static int spsc_send(AVThreadMessageQueue *mq, const uint8_t *msgs,
+                     unsigned nb_msgs, unsigned flags)
+{
+    unsigned done = 0;
+
+    while (done < nb_msgs) {
+        unsigned pos, n;
+        int ret = spsc_wait(mq, 0, flags);
+
+        if (ret < 0)
+            return done ? done : ret;
+        pos = atomic_load_explicit(&mq->write_pos, memory_order_relaxed);
+        n   = FFMIN(nb_msgs - done, spsc_can_write(mq));
+        spsc_copy(mq, pos, (uint8_t *)msgs + (size_t)done * mq->elsize, n, 1);
+        atomic_store(&mq->write_pos, spsc_advance(mq, pos, n));
+        spsc_wake(mq, 1);
+        done += n;
+    }
+    return done;
+}
+
+static int spsc_recv(AVThreadMessageQueue *mq, uint8_t *msgs,
+                     unsigned nb_msgs, unsigned flags)
+{
+    unsigned pos, n;
+    int ret = spsc_wait(mq, 1, flags);
+
+    if (ret < 0)
+        return ret;
+    pos = atomic_load_explicit(&mq->read_pos, memory_order_relaxed);
+    n   = FFMIN(nb_msgs, spsc_can_read(mq));
+    spsc_copy(mq, pos, msgs, n, 0);
+    atomic_store(&mq->read_pos, spsc_advance(mq, pos, n));
+    spsc_wake(mq, 0);
+    return n;
+}
+
+#endif /* HAVE_THREADS */
+
 int av_thread_message_queue_nb_elems(AVThreadMessageQueue *mq)
 {
 #if HAVE_THREADS
     int ret;
+    if (mq->ring)
+        return spsc_can_read(mq);
     pthread_mutex_lock(&mq->lock);
     ret = av_fifo_can_read(mq->fifo);
     pthread_mutex_unlock(&mq->lock);
@@ -160,6 +353,10 @@ int av_thread_message_queue_send(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->ring) {
+        ret = spsc_send(mq, msg, 1, flags);
+        return FFMIN(ret, 0);
+    }
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_send_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -176,6 +373,10 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
 #if HAVE_THREADS
     int ret;
 
+    if (mq->ring) {
+        ret = spsc_recv(mq, msg, 1, flags);
+        return FFMIN(ret, 0);
+    }
     pthread_mutex_lock(&mq->lock);
     ret = av_thread_message_queue_recv_locked(mq, msg, flags);
     pthread_mutex_unlock(&mq->lock);
@@ -185,6 +386,59 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
 #endif /* HAVE_THREADS */
 }
 
+int av_thread_message_queue_send_batch(AVThreadMessageQueue *mq,
+                                       const void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags)
+{
+#if HAVE_THREADS
+    const uint8_t *msg = msgs;
+    unsigned i;
+    int ret = 0;
+
+    if (mq->ring)
+        return spsc_send(mq, msgs, nb_msgs, flags);
+    pthread_mutex_lock(&mq->lock);
+    for (i = 0; i < nb_msgs; i++) {
+        ret = av_thread_message_queue_send_locked(mq, (void *)(msg + (size_t)i * mq->elsize),
+                                                  flags);
+        if (ret < 0)
+            break;
+    }
+    pthread_mutex_unlock(&mq->lock);
+    return i ? i : ret;
+#else
+    return AVERROR(ENOSYS);
+#endif /* HAVE_THREADS */
+}
+
+int av_thread_message_queue_recv_batch(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags)
+{
+#if HAVE_THREADS
+    uint8_t *msg = msgs;
+    unsigned i;
+    int ret = 0;
+
+    if (mq->ring)
+        return spsc_recv(mq, msgs, nb_msgs, flags);
+    pthread_mutex_lock(&mq->lock);
+    /* wait for the first message only, then take whatever is there */
+    for (i = 0; i < nb_msgs; i++) {
+        ret = av_thread_message_queue_recv_locked(mq, msg + (size_t)i * mq->elsize,
+                                                  i ? AV_THREAD_MESSAGE_NONBLOCK : flags);
+        if (ret < 0)
+            break;
+    }
+    pthread_mutex_unlock(&mq->lock);
+    return i ? i : ret;
+#else
+    return AVERROR(ENOSYS);
+#endif /* HAVE_THREADS */
+}
+
 void av_thread_message_queue_set_err_send(AVThreadMessageQueue *mq,
                                           int err)
 {
@@ -216,6 +470,21 @@ static int free_func_wrap(void *arg, void *buf, size_t *nb_elems)
         mq->free_func(msg + i * mq->elsize);
     return 0;
 }
+
+static void spsc_flush(AVThreadMessageQueue *mq)
+{
+    unsigned pos = atomic_load_explicit(&mq->read_pos, memory_order_relaxed);
+    unsigned nb  = spsc_can_read(mq);
+
+    if (mq->free_func) {
+        unsigned i, p = pos;
+
+        for (i = 0; i < nb; i++, p = spsc_advance(mq, p, 1))
+            mq->free_func(mq->ring + (size_t)(p >= mq->nelem ? p - mq->nelem : p) * mq->elsize);
+    }
+    atomic_store(&mq->read_pos, spsc_advance(mq, pos, nb));
+    spsc_wake(mq, 0);
+}
 #endif
 
 void av_thread_message_flush(AVThreadMessageQueue *mq)
@@ -223,6 +492,10 @@ void av_thread_message_flush(AVThreadMessageQueue *mq)
 #if HAVE_THREADS
     size_t used;
 
+    if (mq->ring) {
+        spsc_flush(mq);
+        return;
+    }
     pthread_mutex_lock(&mq->lock);
     used = av_fifo_can_read(mq->fifo);
     if (mq->free_func)
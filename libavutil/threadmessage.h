@@ -32,6 +32,17 @@ typedef enum AVThreadMessageFlags {
 
 } AVThreadMessageFlags;
 
+/**
+ * Use a lock-free ring buffer instead of a locked FIFO.
+ *
+ * Only one thread may send messages and only one thread may receive them
+ * (they may be the same thread). av_thread_message_flush() must then be
+ * called from the receiving thread. The error codes may be set from any
+ * thread. Waiting threads poll the queue for a short while before sleeping,
+ * if there is more than one CPU.
+ */
+#define AV_THREAD_MESSAGE_QUEUE_FLAG_SPSC (1 << 0)
+
 /**
  * Allocate a new message queue.
  *
@@ -45,6 +56,21 @@ int av_thread_message_queue_alloc(AVThreadMessageQueue **mq,
                                   unsigned nelem,
                                   unsigned elsize);
 
+/**
+ * Allocate a new message queue.
+ *
+ * @param mq      pointer to the message queue
+ * @param nelem   maximum number of elements in the queue
+ * @param elsize  size of each element in the queue
+ * @param flags   a combination of AV_THREAD_MESSAGE_QUEUE_FLAG_*
+ * @return  >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *          lavu was built without thread support
+ */
+int av_thread_message_queue_alloc2(AVThreadMessageQueue **mq,
+                                   unsigned nelem,
+                                   unsigned elsize,
+                                   unsigned flags);
+
 /**
  * Free a message queue.
  *
@@ -66,6 +92,37 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
                                  void *msg,
                                  unsigned flags);
 
+/**
+ * Send several messages on the queue.
+ *
+ * Without AV_THREAD_MESSAGE_NONBLOCK, this blocks until all the messages are
+ * sent or an error is set; otherwise it sends as many as currently fit.
+ *
+ * @param msgs     array of nb_msgs messages
+ * @param nb_msgs  number of messages, at most INT_MAX
+ * @return the number of messages sent if any, or a negative error code
+ */
+int av_thread_message_queue_send_batch(AVThreadMessageQueue *mq,
+                                       const void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags);
+
+/**
+ * Receive up to nb_msgs messages from the queue.
+ *
+ * Without AV_THREAD_MESSAGE_NONBLOCK, this blocks until at least one message
+ * is available, then returns all that are available without waiting further.
+ *
+ * @param msgs     array of room for nb_msgs messages
+ * @param nb_msgs  number of messages, at most INT_MAX
+ * @return the number of messages received (at least 1), or a negative error
+ *         code
+ */
+int av_thread_message_queue_recv_batch(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags);
+
 /**
  * Set the sending error code.
  *
@@ -262,7 +262,8 @@ static av_cold int ff_tx_null_init(AVTXContext *s, const FFTXCodelet *cd,
                                    int len, int inv, const void *scale)
 {
     /* Can only handle one sample+type to one sample+type transforms */
-    if (TYPE_IS(MDCT, s->type) || TYPE_IS(RDFT, s->type))
+    if (TYPE_IS(MDCT, s->type) || TYPE_IS(RDFT, s->type) ||
+        TYPE_IS(DCT, s->type))
         return AVERROR(EINVAL);
     return 0;
 }
@@ -324,12 +325,15 @@ static void print_type(AVBPrint *bp, enum AVTXType type)
                type == AV_TX_FLOAT_FFT   ? "fft_float"   :
                type == AV_TX_FLOAT_MDCT  ? "mdct_float"  :
                type == AV_TX_FLOAT_RDFT  ? "rdft_float"  :
+               type == AV_TX_FLOAT_DCT   ? "dct_float"   :
                type == AV_TX_DOUBLE_FFT  ? "fft_double"  :
                type == AV_TX_DOUBLE_MDCT ? "mdct_double" :
                type == AV_TX_DOUBLE_RDFT ? "rdft_double" :
+               type == AV_TX_DOUBLE_DCT  ? "dct_double"  :
                type == AV_TX_INT32_FFT   ? "fft_int32"   :
                type == AV_TX_INT32_MDCT  ? "mdct_int32"  :
                type == AV_TX_INT32_RDFT  ? "rdft_int32"  :
+               type == AV_TX_INT32_DCT   ? "dct_int32"   :
                "unknown");
 }
 
@@ -651,10 +655,12 @@ av_cold int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
     if (!(flags & AV_TX_INPLACE))
         flags |= FF_TX_OUT_OF_PLACE;
 
-    if (!scale && ((type == AV_TX_FLOAT_MDCT) || (type == AV_TX_INT32_MDCT)))
-        scale = &default_scale_f;
-    else if (!scale && (type == AV_TX_DOUBLE_MDCT))
+    /* All types but the FFT take a scale, which defaults to 1.0 */
+    if (!scale && (type == AV_TX_DOUBLE_MDCT || type == AV_TX_DOUBLE_RDFT ||
+                   type == AV_TX_DOUBLE_DCT))
         scale = &default_scale_d;
+    else if (!scale && !TYPE_IS(FFT, type))
+        scale = &default_scale_f;
 
     ret = ff_tx_init_subtx(&tmp, type, flags, NULL, len, inv, scale);
     if (ret < 0)
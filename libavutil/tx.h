@@ -89,6 +89,24 @@ enum AVTXType {
     AV_TX_DOUBLE_RDFT = 7,
     AV_TX_INT32_RDFT  = 8,
 
+    /**
+     * Real to real (DCT) transforms, with a sample data type of float, double
+     * or int32_t. The scale type is the same as for the RDFT.
+     *
+     * The forward transform is an unnormalized DCT-II:
+     *     X[k] = sum(x[n]*cos(pi*(n + 0.5)*k/len))
+     * The inverse transform is a DCT-III, the inverse of the DCT-II up to
+     * a factor of len/2:
+     *     x[n] = X[0]/2 + sum(X[k]*cos(pi*(n + 0.5)*k/len), k > 0)
+     * so a scale of 2.0/len makes the pair an identity.
+     *
+     * The length must be even. The stride parameter must be set to the size
+     * of a single sample in bytes.
+     */
+    AV_TX_FLOAT_DCT  = 9,
+    AV_TX_DOUBLE_DCT = 10,
+    AV_TX_INT32_DCT  = 11,
+
     /* Not part of the API, do not use */
     AV_TX_NB,
 };
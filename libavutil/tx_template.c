@@ -193,10 +193,10 @@ static av_always_inline void fft3(TXComplex *out, TXComplex *in,
     mtmp[1] = (int64_t)tab[1] * tmp[0].im;
     mtmp[2] = (int64_t)tab[2] * tmp[1].re;
     mtmp[3] = (int64_t)tab[2] * tmp[1].im;
-    out[1*stride].re = in[0].re - (mtmp[2] + mtmp[0] + 0x40000000 >> 31);
-    out[1*stride].im = in[0].im - (mtmp[3] - mtmp[1] + 0x40000000 >> 31);
-    out[2*stride].re = in[0].re - (mtmp[2] - mtmp[0] + 0x40000000 >> 31);
-    out[2*stride].im = in[0].im - (mtmp[3] + mtmp[1] + 0x40000000 >> 31);
+    out[1*stride].re = in[0].re - (mtmp[2] - mtmp[0] + 0x40000000 >> 31);
+    out[1*stride].im = in[0].im - (mtmp[3] + mtmp[1] + 0x40000000 >> 31);
+    out[2*stride].re = in[0].re - (mtmp[2] + mtmp[0] + 0x40000000 >> 31);
+    out[2*stride].im = in[0].im - (mtmp[3] - mtmp[1] + 0x40000000 >> 31);
 #else
     tmp[0].re = tab[0] * tmp[0].re;
     tmp[0].im = tab[1] * tmp[0].im;
@@ -778,6 +778,119 @@ static const FFTXCodelet TX_NAME(ff_tx_fft_naive_def) = {
     .prio       = FF_TX_PRIO_MIN,
 };
 
+#ifndef TX_INT32
+/* Bluestein's algorithm: for any length, n*k = (n^2 + k^2 - (k - n)^2)/2
+ * turns the DFT into a circular convolution with a chirp, which is done
+ * with power of two FFTs. The fixed-point chirp has too little headroom for
+ * the convolution, so this is only built for floating point. */
+static av_cold int TX_NAME(ff_tx_fft_bluestein_init)(AVTXContext *s,
+                                                     const FFTXCodelet *cd,
+                                                     uint64_t flags,
+                                                     FFTXCodeletOptions *opts,
+                                                     int len, int inv,
+                                                     const void *scale)
+{
+    int ret, m = 1;
+    int filter_off = FFALIGN(len, 8);
+    TXComplex *chirp, *filter;
+
+    /* Power of two lengths never need this */
+    if (!(len & (len - 1)) || len > (1 << 29))
+        return AVERROR(ENOTSUP);
+
+    while (m < 2*len - 1)
+        m <<= 1;
+
+    /* The subtransform works between the two aligned halves of s->tmp */
+    flags &= ~(AV_TX_INPLACE | AV_TX_UNALIGNED);
+    flags |=  FF_TX_OUT_OF_PLACE | FF_TX_ALIGNED;
+
+    if ((ret = ff_tx_init_subtx(s, TX_TYPE(FFT), flags, NULL, m, 0, scale)))
+        return ret;
+
+    /* The filter is the output of the subtransform, whose SIMD versions use
+     * aligned stores, so it starts at a multiple of 8 values. */
+    if (!(s->exp = av_malloc_array(filter_off + m, sizeof(*s->exp))))
+        return AVERROR(ENOMEM);
+    if (!(s->tmp = av_malloc_array(2*m, sizeof(*s->tmp))))
+        return AVERROR(ENOMEM);
+
+    chirp  = s->exp;
+    filter = s->exp + filter_off;
+
+    /* n^2 is reduced modulo 2*len to keep the phase accurate */
+    for (int i = 0; i < len; i++) {
+        double phase = M_PI*((int64_t)i*i % (2*len))/len;
+        chirp[i].re = RESCALE(cos(phase));
+        chirp[i].im = RESCALE(inv ? sin(phase) : -sin(phase));
+    }
+
+    /* The filter is the conjugate chirp, wrapped around and transformed
+     * once here, with the 1/m of the inverse transform folded in. */
+    memset(s->tmp, 0, m*sizeof(*s->tmp));
+    for (int i = 0; i < len; i++) {
+        s->tmp[i].re =  chirp[i].re;
+        s->tmp[i].im = -chirp[i].im;
+        if (i)
+            s->tmp[m - i] = s->tmp[i];
+    }
+    s->fn[0](&s->sub[0], filter, s->tmp, sizeof(TXComplex));
+    for (int i = 0; i < m; i++) {
+        filter[i].re /= m;
+        filter[i].im /= m;
+    }
+
+    return 0;
+}
+
+static void TX_NAME(ff_tx_fft_bluestein)(AVTXContext *s, void *_dst,
+                                         void *_src, ptrdiff_t stride)
+{
+    TXComplex *src = _src;
+    TXComplex *dst = _dst;
+    const TXComplex *chirp  = s->exp;
+    const TXComplex *filter = s->exp + FFALIGN(s->len, 8);
+    const int len = s->len;
+    const int m = s->sub->len;
+    TXComplex *tmp1 = s->tmp;
+    TXComplex *tmp2 = s->tmp + m;
+
+    for (int i = 0; i < len; i++)
+        CMUL3(tmp1[i], src[i], chirp[i]);
+    memset(tmp1 + len, 0, (m - len)*sizeof(*tmp1));
+
+    s->fn[0](&s->sub[0], tmp2, tmp1, sizeof(TXComplex));
+
+    /* The inverse transform is done as a forward one on the conjugate */
+    for (int i = 0; i < m; i++) {
+        TXComplex t;
+        CMUL3(t, tmp2[i], filter[i]);
+        tmp1[i].re =  t.re;
+        tmp1[i].im = -t.im;
+    }
+
+    s->fn[0](&s->sub[0], tmp2, tmp1, sizeof(TXComplex));
+
+    for (int i = 0; i < len; i++) {
+        tmp2[i].im = -tmp2[i].im;
+        CMUL3(dst[i], tmp2[i], chirp[i]);
+    }
+}
+
+static const FFTXCodelet TX_NAME(ff_tx_fft_bluestein_def) = {
+    .name       = TX_NAME_STR("fft_bluestein"),
+    .function   = TX_NAME(ff_tx_fft_bluestein),
+    .type       = TX_TYPE(FFT),
+    .flags      = AV_TX_UNALIGNED | AV_TX_INPLACE | FF_TX_OUT_OF_PLACE,
+    .factors[0] = TX_FACTOR_ANY,
+    .min_len    = 2,
+    .max_len    = TX_LEN_UNLIMITED,
+    .init       = TX_NAME(ff_tx_fft_bluestein_init),
+    .cpu_flags  = FF_TX_CPU_FLAGS_ALL,
+    .prio       = FF_TX_PRIO_MIN/2, /* Only better than the naive version */
+};
+#endif /* TX_INT32 */
+
 static av_cold int TX_NAME(ff_tx_fft_pfa_init)(AVTXContext *s,
                                                const FFTXCodelet *cd,
                                                uint64_t flags,
@@ -1294,7 +1407,7 @@ static av_cold int TX_NAME(ff_tx_rdft_init)(AVTXContext *s,
     if ((ret = ff_tx_init_subtx(s, TX_TYPE(FFT), flags, NULL, len >> 1, inv, scale)))
         return ret;
 
-    if (!(s->exp = av_mallocz((8 + (len >> 2) - 1)*sizeof(*s->exp))))
+    if (!(s->exp = av_mallocz((8 + 2*((len >> 2) + 1))*sizeof(TXSample))))
         return AVERROR(ENOMEM);
 
     tab = (TXSample *)s->exp;
@@ -1304,7 +1417,7 @@ static av_cold int TX_NAME(ff_tx_rdft_init)(AVTXContext *s,
     m = (inv ? 2*s->scale_d : s->scale_d);
 
     *tab++ = RESCALE((inv ? 0.5 : 1.0) * m);
-    *tab++ = RESCALE(inv ? 0.5*m : 1.0);
+    *tab++ = RESCALE((inv ? 0.5 : 1.0) * m);
     *tab++ = RESCALE( m);
     *tab++ = RESCALE(-m);
 
@@ -1313,10 +1426,10 @@ static av_cold int TX_NAME(ff_tx_rdft_init)(AVTXContext *s,
     *tab++ = RESCALE( (0.5 - inv) * m);
     *tab++ = RESCALE(-(0.5 - inv) * m);
 
-    for (int i = 0; i < len >> 2; i++)
+    for (int i = 0; i <= len >> 2; i++)
         *tab++ = RESCALE(cos(i*f));
-    for (int i = len >> 2; i >= 0; i--)
-        *tab++ = RESCALE(cos(i*f) * (inv ? +1.0 : -1.0));
+    for (int i = 0; i <= len >> 2; i++)
+        *tab++ = RESCALE(sin(i*f) * (inv ? +1.0 : -1.0));
 
     return 0;
 }
@@ -1329,7 +1442,7 @@ static void TX_NAME(ff_tx_rdft_ ##name)(AVTXContext *s, void *_dst,            \
     const int len4 = s->len >> 2;                                              \
     const TXSample *fact = (void *)s->exp;                                     \
     const TXSample *tcos = fact + 8;                                           \
-    const TXSample *tsin = tcos + len4;                                        \
+    const TXSample *tsin = tcos + len4 + 1;                                    \
     TXComplex *data = inv ? _src : _dst;                                       \
     TXComplex t[3];                                                            \
                                                                                \
@@ -1346,10 +1459,13 @@ static void TX_NAME(ff_tx_rdft_ ##name)(AVTXContext *s, void *_dst,            \
     data[0].im = t[0].re - data[0].im;                                         \
     data[   0].re = MULT(fact[0], data[   0].re);                              \
     data[   0].im = MULT(fact[1], data[   0].im);                              \
-    data[len4].re = MULT(fact[2], data[len4].re);                              \
-    data[len4].im = MULT(fact[3], data[len4].im);                              \
+    if (!(len2 & 1)) {                                                         \
+        data[len4].re = MULT(fact[2], data[len4].re);                          \
+        data[len4].im = MULT(fact[3], data[len4].im);                          \
+    }                                                                          \
                                                                                \
-    for (int i = 1; i < len4; i++) {                                           \
+    /* With an odd half length, there is no middle and len4 is a pair too */   \
+    for (int i = 1; i < len4 + (len2 & 1); i++) {                              \
         /* Separate even and odd FFTs */                                       \
         t[0].re = MULT(fact[4], (data[i].re + data[len2 - i].re));             \
         t[0].im = MULT(fact[5], (data[i].im - data[len2 - i].im));             \
@@ -1405,6 +1521,132 @@ static const FFTXCodelet TX_NAME(ff_tx_rdft_c2r_def) = {
     .prio       = FF_TX_PRIO_BASE,
 };
 
+#define DCT_SIG_OFFSET(len) FFALIGN(((len) >> 1) + 1, 8)
+
+static av_cold int TX_NAME(ff_tx_dct_init)(AVTXContext *s,
+                                           const FFTXCodelet *cd,
+                                           uint64_t flags,
+                                           FFTXCodeletOptions *opts,
+                                           int len, int inv,
+                                           const void *scale)
+{
+    int ret;
+    SCALE_TYPE rsc = *((SCALE_TYPE *)scale);
+
+    /* The reordering in ff_tx_dctIII() yields twice the DCT-III */
+    if (inv)
+        rsc *= 0.5;
+
+    /* The subtransform only sees our own, aligned, buffers */
+    flags &= ~(AV_TX_INPLACE | AV_TX_UNALIGNED);
+    flags |=  FF_TX_OUT_OF_PLACE | FF_TX_ALIGNED;
+
+    if ((ret = ff_tx_init_subtx(s, TX_TYPE(RDFT), flags, NULL, len, inv, &rsc)))
+        return ret;
+
+    /* len/2 + 1 spectrum values, followed by the len reordered samples */
+    if (!(s->tmp = av_malloc_array(DCT_SIG_OFFSET(len) + (len >> 1), sizeof(*s->tmp))))
+        return AVERROR(ENOMEM);
+
+    if (!(s->exp = av_malloc_array((len >> 1) + 1, sizeof(*s->exp))))
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i <= len >> 1; i++) {
+        const double alpha = M_PI_2*i/len;
+        s->exp[i].re = RESCALE( cos(alpha));
+        s->exp[i].im = RESCALE(-sin(alpha));
+    }
+
+    return 0;
+}
+
+/* The DCT-II of x is Re(exp(-i*pi*k/(2*len)) * V[k]), where V is the DFT of
+ * the even samples of x followed by the odd ones reversed (Makhoul). As V is
+ * the DFT of a real signal, the upper half of the output comes from the
+ * imaginary parts. */
+static void TX_NAME(ff_tx_dctII)(AVTXContext *s, void *_dst,
+                                 void *_src, ptrdiff_t stride)
+{
+    TXSample *dst = _dst;
+    TXSample *src = _src;
+    const int len = s->len;
+    const int len2 = len >> 1;
+    const TXComplex *exp = s->exp;
+    TXComplex *spec = s->tmp;
+    TXSample *sig = (TXSample *)(spec + DCT_SIG_OFFSET(len));
+
+    for (int i = 0; i < len2; i++) {
+        sig[i]           = src[2*i + 0];
+        sig[len - i - 1] = src[2*i + 1];
+    }
+
+    s->fn[0](&s->sub[0], spec, sig, sizeof(TXSample));
+
+    dst[0] = spec[0].re;
+    for (int i = 1; i < len2; i++) {
+        TXSample re, im;
+        CMUL(re, im, spec[i].re, spec[i].im, exp[i].re, exp[i].im);
+        dst[i]       =  re;
+        dst[len - i] = -im;
+    }
+    dst[len2] = MULT(spec[len2].re, exp[len2].re);
+}
+
+/* The steps of ff_tx_dctII() in reverse */
+static void TX_NAME(ff_tx_dctIII)(AVTXContext *s, void *_dst,
+                                  void *_src, ptrdiff_t stride)
+{
+    TXSample *dst = _dst;
+    TXSample *src = _src;
+    const int len = s->len;
+    const int len2 = len >> 1;
+    const TXComplex *exp = s->exp;
+    TXComplex *spec = s->tmp;
+    TXSample *sig = (TXSample *)(spec + DCT_SIG_OFFSET(len));
+
+    spec[0].re = src[0];
+    spec[0].im = 0;
+    for (int i = 1; i < len2; i++)
+        CMUL(spec[i].re, spec[i].im, src[i], -src[len - i], exp[i].re, -exp[i].im);
+    spec[len2].re = 2*MULT(src[len2], exp[len2].re);
+    spec[len2].im = 0;
+
+    s->fn[0](&s->sub[0], sig, spec, sizeof(TXComplex));
+
+    for (int i = 0; i < len2; i++) {
+        dst[2*i + 0] = sig[i];
+        dst[2*i + 1] = sig[len - i - 1];
+    }
+}
+
+static const FFTXCodelet TX_NAME(ff_tx_dctII_def) = {
+    .name       = TX_NAME_STR("dctII"),
+    .function   = TX_NAME(ff_tx_dctII),
+    .type       = TX_TYPE(DCT),
+    .flags      = AV_TX_UNALIGNED | AV_TX_INPLACE |
+                  FF_TX_OUT_OF_PLACE | FF_TX_FORWARD_ONLY,
+    .factors    = { 2, TX_FACTOR_ANY },
+    .min_len    = 2,
+    .max_len    = TX_LEN_UNLIMITED,
+    .init       = TX_NAME(ff_tx_dct_init),
+    .cpu_flags  = FF_TX_CPU_FLAGS_ALL,
+    .prio       = FF_TX_PRIO_BASE,
+};
+
+static const FFTXCodelet TX_NAME(ff_tx_dctIII_def) = {
+    .name       = TX_NAME_STR("dctIII"),
+    .function   = TX_NAME(ff_tx_dctIII),
+    .type       = TX_TYPE(DCT),
+    .flags      = AV_TX_UNALIGNED | AV_TX_INPLACE |
+                  FF_TX_OUT_OF_PLACE | FF_TX_INVERSE_ONLY,
+    .factors    = { 2, TX_FACTOR_ANY },
+    .min_len    = 2,
+    .max_len    = TX_LEN_UNLIMITED,
+    .init       = TX_NAME(ff_tx_dct_init),
+    .cpu_flags  = FF_TX_CPU_FLAGS_ALL,
+    .prio       = FF_TX_PRIO_BASE,
+};
+
 int TX_TAB(ff_tx_mdct_gen_exp)(AVTXContext *s)
 {
     int len4 = s->len >> 1;
@@ -1452,6 +1694,9 @@ const FFTXCodelet * const TX_NAME(ff_tx_codelet_list)[] = {
     &TX_NAME(ff_tx_fft_pfa_7xM_def),
     &TX_NAME(ff_tx_fft_pfa_9xM_def),
     &TX_NAME(ff_tx_fft_pfa_15xM_def),
+#ifndef TX_INT32
+    &TX_NAME(ff_tx_fft_bluestein_def),
+#endif
     &TX_NAME(ff_tx_fft_naive_def),
     &TX_NAME(ff_tx_mdct_sr_fwd_def),
     &TX_NAME(ff_tx_mdct_sr_inv_def),
@@ -1470,6 +1715,8 @@ const FFTXCodelet * const TX_NAME(ff_tx_codelet_list)[] = {
     &TX_NAME(ff_tx_mdct_inv_full_def),
     &TX_NAME(ff_tx_rdft_r2c_def),
     &TX_NAME(ff_tx_rdft_c2r_def),
+    &TX_NAME(ff_tx_dctII_def),
+    &TX_NAME(ff_tx_dctIII_def),
 
     NULL,
 };
@@ -0,0 +1,164 @@
+/*
+ * AES-NI implementation of av_aes_crypt()
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/aes_internal.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+
+#if HAVE_AESNI_INLINE && HAVE_6REGS
+
+/*
+ * The round keys are laid out as for the C code: the first one applied is
+ * round_key[rounds] and the last one round_key[0]. For decryption the inner
+ * keys already went through InvMixColumns, which is what aesdec expects.
+ */
+#define ROUNDS(op, x)                                   \
+        "movups     (%[key]), %%xmm4              \n\t" \
+        x(pxor)                                         \
+        "lea        -16(%[key]), %[k]             \n\t" \
+        "1:                                       \n\t" \
+        "movups     (%[k]), %%xmm4                \n\t" \
+        x(op)                                           \
+        "sub        $16, %[k]                     \n\t" \
+        "cmp        %[end], %[k]                  \n\t" \
+        "jne        1b                            \n\t" \
+        "movups     (%[end]), %%xmm4              \n\t" \
+        x(op ## last)
+
+#define X1(op)                                          \
+        #op "       %%xmm4, %%xmm0                \n\t"
+
+#define X4(op)                                          \
+        #op "       %%xmm4, %%xmm0                \n\t" \
+        #op "       %%xmm4, %%xmm1                \n\t" \
+        #op "       %%xmm4, %%xmm2                \n\t" \
+        #op "       %%xmm4, %%xmm3                \n\t"
+
+#define LOAD4                                           \
+        "movdqu       (%[src]), %%xmm0            \n\t" \
+        "movdqu     16(%[src]), %%xmm1            \n\t" \
+        "movdqu     32(%[src]), %%xmm2            \n\t" \
+        "movdqu     48(%[src]), %%xmm3            \n\t"
+
+#define STORE4                                          \
+        "movdqu     %%xmm0,   (%[dst])            \n\t" \
+        "movdqu     %%xmm1, 16(%[dst])            \n\t" \
+        "movdqu     %%xmm2, 32(%[dst])            \n\t" \
+        "movdqu     %%xmm3, 48(%[dst])            \n\t"
+
+#define AES_ASM(code, ...)                                                  \
+    __asm__ volatile (code                                                  \
+        : [k] "=&r"(k)                                                      \
+        : [dst] "r"(dst), [src] "r"(src), [iv] "r"(iv),                     \
+          [key] "r"(a->round_key[rounds].u8), [end] "r"(a->round_key[0].u8) \
+        : XMM_CLOBBERS(__VA_ARGS__,) "memory")
+
+static void aes_encrypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+                              int count, uint8_t *iv, int rounds)
+{
+    const uint8_t *k;
+
+    if (iv) {
+        /* each block depends on the previous one */
+        for (; count > 0; count--, src += 16, dst += 16)
+            AES_ASM("movdqu     (%[src]), %%xmm0              \n\t"
+                    "movdqu     (%[iv]), %%xmm5               \n\t"
+                    "pxor       %%xmm5, %%xmm0                \n\t"
+                    ROUNDS(aesenc, X1)
+                    "movdqu     %%xmm0, (%[dst])              \n\t"
+                    "movdqu     %%xmm0, (%[iv])               \n\t",
+                    "%xmm0", "%xmm4", "%xmm5");
+        return;
+    }
+
+    for (; count >= 4; count -= 4, src += 64, dst += 64)
+        AES_ASM(LOAD4
+                ROUNDS(aesenc, X4)
+                STORE4,
+                "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4");
+    for (; count > 0; count--, src += 16, dst += 16)
+        AES_ASM("movdqu     (%[src]), %%xmm0              \n\t"
+                ROUNDS(aesenc, X1)
+                "movdqu     %%xmm0, (%[dst])              \n\t",
+                "%xmm0", "%xmm4");
+}
+
+static void aes_decrypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+                              int count, uint8_t *iv, int rounds)
+{
+    const uint8_t *k;
+
+    if (iv) {
+        /* Everything is read before anything is written, so that dst may
+         * be equal to src. */
+        for (; count >= 4; count -= 4, src += 64, dst += 64)
+            AES_ASM(LOAD4
+                    ROUNDS(aesdec, X4)
+                    "movdqu       (%[iv]), %%xmm5             \n\t"
+                    "pxor       %%xmm5, %%xmm0                \n\t"
+                    "movdqu       (%[src]), %%xmm5            \n\t"
+                    "pxor       %%xmm5, %%xmm1                \n\t"
+                    "movdqu     16(%[src]), %%xmm5            \n\t"
+                    "pxor       %%xmm5, %%xmm2                \n\t"
+                    "movdqu     32(%[src]), %%xmm5            \n\t"
+                    "pxor       %%xmm5, %%xmm3                \n\t"
+                    "movdqu     48(%[src]), %%xmm5            \n\t"
+                    "movdqu     %%xmm5, (%[iv])               \n\t"
+                    STORE4,
+                    "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5");
+        for (; count > 0; count--, src += 16, dst += 16)
+            AES_ASM("movdqu     (%[src]), %%xmm0              \n\t"
+                    "movdqa     %%xmm0, %%xmm1                \n\t"
+                    ROUNDS(aesdec, X1)
+                    "movdqu     (%[iv]), %%xmm5               \n\t"
+                    "pxor       %%xmm5, %%xmm0                \n\t"
+                    "movdqu     %%xmm1, (%[iv])               \n\t"
+                    "movdqu     %%xmm0, (%[dst])              \n\t",
+                    "%xmm0", "%xmm1", "%xmm4", "%xmm5");
+        return;
+    }
+
+    for (; count >= 4; count -= 4, src += 64, dst += 64)
+        AES_ASM(LOAD4
+                ROUNDS(aesdec, X4)
+                STORE4,
+                "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4");
+    for (; count > 0; count--, src += 16, dst += 16)
+        AES_ASM("movdqu     (%[src]), %%xmm0              \n\t"
+                ROUNDS(aesdec, X1)
+                "movdqu     %%xmm0, (%[dst])              \n\t",
+                "%xmm0", "%xmm4");
+}
+
+#endif /* HAVE_AESNI_INLINE && HAVE_6REGS */
+
+av_cold void ff_init_aes_x86(AVAES *a, int decrypt)
+{
+#if HAVE_AESNI_INLINE && HAVE_6REGS
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_AESNI(cpu_flags))
+        a->crypt = decrypt ? aes_decrypt_aesni : aes_encrypt_aesni;
+#endif
+}
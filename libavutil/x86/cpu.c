@@ -129,6 +129,8 @@ int ff_get_cpu_flags_x86(void)
             rval |= AV_CPU_FLAG_SSE42;
         if (ecx & 0x02000000 )
             rval |= AV_CPU_FLAG_AESNI;
+        if (ecx & 0x00000002 )
+            rval |= AV_CPU_FLAG_CLMUL;
 #if HAVE_AVX
         /* Check OXSAVE and AVX bits */
         if ((ecx & 0x18000000) == 0x18000000) {
@@ -156,6 +158,10 @@ int ff_get_cpu_flags_x86(void)
         }
 #endif /* HAVE_AVX512 */
 #endif /* HAVE_AVX2 */
+#if HAVE_SSE
+        if ((rval & AV_CPU_FLAG_SSE4) && (ebx & 0x20000000))
+            rval |= AV_CPU_FLAG_SHA;
+#endif
         /* BMI1/2 don't need OS support */
         if (ebx & 0x00000008) {
             rval |= AV_CPU_FLAG_BMI1;
@@ -264,6 +270,8 @@ size_t ff_get_cpu_max_align_x86(void)
                  AV_CPU_FLAG_AVXSLOW))
         return 32;
     if (flags & (AV_CPU_FLAG_AESNI     |
+                 AV_CPU_FLAG_CLMUL     |
+                 AV_CPU_FLAG_SHA       |
                  AV_CPU_FLAG_SSE42     |
                  AV_CPU_FLAG_SSE4      |
                  AV_CPU_FLAG_SSSE3     |
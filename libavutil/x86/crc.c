@@ -0,0 +1,160 @@
+/*
+ * CRC computation with carry-less multiplication
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Every CRC handled by av_crc() is a 32-bit CRC once its polynomial P is
+ * shifted up to degree 32, so one folding loop serves all of them. A 16-byte
+ * lane A = H * x^64 + L of the message is moved 128 (or 512) bits further
+ * down by replacing it with H * (x^(128+64) mod P) + L * (x^128 mod P), which
+ * leaves the CRC unchanged. What remains after the last block is a single
+ * lane, which av_crc() finishes with its tables.
+ *
+ * Bit-reflected CRCs keep the lanes in memory order, where the product of two
+ * reflected 64-bit halves comes out multiplied by x^-33; the constants are
+ * adjusted for that. The others byte-reverse every lane so that bit n is the
+ * coefficient of x^n.
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/reverse.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "crc.h"
+
+#if HAVE_CLMUL_INLINE
+
+#define FOLD(x, offset)                               \
+        "movdqa     %%"#x", %%xmm4              \n\t" \
+        "pclmulqdq  $0x00, %%xmm6, %%"#x"       \n\t" \
+        "pclmulqdq  $0x11, %%xmm6, %%xmm4       \n\t" \
+        "movdqu     "#offset"(%0), %%xmm5       \n\t" \
+        "pshufb     %%xmm7, %%xmm5              \n\t" \
+        "pxor       %%xmm4, %%"#x"              \n\t" \
+        "pxor       %%xmm5, %%"#x"              \n\t"
+
+#define FOLD_INTO(x, y)                               \
+        "movdqa     %%"#x", %%xmm4              \n\t" \
+        "pclmulqdq  $0x00, %%xmm6, %%"#x"       \n\t" \
+        "pclmulqdq  $0x11, %%xmm6, %%xmm4       \n\t" \
+        "pxor       %%xmm4, %%"#y"              \n\t" \
+        "pxor       %%"#x", %%"#y"              \n\t"
+
+static void crc_fold_clmul(const CRCX86Context *c, uint32_t crc,
+                           const uint8_t *buf, size_t len, uint8_t *out)
+{
+    __asm__ volatile (
+        "movdqa     %3, %%xmm7                  \n\t"
+        "movd       %2, %%xmm4                  \n\t"
+        "movdqu       (%0), %%xmm0              \n\t"
+        "movdqu     16(%0), %%xmm1              \n\t"
+        "movdqu     32(%0), %%xmm2              \n\t"
+        "movdqu     48(%0), %%xmm3              \n\t"
+        "pxor       %%xmm4, %%xmm0              \n\t"
+        "pshufb     %%xmm7, %%xmm0              \n\t"
+        "pshufb     %%xmm7, %%xmm1              \n\t"
+        "pshufb     %%xmm7, %%xmm2              \n\t"
+        "pshufb     %%xmm7, %%xmm3              \n\t"
+        "movdqa     %4, %%xmm6                  \n\t"
+        "add        $64, %0                     \n\t"
+        "sub        $64, %1                     \n\t"
+        "jmp        2f                          \n\t"
+        "1:                                     \n\t"
+        FOLD(xmm0,  0)
+        FOLD(xmm1, 16)
+        FOLD(xmm2, 32)
+        FOLD(xmm3, 48)
+        "add        $64, %0                     \n\t"
+        "sub        $64, %1                     \n\t"
+        "2:                                     \n\t"
+        "cmp        $64, %1                     \n\t"
+        "jae        1b                          \n\t"
+        "movdqa     %5, %%xmm6                  \n\t"
+        FOLD_INTO(xmm0, xmm1)
+        FOLD_INTO(xmm1, xmm2)
+        FOLD_INTO(xmm2, xmm3)
+        "jmp        4f                          \n\t"
+        "3:                                     \n\t"
+        FOLD(xmm3, 0)
+        "add        $16, %0                     \n\t"
+        "sub        $16, %1                     \n\t"
+        "4:                                     \n\t"
+        "test       %1, %1                      \n\t"
+        "jnz        3b                          \n\t"
+        "pshufb     %%xmm7, %%xmm3              \n\t"
+        "movdqu     %%xmm3, (%6)                \n\t"
+        : "+r"(buf), "+r"(len)
+        : "r"(crc), "m"(c->shuffle), "m"(c->fold4), "m"(c->fold1), "r"(out)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+
+/* x^n mod P, P having an implicit x^32 term */
+static av_cold uint32_t xnmodp(unsigned n, uint32_t poly)
+{
+    uint32_t r = 1;
+
+    while (n--)
+        r = (r << 1) ^ (poly & -(r >> 31));
+    return r;
+}
+
+static av_cold uint32_t bitswap_32(uint32_t x)
+{
+    return (uint32_t)ff_reverse[ x        & 0xFF] << 24 |
+           (uint32_t)ff_reverse[(x >> 8)  & 0xFF] << 16 |
+           (uint32_t)ff_reverse[(x >> 16) & 0xFF] << 8  |
+           (uint32_t)ff_reverse[ x >> 24];
+}
+
+#endif /* HAVE_CLMUL_INLINE */
+
+av_cold void ff_crc_init_x86(CRCX86Context *c, int le, int bits, uint32_t poly)
+{
+#if HAVE_CLMUL_INLINE
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    if (!INLINE_CLMUL(cpu_flags))
+        return;
+
+    if (le) {
+        poly = bitswap_32(poly);
+        c->fold4[0] = bitswap_32(xnmodp(512 + 31, poly));
+        c->fold4[1] = bitswap_32(xnmodp(512 - 33, poly));
+        c->fold1[0] = bitswap_32(xnmodp(128 + 31, poly));
+        c->fold1[1] = bitswap_32(xnmodp(128 - 33, poly));
+        for (i = 0; i < 16; i++)
+            c->shuffle[i] = i;
+    } else {
+        poly <<= 32 - bits;
+        c->fold4[0] = xnmodp(512,      poly);
+        c->fold4[1] = xnmodp(512 + 64, poly);
+        c->fold1[0] = xnmodp(128,      poly);
+        c->fold1[1] = xnmodp(128 + 64, poly);
+        for (i = 0; i < 16; i++)
+            c->shuffle[i] = 15 - i;
+    }
+    c->fold = crc_fold_clmul;
+#endif
+}
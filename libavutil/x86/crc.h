@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_X86_CRC_H
+#define AVUTIL_X86_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/mem_internal.h"
+
+typedef struct CRCX86Context {
+    DECLARE_ALIGNED(16, uint64_t, fold4)[2];    ///< constants to fold a lane over 512 bits
+    DECLARE_ALIGNED(16, uint64_t, fold1)[2];    ///< constants to fold a lane over 128 bits
+    DECLARE_ALIGNED(16, uint8_t,  shuffle)[16]; ///< byte order of a lane
+    /**
+     * Fold len bytes of buf, starting with the CRC value crc, into 16 bytes
+     * whose CRC starting from 0 is the CRC of buf.
+     * len must be a multiple of 16 and at least 64.
+     */
+    void (*fold)(const struct CRCX86Context *c, uint32_t crc,
+                 const uint8_t *buf, size_t len, uint8_t *out);
+} CRCX86Context;
+
+/**
+ * Set up c for the CRC with the given parameters (as in av_crc_init()).
+ * c->fold is left NULL if the CPU cannot run it.
+ */
+void ff_crc_init_x86(CRCX86Context *c, int le, int bits, uint32_t poly);
+
+#endif /* AVUTIL_X86_CRC_H */
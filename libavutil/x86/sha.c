@@ -0,0 +1,237 @@
+/*
+ * SHA-1 and SHA-256 block functions using the SHA extensions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+#include "sha.h"
+
+#if HAVE_SHA_INLINE
+
+DECLARE_ALIGNED(16, static const uint8_t, sha1_flip)[16] = {
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+DECLARE_ALIGNED(16, static const uint8_t, sha256_flip)[16] = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+DECLARE_ALIGNED(16, static const uint32_t, sha256_k)[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/*
+ * SHA-1: xmm0 holds ABCD, xmm1/xmm2 take turns holding E, xmm3-xmm6 hold
+ * the message schedule W[4n..4n+3] and xmm7 the byte order mask.
+ */
+#define SHA1_LOAD(i, m)                                     \
+        "movdqu     "#i"*16(%[data]), %%"#m"          \n\t" \
+        "pshufb     %%xmm7, %%"#m"                    \n\t"
+
+#define SHA1_RNDS(f, m, e0, e1)                             \
+        "sha1nexte  %%"#m", %%"#e0"                   \n\t" \
+        "movdqa     %%xmm0, %%"#e1"                   \n\t" \
+        "sha1rnds4  $"#f", %%"#e0", %%xmm0            \n\t"
+
+#define SHA1_MSG1(m, prev)                                  \
+        "sha1msg1   %%"#m", %%"#prev"                 \n\t"
+
+#define SHA1_MSG2(m, next)                                  \
+        "sha1msg2   %%"#m", %%"#next"                 \n\t"
+
+#define SHA1_XOR(m, prev2)                                  \
+        "pxor       %%"#m", %%"#prev2"                \n\t"
+
+#define SHA1_QUAD(f, m, next, prev, prev2, e0, e1)          \
+        SHA1_RNDS(f, m, e0, e1)                             \
+        SHA1_MSG2(m, next)                                  \
+        SHA1_MSG1(m, prev)                                  \
+        SHA1_XOR(m, prev2)
+
+static void sha1_transform_shani(uint32_t *state, const uint8_t buffer[64])
+{
+    __asm__ volatile (
+        "movdqu     (%[state]), %%xmm0                \n\t"
+        "pshufd     $0x1B, %%xmm0, %%xmm0             \n\t"
+        "pxor       %%xmm1, %%xmm1                    \n\t"
+        "pinsrd     $3, 16(%[state]), %%xmm1          \n\t"
+        "movdqa     %[flip], %%xmm7                   \n\t"
+
+        SHA1_LOAD(0, xmm3)
+        "paddd      %%xmm3, %%xmm1                    \n\t"
+        "movdqa     %%xmm0, %%xmm2                    \n\t"
+        "sha1rnds4  $0, %%xmm1, %%xmm0                \n\t"
+        SHA1_LOAD(1, xmm4)
+        SHA1_RNDS(0, xmm4, xmm2, xmm1)
+        SHA1_MSG1(xmm4, xmm3)
+        SHA1_LOAD(2, xmm5)
+        SHA1_RNDS(0, xmm5, xmm1, xmm2)
+        SHA1_MSG1(xmm5, xmm4)
+        SHA1_XOR(xmm5, xmm3)
+        SHA1_LOAD(3, xmm6)
+        SHA1_QUAD(0, xmm6, xmm3, xmm5, xmm4, xmm2, xmm1)
+        SHA1_QUAD(0, xmm3, xmm4, xmm6, xmm5, xmm1, xmm2)
+        SHA1_QUAD(1, xmm4, xmm5, xmm3, xmm6, xmm2, xmm1)
+        SHA1_QUAD(1, xmm5, xmm6, xmm4, xmm3, xmm1, xmm2)
+        SHA1_QUAD(1, xmm6, xmm3, xmm5, xmm4, xmm2, xmm1)
+        SHA1_QUAD(1, xmm3, xmm4, xmm6, xmm5, xmm1, xmm2)
+        SHA1_QUAD(1, xmm4, xmm5, xmm3, xmm6, xmm2, xmm1)
+        SHA1_QUAD(2, xmm5, xmm6, xmm4, xmm3, xmm1, xmm2)
+        SHA1_QUAD(2, xmm6, xmm3, xmm5, xmm4, xmm2, xmm1)
+        SHA1_QUAD(2, xmm3, xmm4, xmm6, xmm5, xmm1, xmm2)
+        SHA1_QUAD(2, xmm4, xmm5, xmm3, xmm6, xmm2, xmm1)
+        SHA1_QUAD(2, xmm5, xmm6, xmm4, xmm3, xmm1, xmm2)
+        SHA1_QUAD(3, xmm6, xmm3, xmm5, xmm4, xmm2, xmm1)
+        SHA1_QUAD(3, xmm3, xmm4, xmm6, xmm5, xmm1, xmm2)
+        SHA1_RNDS(3, xmm4, xmm2, xmm1)
+        SHA1_MSG2(xmm4, xmm5)
+        SHA1_XOR(xmm4, xmm6)
+        SHA1_RNDS(3, xmm5, xmm1, xmm2)
+        SHA1_MSG2(xmm5, xmm6)
+        SHA1_RNDS(3, xmm6, xmm2, xmm1)
+
+        "pinsrd     $3, 16(%[state]), %%xmm7          \n\t"
+        "sha1nexte  %%xmm7, %%xmm1                    \n\t"
+        "pextrd     $3, %%xmm1, 16(%[state])          \n\t"
+        "movdqu     (%[state]), %%xmm7                \n\t"
+        "pshufd     $0x1B, %%xmm0, %%xmm0             \n\t"
+        "paddd      %%xmm7, %%xmm0                    \n\t"
+        "movdqu     %%xmm0, (%[state])                \n\t"
+        :
+        : [state] "r"(state), [data] "r"(buffer), [flip] "m"(sha1_flip)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+
+/*
+ * SHA-256: xmm1 holds ABEF, xmm2 CDGH, xmm0 the message words plus round
+ * constants, xmm3-xmm6 the message schedule and xmm7 is scratch.
+ */
+#define SHA256_LOAD(i, m)                                   \
+        "movdqu     "#i"*16(%[data]), %%"#m"          \n\t" \
+        "pshufb     %[flip], %%"#m"                   \n\t"
+
+#define SHA256_RNDS(i, m)                                   \
+        "movdqa     %%"#m", %%xmm0                    \n\t" \
+        "paddd      "#i"*16(%[k]), %%xmm0             \n\t" \
+        "sha256rnds2 %%xmm1, %%xmm2                   \n\t" \
+        "pshufd     $0x0E, %%xmm0, %%xmm0             \n\t" \
+        "sha256rnds2 %%xmm2, %%xmm1                   \n\t"
+
+#define SHA256_MSG1(m, prev)                                \
+        "sha256msg1 %%"#m", %%"#prev"                 \n\t"
+
+#define SHA256_MSG2(m, next, prev)                          \
+        "movdqa     %%"#m", %%xmm7                    \n\t" \
+        "palignr    $4, %%"#prev", %%xmm7             \n\t" \
+        "paddd      %%xmm7, %%"#next"                 \n\t" \
+        "sha256msg2 %%"#m", %%"#next"                 \n\t"
+
+#define SHA256_QUAD(i, m, next, prev)                       \
+        SHA256_RNDS(i, m)                                   \
+        SHA256_MSG2(m, next, prev)                          \
+        SHA256_MSG1(m, prev)
+
+static void sha256_transform_shani(uint32_t *state, const uint8_t buffer[64])
+{
+    __asm__ volatile (
+        "movdqu       (%[state]), %%xmm1              \n\t"
+        "movdqu     16(%[state]), %%xmm2              \n\t"
+        "pshufd     $0xB1, %%xmm1, %%xmm1             \n\t"
+        "pshufd     $0x1B, %%xmm2, %%xmm2             \n\t"
+        "movdqa     %%xmm1, %%xmm7                    \n\t"
+        "palignr    $8, %%xmm2, %%xmm1                \n\t"
+        "pblendw    $0xF0, %%xmm7, %%xmm2             \n\t"
+
+        SHA256_LOAD(0, xmm3)
+        SHA256_RNDS(0, xmm3)
+        SHA256_LOAD(1, xmm4)
+        SHA256_RNDS(1, xmm4)
+        SHA256_MSG1(xmm4, xmm3)
+        SHA256_LOAD(2, xmm5)
+        SHA256_RNDS(2, xmm5)
+        SHA256_MSG1(xmm5, xmm4)
+        SHA256_LOAD(3, xmm6)
+        SHA256_QUAD( 3, xmm6, xmm3, xmm5)
+        SHA256_QUAD( 4, xmm3, xmm4, xmm6)
+        SHA256_QUAD( 5, xmm4, xmm5, xmm3)
+        SHA256_QUAD( 6, xmm5, xmm6, xmm4)
+        SHA256_QUAD( 7, xmm6, xmm3, xmm5)
+        SHA256_QUAD( 8, xmm3, xmm4, xmm6)
+        SHA256_QUAD( 9, xmm4, xmm5, xmm3)
+        SHA256_QUAD(10, xmm5, xmm6, xmm4)
+        SHA256_QUAD(11, xmm6, xmm3, xmm5)
+        SHA256_QUAD(12, xmm3, xmm4, xmm6)
+        SHA256_RNDS(13, xmm4)
+        SHA256_MSG2(xmm4, xmm5, xmm3)
+        SHA256_RNDS(14, xmm5)
+        SHA256_MSG2(xmm5, xmm6, xmm4)
+        SHA256_RNDS(15, xmm6)
+
+        "pshufd     $0x1B, %%xmm1, %%xmm1             \n\t"
+        "pshufd     $0xB1, %%xmm2, %%xmm2             \n\t"
+        "movdqa     %%xmm1, %%xmm7                    \n\t"
+        "pblendw    $0xF0, %%xmm2, %%xmm1             \n\t"
+        "palignr    $8, %%xmm7, %%xmm2                \n\t"
+        "movdqu       (%[state]), %%xmm7              \n\t"
+        "paddd      %%xmm7, %%xmm1                    \n\t"
+        "movdqu     16(%[state]), %%xmm7              \n\t"
+        "paddd      %%xmm7, %%xmm2                    \n\t"
+        "movdqu     %%xmm1,   (%[state])              \n\t"
+        "movdqu     %%xmm2, 16(%[state])              \n\t"
+        :
+        : [state] "r"(state), [data] "r"(buffer), [k] "r"(sha256_k),
+          [flip] "m"(sha256_flip)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+
+#endif /* HAVE_SHA_INLINE */
+
+av_cold void ff_sha_init_x86(sha_transform_fn *transform, int bits)
+{
+#if HAVE_SHA_INLINE
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INLINE_SHA(cpu_flags))
+        *transform = bits == 160 ? sha1_transform_shani : sha256_transform_shani;
+#endif
+}
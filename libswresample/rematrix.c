@@ -392,6 +392,27 @@ av_cold static int auto_matrix(SwrContext *s)
     return ret;
 }
 
+/**
+ * Check if the automatic matrix of the context swr_init_shared() was given
+ * is the one auto_matrix() would build for s.
+ */
+static int shared_matrix_matches(const SwrContext *s)
+{
+    const SwrContext *src = s->shared;
+
+    return src && (src->rematrix || src->dither.method) && !src->rematrix_custom &&
+           src->in_ch_layout    == s->in_ch_layout    &&
+           src->out_ch_layout   == s->out_ch_layout   &&
+           src->clev            == s->clev            &&
+           src->slev            == s->slev            &&
+           src->lfe_mix_level   == s->lfe_mix_level   &&
+           src->rematrix_volume == s->rematrix_volume &&
+           src->rematrix_maxval == s->rematrix_maxval &&
+           src->matrix_encoding == s->matrix_encoding &&
+           src->int_sample_fmt  == s->int_sample_fmt  &&
+           src->out_sample_fmt  == s->out_sample_fmt;
+}
+
 av_cold int swri_rematrix_init(SwrContext *s){
     int i, j;
     int nb_in  = s->used_ch_count;
@@ -399,7 +420,10 @@ av_cold int swri_rematrix_init(SwrContext *s){
 
     s->mix_any_f = NULL;
 
-    if (!s->rematrix_custom) {
+    if (!s->rematrix_custom && shared_matrix_matches(s)) {
+        memcpy(s->matrix,     s->shared->matrix,     sizeof(s->matrix));
+        memcpy(s->matrix_flt, s->shared->matrix_flt, sizeof(s->matrix_flt));
+    } else if (!s->rematrix_custom) {
         int r = auto_matrix(s);
         if (r)
             return r;
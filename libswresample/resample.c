@@ -277,17 +277,77 @@ fail:
     return ret;
 }
 
+static AVBufferRef *alloc_filter_bank(int filter_alloc, int phase_count, int felem_size)
+{
+    uint8_t *data = av_calloc(filter_alloc, (phase_count + 1) * felem_size);
+    AVBufferRef *buf;
+
+    if (!data)
+        return NULL;
+    buf = av_buffer_create(data, (size_t)filter_alloc * (phase_count + 1) * felem_size,
+                           av_buffer_default_free, NULL, 0);
+    if (!buf)
+        av_free(data);
+    return buf;
+}
+
 static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
-    av_freep(&c->filter_bank);
+    av_buffer_unref(&c->filter_bank_buf);
+    c->filter_bank = NULL;
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(cc);
 }
 
+static void resample_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+    int ch_count = c->job_dst->ch_count;
+    int start = ch_count *  jobnr      / nb_jobs;
+    int end   = ch_count * (jobnr + 1) / nb_jobs;
+
+    for (int i = start; i < end; i++) {
+        if (i + 1 == ch_count) {
+            /* the last channel advances the position, on a private copy so
+             * that the other jobs still see the initial one */
+            ResampleContext tmp = *c;
+            c->job_consumed = c->job_func(&tmp, c->job_dst->ch[i], c->job_src->ch[i],
+                                          c->job_size, 1);
+            c->job_index    = tmp.index;
+            c->job_frac     = tmp.frac;
+        } else {
+            c->job_func(c, c->job_dst->ch[i], c->job_src->ch[i], c->job_size, 0);
+        }
+    }
+}
+
+static int init_threads(ResampleContext *c, int nb_threads)
+{
+    int ret;
+
+    if (c->slicethread && c->nb_threads == nb_threads)
+        return 0;
+    avpriv_slicethread_free(&c->slicethread);
+    c->nb_threads = nb_threads;
+    if (nb_threads == 1)
+        return 0;
+
+    ret = avpriv_slicethread_create(&c->slicethread, c, resample_worker, NULL, nb_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret == 1)
+        avpriv_slicethread_free(&c->slicethread);
+    return 0;
+}
+
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int nb_threads,
+                                    const ResampleContext *shared)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -346,16 +406,29 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->factor        = factor;
         c->filter_length = filter_length;
         c->filter_alloc  = FFALIGN(c->filter_length, 8);
-        c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
         c->phase_count_compensation = phase_count_compensation;
-        if (!c->filter_bank)
-            goto error;
-        if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
-            goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+        /* the bank only depends on these, so a context with the same ones can
+         * lend us its own instead of building it again */
+        if (shared && shared->filter_bank_buf && shared->format == format &&
+            shared->phase_count == phase_count && shared->factor == factor &&
+            shared->filter_length == filter_length &&
+            shared->filter_type == filter_type && shared->kaiser_beta == kaiser_beta) {
+            c->filter_bank_buf = av_buffer_ref(shared->filter_bank_buf);
+            if (!c->filter_bank_buf)
+                goto error;
+            c->filter_bank = c->filter_bank_buf->data;
+        } else {
+            c->filter_bank_buf = alloc_filter_bank(c->filter_alloc, phase_count, c->felem_size);
+            if (!c->filter_bank_buf)
+                goto error;
+            c->filter_bank = c->filter_bank_buf->data;
+            if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
+                goto error;
+            memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
+            memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+        }
     }
 
     c->compensation_distance= 0;
@@ -372,17 +445,22 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
     c->index= -phase_count*((c->filter_length-1)/2);
     c->frac= 0;
 
+    if (init_threads(c, nb_threads) < 0)
+        goto error;
+
     swri_resample_dsp_init(c);
 
     return c;
 error:
-    av_freep(&c->filter_bank);
+    av_buffer_unref(&c->filter_bank_buf);
+    avpriv_slicethread_free(&c->slicethread);
     av_free(c);
     return NULL;
 }
 
 static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 {
+    AVBufferRef *new_filter_bank_buf;
     uint8_t *new_filter_bank;
     int new_src_incr, new_dst_incr;
     int phase_count = c->phase_count_compensation;
@@ -393,14 +471,15 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 
     av_assert0(!c->frac && !c->dst_incr_mod);
 
-    new_filter_bank = av_calloc(c->filter_alloc, (phase_count + 1) * c->felem_size);
-    if (!new_filter_bank)
+    new_filter_bank_buf = alloc_filter_bank(c->filter_alloc, phase_count, c->felem_size);
+    if (!new_filter_bank_buf)
         return AVERROR(ENOMEM);
+    new_filter_bank = new_filter_bank_buf->data;
 
     ret = build_filter(c, new_filter_bank, c->factor, c->filter_length, c->filter_alloc,
                        phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta);
     if (ret < 0) {
-        av_freep(&new_filter_bank);
+        av_buffer_unref(&new_filter_bank_buf);
         return ret;
     }
     memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_alloc-1)*c->felem_size);
@@ -409,7 +488,7 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
     if (!av_reduce(&new_src_incr, &new_dst_incr, c->src_incr,
                    c->dst_incr * (int64_t)(phase_count/c->phase_count), INT32_MAX/2))
     {
-        av_freep(&new_filter_bank);
+        av_buffer_unref(&new_filter_bank_buf);
         return AVERROR(EINVAL);
     }
 
@@ -424,8 +503,9 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
     c->dst_incr_mod   = c->dst_incr % c->src_incr;
     c->index         *= phase_count / c->phase_count;
     c->phase_count    = phase_count;
-    av_freep(&c->filter_bank);
-    c->filter_bank = new_filter_bank;
+    av_buffer_unref(&c->filter_bank_buf);
+    c->filter_bank_buf = new_filter_bank_buf;
+    c->filter_bank     = new_filter_bank;
     return 0;
 }
 
@@ -495,8 +575,20 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (c->slicethread && !need_emms && dst->ch_count > 1 &&
+                (int64_t)dst_size * c->filter_length * dst->ch_count >= 1 << 17) {
+                c->job_func = resample_func;
+                c->job_dst  = dst;
+                c->job_src  = src;
+                c->job_size = dst_size;
+                avpriv_slicethread_execute(c->slicethread, dst->ch_count, 0);
+                *consumed = c->job_consumed;
+                c->index  = c->job_index;
+                c->frac   = c->job_frac;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
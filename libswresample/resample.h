@@ -22,8 +22,10 @@
 #ifndef SWRESAMPLE_RESAMPLE_H
 #define SWRESAMPLE_RESAMPLE_H
 
+#include "libavutil/buffer.h"
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -58,6 +60,20 @@ typedef struct ResampleContext {
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
     } dsp;
+
+    AVBufferRef *filter_bank_buf;      /* owns filter_bank, may be shared between contexts */
+
+    AVSliceThread *slicethread;        /* resamples the channels in parallel */
+    int nb_threads;                    /* requested number of threads */
+    /* the current multiple_resample() call, for the slice threads */
+    int (*job_func)(struct ResampleContext *c, void *dst,
+                    const void *src, int n, int update_ctx);
+    AudioData *job_dst;
+    AudioData *job_src;
+    int job_size;
+    int job_consumed;
+    int job_index;
+    int job_frac;
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
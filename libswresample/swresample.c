@@ -272,7 +272,9 @@ av_cold int swr_init(struct SwrContext *s){
     }
 
     if (s->out_sample_rate!=s->in_sample_rate || (s->flags & SWR_FLAG_RESAMPLE)){
-        s->resample = s->resampler->init(s->resample, s->out_sample_rate, s->in_sample_rate, s->filter_size, s->phase_shift, s->linear_interp, s->cutoff, s->int_sample_fmt, s->filter_type, s->kaiser_beta, s->precision, s->cheby, s->exact_rational);
+        s->resample = s->resampler->init(s->resample, s->out_sample_rate, s->in_sample_rate, s->filter_size, s->phase_shift, s->linear_interp, s->cutoff, s->int_sample_fmt, s->filter_type, s->kaiser_beta, s->precision, s->cheby, s->exact_rational,
+                                         s->nb_threads,
+                                         s->shared && s->shared->engine == s->engine ? s->shared->resample : NULL);
         if (!s->resample) {
             av_log(s, AV_LOG_ERROR, "Failed to initialize resampler\n");
             return AVERROR(ENOMEM);
@@ -397,6 +399,15 @@ fail:
 
 }
 
+av_cold int swr_init_shared(struct SwrContext *s, const struct SwrContext *src){
+    int ret;
+
+    s->shared = src;
+    ret = swr_init(s);
+    s->shared = NULL;
+    return ret;
+}
+
 int swri_realloc_audio(AudioData *a, int count){
     int i, countb;
     AudioData old;
@@ -709,6 +720,36 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
     return out_count;
 }
 
+/**
+ * Run swr_convert_internal() on blocks of at most block_size input samples,
+ * so that the temporaries between the conversion, rematrixing and resampling
+ * stay in cache instead of each step going over the whole call.
+ */
+static int convert_blocks(struct SwrContext *s, AudioData *out, int out_count,
+                                                AudioData *in , int  in_count){
+    AudioData in_block, out_block;
+    int ret_sum = 0;
+
+    if (s->block_size <= 0 || in_count <= s->block_size)
+        return swr_convert_internal(s, out, out_count, in, in_count);
+
+    in_block  = *in;
+    out_block = *out;
+    while (in_count > 0) {
+        int count = FFMIN(in_count, s->block_size);
+        int ret = swr_convert_internal(s, &out_block, s->resample ? out_count : FFMIN(out_count, count),
+                                       &in_block, count);
+        if (ret < 0)
+            return ret;
+        buf_set(&in_block,  &in_block,  count);
+        buf_set(&out_block, &out_block, ret);
+        in_count  -= count;
+        out_count -= ret;
+        ret_sum   += ret;
+    }
+    return ret_sum;
+}
+
 int swr_is_initialized(struct SwrContext *s) {
     return !!s->in_buffer.ch_count;
 }
@@ -767,7 +808,7 @@ int attribute_align_arg swr_convert(struct SwrContext *s,
     fill_audiodata(out, out_arg);
 
     if(s->resample){
-        int ret = swr_convert_internal(s, out, out_count, in, in_count);
+        int ret = convert_blocks(s, out, out_count, in, in_count);
         if(ret>0 && !s->drop_output)
             s->outpts += ret * (int64_t)s->in_sample_rate;
 
@@ -781,7 +822,7 @@ int attribute_align_arg swr_convert(struct SwrContext *s,
         size = FFMIN(out_count, s->in_buffer_count);
         if(size){
             buf_set(&tmp, &s->in_buffer, s->in_buffer_index);
-            ret= swr_convert_internal(s, out, size, &tmp, size);
+            ret= convert_blocks(s, out, size, &tmp, size);
             if(ret<0)
                 return ret;
             ret2= ret;
@@ -809,7 +850,7 @@ int attribute_align_arg swr_convert(struct SwrContext *s,
 
             if(out_count){
                 size = FFMIN(in_count, out_count);
-                ret= swr_convert_internal(s, out, size, in, size);
+                ret= convert_blocks(s, out, size, in, size);
                 if(ret<0)
                     return ret;
                 buf_set(in, in, ret);
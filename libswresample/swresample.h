@@ -218,6 +218,24 @@ struct SwrContext *swr_alloc(void);
  */
 int swr_init(struct SwrContext *s);
 
+/**
+ * Initialize context like swr_init(), reusing the precomputed tables of
+ * another initialized context where the configurations are identical.
+ *
+ * The automatic rematrixing matrix is copied and the resampling filter bank
+ * is shared by reference, so both are only computed once for a set of
+ * contexts doing the same conversion. Whatever does not match is computed
+ * as usual, so the result is the same as with swr_init().
+ *
+ * src may be freed or reinitialized afterwards, but must not be used from
+ * another thread during this call.
+ *
+ * @param[in,out]   s   Swr context to initialize
+ * @param[in]       src initialized Swr context to take the tables from
+ * @return AVERROR error code in case of failure.
+ */
+int swr_init_shared(struct SwrContext *s, const struct SwrContext *src);
+
 /**
  * Check whether an swr context has been initialized or not.
  *
@@ -0,0 +1,311 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Checks that resampling the channels on several threads, converting in
+ * blocks and sharing the tables of another context give the same output as
+ * the plain conversion, and with -b <iterations>, measures them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
+
+#include "libswresample/swresample.h"
+#include "libswresample/swresample_internal.h"
+#include "libswresample/resample.h"
+
+#define NB_SAMPLES 16384
+
+static const struct {
+    enum AVSampleFormat fmt;
+    int channels;
+    int in_rate, out_rate;
+    int linear;
+} tests[] = {
+    { AV_SAMPLE_FMT_FLTP, 32, 48000, 44100, 0 },
+    { AV_SAMPLE_FMT_FLTP, 64, 44100, 96000, 1 },
+    { AV_SAMPLE_FMT_DBLP, 32, 96000, 48000, 0 },
+    { AV_SAMPLE_FMT_DBLP, 16, 22050, 48000, 1 },
+    { AV_SAMPLE_FMT_S16P, 32, 48000, 32000, 0 },
+    { AV_SAMPLE_FMT_S32P,  8, 44100, 48000, 0 },
+    { AV_SAMPLE_FMT_FLTP,  2, 48000, 44100, 0 },
+};
+
+static const struct {
+    enum AVSampleFormat in_fmt, out_fmt;
+    uint64_t in_layout, out_layout;
+    int in_rate, out_rate;
+} pipelines[] = {
+    { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_FLTP, AV_CH_LAYOUT_5POINT1, AV_CH_LAYOUT_STEREO,  48000, 44100 },
+    { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16,  AV_CH_LAYOUT_7POINT1, AV_CH_LAYOUT_5POINT1, 44100, 48000 },
+    { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_S16,  AV_CH_LAYOUT_MONO,    AV_CH_LAYOUT_STEREO,  22050, 48000 },
+    { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_S16P, AV_CH_LAYOUT_STEREO,  AV_CH_LAYOUT_MONO,    48000, 48000 },
+};
+
+static SwrContext *alloc_pipeline(int i, int block_size, const SwrContext *shared)
+{
+    SwrContext *s = swr_alloc_set_opts(NULL,
+                                       pipelines[i].out_layout, pipelines[i].out_fmt, pipelines[i].out_rate,
+                                       pipelines[i].in_layout,  pipelines[i].in_fmt,  pipelines[i].in_rate,
+                                       0, NULL);
+
+    if (!s)
+        return NULL;
+    av_opt_set_int(s, "block_size", block_size, 0);
+    if ((shared ? swr_init_shared(s, shared) : swr_init(s)) < 0)
+        swr_free(&s);
+    return s;
+}
+
+/* feeds the input in a few uneven calls and flushes, returns the output size */
+static int run_pipeline(SwrContext *s, int i, uint8_t **dst, int dst_size, uint8_t **src)
+{
+    static const int sizes[] = { 4000, 1, 9000, 3383 };
+    int in_bps = av_get_bytes_per_sample(pipelines[i].in_fmt) *
+                 (av_sample_fmt_is_planar(pipelines[i].in_fmt) ? 1 :
+                  av_get_channel_layout_nb_channels(pipelines[i].in_layout));
+    int out_bps = av_get_bytes_per_sample(pipelines[i].out_fmt) *
+                  (av_sample_fmt_is_planar(pipelines[i].out_fmt) ? 1 :
+                   av_get_channel_layout_nb_channels(pipelines[i].out_layout));
+    int nb_in = av_sample_fmt_is_planar(pipelines[i].in_fmt) ?
+                av_get_channel_layout_nb_channels(pipelines[i].in_layout) : 1;
+    int nb_out = av_sample_fmt_is_planar(pipelines[i].out_fmt) ?
+                 av_get_channel_layout_nb_channels(pipelines[i].out_layout) : 1;
+    int in_pos = 0, out_pos = 0;
+
+    for (int n = 0; n <= FF_ARRAY_ELEMS(sizes); n++) {
+        const uint8_t *in[SWR_CH_MAX];
+        uint8_t *out[SWR_CH_MAX];
+        int ret;
+
+        for (int ch = 0; ch < nb_in; ch++)
+            in[ch] = src[ch] + in_pos * in_bps;
+        for (int ch = 0; ch < nb_out; ch++)
+            out[ch] = dst[ch] + out_pos * out_bps;
+        ret = swr_convert(s, out, dst_size - out_pos,
+                          n < FF_ARRAY_ELEMS(sizes) ? in : NULL,
+                          n < FF_ARRAY_ELEMS(sizes) ? sizes[n] : 0);
+        if (ret < 0)
+            return ret;
+        if (n < FF_ARRAY_ELEMS(sizes))
+            in_pos += sizes[n];
+        out_pos += ret;
+    }
+    return out_pos;
+}
+
+static int check_pipeline(int i, int iterations, AVLFG *rand)
+{
+    int in_ch     = av_get_channel_layout_nb_channels(pipelines[i].in_layout);
+    int out_ch    = av_get_channel_layout_nb_channels(pipelines[i].out_layout);
+    int in_size   = 4000 + 1 + 9000 + 3383;
+    int dst_size  = av_rescale_rnd(in_size, pipelines[i].out_rate,
+                                   pipelines[i].in_rate, AV_ROUND_UP) + 256;
+    int out_bytes = av_samples_get_buffer_size(NULL, out_ch, dst_size, pipelines[i].out_fmt, 1);
+    SwrContext *whole   = alloc_pipeline(i, 0, NULL);
+    SwrContext *blocked = alloc_pipeline(i, 1024, NULL);
+    SwrContext *shared  = alloc_pipeline(i, 0, whole);
+    uint8_t **src = NULL, **dst[3] = { NULL };
+    SwrContext *ctx[3] = { whole, blocked, shared };
+    int n[3], mismatch = 0, in_bytes, ret = 0;
+
+    if (!whole || !blocked || !shared) {
+        fprintf(stderr, "Failed to create the converters for pipeline %d\n", i);
+        return 1;
+    }
+    if ((in_bytes = av_samples_alloc_array_and_samples(&src, NULL, in_ch, in_size,
+                                                       pipelines[i].in_fmt, 0)) < 0)
+        return 1;
+    for (int j = 0; j < 3; j++)
+        if (av_samples_alloc_array_and_samples(&dst[j], NULL, out_ch, dst_size,
+                                               pipelines[i].out_fmt, 1) < 0)
+            return 1;
+    if (pipelines[i].in_fmt == AV_SAMPLE_FMT_FLTP) {
+        for (int j = 0; j < in_bytes / 4; j++)
+            ((float *)src[0])[j] = ((int)av_lfg_get(rand) >> 16) / 32768.0f;
+    } else {
+        for (int j = 0; j < in_bytes; j++)
+            src[0][j] = av_lfg_get(rand);
+    }
+
+    for (int j = 0; j < 3; j++) {
+        memset(dst[j][0], 0, out_bytes);
+        n[j] = run_pipeline(ctx[j], i, dst[j], dst_size, src);
+        if (n[j] < 0)
+            return 1;
+        mismatch |= n[j] != n[0] || memcmp(dst[j][0], dst[0][0], out_bytes);
+    }
+
+    printf("%s %dch %d -> %s %dch %d: %d samples, blocks %s, shared %s%s\n",
+           av_get_sample_fmt_name(pipelines[i].in_fmt), in_ch, pipelines[i].in_rate,
+           av_get_sample_fmt_name(pipelines[i].out_fmt), out_ch, pipelines[i].out_rate,
+           n[0], n[1] == n[0] && !memcmp(dst[1][0], dst[0][0], out_bytes) ? "ok" : "MISMATCH",
+           n[2] == n[0] && !memcmp(dst[2][0], dst[0][0], out_bytes) ? "ok" : "MISMATCH",
+           whole->resample && whole->engine == SWR_ENGINE_SWR &&
+           whole->resample->filter_bank == shared->resample->filter_bank ? " (filter bank shared)" : "");
+    ret |= mismatch;
+
+    if (iterations > 0) {
+        int64_t t[2];
+        for (int j = 0; j < 2; j++) {
+            t[j] = av_gettime_relative();
+            for (int k = 0; k < iterations; k++) {
+                swr_init(ctx[j]);
+                run_pipeline(ctx[j], i, dst[j], dst_size, src);
+            }
+            t[j] = av_gettime_relative() - t[j];
+        }
+        printf("    whole calls %8.3f ms, blocks %8.3f ms per run\n",
+               t[0] / 1000.0 / iterations, t[1] / 1000.0 / iterations);
+    }
+
+    av_freep(&src[0]);
+    av_freep(&src);
+    for (int j = 0; j < 3; j++) {
+        av_freep(&dst[j][0]);
+        av_freep(&dst[j]);
+        swr_free(&ctx[j]);
+    }
+    return ret;
+}
+
+static SwrContext *alloc_context(int i, int threads)
+{
+    SwrContext *s = swr_alloc();
+
+    if (!s)
+        return NULL;
+    av_opt_set_int       (s, "in_channel_count",  tests[i].channels, 0);
+    av_opt_set_int       (s, "out_channel_count", tests[i].channels, 0);
+    av_opt_set_int       (s, "in_sample_rate",  tests[i].in_rate,  0);
+    av_opt_set_int       (s, "out_sample_rate", tests[i].out_rate, 0);
+    av_opt_set_sample_fmt(s, "in_sample_fmt",   tests[i].fmt,      0);
+    av_opt_set_sample_fmt(s, "out_sample_fmt",  tests[i].fmt,      0);
+    av_opt_set_sample_fmt(s, "internal_sample_fmt", tests[i].fmt,  0);
+    av_opt_set_int       (s, "linear_interp",   tests[i].linear,   0);
+    av_opt_set_int       (s, "exact_rational",  !tests[i].linear,  0);
+    av_opt_set_int       (s, "filter_size",     64,                0);
+    av_opt_set_int       (s, "threads",         threads,           0);
+    if (swr_init(s) < 0)
+        swr_free(&s);
+    return s;
+}
+
+static int64_t bench(SwrContext *s, int iterations, uint8_t **dst, int dst_size,
+                     const uint8_t **src)
+{
+    int64_t t = av_gettime_relative();
+
+    for (int n = 0; n < iterations; n++)
+        swr_convert(s, dst, dst_size, src, NB_SAMPLES);
+    return av_gettime_relative() - t;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 0, ret = 0;
+    AVLFG rand;
+
+    if (argc == 3 && !strcmp(argv[1], "-b"))
+        iterations = atoi(argv[2]);
+
+    av_lfg_init(&rand, 1);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        int bps      = av_get_bytes_per_sample(tests[i].fmt);
+        int dst_size = av_rescale_rnd(NB_SAMPLES, tests[i].out_rate,
+                                      tests[i].in_rate, AV_ROUND_UP) + 256;
+        SwrContext *serial   = alloc_context(i, 1);
+        SwrContext *threaded = alloc_context(i, 4);
+        uint8_t **src = NULL, **dst0 = NULL, **dst1 = NULL;
+        int n0 = 0, n1, mismatch = 0;
+
+        if (!serial || !threaded) {
+            fprintf(stderr, "Failed to create the resamplers for test %d\n", i);
+            return 1;
+        }
+
+        if (av_samples_alloc_array_and_samples(&src, NULL, tests[i].channels,
+                                               NB_SAMPLES, tests[i].fmt, 0) < 0 ||
+            av_samples_alloc_array_and_samples(&dst0, NULL, tests[i].channels,
+                                               dst_size, tests[i].fmt, 0) < 0 ||
+            av_samples_alloc_array_and_samples(&dst1, NULL, tests[i].channels,
+                                               dst_size, tests[i].fmt, 0) < 0) {
+            fprintf(stderr, "Failed to allocate the samples for test %d\n", i);
+            return 1;
+        }
+        for (int ch = 0; ch < tests[i].channels; ch++) {
+            for (int j = 0; j < NB_SAMPLES; j++) {
+                int v = (int)av_lfg_get(&rand) >> 16;
+                switch (tests[i].fmt) {
+                case AV_SAMPLE_FMT_S16P: ((int16_t *)src[ch])[j] = v;                break;
+                case AV_SAMPLE_FMT_S32P: ((int32_t *)src[ch])[j] = v * 65536;        break;
+                case AV_SAMPLE_FMT_FLTP: ((float   *)src[ch])[j] = v / 32768.0f;     break;
+                case AV_SAMPLE_FMT_DBLP: ((double  *)src[ch])[j] = v / 32768.0;      break;
+                default: break;
+                }
+            }
+        }
+
+        /* convert twice so that the state carried between calls is checked */
+        for (int pass = 0; pass < 2 && !mismatch; pass++) {
+            n0 = swr_convert(serial,   dst0, dst_size, (const uint8_t **)src, NB_SAMPLES);
+            n1 = swr_convert(threaded, dst1, dst_size, (const uint8_t **)src, NB_SAMPLES);
+            mismatch = n0 != n1;
+            for (int ch = 0; ch < tests[i].channels && !mismatch; ch++)
+                mismatch |= memcmp(dst0[ch], dst1[ch], n0 * bps);
+        }
+
+        printf("%s %dch %d -> %d%s: %d samples, %s\n",
+               av_get_sample_fmt_name(tests[i].fmt), tests[i].channels,
+               tests[i].in_rate, tests[i].out_rate,
+               tests[i].linear ? " linear" : "", n0,
+               mismatch ? "MISMATCH" : "ok");
+        ret |= mismatch;
+
+        if (iterations > 0) {
+            int64_t t0 = bench(serial,   iterations, dst0, dst_size, (const uint8_t **)src);
+            int64_t t1 = bench(threaded, iterations, dst1, dst_size, (const uint8_t **)src);
+            printf("    1 thread %8.3f ms, 4 threads %8.3f ms per call\n",
+                   t0 / 1000.0 / iterations, t1 / 1000.0 / iterations);
+        }
+
+        av_freep(&src[0]);
+        av_freep(&dst0[0]);
+        av_freep(&dst1[0]);
+        av_freep(&src);
+        av_freep(&dst0);
+        av_freep(&dst1);
+        swr_free(&serial);
+        swr_free(&threaded);
+    }
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(pipelines); i++)
+        ret |= check_pipeline(i, iterations, &rand);
+
+    return ret;
+}
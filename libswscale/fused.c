@@ -0,0 +1,427 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Fused scaler for whole frames of common planar conversions.
+ *
+ * Each plane is scaled in a single pass: for every output line the source
+ * lines it needs are horizontally scaled into a small ring buffer, and the
+ * output line is vertically scaled straight into the destination. Input
+ * formats which need converting (P010) are read and deinterleaved by the
+ * horizontal scaler itself instead of going through a separate pass.
+ *
+ * SIMD scalers are used when the generic path has them. Otherwise the C
+ * scalers below, specialized for the usual filter sizes, are used. Either
+ * way the output is identical to the one of the generic path.
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "swscale.h"
+#include "swscale_internal.h"
+
+DECLARE_ALIGNED(8, static const uint8_t, dither_64)[8] = {
+    64, 64, 64, 64, 64, 64, 64, 64
+};
+
+typedef void (*hscale_fn)(SwsContext *c, int16_t *dst, int dstW,
+                          const uint8_t *src, const int16_t *filter,
+                          const int32_t *filterPos, int filterSize);
+
+typedef struct FusedPlane {
+    const uint8_t *src;
+    int src_stride;
+    int src_h;
+
+    /* two destinations when both chroma planes come from one source plane */
+    uint8_t *dst[2];
+    int dst_stride[2];
+    int dither_offset[2];
+    int nb_dst;
+    int dst_w;
+    int dst_h;
+    int v_sub;                  ///< vertical subsampling of the plane
+
+    const int16_t *h_filter;
+    const int32_t *h_filter_pos;
+    int h_filter_size;
+    const int16_t *v_filter;
+    const int32_t *v_filter_pos;
+    int v_filter_size;
+
+    hscale_fn hscale8;          ///< horizontal scaler for 8-bit planes
+    void (*hscale)(SwsContext *c, const struct FusedPlane *p,
+                   int16_t *dst[2], const uint8_t *src);
+} FusedPlane;
+
+typedef struct FusedOutput {
+    const uint8_t *dither;      ///< NULL for the 8x8 ordered dither
+    yuv2planar1_fn plane1_c;
+    yuv2planarX_fn planeX_c;
+    int vscale_c;               ///< use vscale8() instead of c->yuv2planeX
+} FusedOutput;
+
+/* Same as ff_hscale8to15_c(), with a constant filter size. */
+static av_always_inline void hscale8(int16_t *dst, int dstW, const uint8_t *src,
+                                     const int16_t *filter,
+                                     const int32_t *filterPos, int filterSize)
+{
+    int i, j;
+
+    for (i = 0; i < dstW; i++) {
+        const uint8_t *s = src + filterPos[i];
+        const int16_t *f = filter + filterSize * i;
+        int val = 0;
+
+        for (j = 0; j < filterSize; j++)
+            val += s[j] * f[j];
+        dst[i] = FFMIN(val >> 7, (1 << 15) - 1);
+    }
+}
+
+#define HSCALE8(n)                                                            \
+static void hscale8_ ## n(SwsContext *c, int16_t *dst, int dstW,              \
+                          const uint8_t *src, const int16_t *filter,          \
+                          const int32_t *filterPos, int filterSize)           \
+{                                                                             \
+    hscale8(dst, dstW, src, filter, filterPos, n);                            \
+}
+
+HSCALE8(4)
+HSCALE8(6)
+HSCALE8(8)
+HSCALE8(12)
+HSCALE8(16)
+
+static hscale_fn get_hscale8(hscale_fn simd, int filter_size)
+{
+    if (simd != ff_hscale8to15_c)
+        return simd;
+
+    switch (filter_size) {
+    case  4: return hscale8_4;
+    case  6: return hscale8_6;
+    case  8: return hscale8_8;
+    case 12: return hscale8_12;
+    case 16: return hscale8_16;
+    default: return ff_hscale8to15_c;
+    }
+}
+
+static void hscale_planar(SwsContext *c, const FusedPlane *p,
+                          int16_t *dst[2], const uint8_t *src)
+{
+    p->hscale8(c, dst[0], p->dst_w, src, p->h_filter, p->h_filter_pos,
+               p->h_filter_size);
+}
+
+/* Same as p010{LE,BE}To{Y,UV}_c() followed by hScale16To15_c(). */
+static av_always_inline void hscale_p010(const FusedPlane *p, int16_t *dst[2],
+                                         const uint8_t *src, int filter_size,
+                                         int uv, int be)
+{
+    const int16_t *filter = p->h_filter;
+    const int step = uv ? 4 : 2;
+    int i, j;
+
+#define READ(x) ((be ? AV_RB16(x) : AV_RL16(x)) >> 6)
+    for (i = 0; i < p->dst_w; i++) {
+        const uint8_t *s = src + step * p->h_filter_pos[i];
+        const int16_t *f = filter + filter_size * i;
+        int u = 0, v = 0;
+
+        for (j = 0; j < filter_size; j++) {
+            u += READ(s + step * j) * f[j];
+            if (uv)
+                v += READ(s + step * j + 2) * f[j];
+        }
+        dst[0][i] = FFMIN(u >> 9, (1 << 15) - 1);
+        if (uv)
+            dst[1][i] = FFMIN(v >> 9, (1 << 15) - 1);
+    }
+#undef READ
+}
+
+#define HSCALE_P010(name, uv, be)                                             \
+static void hscale_ ## name(SwsContext *c, const FusedPlane *p,               \
+                            int16_t *dst[2], const uint8_t *src)              \
+{                                                                             \
+    switch (p->h_filter_size) {                                               \
+    case 4:  hscale_p010(p, dst, src, 4, uv, be);                 break;      \
+    case 8:  hscale_p010(p, dst, src, 8, uv, be);                 break;      \
+    default: hscale_p010(p, dst, src, p->h_filter_size, uv, be);  break;      \
+    }                                                                         \
+}
+
+HSCALE_P010(p010le_y,  0, 0)
+HSCALE_P010(p010le_uv, 1, 0)
+HSCALE_P010(p010be_y,  0, 1)
+HSCALE_P010(p010be_uv, 1, 1)
+
+static int16_t *ring_line(SwsContext *c, int ring, int line)
+{
+    return c->fused_buf + ((ptrdiff_t)ring * c->fused_buf_lines +
+                           line % c->fused_buf_lines) * c->fused_buf_stride;
+}
+
+/* Same as yuv2planeX_8_c(), but filtering a tap of the whole line at a time
+ * so that the loops vectorize. */
+static void vscale8(SwsContext *c, const int16_t *filter, int filter_size,
+                    const int16_t **src, uint8_t *dst, int dst_w,
+                    const uint8_t *dither, int offset)
+{
+    int32_t *acc = (int32_t *)ring_line(c, 2, 0);
+    int i, j;
+
+    for (i = 0; i < dst_w; i++)
+        acc[i] = dither[(i + offset) & 7] << 12;
+    for (j = 0; j < filter_size; j++) {
+        const int16_t *s = src[j];
+        const int f = filter[j];
+
+        for (i = 0; i < dst_w; i++)
+            acc[i] += s[i] * f;
+    }
+    for (i = 0; i < dst_w; i++)
+        dst[i] = av_clip_uint8(acc[i] >> 19);
+}
+
+static void scale_plane(SwsContext *c, const FusedPlane *p,
+                        const FusedOutput *out)
+{
+    const int16_t *lines[2][MAX_FILTER_SIZE];
+    int16_t *hout[2];
+    int last = -1;
+    int y, i, k;
+
+    for (y = 0; y < p->dst_h; y++) {
+        const int first = p->v_filter_pos[y];
+        const int lo = av_clip(first, 0, p->src_h - 1);
+        const int hi = av_clip(first + p->v_filter_size - 1, 0, p->src_h - 1);
+        const uint8_t *dither = out->dither ? out->dither
+                                            : ff_dither_8x8_128[y & 7];
+        yuv2planar1_fn plane1 = c->yuv2plane1;
+        yuv2planarX_fn planeX = c->yuv2planeX;
+        int vscale_c = out->vscale_c;
+
+        /* The SIMD output functions may write past the end of the line,
+         * swscale() avoids them on the last lines of the picture. */
+        if ((y << p->v_sub) >= c->dstH - 2) {
+            plane1   = out->plane1_c;
+            planeX   = out->planeX_c;
+            vscale_c = 1;
+        }
+
+        for (i = FFMAX(last + 1, lo); i <= hi; i++) {
+            for (k = 0; k < p->nb_dst; k++)
+                hout[k] = ring_line(c, k, i);
+            p->hscale(c, p, hout, p->src + i * (ptrdiff_t)p->src_stride);
+        }
+        last = FFMAX(last, hi);
+
+        /* lines outside of the picture repeat the edge lines */
+        for (i = 0; i < p->v_filter_size; i++)
+            for (k = 0; k < p->nb_dst; k++)
+                lines[k][i] = ring_line(c, k, av_clip(first + i, 0, p->src_h - 1));
+
+        for (k = 0; k < p->nb_dst; k++) {
+            const int16_t *filter = p->v_filter + y * p->v_filter_size;
+            uint8_t *dst = p->dst[k] + y * (ptrdiff_t)p->dst_stride[k];
+
+            if (p->v_filter_size == 1)
+                plane1(lines[k][0], dst, p->dst_w, dither, p->dither_offset[k]);
+            else if (vscale_c)
+                vscale8(c, filter, p->v_filter_size, lines[k], dst, p->dst_w,
+                        dither, p->dither_offset[k]);
+            else
+                planeX(filter, p->v_filter_size, lines[k], dst, p->dst_w,
+                       dither, p->dither_offset[k]);
+        }
+    }
+}
+
+static void init_output(SwsContext *c, FusedOutput *out, int dither)
+{
+    yuv2interleavedX_fn nv12cX;
+    yuv2packed1_fn packed1;
+    yuv2packed2_fn packed2;
+    yuv2packedX_fn packedX;
+    yuv2anyX_fn anyX;
+
+    out->dither = dither ? NULL : dither_64;
+    ff_sws_init_output_funcs(c, &out->plane1_c, &out->planeX_c, &nv12cX,
+                             &packed1, &packed2, &packedX, &anyX);
+    out->vscale_c = c->yuv2planeX == out->planeX_c;
+}
+
+static void init_luma(SwsContext *c, FusedPlane *p,
+                      const uint8_t *src, int src_stride,
+                      uint8_t *dst, int dst_stride)
+{
+    p->src           = src;
+    p->src_stride    = src_stride;
+    p->src_h         = c->srcH;
+    p->dst[0]        = dst;
+    p->dst_stride[0] = dst_stride;
+    p->dither_offset[0] = 0;
+    p->nb_dst        = 1;
+    p->dst_w         = c->dstW;
+    p->dst_h         = c->dstH;
+    p->v_sub         = 0;
+    p->h_filter      = c->hLumFilter;
+    p->h_filter_pos  = c->hLumFilterPos;
+    p->h_filter_size = c->hLumFilterSize;
+    p->v_filter      = c->vLumFilter;
+    p->v_filter_pos  = c->vLumFilterPos;
+    p->v_filter_size = c->vLumFilterSize;
+    p->hscale8       = get_hscale8(c->hyScale, c->hLumFilterSize);
+}
+
+static void init_chroma(SwsContext *c, FusedPlane *p,
+                        const uint8_t *src, int src_stride)
+{
+    p->src           = src;
+    p->src_stride    = src_stride;
+    p->src_h         = c->chrSrcH;
+    p->dst_w         = c->chrDstW;
+    p->dst_h         = c->chrDstH;
+    p->v_sub         = c->chrDstVSubSample;
+    p->h_filter      = c->hChrFilter;
+    p->h_filter_pos  = c->hChrFilterPos;
+    p->h_filter_size = c->hChrFilterSize;
+    p->v_filter      = c->vChrFilter;
+    p->v_filter_pos  = c->vChrFilterPos;
+    p->v_filter_size = c->vChrFilterSize;
+    p->hscale8       = get_hscale8(c->hcScale, c->hChrFilterSize);
+}
+
+static int fused_planar8(SwsContext *c, const uint8_t *src[],
+                         int srcStride[], int srcSliceY, int srcSliceH,
+                         uint8_t *dst[], int dstStride[])
+{
+    FusedOutput out;
+    FusedPlane p;
+    int i;
+
+    init_output(c, &out, 0);
+
+    init_luma(c, &p, src[0], srcStride[0], dst[0], dstStride[0]);
+    p.hscale = hscale_planar;
+    scale_plane(c, &p, &out);
+
+    if (!isGray(c->dstFormat)) {
+        for (i = 1; i < 3; i++) {
+            init_chroma(c, &p, src[i], srcStride[i]);
+            p.dst[0]           = dst[i];
+            p.dst_stride[0]    = dstStride[i];
+            p.dither_offset[0] = i == 2 ? 3 : 0;
+            p.nb_dst           = 1;
+            p.hscale           = hscale_planar;
+            scale_plane(c, &p, &out);
+        }
+    }
+
+    emms_c();
+    return c->dstH;
+}
+
+static int fused_p010(SwsContext *c, const uint8_t *src[],
+                      int srcStride[], int srcSliceY, int srcSliceH,
+                      uint8_t *dst[], int dstStride[])
+{
+    const int be = c->srcFormat == AV_PIX_FMT_P010BE;
+    FusedOutput out;
+    FusedPlane p;
+
+    init_output(c, &out, 1);
+
+    init_luma(c, &p, src[0], srcStride[0], dst[0], dstStride[0]);
+    p.hscale = be ? hscale_p010be_y : hscale_p010le_y;
+    scale_plane(c, &p, &out);
+
+    init_chroma(c, &p, src[1], srcStride[1]);
+    p.dst[0]           = dst[1];
+    p.dst[1]           = dst[2];
+    p.dst_stride[0]    = dstStride[1];
+    p.dst_stride[1]    = dstStride[2];
+    p.dither_offset[0] = 0;
+    p.dither_offset[1] = 3;
+    p.nb_dst           = 2;
+    p.hscale           = be ? hscale_p010be_uv : hscale_p010le_uv;
+    scale_plane(c, &p, &out);
+
+    emms_c();
+    return c->dstH;
+}
+
+static int is_planar8(enum AVPixelFormat fmt)
+{
+    switch (fmt) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_GRAY8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+av_cold int ff_sws_init_fused(SwsContext *c)
+{
+    enum AVPixelFormat srcFormat = c->srcFormat;
+    enum AVPixelFormat dstFormat = c->dstFormat;
+    SwsFunc func;
+
+    c->fused_scale = NULL;
+
+    /* The MMX vertical scalers need per line tables set up by swscale(). */
+    if (!c->fused || c->use_mmx_vfilter || c->vChrDrop ||
+        (c->flags & SWS_FAST_BILINEAR) || c->is_internal_gamma)
+        return 0;
+
+    if (srcFormat == dstFormat && is_planar8(srcFormat))
+        func = fused_planar8;
+    else if ((srcFormat == AV_PIX_FMT_P010LE || srcFormat == AV_PIX_FMT_P010BE) &&
+             dstFormat == AV_PIX_FMT_YUV420P)
+        func = fused_p010;
+    else
+        return 0;
+
+    /* two rings of scaled lines, and one line of int32_t for vscale8() */
+    c->fused_buf_lines  = FFMAX(c->vLumFilterSize, c->vChrFilterSize);
+    c->fused_buf_stride = FFALIGN(c->dstW * sizeof(int32_t) + 66, 16) / sizeof(int16_t);
+    c->fused_buf = av_malloc_array(2 * c->fused_buf_lines + 1,
+                                   c->fused_buf_stride * sizeof(int16_t));
+    if (!c->fused_buf)
+        return AVERROR(ENOMEM);
+
+    c->fused_scale = func;
+
+    if (c->flags & SWS_PRINT_INFO)
+        av_log(c, AV_LOG_INFO, "using fused %s -> %s scaler\n",
+               av_get_pix_fmt_name(srcFormat), av_get_pix_fmt_name(dstFormat));
+
+    return 0;
+}
@@ -18,6 +18,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <math.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixfmt.h"
+
 #include "swscale_internal.h"
 
 typedef struct GammaContext
@@ -70,3 +76,86 @@ int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *t
     return 0;
 }
 
+/* SMPTE ST 2084 constants */
+#define PQ_M1 (2610.0 / 16384.0)
+#define PQ_M2 (2523.0 / 4096.0 * 128.0)
+#define PQ_C1 (3424.0 / 4096.0)
+#define PQ_C2 (2413.0 / 4096.0 * 32.0)
+#define PQ_C3 (2392.0 / 4096.0 * 32.0)
+
+/* ARIB STD-B67 constants */
+#define HLG_A 0.17883277
+#define HLG_B 0.28466892
+#define HLG_C 0.55991073
+
+/**
+ * Map a coded value in [0,1] to linear light in [0,1].
+ * PQ is normalized to 10000 cd/m^2, BT.709 and HLG give scene light.
+ */
+static double trc_to_linear(enum AVColorTransferCharacteristic trc,
+                            double gamma, double v)
+{
+    switch (trc) {
+    case AVCOL_TRC_BT709:
+        return v < 0.081 ? v / 4.5 : pow((v + 0.099) / 1.099, 1.0 / 0.45);
+    case AVCOL_TRC_GAMMA22:
+        return pow(v, 2.2);
+    case AVCOL_TRC_GAMMA28:
+        return pow(v, 2.8);
+    case AVCOL_TRC_IEC61966_2_1:
+        return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+    case AVCOL_TRC_SMPTE2084: {
+        double vp = pow(v, 1.0 / PQ_M2);
+        return pow(FFMAX(vp - PQ_C1, 0.0) / (PQ_C2 - PQ_C3 * vp), 1.0 / PQ_M1);
+    }
+    case AVCOL_TRC_ARIB_STD_B67:
+        return v <= 0.5 ? v * v / 3.0 : (exp((v - HLG_C) / HLG_A) + HLG_B) / 12.0;
+    default:
+        return pow(v, gamma);
+    }
+}
+
+/**
+ * Inverse of trc_to_linear().
+ */
+static double trc_from_linear(enum AVColorTransferCharacteristic trc,
+                              double gamma, double l)
+{
+    switch (trc) {
+    case AVCOL_TRC_BT709:
+        return l < 0.018 ? l * 4.5 : 1.099 * pow(l, 0.45) - 0.099;
+    case AVCOL_TRC_GAMMA22:
+        return pow(l, 1.0 / 2.2);
+    case AVCOL_TRC_GAMMA28:
+        return pow(l, 1.0 / 2.8);
+    case AVCOL_TRC_IEC61966_2_1:
+        return l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+    case AVCOL_TRC_SMPTE2084: {
+        double lp = pow(l, PQ_M1);
+        return pow((PQ_C1 + PQ_C2 * lp) / (1.0 + PQ_C3 * lp), PQ_M2);
+    }
+    case AVCOL_TRC_ARIB_STD_B67:
+        return l <= 1.0 / 12.0 ? sqrt(3.0 * l) : HLG_A * log(12.0 * l - HLG_B) + HLG_C;
+    default:
+        return pow(l, 1.0 / gamma);
+    }
+}
+
+uint16_t *ff_alloc_gamma_table(enum AVColorTransferCharacteristic trc,
+                               double gamma, int to_linear)
+{
+    uint16_t *table;
+    int i;
+
+    table = av_malloc(65536 * sizeof(*table));
+    if (!table)
+        return NULL;
+
+    for (i = 0; i < 65536; ++i) {
+        double v = i / 65535.0;
+        v = to_linear ? trc_to_linear(trc, gamma, v) : trc_from_linear(trc, gamma, v);
+        table[i] = av_clip_uint16(lrint(v * 65535.0));
+    }
+
+    return table;
+}
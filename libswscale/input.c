@@ -1107,6 +1107,7 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
         c->chrToYV12 = uyvyToUV_c;
         break;
     case AV_PIX_FMT_NV12:
+    case AV_PIX_FMT_NV16:
     case AV_PIX_FMT_NV24:
         c->chrToYV12 = nv12ToUV_c;
         break;
@@ -1247,11 +1248,13 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
     case AV_PIX_FMT_P410BE:
         c->chrToYV12 = p010BEToUV_c;
         break;
+    case AV_PIX_FMT_NV20LE:
     case AV_PIX_FMT_P016LE:
     case AV_PIX_FMT_P216LE:
     case AV_PIX_FMT_P416LE:
         c->chrToYV12 = p016LEToUV_c;
         break;
+    case AV_PIX_FMT_NV20BE:
     case AV_PIX_FMT_P016BE:
     case AV_PIX_FMT_P216BE:
     case AV_PIX_FMT_P416BE:
@@ -1526,6 +1529,7 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
     case AV_PIX_FMT_GRAY14LE:
     case AV_PIX_FMT_GRAY16LE:
 
+    case AV_PIX_FMT_NV20LE:
     case AV_PIX_FMT_P016LE:
     case AV_PIX_FMT_P216LE:
     case AV_PIX_FMT_P416LE:
@@ -1570,6 +1574,7 @@ av_cold void ff_sws_init_input_funcs(SwsContext *c)
     case AV_PIX_FMT_GRAY14BE:
     case AV_PIX_FMT_GRAY16BE:
 
+    case AV_PIX_FMT_NV20BE:
     case AV_PIX_FMT_P016BE:
     case AV_PIX_FMT_P216BE:
     case AV_PIX_FMT_P416BE:
@@ -76,11 +76,20 @@ static const AVOption swscale_options[] = {
     { "a_dither",        "arithmetic addition dither",    0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_DITHER_A_DITHER}, INT_MIN, INT_MAX,        VE, "sws_dither" },
     { "x_dither",        "arithmetic xor dither",         0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_DITHER_X_DITHER}, INT_MIN, INT_MAX,        VE, "sws_dither" },
     { "gamma",           "gamma correct scaling",         OFFSET(gamma_flag),AV_OPT_TYPE_BOOL,   { .i64  = 0                  }, 0,       1,              VE },
+    { "gamma_trc",       "transfer characteristic for gamma correct scaling", OFFSET(gamma_trc), AV_OPT_TYPE_INT, { .i64 = AVCOL_TRC_UNSPECIFIED }, 0, AVCOL_TRC_NB-1, VE, "gamma_trc" },
+    { "bt709",           "BT.709 / BT.601 / BT.2020",     0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_BT709        }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
+    { "gamma22",         "2.2 power law",                 0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_GAMMA22      }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
+    { "gamma28",         "2.8 power law",                 0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_GAMMA28      }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
+    { "srgb",            "IEC 61966-2-1 (sRGB)",          0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_IEC61966_2_1 }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
+    { "pq",              "SMPTE ST 2084 (PQ)",            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_SMPTE2084    }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
+    { "hlg",             "ARIB STD-B67 (HLG)",            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_ARIB_STD_B67 }, INT_MIN, INT_MAX,    VE, "gamma_trc" },
     { "alphablend",      "mode for alpha -> non alpha",   OFFSET(alphablend),AV_OPT_TYPE_INT,    { .i64  = SWS_ALPHA_BLEND_NONE}, 0,       SWS_ALPHA_BLEND_NB-1, VE, "alphablend" },
     { "none",            "ignore alpha",                  0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_ALPHA_BLEND_NONE}, INT_MIN, INT_MAX,       VE, "alphablend" },
     { "uniform_color",   "blend onto a uniform color",    0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_ALPHA_BLEND_UNIFORM},INT_MIN, INT_MAX,     VE, "alphablend" },
     { "checkerboard",    "blend onto a checkerboard",     0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_ALPHA_BLEND_CHECKERBOARD},INT_MIN, INT_MAX,     VE, "alphablend" },
 
+    { "fused",           "allow single pass scaling of whole frames", OFFSET(fused), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0,       1,              VE },
+
     { "threads",         "number of threads",             OFFSET(nb_threads),   AV_OPT_TYPE_INT, {.i64 = 1 }, 0, INT_MAX, VE, "threads" },
         { "auto",        NULL,                            0,                  AV_OPT_TYPE_CONST, {.i64 = 0 },    .flags = VE, "threads" },
 
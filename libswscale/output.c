@@ -460,9 +460,9 @@ static void yuv2nv12cX_c(enum AVPixelFormat dstFormat, const uint8_t *chrDither,
 
 #define output_pixel(pos, val) \
     if (big_endian) { \
-        AV_WB16(pos, av_clip_uintp2(val >> shift, 10) << 6); \
+        AV_WB16(pos, av_clip_uintp2(val >> shift, 10) << output_shift); \
     } else { \
-        AV_WL16(pos, av_clip_uintp2(val >> shift, 10) << 6); \
+        AV_WL16(pos, av_clip_uintp2(val >> shift, 10) << output_shift); \
     }
 
 static void yuv2p010l1_c(const int16_t *src,
@@ -471,6 +471,7 @@ static void yuv2p010l1_c(const int16_t *src,
 {
     int i;
     int shift = 5;
+    int output_shift = 6;
 
     for (i = 0; i < dstW; i++) {
         int val = src[i] + (1 << (shift - 1));
@@ -484,6 +485,7 @@ static void yuv2p010lX_c(const int16_t *filter, int filterSize,
 {
     int i, j;
     int shift = 17;
+    int output_shift = 6;
 
     for (i = 0; i < dstW; i++) {
         int val = 1 << (shift - 1);
@@ -495,7 +497,7 @@ static void yuv2p010lX_c(const int16_t *filter, int filterSize,
     }
 }
 
-static void yuv2p010cX_c(int big_endian, const uint8_t *chrDither,
+static void yuv2p010cX_c(int big_endian, int output_shift, const uint8_t *chrDither,
                          const int16_t *chrFilter, int chrFilterSize,
                          const int16_t **chrUSrc, const int16_t **chrVSrc,
                          uint8_t *dest8, int chrDstW)
@@ -551,7 +553,7 @@ static void yuv2p010cX_LE_c(enum AVPixelFormat dstFormat, const uint8_t *chrDith
                             const int16_t **chrUSrc, const int16_t **chrVSrc,
                             uint8_t *dest8, int chrDstW)
 {
-    yuv2p010cX_c(0, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
+    yuv2p010cX_c(0, 6, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
 }
 
 static void yuv2p010cX_BE_c(enum AVPixelFormat dstFormat, const uint8_t *chrDither,
@@ -559,7 +561,23 @@ static void yuv2p010cX_BE_c(enum AVPixelFormat dstFormat, const uint8_t *chrDith
                             const int16_t **chrUSrc, const int16_t **chrVSrc,
                             uint8_t *dest8, int chrDstW)
 {
-    yuv2p010cX_c(1, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
+    yuv2p010cX_c(1, 6, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
+}
+
+static void yuv2nv20cX_LE_c(enum AVPixelFormat dstFormat, const uint8_t *chrDither,
+                            const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest8, int chrDstW)
+{
+    yuv2p010cX_c(0, 0, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
+}
+
+static void yuv2nv20cX_BE_c(enum AVPixelFormat dstFormat, const uint8_t *chrDither,
+                            const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest8, int chrDstW)
+{
+    yuv2p010cX_c(1, 0, chrDither, chrFilter, chrFilterSize, chrUSrc, chrVSrc, dest8, chrDstW);
 }
 
 #undef output_pixel
@@ -2614,6 +2632,8 @@ av_cold void ff_sws_init_output_funcs(SwsContext *c,
         } else if (desc->comp[0].depth == 10) {
             *yuv2planeX = isBE(dstFormat) ? yuv2planeX_10BE_c  : yuv2planeX_10LE_c;
             *yuv2plane1 = isBE(dstFormat) ? yuv2plane1_10BE_c  : yuv2plane1_10LE_c;
+            if (isSemiPlanarYUV(dstFormat))
+                *yuv2nv12cX = isBE(dstFormat) ? yuv2nv20cX_BE_c : yuv2nv20cX_LE_c;
         } else if (desc->comp[0].depth == 12) {
             *yuv2planeX = isBE(dstFormat) ? yuv2planeX_12BE_c  : yuv2planeX_12LE_c;
             *yuv2plane1 = isBE(dstFormat) ? yuv2plane1_12BE_c  : yuv2plane1_12LE_c;
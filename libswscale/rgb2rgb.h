@@ -142,6 +142,27 @@ extern void (*deinterleaveBytes)(const uint8_t *src, uint8_t *dst1, uint8_t *dst
                                  int width, int height, int srcStride,
                                  int dst1Stride, int dst2Stride);
 
+/**
+ * Word versions of interleaveBytes() and deinterleaveBytes() for 16-bit
+ * semi-planar formats, in native endianness. Samples are shifted left by
+ * shift when interleaving and right by shift when deinterleaving.
+ * width is in samples and strides are in bytes.
+ */
+extern void (*interleaveWords)(const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                               int width, int height, int src1Stride,
+                               int src2Stride, int dstStride, int shift);
+
+extern void (*deinterleaveWords)(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                 int width, int height, int srcStride,
+                                 int dst1Stride, int dst2Stride, int shift);
+
+/**
+ * Copy a plane of native endian 16-bit samples, shifting them left by shift,
+ * or right by -shift if it is negative.
+ */
+extern void (*shiftWords)(const uint8_t *src, uint8_t *dst, int width, int height,
+                          int srcStride, int dstStride, int shift);
+
 extern void (*vu9_to_vu12)(const uint8_t *src1, const uint8_t *src2,
                            uint8_t *dst1, uint8_t *dst2,
                            int width, int height,
@@ -167,6 +188,13 @@ extern void (*yuyvtoyuv422)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst, const u
                             int width, int height,
                             int lumStride, int chromStride, int srcStride);
 
+/**
+ * Native endian Y210 to 10-bit YUV 4:2:2. width should be a multiple of 2.
+ */
+extern void (*y210toyuv422)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst, const uint8_t *src,
+                            int width, int height,
+                            int lumStride, int chromStride, int srcStride);
+
 void ff_sws_rgb2rgb_init(void);
 
 void rgb2rgb_init_aarch64(void);
@@ -123,9 +123,9 @@ static void hScale16To15_c(SwsContext *c, int16_t *dst, int dstW,
 }
 
 // bilinear / bicubic scaling
-static void hScale8To15_c(SwsContext *c, int16_t *dst, int dstW,
-                          const uint8_t *src, const int16_t *filter,
-                          const int32_t *filterPos, int filterSize)
+void ff_hscale8to15_c(SwsContext *c, int16_t *dst, int dstW,
+                      const uint8_t *src, const int16_t *filter,
+                      const int32_t *filterPos, int filterSize)
 {
     int i;
     for (i = 0; i < dstW; i++) {
@@ -570,7 +570,7 @@ static av_cold void sws_init_swscale(SwsContext *c)
 
     if (c->srcBpc == 8) {
         if (c->dstBpc <= 14) {
-            c->hyScale = c->hcScale = hScale8To15_c;
+            c->hyScale = c->hcScale = ff_hscale8to15_c;
             if (c->flags & SWS_FAST_BILINEAR) {
                 c->hyscale_fast = ff_hyscale_fast_c;
                 c->hcscale_fast = ff_hcscale_fast_c;
@@ -826,13 +826,102 @@ static int scale_internal(SwsContext *c,
                           uint8_t *const dstSlice[], const int dstStride[],
                           int dstSliceY, int dstSliceH);
 
+static void offset_lines(uint8_t *dst[4], uint8_t * const src[4],
+                         const int stride[4], int y)
+{
+    for (int i = 0; i < 4; i++)
+        dst[i] = src[i] ? src[i] + y * stride[i] : NULL;
+}
+
+/**
+ * Compute the range [*start, *end) of source lines read by c to produce the
+ * output lines [y, y + h), aligned to align.
+ */
+static void needed_src_lines(const SwsContext *c, int y, int h, int align,
+                             int *start, int *end)
+{
+    int last = y + h - 1;
+
+    if (c->convert_unscaled) {
+        *start = y;
+        *end   = y + h;
+    } else {
+        int chr_y    = y    >> c->chrDstVSubSample;
+        int chr_last = last >> c->chrDstVSubSample;
+
+        *start = FFMIN(c->vLumFilterPos[y],
+                       c->vChrFilterPos[chr_y] << c->chrSrcVSubSample);
+        *end   = FFMAX(c->vLumFilterPos[last] + c->vLumFilterSize,
+                       (c->vChrFilterPos[chr_last] + c->vChrFilterSize) << c->chrSrcVSubSample);
+    }
+    *start = FFMAX(*start, 0) & ~(align - 1);
+    *end   = FFMIN(FFALIGN(*end, align), c->srcH);
+}
+
+/**
+ * Linear light scaling of a part of the output, as done by the slice
+ * threads: each of the cascaded contexts only processes the lines needed
+ * for the output lines [dstSliceY, dstSliceY + dstSliceH).
+ */
+static int scale_gamma_dst_slice(SwsContext *c,
+                                 const uint8_t * const srcSlice[], const int srcStride[],
+                                 uint8_t * const dstSlice[], const int dstStride[],
+                                 int dstSliceY, int dstSliceH)
+{
+    SwsContext *c0 = c->cascaded_context[0];
+    SwsContext *c1 = c->cascaded_context[1];
+    SwsContext *c2 = c->cascaded_context[2];
+    int y1 = dstSliceY, h1 = dstSliceH;
+    int y0, end0, align, ret;
+    uint8_t *tmp[4], *tmp1[4];
+
+    if (c2) {
+        needed_src_lines(c2, dstSliceY, dstSliceH, 1, &y1, &end0);
+        h1 = end0 - y1;
+    }
+
+    align = FFMAX(c0->dst_slice_align,
+                  isBayer(c0->srcFormat) ? 2 : 1 << c0->chrSrcVSubSample);
+    needed_src_lines(c1, y1, h1, align, &y0, &end0);
+
+    offset_lines(tmp, c->cascaded_tmp, c->cascaded_tmpStride, y0);
+    ret = scale_internal(c0, srcSlice, srcStride, 0, c->srcH,
+                         tmp, c->cascaded_tmpStride, y0, end0 - y0);
+    if (ret < 0)
+        return ret;
+
+    if (!c2)
+        return scale_internal(c1, (const uint8_t * const *)tmp, c->cascaded_tmpStride,
+                              y0, end0 - y0, dstSlice, dstStride, dstSliceY, dstSliceH);
+
+    offset_lines(tmp1, c->cascaded1_tmp, c->cascaded1_tmpStride, y1);
+    ret = scale_internal(c1, (const uint8_t * const *)tmp, c->cascaded_tmpStride,
+                         y0, end0 - y0, tmp1, c->cascaded1_tmpStride, y1, h1);
+    if (ret < 0)
+        return ret;
+
+    // the unscaled converters only take dst slices of whole frames
+    if (c2->convert_unscaled)
+        return scale_internal(c2, (const uint8_t * const *)c->cascaded1_tmp,
+                              c->cascaded1_tmpStride, 0, c->dstH,
+                              dstSlice, dstStride, dstSliceY, dstSliceH);
+    return scale_internal(c2, (const uint8_t * const *)tmp1, c->cascaded1_tmpStride,
+                          y1, h1, dstSlice, dstStride, dstSliceY, dstSliceH);
+}
+
 static int scale_gamma(SwsContext *c,
                        const uint8_t * const srcSlice[], const int srcStride[],
                        int srcSliceY, int srcSliceH,
                        uint8_t * const dstSlice[], const int dstStride[],
                        int dstSliceY, int dstSliceH)
 {
-    int ret = scale_internal(c->cascaded_context[0],
+    int ret;
+
+    if (dstSliceY > 0 || dstSliceH < c->dstH)
+        return scale_gamma_dst_slice(c, srcSlice, srcStride, dstSlice, dstStride,
+                                     dstSliceY, dstSliceH);
+
+    ret = scale_internal(c->cascaded_context[0],
                              srcSlice, srcStride, srcSliceY, srcSliceH,
                              c->cascaded_tmp, c->cascaded_tmpStride, 0, c->srcH);
 
@@ -1042,6 +1131,10 @@ static int scale_internal(SwsContext *c,
                                   dst2, dstStride2);
         if (scale_dst)
             dst2[0] += dstSliceY * dstStride2[0];
+    } else if (c->fused_scale && !scale_dst && !c->lumConvertRange &&
+               srcSliceY_internal == 0 && srcSliceH == c->srcH) {
+        ret = c->fused_scale(c, src2, srcStride2, 0, srcSliceH,
+                             dst2, dstStride2);
     } else {
         ret = swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH,
                       dst2, dstStride2, dstSliceY, dstSliceH);
@@ -361,8 +361,8 @@ typedef struct SwsContext {
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
-    uint16_t *gamma;
-    uint16_t *inv_gamma;
+    uint16_t *gamma;              ///< coded to linear light table
+    uint16_t *inv_gamma;          ///< linear light to coded table
 
     int numDesc;
     int descIndex[2];
@@ -676,6 +676,29 @@ typedef struct SwsContext {
     unsigned int dst_slice_align;
     atomic_int   stride_unaligned_warned;
     atomic_int   data_unaligned_warned;
+
+    /**
+     * @name Fused scaler.
+     * Whole frames of a few common scaled conversions are done in a single
+     * pass per plane, without the slice and filter descriptor machinery.
+     * The fused scaler keeps its own ring buffers of scaled lines.
+     */
+    //@{
+    int fused;                    ///< Allow the fused scaler to be used.
+    SwsFunc fused_scale;          ///< Fused scaler, NULL if it can not be used for this conversion.
+    int16_t *fused_buf;           ///< Storage for the horizontally scaled lines.
+    int fused_buf_stride;         ///< Length of one scaled line in fused_buf, in int16_t.
+    int fused_buf_lines;          ///< Number of lines in each of the two rings in fused_buf.
+    //@}
+
+    /**
+     * @name Linear light scaling.
+     * With gamma_flag set, the scaling is done on RGBA64 linearized with
+     * the transfer characteristic gamma_trc.
+     */
+    //@{
+    int gamma_trc;                ///< Transfer characteristic, AVCOL_TRC_UNSPECIFIED for a gamma_value power law.
+    //@}
 } SwsContext;
 //FIXME check init (where 0)
 
@@ -956,6 +979,12 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
 
 void ff_sws_init_scale(SwsContext *c);
 
+/**
+ * Set up c->fused_scale if the fused scaler supports the conversion.
+ * Must be called once the filters are initialized.
+ */
+int ff_sws_init_fused(SwsContext *c);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
@@ -971,6 +1000,10 @@ void ff_sws_init_swscale_x86(SwsContext *c);
 void ff_sws_init_swscale_aarch64(SwsContext *c);
 void ff_sws_init_swscale_arm(SwsContext *c);
 
+void ff_hscale8to15_c(SwsContext *c, int16_t *dst, int dstW,
+                      const uint8_t *src, const int16_t *filter,
+                      const int32_t *filterPos, int filterSize);
+
 void ff_hyscale_fast_c(SwsContext *c, int16_t *dst, int dstWidth,
                        const uint8_t *src, int srcW, int xInc);
 void ff_hcscale_fast_c(SwsContext *c, int16_t *dst1, int16_t *dst2,
@@ -1115,6 +1148,14 @@ int ff_rotate_slice(SwsSlice *s, int lum, int chr);
 /// initializes gamma conversion descriptor
 int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *table);
 
+/**
+ * Allocate a 65536 entry table mapping 16 bit coded values to linear light
+ * (to_linear set) or back. gamma is the exponent used when trc is not one of
+ * the supported transfer characteristics.
+ */
+uint16_t *ff_alloc_gamma_table(enum AVColorTransferCharacteristic trc,
+                               double gamma, int to_linear);
+
 /// initializes lum pixel format conversion descriptor
 int ff_init_desc_fmt_convert(SwsFilterDescriptor *desc, SwsSlice * src, SwsSlice *dst, uint32_t *pal);
 
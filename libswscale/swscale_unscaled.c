@@ -144,16 +144,18 @@ static int planarToNv12Wrapper(SwsContext *c, const uint8_t *src[],
                                int srcSliceH, uint8_t *dstParam[],
                                int dstStride[])
 {
-    uint8_t *dst = dstParam[1] + dstStride[1] * srcSliceY / 2;
+    const int vsub = c->chrDstVSubSample;
+    const int chrSliceH = AV_CEIL_RSHIFT(srcSliceH, vsub);
+    uint8_t *dst = dstParam[1] + dstStride[1] * (srcSliceY >> vsub);
 
     copyPlane(src[0], srcStride[0], srcSliceY, srcSliceH, c->srcW,
               dstParam[0], dstStride[0]);
 
-    if (c->dstFormat == AV_PIX_FMT_NV12)
-        interleaveBytes(src[1], src[2], dst, c->chrSrcW, (srcSliceH + 1) / 2,
+    if (c->dstFormat == AV_PIX_FMT_NV12 || c->dstFormat == AV_PIX_FMT_NV16)
+        interleaveBytes(src[1], src[2], dst, c->chrSrcW, chrSliceH,
                         srcStride[1], srcStride[2], dstStride[1]);
     else
-        interleaveBytes(src[2], src[1], dst, c->chrSrcW, (srcSliceH + 1) / 2,
+        interleaveBytes(src[2], src[1], dst, c->chrSrcW, chrSliceH,
                         srcStride[2], srcStride[1], dstStride[1]);
 
     return srcSliceH;
@@ -164,17 +166,19 @@ static int nv12ToPlanarWrapper(SwsContext *c, const uint8_t *src[],
                                int srcSliceH, uint8_t *dstParam[],
                                int dstStride[])
 {
-    uint8_t *dst1 = dstParam[1] + dstStride[1] * srcSliceY / 2;
-    uint8_t *dst2 = dstParam[2] + dstStride[2] * srcSliceY / 2;
+    const int vsub = c->chrSrcVSubSample;
+    const int chrSliceH = AV_CEIL_RSHIFT(srcSliceH, vsub);
+    uint8_t *dst1 = dstParam[1] + dstStride[1] * (srcSliceY >> vsub);
+    uint8_t *dst2 = dstParam[2] + dstStride[2] * (srcSliceY >> vsub);
 
     copyPlane(src[0], srcStride[0], srcSliceY, srcSliceH, c->srcW,
               dstParam[0], dstStride[0]);
 
-    if (c->srcFormat == AV_PIX_FMT_NV12)
-        deinterleaveBytes(src[1], dst1, dst2, c->chrSrcW, (srcSliceH + 1) / 2,
+    if (c->srcFormat == AV_PIX_FMT_NV12 || c->srcFormat == AV_PIX_FMT_NV16)
+        deinterleaveBytes(src[1], dst1, dst2, c->chrSrcW, chrSliceH,
                           srcStride[1], dstStride[1], dstStride[2]);
     else
-        deinterleaveBytes(src[1], dst2, dst1, c->chrSrcW, (srcSliceH + 1) / 2,
+        deinterleaveBytes(src[1], dst2, dst1, c->chrSrcW, chrSliceH,
                           srcStride[1], dstStride[2], dstStride[1]);
 
     return srcSliceH;
@@ -221,53 +225,58 @@ static int nv24ToPlanarWrapper(SwsContext *c, const uint8_t *src[],
     return srcSliceH;
 }
 
-static int planarToP01xWrapper(SwsContext *c, const uint8_t *src8[],
-                               int srcStride[], int srcSliceY,
-                               int srcSliceH, uint8_t *dstParam8[],
-                               int dstStride[])
+static int planar16ToSemiPlanarWrapper(SwsContext *c, const uint8_t *src[],
+                                       int srcStride[], int srcSliceY,
+                                       int srcSliceH, uint8_t *dstParam[],
+                                       int dstStride[])
 {
     const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
     const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
-    const uint16_t **src = (const uint16_t**)src8;
-    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
-    uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
-    int x, y;
+    const int vsub = c->chrDstVSubSample;
+    uint8_t *dstY  = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstUV = dstParam[1] + dstStride[1] * (srcSliceY >> vsub);
 
     /* Calculate net shift required for values. */
-    const int shift[3] = {
+    const int shift[2] = {
         dst_format->comp[0].depth + dst_format->comp[0].shift -
         src_format->comp[0].depth - src_format->comp[0].shift,
         dst_format->comp[1].depth + dst_format->comp[1].shift -
         src_format->comp[1].depth - src_format->comp[1].shift,
-        dst_format->comp[2].depth + dst_format->comp[2].shift -
-        src_format->comp[2].depth - src_format->comp[2].shift,
     };
 
     av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
                  dstStride[0] % 2 || dstStride[1] % 2));
 
-    for (y = 0; y < srcSliceH; y++) {
-        uint16_t *tdstY = dstY;
-        const uint16_t *tsrc0 = src[0];
-        for (x = c->srcW; x > 0; x--) {
-            *tdstY++ = *tsrc0++ << shift[0];
-        }
-        src[0] += srcStride[0] / 2;
-        dstY += dstStride[0] / 2;
+    shiftWords(src[0], dstY, c->srcW, srcSliceH,
+               srcStride[0], dstStride[0], shift[0]);
+    interleaveWords(src[1], src[2], dstUV, c->chrSrcW,
+                    AV_CEIL_RSHIFT(srcSliceH, vsub),
+                    srcStride[1], srcStride[2], dstStride[1], shift[1]);
 
-        if (!(y & 1)) {
-            uint16_t *tdstUV = dstUV;
-            const uint16_t *tsrc1 = src[1];
-            const uint16_t *tsrc2 = src[2];
-            for (x = c->srcW / 2; x > 0; x--) {
-                *tdstUV++ = *tsrc1++ << shift[1];
-                *tdstUV++ = *tsrc2++ << shift[2];
-            }
-            src[1] += srcStride[1] / 2;
-            src[2] += srcStride[2] / 2;
-            dstUV += dstStride[1] / 2;
-        }
-    }
+    return srcSliceH;
+}
+
+static int semiPlanar16ToPlanarWrapper(SwsContext *c, const uint8_t *src[],
+                                       int srcStride[], int srcSliceY,
+                                       int srcSliceH, uint8_t *dstParam[],
+                                       int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const int vsub = c->chrSrcVSubSample;
+    uint8_t *dstY = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstU = dstParam[1] + dstStride[1] * (srcSliceY >> vsub);
+    uint8_t *dstV = dstParam[2] + dstStride[2] * (srcSliceY >> vsub);
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    /* The samples of the semi-planar formats may be in the high bits. */
+    shiftWords(src[0], dstY, c->srcW, srcSliceH,
+               srcStride[0], dstStride[0], -src_format->comp[0].shift);
+    deinterleaveWords(src[1], dstU, dstV, c->chrSrcW,
+                      AV_CEIL_RSHIFT(srcSliceH, vsub),
+                      srcStride[1], dstStride[1], dstStride[2],
+                      src_format->comp[1].shift);
 
     return srcSliceH;
 }
@@ -433,6 +442,20 @@ static int uyvyToYuv422Wrapper(SwsContext *c, const uint8_t *src[],
     return srcSliceH;
 }
 
+static int y210ToYuv422p10Wrapper(SwsContext *c, const uint8_t *src[],
+                                  int srcStride[], int srcSliceY, int srcSliceH,
+                                  uint8_t *dstParam[], int dstStride[])
+{
+    uint8_t *ydst = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *udst = dstParam[1] + dstStride[1] * srcSliceY;
+    uint8_t *vdst = dstParam[2] + dstStride[2] * srcSliceY;
+
+    y210toyuv422(ydst, udst, vdst, src[0], c->srcW, srcSliceH, dstStride[0],
+                 dstStride[1], srcStride[0]);
+
+    return srcSliceH;
+}
+
 static void gray8aToPacked32(const uint8_t *src, uint8_t *dst, int num_pixels,
                              const uint8_t *palette)
 {
@@ -1971,6 +1994,22 @@ static int planarCopyWrapper(SwsContext *c, const uint8_t *src[],
      (src_fmt == pix_fmt ## LE && dst_fmt == pix_fmt ## BE))
 
 
+/* Planar and semi-planar YUV formats with the same subsampling and more than
+ * 8 bits per sample, in native endianness. */
+static int isSemiPlanar16Pair(enum AVPixelFormat planar,
+                              enum AVPixelFormat semi_planar)
+{
+    const AVPixFmtDescriptor *p = av_pix_fmt_desc_get(planar);
+    const AVPixFmtDescriptor *s = av_pix_fmt_desc_get(semi_planar);
+
+    return isPlanarYUV(planar) && !isSemiPlanarYUV(planar) &&
+           isSemiPlanarYUV(semi_planar) && p->nb_components == 3 &&
+           p->comp[0].depth > 8 && p->comp[0].depth == s->comp[0].depth &&
+           p->log2_chroma_w == s->log2_chroma_w &&
+           p->log2_chroma_h == s->log2_chroma_h &&
+           isBE(planar) == HAVE_BIGENDIAN && isBE(semi_planar) == HAVE_BIGENDIAN;
+}
+
 void ff_get_unscaled_swscale(SwsContext *c)
 {
     const enum AVPixelFormat srcFormat = c->srcFormat;
@@ -1999,6 +2038,12 @@ void ff_get_unscaled_swscale(SwsContext *c)
         (srcFormat == AV_PIX_FMT_NV12 || srcFormat == AV_PIX_FMT_NV21)) {
         c->convert_unscaled = nv12ToPlanarWrapper;
     }
+    /* yuv422p_to_nv16 */
+    if (srcFormat == AV_PIX_FMT_YUV422P && dstFormat == AV_PIX_FMT_NV16)
+        c->convert_unscaled = planarToNv12Wrapper;
+    /* nv16_to_yuv422p */
+    if (srcFormat == AV_PIX_FMT_NV16 && dstFormat == AV_PIX_FMT_YUV422P)
+        c->convert_unscaled = nv12ToPlanarWrapper;
     /* nv24_to_yv24 */
     if (dstFormat == AV_PIX_FMT_YUV444P &&
         (srcFormat == AV_PIX_FMT_NV24 || srcFormat == AV_PIX_FMT_NV42)) {
@@ -2017,8 +2062,18 @@ void ff_get_unscaled_swscale(SwsContext *c)
          srcFormat == AV_PIX_FMT_YUV420P14 ||
          srcFormat == AV_PIX_FMT_YUV420P16 || srcFormat == AV_PIX_FMT_YUVA420P16) &&
         (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016)) {
-        c->convert_unscaled = planarToP01xWrapper;
+        c->convert_unscaled = planar16ToSemiPlanarWrapper;
     }
+    /* yuv4xxp1x_to_p{0,2,4}1x, yuv422p10_to_nv20 */
+    if (isSemiPlanar16Pair(srcFormat, dstFormat))
+        c->convert_unscaled = planar16ToSemiPlanarWrapper;
+    /* p{0,2,4}1x_to_yuv4xxp1x, nv20_to_yuv422p10 */
+    if (isSemiPlanar16Pair(dstFormat, srcFormat))
+        c->convert_unscaled = semiPlanar16ToPlanarWrapper;
+    /* y210_to_yuv422p10 */
+    if (srcFormat == AV_PIX_FMT_Y210 && dstFormat == AV_PIX_FMT_YUV422P10 &&
+        !(c->srcW & 1))
+        c->convert_unscaled = y210ToYuv422p10Wrapper;
     /* yuv420p_to_p01xle */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
         (dstFormat == AV_PIX_FMT_P010LE || dstFormat == AV_PIX_FMT_P016LE)) {
@@ -0,0 +1,161 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Checks that the fused scaler gives the same output as the generic one,
+ * and with -b <iterations>, measures both of them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+static const struct {
+    enum AVPixelFormat src_fmt, dst_fmt;
+    int src_w, src_h, dst_w, dst_h;
+    int flags;
+} tests[] = {
+    { AV_PIX_FMT_YUV420P,  AV_PIX_FMT_YUV420P, 1920, 1080, 1280, 720, SWS_BICUBIC  },
+    { AV_PIX_FMT_YUV420P,  AV_PIX_FMT_YUV420P, 1920, 1080,  854, 480, SWS_BICUBIC  },
+    { AV_PIX_FMT_YUV420P,  AV_PIX_FMT_YUV420P, 1280,  720, 1920, 1080, SWS_BILINEAR },
+    { AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_YUVJ422P, 720,  576,  352, 288, SWS_LANCZOS  },
+    { AV_PIX_FMT_YUV444P,  AV_PIX_FMT_YUV444P,  352,  288,  641, 479, SWS_POINT    },
+    { AV_PIX_FMT_GRAY8,    AV_PIX_FMT_GRAY8,    640,  480,  320, 240, SWS_AREA     },
+    { AV_PIX_FMT_YUV420P,  AV_PIX_FMT_YUV420P,   64,    6,   33,   2, SWS_LANCZOS  },
+    { AV_PIX_FMT_P010LE,   AV_PIX_FMT_YUV420P, 1920, 1080, 1280, 720, SWS_BICUBIC  },
+    { AV_PIX_FMT_P010BE,   AV_PIX_FMT_YUV420P, 1280,  720,  854, 480, SWS_BICUBIC  },
+};
+
+static struct SwsContext *alloc_context(int i, int fused)
+{
+    struct SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    av_opt_set_int(c, "srcw",       tests[i].src_w,   0);
+    av_opt_set_int(c, "srch",       tests[i].src_h,   0);
+    av_opt_set_int(c, "src_format", tests[i].src_fmt, 0);
+    av_opt_set_int(c, "dstw",       tests[i].dst_w,   0);
+    av_opt_set_int(c, "dsth",       tests[i].dst_h,   0);
+    av_opt_set_int(c, "dst_format", tests[i].dst_fmt, 0);
+    av_opt_set_int(c, "sws_flags",  tests[i].flags | SWS_ACCURATE_RND | SWS_BITEXACT, 0);
+    av_opt_set_int(c, "fused",      fused, 0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+    return c;
+}
+
+static int64_t bench(struct SwsContext *c, int iterations, int h,
+                     uint8_t *src[4], int src_stride[4],
+                     uint8_t *dst[4], int dst_stride[4])
+{
+    int64_t t = av_gettime_relative();
+
+    for (int n = 0; n < iterations; n++)
+        sws_scale(c, (const uint8_t * const *)src, src_stride, 0, h, dst, dst_stride);
+    return av_gettime_relative() - t;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 0, ret = 0;
+    AVLFG rand;
+
+    if (argc == 3 && !strcmp(argv[1], "-b"))
+        iterations = atoi(argv[2]);
+
+    av_lfg_init(&rand, 1);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(tests[i].dst_fmt);
+        struct SwsContext *generic = alloc_context(i, 0);
+        struct SwsContext *fused   = alloc_context(i, 1);
+        uint8_t *src[4], *dst0[4], *dst1[4];
+        int src_stride[4], dst_stride[4];
+        int src_size, mismatch = 0;
+
+        if (!generic || !fused) {
+            fprintf(stderr, "Failed to create the scalers for test %d\n", i);
+            return 1;
+        }
+
+        src_size = av_image_alloc(src, src_stride, tests[i].src_w, tests[i].src_h,
+                                  tests[i].src_fmt, 64);
+        if (src_size < 0 ||
+            av_image_alloc(dst0, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                           tests[i].dst_fmt, 64) < 0 ||
+            av_image_alloc(dst1, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                           tests[i].dst_fmt, 64) < 0) {
+            fprintf(stderr, "Failed to allocate the pictures for test %d\n", i);
+            return 1;
+        }
+        for (int j = 0; j < src_size; j++)
+            src[0][j] = av_lfg_get(&rand);
+
+        sws_scale(generic, (const uint8_t * const *)src, src_stride, 0,
+                  tests[i].src_h, dst0, dst_stride);
+        sws_scale(fused, (const uint8_t * const *)src, src_stride, 0,
+                  tests[i].src_h, dst1, dst_stride);
+
+        for (int p = 0; p < desc->nb_components; p++) {
+            int w = p == 1 || p == 2 ? AV_CEIL_RSHIFT(tests[i].dst_w, desc->log2_chroma_w)
+                                     : tests[i].dst_w;
+            int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(tests[i].dst_h, desc->log2_chroma_h)
+                                     : tests[i].dst_h;
+            for (int y = 0; y < h; y++)
+                mismatch |= memcmp(dst0[p] + y * dst_stride[p],
+                                   dst1[p] + y * dst_stride[p], w);
+        }
+
+        printf("%s %dx%d -> %s %dx%d: %s, %s\n",
+               av_get_pix_fmt_name(tests[i].src_fmt), tests[i].src_w, tests[i].src_h,
+               av_get_pix_fmt_name(tests[i].dst_fmt), tests[i].dst_w, tests[i].dst_h,
+               fused->fused_scale ? "fused" : "generic",
+               mismatch ? "MISMATCH" : "ok");
+        ret |= mismatch;
+
+        if (iterations > 0) {
+            int64_t t0 = bench(generic, iterations, tests[i].src_h,
+                               src, src_stride, dst0, dst_stride);
+            int64_t t1 = bench(fused, iterations, tests[i].src_h,
+                               src, src_stride, dst1, dst_stride);
+            printf("    generic %8.3f ms, fused %8.3f ms per frame\n",
+                   t0 / 1000.0 / iterations, t1 / 1000.0 / iterations);
+        }
+
+        av_freep(&src[0]);
+        av_freep(&dst0[0]);
+        av_freep(&dst1[0]);
+        sws_freeContext(generic);
+        sws_freeContext(fused);
+    }
+
+    return ret;
+}
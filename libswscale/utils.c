@@ -263,6 +263,9 @@ static const FormatEntry format_entries[] = {
     [AV_PIX_FMT_YUVA422P12LE] = { 1, 1 },
     [AV_PIX_FMT_YUVA444P12BE] = { 1, 1 },
     [AV_PIX_FMT_YUVA444P12LE] = { 1, 1 },
+    [AV_PIX_FMT_NV16]        = { 1, 1 },
+    [AV_PIX_FMT_NV20LE]      = { 1, 1 },
+    [AV_PIX_FMT_NV20BE]      = { 1, 1 },
     [AV_PIX_FMT_NV24]        = { 1, 1 },
     [AV_PIX_FMT_NV42]        = { 1, 1 },
     [AV_PIX_FMT_Y210LE]      = { 1, 0 },
@@ -976,6 +979,16 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->dstFormatBpp = av_get_bits_per_pixel(desc_dst);
     c->srcFormatBpp = av_get_bits_per_pixel(desc_src);
 
+    if (c->gamma_flag && c->cascaded_context[0]) {
+        // the source matrix is used by the first context, the destination one by the last
+        int ret = sws_setColorspaceDetails(c->cascaded_context[0], inv_table, srcRange,
+                                           table, dstRange, brightness, contrast, saturation);
+        if (ret >= 0 && c->cascaded_context[2])
+            ret = sws_setColorspaceDetails(c->cascaded_context[2], inv_table, srcRange,
+                                           table, dstRange, brightness, contrast, saturation);
+        return ret;
+    }
+
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
@@ -1176,20 +1189,6 @@ SwsContext *sws_alloc_context(void)
     return c;
 }
 
-static uint16_t * alloc_gamma_tbl(double e)
-{
-    int i = 0;
-    uint16_t * tbl;
-    tbl = (uint16_t*)av_malloc(sizeof(uint16_t) * 1 << 16);
-    if (!tbl)
-        return NULL;
-
-    for (i = 0; i < 65536; ++i) {
-        tbl[i] = pow(i / 65535.0, e) * 65535.0;
-    }
-    return tbl;
-}
-
 static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
 {
     switch(fmt) {
@@ -1623,6 +1622,10 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     c->gamma_value = 2.2;
     tmpFmt = AV_PIX_FMT_RGBA64LE;
 
+    // choosing a transfer characteristic implies linear light scaling
+    if (c->gamma_trc != AVCOL_TRC_UNSPECIFIED)
+        c->gamma_flag = 1;
+
 
     if (!unscaled && c->gamma_flag && (srcFormat != tmpFmt || dstFormat != tmpFmt)) {
         SwsContext *c2;
@@ -1649,8 +1652,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 
         c2 = c->cascaded_context[1];
         c2->is_internal_gamma = 1;
-        c2->gamma     = alloc_gamma_tbl(    c->gamma_value);
-        c2->inv_gamma = alloc_gamma_tbl(1.f/c->gamma_value);
+        c2->gamma     = ff_alloc_gamma_table(c->gamma_trc, c->gamma_value, 1);
+        c2->inv_gamma = ff_alloc_gamma_table(c->gamma_trc, c->gamma_value, 0);
         if (!c2->gamma || !c2->inv_gamma)
             return AVERROR(ENOMEM);
 
@@ -1676,6 +1679,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                                                 flags, NULL, NULL, c->param);
             if (!c->cascaded_context[2])
                 return AVERROR(ENOMEM);
+            c->dst_slice_align = FFMAX(c->dst_slice_align,
+                                       c->cascaded_context[2]->dst_slice_align);
         }
         return 0;
     }
@@ -1999,7 +2004,11 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
 
     ff_sws_init_scale(c);
 
-    return ff_init_filters(c);
+    ret = ff_init_filters(c);
+    if (ret < 0)
+        return ret;
+
+    return ff_sws_init_fused(c);
 nomem:
     ret = AVERROR(ENOMEM);
 fail: // FIXME replace things by appropriate error codes
@@ -2447,6 +2456,7 @@ void sws_freeContext(SwsContext *c)
 
     av_freep(&c->yuvTable);
     av_freep(&c->formatConvBuffer);
+    av_freep(&c->fused_buf);
 
     sws_freeContext(c->cascaded_context[0]);
     sws_freeContext(c->cascaded_context[1]);
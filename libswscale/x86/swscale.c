@@ -567,6 +567,7 @@ switch(c->dstBpc){ \
             c->chrToYV12 = ff_uyvyToUV_mmx;
             break;
         case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV16:
             c->chrToYV12 = ff_nv12ToUV_mmx;
             break;
         case AV_PIX_FMT_NV21:
@@ -616,6 +617,7 @@ switch(c->dstBpc){ \
             c->chrToYV12 = ff_uyvyToUV_sse2;
             break;
         case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV16:
             c->chrToYV12 = ff_nv12ToUV_sse2;
             break;
         case AV_PIX_FMT_NV21:
@@ -665,6 +667,7 @@ switch(c->dstBpc){ \
             c->chrToYV12 = ff_uyvyToUV_avx;
             break;
         case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV16:
             c->chrToYV12 = ff_nv12ToUV_avx;
             break;
         case AV_PIX_FMT_NV21:
@@ -701,6 +704,7 @@ switch(c->dstBpc){ \
     if (EXTERNAL_AVX2_FAST(cpu_flags)) {
         switch (c->dstFormat) {
         case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV16:
         case AV_PIX_FMT_NV24:
             c->yuv2nv12cX = ff_yuv2nv12cX_avx2;
             break;
@@ -41,6 +41,7 @@
 
 static const int check_lens[] = {
     2, 4, 8, 16, 32, 64, 1024, 16384,
+    17, 31, /* Bluestein */
 };
 
 static AVTXContext *tx_refs[6 /*AVTXType*/][FF_ARRAY_ELEMS(check_lens)];
@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixelutils.h"
+
+#define MAX_BITS 6
+#define STRIDE   (2 << MAX_BITS)
+#define BUF_SIZE (STRIDE << MAX_BITS)
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j++)        \
+            buf[j] = rnd() & 0xFF;        \
+    } while (0)
+
+void checkasm_check_pixelutils(void)
+{
+    /* aligned: 0 = both unaligned, 1 = src1 aligned, 2 = both aligned */
+    static const char *const align_names[] = { "u", "au", "a" };
+    DECLARE_ALIGNED(64, static uint8_t, src1)[BUF_SIZE];
+    DECLARE_ALIGNED(64, static uint8_t, src2)[BUF_SIZE];
+    int bits, aligned;
+
+    declare_func(int, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2);
+
+    for (bits = 1; bits <= MAX_BITS; bits++) {
+        for (aligned = 0; aligned < 3; aligned++) {
+            av_pixelutils_sad_fn fn = av_pixelutils_get_sad_fn(bits, bits, aligned, NULL);
+            const uint8_t *b1 = src1 + (aligned < 1);
+            const uint8_t *b2 = src2 + (aligned < 2);
+            int ref, new;
+
+            if (!fn)
+                continue;
+            if (check_func(fn, "sad_%dx%d_%s", 1 << bits, 1 << bits,
+                           align_names[aligned])) {
+                randomize_buffers(src1, BUF_SIZE);
+                randomize_buffers(src2, BUF_SIZE);
+                ref = call_ref(b1, STRIDE, b2, STRIDE);
+                new = call_new(b1, STRIDE, b2, STRIDE);
+                if (ref != new)
+                    fail();
+
+                /* maximum SAD, to catch overflows of the accumulators */
+                memset(src1, 0xFF, BUF_SIZE);
+                memset(src2, 0x00, BUF_SIZE);
+                ref = call_ref(b1, STRIDE, b2, STRIDE);
+                new = call_new(b1, STRIDE, b2, STRIDE);
+                if (ref != new)
+                    fail();
+
+                bench_new(b1, STRIDE, b2, STRIDE);
+            }
+        }
+        report("sad_%dx%d", 1 << bits, 1 << bits);
+    }
+}
@@ -171,6 +171,16 @@ md5(){
     do_md5sum $encfile | awk '{print $1}'
 }
 
+tee_muxer(){
+    tee_opts=$1
+    shift
+    out1="${outdir}/${test}.1.framecrc"
+    out2="${outdir}/${test}.2.framecrc"
+    cleanfiles="$cleanfiles $out1 $out2"
+    ffmpeg -y "$@" -bitexact $tee_opts -f tee "[f=framecrc]$(target_path $out1)|[f=framecrc:select=v:bsfs/v=dump_extra]$(target_path $out2)" || return
+    cat $out1 $out2
+}
+
 pcm(){
     ffmpeg -auto_conversion_filters "$@" -vn -f s16le -
 }
@@ -509,6 +519,13 @@ venc_data(){
     run tools/venc_data_dump${EXECSUF} ${file} ${stream} ${frames} ${threads} ${thread_type}
 }
 
+seek_index(){
+    file=$1
+    index=$outdir/$test.idx
+    run tools/seekindex${EXECSUF} ${file} $(target_path $index) || return
+    run libavformat/tests/seek${EXECSUF} ${file} -seek_index $(target_path $index)
+}
+
 null(){
     :
 }
@@ -219,6 +219,15 @@ fate-ffmpeg-bsf-remove-e: CMD = transcode "mpeg" $(TARGET_SAMPLES)/mpeg2/matrixb
 
 FATE_SAMPLES_FFMPEG-yes += $(FATE_STREAMCOPY-yes)
 
+# the slave threads must not change the output
+FATE_TEE-$(call ALLYES, TEE_MUXER FRAMECRC_MUXER LAVFI_INDEV TESTSRC2_FILTER SINE_FILTER \
+                        MPEG4_ENCODER PCM_S16LE_ENCODER DUMP_EXTRADATA_BSF) += fate-tee-sync fate-tee-threads
+fate-tee-sync:    CMD = tee_muxer "" -f lavfi -i testsrc2=d=1:s=64x48:r=25 -f lavfi -i sine=d=1 -map 0 -map 1 -pix_fmt yuv420p -c:v mpeg4 -g 10 -flags:v +global_header -c:a pcm_s16le -cpuflags 0
+fate-tee-threads: CMD = tee_muxer "-use_threads 1 -queue_size 2" -f lavfi -i testsrc2=d=1:s=64x48:r=25 -f lavfi -i sine=d=1 -map 0 -map 1 -pix_fmt yuv420p -c:v mpeg4 -g 10 -flags:v +global_header -c:a pcm_s16le -cpuflags 0
+fate-tee-threads: REF = $(SRC_PATH)/tests/ref/fate/tee-sync
+
+FATE_FFMPEG += $(FATE_TEE-yes)
+
 FATE_TIME_BASE-$(call ALLYES, MPEGPS_DEMUXER MXF_MUXER) += fate-time_base
 fate-time_base: $(SAMPLES)/mpeg2/dvd_single_frame.vob
 fate-time_base: CMD = md5 -i $(TARGET_SAMPLES)/mpeg2/dvd_single_frame.vob -an -sn -c:v copy -r 25 -time_base 1001:30000 -fflags +bitexact -f mxf
@@ -41,6 +41,19 @@ fate-hls-live-endlist: CMD = md5 -i $(SRC) -af hdcd=process_stereo=false -t 20 -
 fate-hls-live-endlist: CMP = oneline
 fate-hls-live-endlist: REF = e189ce781d9c87882f58e3929455167b
 
+# segments downloaded in the background must give the same output
+FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-prefetch
+fate-hls-prefetch: tests/data/live_endlist.m3u8
+fate-hls-prefetch: SRC = $(TARGET_PATH)/tests/data/live_endlist.m3u8
+fate-hls-prefetch: CMD = md5 -prefetch_segments 3 -i $(SRC) -af hdcd=process_stereo=false -t 20 -f s24le
+fate-hls-prefetch: CMP = oneline
+fate-hls-prefetch: REF = e189ce781d9c87882f58e3929455167b
+
+# the seek drops the segments prefetched from the start
+FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-prefetch-seek
+fate-hls-prefetch-seek: tests/data/live_endlist.m3u8
+fate-hls-prefetch-seek: CMD = framecrc -prefetch_segments 3 -ss 7 -i $(TARGET_PATH)/tests/data/live_endlist.m3u8 -c copy
+
 tests/data/hls_segment_size.m3u8: TAG = GEN
 tests/data/hls_segment_size.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
@@ -97,6 +110,24 @@ FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILT
 fate-hls-fmp4: tests/data/hls_fmp4.m3u8
 fate-hls-fmp4: CMD = framecrc -auto_conversion_filters -flags +bitexact -i $(TARGET_PATH)/tests/data/hls_fmp4.m3u8 -vf setpts=N*23
 
+tests/data/hls_ll.m3u8: TAG = GEN
+tests/data/hls_ll.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=7" -map 0 -codec:a mp2fixed \
+	-hls_segment_type fmp4 -hls_fmp4_init_filename hls_ll_init.mp4 -hls_list_size 0 \
+	-hls_time 2 -hls_part_time 0.5 -hls_flags omit_endlist \
+	-hls_segment_filename "$(TARGET_PATH)/tests/data/hls_ll_%d.m4s" \
+	$(TARGET_PATH)/tests/data/hls_ll.m3u8 2>/dev/null
+
+FATE_HLSENC-$(call ALLYES, HLS_MUXER MP4_MUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-ll-playlist
+fate-hls-ll-playlist: tests/data/hls_ll.m3u8
+fate-hls-ll-playlist: CMD = cat $(TARGET_PATH)/tests/data/hls_ll.m3u8
+
+# the playlist has no EXT-X-ENDLIST, so reading starts PART-HOLD-BACK from its end
+FATE_HLSENC-$(call ALLYES, HLS_MUXER MP4_MUXER HLS_DEMUXER MOV_DEMUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-ll-live
+fate-hls-ll-live: tests/data/hls_ll.m3u8
+fate-hls-ll-live: CMD = framecrc -m3u8_hold_counters 2 -i $(TARGET_PATH)/tests/data/hls_ll.m3u8 -c copy
+
 tests/data/hls_fmp4_ac3.m3u8: TAG = GEN
 tests/data/hls_fmp4_ac3.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
@@ -51,6 +51,16 @@ fate-h264-levels: libavcodec/tests/h264_levels$(EXESUF)
 fate-h264-levels: CMD = run libavcodec/tests/h264_levels$(EXESUF)
 fate-h264-levels: REF = /dev/null
 
+FATE_LIBAVCODEC-$(CONFIG_H264_METADATA_BSF) += fate-h264-metadata-multi-sps
+fate-h264-metadata-multi-sps: libavcodec/tests/h264_metadata$(EXESUF)
+fate-h264-metadata-multi-sps: CMD = run libavcodec/tests/h264_metadata$(EXESUF)
+fate-h264-metadata-multi-sps: REF = /dev/null
+
+FATE_LIBAVCODEC-$(CONFIG_H264_DECODER) += fate-h264-thumbnail
+fate-h264-thumbnail: libavcodec/tests/h264_thumbnail$(EXESUF)
+fate-h264-thumbnail: CMD = run libavcodec/tests/h264_thumbnail$(EXESUF)
+fate-h264-thumbnail: REF = /dev/null
+
 FATE_LIBAVCODEC-$(CONFIG_HEVC_METADATA_BSF) += fate-h265-levels
 fate-h265-levels: libavcodec/tests/h265_levels$(EXESUF)
 fate-h265-levels: CMD = run libavcodec/tests/h265_levels$(EXESUF)
@@ -70,6 +80,11 @@ fate-rangecoder: libavcodec/tests/rangecoder$(EXESUF)
 fate-rangecoder: CMD = run libavcodec/tests/rangecoder$(EXESUF)
 fate-rangecoder: CMP = null
 
+FATE_LIBAVCODEC-$(CONFIG_H264PARSE) += fate-startcode
+fate-startcode: libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMD = run libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMP = null
+
 FATE_LIBAVCODEC-yes += fate-mathops
 fate-mathops: libavcodec/tests/mathops$(EXESUF)
 fate-mathops: CMD = run libavcodec/tests/mathops$(EXESUF)
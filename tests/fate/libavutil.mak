@@ -144,6 +144,11 @@ FATE_LIBAVUTIL += fate-sha512
 fate-sha512: libavutil/tests/sha512$(EXESUF)
 fate-sha512: CMD = run libavutil/tests/sha512$(EXESUF)
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-threadmessage
+fate-threadmessage: libavutil/tests/threadmessage$(EXESUF)
+fate-threadmessage: CMD = run libavutil/tests/threadmessage$(EXESUF)
+fate-threadmessage: CMP = null
+
 FATE_LIBAVUTIL += fate-tree
 fate-tree: libavutil/tests/tree$(EXESUF)
 fate-tree: CMD = run libavutil/tests/tree$(EXESUF)
@@ -154,6 +159,11 @@ fate-twofish: libavutil/tests/twofish$(EXESUF)
 fate-twofish: CMD = run libavutil/tests/twofish$(EXESUF)
 fate-twofish: CMP = null
 
+FATE_LIBAVUTIL += fate-tx
+fate-tx: libavutil/tests/tx$(EXESUF)
+fate-tx: CMD = run libavutil/tests/tx$(EXESUF)
+fate-tx: CMP = null
+
 FATE_LIBAVUTIL += fate-xtea
 fate-xtea: libavutil/tests/xtea$(EXESUF)
 fate-xtea: CMD = run libavutil/tests/xtea$(EXESUF)
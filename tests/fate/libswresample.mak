@@ -1094,5 +1094,11 @@ fate-swr-audioconvert: CMP = stddev
 fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
+
+FATE_SWR_LIB += fate-swr-threads
+fate-swr-threads: libswresample/tests/resample$(EXESUF)
+fate-swr-threads: CMD = run libswresample/tests/resample$(EXESUF)
+
 FATE_FFMPEG += $(FATE_SWR)
-fate-swr: $(FATE_SWR)
+FATE-$(CONFIG_SWRESAMPLE) += $(FATE_SWR_LIB)
+fate-swr: $(FATE_SWR) $(FATE_SWR_LIB)
@@ -266,6 +266,17 @@ fate-seek-mkv-codec-delay:   CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_
 
 FATE_SEEK_EXTRA += $(FATE_SEEK_EXTRA-yes)
 
+FATE_SEEK_INDEX-$(call ALLYES, MPEGTS_MUXER MPEGTS_DEMUXER FILE_PROTOCOL) += fate-seek-index-ts
+fate-seek-index-ts: fate-lavf-ts tools/seekindex$(EXESUF) libavformat/tests/seek$(EXESUF)
+fate-seek-index-ts: CMD = seek_index $(TARGET_PATH)/tests/data/lavf/lavf.ts
+fate-lavf-ts: KEEP_OVERRIDE = -keep
+
+FATE_SEEK_INDEX-$(call ALLYES, MPEG1VIDEO_ENCODER MP2_ENCODER MPEG1SYSTEM_MUXER MPEGPS_DEMUXER FILE_PROTOCOL) += fate-seek-index-mpg
+fate-seek-index-mpg: fate-lavf-mpg tools/seekindex$(EXESUF) libavformat/tests/seek$(EXESUF)
+fate-seek-index-mpg: CMD = seek_index $(TARGET_PATH)/tests/data/lavf/lavf.mpg
+fate-lavf-mpg: KEEP_OVERRIDE = -keep
+FATE_SEEK_INDEX += $(FATE_SEEK_INDEX-yes)
+
 
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA): libavformat/tests/seek$(EXESUF)
 $(FATE_SEEK) $(FATE_SAMPLES_SEEK): CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/$(SRC)
@@ -273,6 +284,6 @@ $(FATE_SEEK) $(FATE_SAMPLES_SEEK): fate-seek-%: fate-%
 $(subst fate-seek-,fate-,$(FATE_SAMPLES_SEEK) $(FATE_SEEK)): KEEP_OVERRIDE = -keep
 fate-seek-%: REF = $(SRC_PATH)/tests/ref/seek/$(@:fate-seek-%=%)
 
-FATE_AVCONV += $(FATE_SEEK)
+FATE_AVCONV += $(FATE_SEEK) $(FATE_SEEK_INDEX)
 FATE_SAMPLES_AVCONV += $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
-fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
+fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA) $(FATE_SEEK_INDEX)
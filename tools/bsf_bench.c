@@ -0,0 +1,179 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the throughput of a bitstream filter chain on the packets of
+ * one stream, next to that of the null filter (i.e. a plain stream copy).
+ * All packets are read into memory first, so that demuxing and I/O are
+ * not part of the measurement.
+ *
+ * Usage: bsf_bench <input> <bsf chain> [runs [stream index]]
+ * e.g.   bsf_bench in.mp4 h264_metadata=video_full_range_flag=1 10
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+#include "libavcodec/bsf.h"
+#include "libavformat/avformat.h"
+
+static int run_bsf(const char *str, const AVStream *st,
+                   AVPacket **pkts, int nb_pkts, int runs,
+                   int64_t *elapsed, int64_t *out_size)
+{
+    AVBSFContext *bsf = NULL;
+    AVPacket *pkt = av_packet_alloc();
+    int64_t start;
+    int ret, i, r;
+
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    ret = av_bsf_list_parse_str(str, &bsf);
+    if (ret < 0)
+        goto end;
+    ret = avcodec_parameters_copy(bsf->par_in, st->codecpar);
+    if (ret < 0)
+        goto end;
+    bsf->time_base_in = st->time_base;
+    ret = av_bsf_init(bsf);
+    if (ret < 0)
+        goto end;
+
+    *out_size = 0;
+    start = av_gettime_relative();
+    for (r = 0; r < runs; r++) {
+        for (i = 0; i <= nb_pkts; i++) {
+            if (i < nb_pkts) {
+                ret = av_packet_ref(pkt, pkts[i]);
+                if (ret < 0)
+                    goto end;
+                ret = av_bsf_send_packet(bsf, pkt);
+            } else {
+                ret = av_bsf_send_packet(bsf, NULL);
+            }
+            if (ret < 0)
+                goto end;
+            while ((ret = av_bsf_receive_packet(bsf, pkt)) >= 0) {
+                *out_size += pkt->size;
+                av_packet_unref(pkt);
+            }
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                goto end;
+        }
+        av_bsf_flush(bsf);
+    }
+    *elapsed = av_gettime_relative() - start;
+    ret = 0;
+
+end:
+    av_bsf_free(&bsf);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    AVFormatContext *fmt = NULL;
+    AVPacket **pkts = NULL;
+    int nb_pkts = 0, runs = 10, stream_index = -1;
+    int64_t in_size = 0;
+    const char *chains[2];
+    int ret, i;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <input> <bsf chain> [runs [stream index]]\n",
+                argv[0]);
+        return 1;
+    }
+    if (argc > 3)
+        runs = FFMAX(atoi(argv[3]), 1);
+    if (argc > 4)
+        stream_index = atoi(argv[4]);
+
+    ret = avformat_open_input(&fmt, argv[1], NULL, NULL);
+    if (ret < 0)
+        goto end;
+    ret = avformat_find_stream_info(fmt, NULL);
+    if (ret < 0)
+        goto end;
+    if (stream_index < 0)
+        stream_index = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO,
+                                           -1, -1, NULL, 0);
+    if (stream_index < 0 || stream_index >= fmt->nb_streams) {
+        ret = AVERROR_STREAM_NOT_FOUND;
+        goto end;
+    }
+
+    for (;;) {
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        ret = av_read_frame(fmt, pkt);
+        if (ret < 0) {
+            av_packet_free(&pkt);
+            break;
+        }
+        if (pkt->stream_index != stream_index) {
+            av_packet_free(&pkt);
+            continue;
+        }
+        ret = av_reallocp_array(&pkts, nb_pkts + 1, sizeof(*pkts));
+        if (ret < 0) {
+            av_packet_free(&pkt);
+            goto end;
+        }
+        in_size += pkt->size;
+        pkts[nb_pkts++] = pkt;
+    }
+
+    printf("%d packets, %"PRId64" bytes, %d runs\n", nb_pkts, in_size, runs);
+
+    chains[0] = "null";
+    chains[1] = argv[2];
+    for (i = 0; i < 2; i++) {
+        int64_t elapsed, out_size;
+        double seconds;
+
+        ret = run_bsf(chains[i], fmt->streams[stream_index],
+                      pkts, nb_pkts, runs, &elapsed, &out_size);
+        if (ret < 0)
+            goto end;
+
+        seconds = FFMAX(elapsed, 1) / 1000000.0;
+        printf("%-40s %10.1f MB/s %10.0f packets/s (%"PRId64" bytes out)\n",
+               chains[i], in_size * runs / seconds / 1000000.0,
+               nb_pkts * runs / seconds, out_size / runs);
+    }
+    ret = 0;
+
+end:
+    for (i = 0; i < nb_pkts; i++)
+        av_packet_free(&pkts[i]);
+    av_freep(&pkts);
+    avformat_close_input(&fmt);
+    if (ret < 0) {
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Writes a seek index of a file, to be loaded with the seek_index option:
+ *
+ * seekindex foo.ts foo.ts.idx
+ * ffmpeg -seek_index foo.ts.idx -ss 3600 -i foo.ts ...
+ */
+
+#include <stdio.h>
+
+#include "libavformat/avformat.h"
+#include "libavutil/error.h"
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s input index\n", argv0);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    AVFormatContext *ic = NULL;
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (argc != 3)
+        return usage(argv[0], 1);
+
+    if ((ret = avformat_open_input(&ic, argv[1], NULL, NULL)) < 0) {
+        fprintf(stderr, "Unable to open %s: %s\n", argv[1], av_err2str(ret));
+        return 1;
+    }
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0) {
+        fprintf(stderr, "Unable to find stream info: %s\n", av_err2str(ret));
+        goto fail;
+    }
+    if ((ret = avformat_index_build(ic)) < 0) {
+        fprintf(stderr, "Unable to build the index: %s\n", av_err2str(ret));
+        goto fail;
+    }
+    if ((ret = avio_open(&pb, argv[2], AVIO_FLAG_WRITE)) < 0) {
+        fprintf(stderr, "Unable to open %s: %s\n", argv[2], av_err2str(ret));
+        goto fail;
+    }
+    if ((ret = avformat_index_save(ic, pb)) < 0)
+        fprintf(stderr, "Unable to write the index: %s\n", av_err2str(ret));
+    avio_closep(&pb);
+
+fail:
+    avformat_close_input(&ic);
+    return ret < 0;
+}